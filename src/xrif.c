@@ -84,8 +84,17 @@ matter of this Agreement.
 
 */
 
+//Needed for LZ4_setCompressionLevel and LZ4_compress_HC_extStateHC_fastReset
+#define LZ4_HC_STATIC_LINKING_ONLY
+
 #include "xrif.h"
 
+#include <math.h>
+
+#if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+#include <omp.h>
+#endif
+
 #define BIT15 (32768)
 #define BIT14 (16384)
 #define BIT13 (8192)
@@ -117,7 +126,7 @@ xrif_error_t xrif_new(xrif_t * handle_ptr)
    if( *handle_ptr == NULL) 
    {
       XRIF_ERROR_PRINT("xrif_new", "error in malloc");
-      XRIF_ERROR_MALLOC;
+      return XRIF_ERROR_MALLOC;
    }
    
    return xrif_initialize_handle(*handle_ptr);
@@ -235,6 +244,13 @@ xrif_error_t xrif_allocate( xrif_t handle )
       }
    }
    
+   rv = xrif_allocate_lz4_state(handle);
+   if(rv < 0) 
+   {
+      XRIF_ERROR_PRINT("xrif_allocate", "error from xrif_allocate_lz4_state");
+      return rv;
+   }
+   
    return XRIF_NOERROR;
 
 }
@@ -263,6 +279,53 @@ xrif_error_t xrif_reset( xrif_t handle )
       free(handle->compressed_buffer);
    }
    
+   if(handle->chain_buffer)
+   {
+      free(handle->chain_buffer);
+   }
+
+   if(handle->adaptive_methods)
+   {
+      free(handle->adaptive_methods);
+   }
+
+   if(handle->lz4_stream_encode)
+   {
+      LZ4_freeStream(handle->lz4_stream_encode);
+   }
+
+   if(handle->lz4hc_stream_encode)
+   {
+      LZ4_freeStreamHC(handle->lz4hc_stream_encode);
+   }
+
+   if(handle->lz4_stream_decode)
+   {
+      LZ4_freeStreamDecode(handle->lz4_stream_decode);
+   }
+
+   if(handle->lz4_dict_buffer)
+   {
+      free(handle->lz4_dict_buffer);
+   }
+
+   if(handle->lz4_state)
+   {
+      free(handle->lz4_state);
+   }
+
+   #ifdef XRIF_USE_ZSTD
+   if(handle->zstd_cctx)
+   {
+      ZSTD_freeCCtx( (ZSTD_CCtx *) handle->zstd_cctx);
+   }
+
+   if(handle->zstd_dctx)
+   {
+      ZSTD_freeDCtx( (ZSTD_DCtx *) handle->zstd_dctx);
+   }
+   #endif
+
    int rv = xrif_initialize_handle(handle);
    
    if(rv != XRIF_NOERROR)
@@ -313,14 +376,44 @@ xrif_error_t xrif_initialize_handle( xrif_t handle )
    
    handle->difference_method = XRIF_DIFFERENCE_DEFAULT;
    
+   handle->chain_cubes = 0;
+   handle->chained = 0;
+   handle->chain_index = 0;
+   
+   handle->keyframe_interval = 0;
+   
+   handle->reference_frame = 0;
+   handle->reference_frame_size = 0;
+   handle->reference_frame_id = 0;
+   handle->reference_id = 0;
+   
+   handle->adaptive_block_size = XRIF_ADAPTIVE_BLOCK_SIZE_DEFAULT;
+   
    handle->reorder_method = XRIF_REORDER_DEFAULT;
    
    handle->compress_method = XRIF_COMPRESS_DEFAULT;
    
    handle->lz4_acceleration = 1;
+   
+   handle->lz4hc_level = XRIF_LZ4HC_LEVEL_DEFAULT;
+   handle->lz4_memory_usage = XRIF_LZ4_MEMORY_USAGE_DEFAULT;
+   handle->zstd_level = XRIF_ZSTD_LEVEL_DEFAULT;
+   handle->zstd_workers = 0;
+   
+   handle->compress_block_size = 0;
+   
+   handle->tile_size = 0;
+   
+   handle->lz4_stream = 0;
+   handle->lz4_chained = 0;
+   
+   handle->compress_planes = 0;
+   
+   handle->skip_entropy = 0;
 
    handle->omp_parallel = 0;
    handle->omp_numthreads = 1;
+   handle->omp_min_pixels = XRIF_OMP_MIN_PIXELS_DEFAULT;
    
    handle->compress_on_raw = 1;
    
@@ -336,6 +429,33 @@ xrif_error_t xrif_initialize_handle( xrif_t handle )
    handle->compressed_buffer = 0;
    handle->compressed_buffer_size = 0;
    
+   handle->chain_buffer = 0;
+   handle->chain_buffer_size = 0;
+   handle->chain_encode_valid = 0;
+   handle->chain_encode_index = 0;
+   handle->chain_decode_valid = 0;
+   handle->chain_decode_index = 0;
+   
+   handle->adaptive_methods = 0;
+   handle->adaptive_methods_size = 0;
+   
+   handle->lz4_stream_encode = 0;
+   handle->lz4hc_stream_encode = 0;
+   handle->lz4_stream_decode = 0;
+   handle->lz4_dict_buffer = 0;
+   handle->lz4_dict_encode_size = 0;
+   handle->lz4_dict_encode_method = 0;
+   handle->lz4_dict_decode_size = 0;
+   
+   handle->lz4_state = 0;
+   handle->lz4_state_size = 0;
+   handle->lz4_nstates = 0;
+   handle->lz4_state_method = 0;
+   handle->lz4_state_memory_usage = 0;
+   
+   handle->zstd_cctx = 0;
+   handle->zstd_dctx = 0;
+   
    handle->calc_performance = 1; 
    
    handle->compression_ratio = 0;
@@ -347,6 +467,7 @@ xrif_error_t xrif_initialize_handle( xrif_t handle )
    handle->reorder_rate = 0;
    handle->compress_time = 0;
    handle->compress_rate = 0;
+   handle->compress_skipped = 0;
    
    return XRIF_NOERROR;
 }
@@ -368,6 +489,11 @@ xrif_error_t xrif_set_difference_method( xrif_t handle,
    else if( difference_method == XRIF_DIFFERENCE_PREVIOUS ) handle->difference_method = XRIF_DIFFERENCE_PREVIOUS;
    else if( difference_method == XRIF_DIFFERENCE_FIRST ) handle->difference_method = XRIF_DIFFERENCE_FIRST;
    else if( difference_method == XRIF_DIFFERENCE_PIXEL ) handle->difference_method = XRIF_DIFFERENCE_PIXEL;
+   else if( xrif_difference_spatial_method(difference_method) ) handle->difference_method = difference_method;
+   else if( difference_method == XRIF_DIFFERENCE_PREVIOUS_MED ) handle->difference_method = XRIF_DIFFERENCE_PREVIOUS_MED;
+   else if( difference_method == XRIF_DIFFERENCE_LINEAR ) handle->difference_method = XRIF_DIFFERENCE_LINEAR;
+   else if( difference_method == XRIF_DIFFERENCE_REFERENCE ) handle->difference_method = XRIF_DIFFERENCE_REFERENCE;
+   else if( difference_method == XRIF_DIFFERENCE_ADAPTIVE ) handle->difference_method = XRIF_DIFFERENCE_ADAPTIVE;
    else
    {
       handle->difference_method = XRIF_DIFFERENCE_DEFAULT;
@@ -418,6 +544,18 @@ xrif_error_t xrif_set_compress_method( xrif_t handle,
    if( compress_method == XRIF_COMPRESS_NONE ) handle->compress_method = XRIF_COMPRESS_NONE;
    else if( compress_method == XRIF_COMPRESS_DEFAULT ) handle->compress_method = XRIF_COMPRESS_DEFAULT;
    else if( compress_method == XRIF_COMPRESS_LZ4 ) handle->compress_method = XRIF_COMPRESS_LZ4;
+   else if( compress_method == XRIF_COMPRESS_LZ4HC ) handle->compress_method = XRIF_COMPRESS_LZ4HC;
+   else if( compress_method == XRIF_COMPRESS_RANS ) handle->compress_method = XRIF_COMPRESS_RANS;
+   else if( compress_method == XRIF_COMPRESS_ZSTD )
+   {
+      #ifdef XRIF_USE_ZSTD
+      handle->compress_method = XRIF_COMPRESS_ZSTD;
+      #else
+      handle->compress_method = XRIF_COMPRESS_DEFAULT;
+      XRIF_ERROR_PRINT("xrif_set_compress_method", "xrif was built without zstd.  Setting default");
+      return XRIF_ERROR_NOTIMPL;
+      #endif
+   }
    else
    {
       handle->compress_method = XRIF_COMPRESS_DEFAULT;
@@ -458,1577 +596,4264 @@ xrif_error_t xrif_set_lz4_acceleration( xrif_t handle,    // [in/out] the xrif h
    return XRIF_NOERROR;
 }
 
-// Calculate the minimum size of the raw buffer.
-size_t xrif_min_raw_size(xrif_t handle)
+// Set the LZ4HC compression level
+xrif_error_t xrif_set_lz4hc_level( xrif_t handle,
+                                   int32_t lz4hc_level
+                                 )
 {
-   if(handle->compress_on_raw == 0) //Won't use raw to store compressed data
+   if( handle == NULL)
    {
-      return handle->width * handle->height * handle->depth * handle->frames * handle->data_size;
+      XRIF_ERROR_PRINT("xrif_set_lz4hc_level", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
    }
-   else
+   
+   if(lz4hc_level < XRIF_LZ4HC_LEVEL_MIN)
    {
-      //In this case it depends on size needed for compression.
-      size_t minSz = xrif_min_compressed_size(handle);
-      
-      if(minSz < handle->width * handle->height * handle->depth * handle->frames * handle->data_size) 
-      {
-         minSz = handle->width * handle->height * handle->depth * handle->frames * handle->data_size;
-      }
+      XRIF_ERROR_PRINT("xrif_set_lz4hc_level", "LZ4HC level can't be less than XRIF_LZ4HC_LEVEL_MIN.  Setting to XRIF_LZ4HC_LEVEL_MIN.");
+      handle->lz4hc_level = XRIF_LZ4HC_LEVEL_MIN;
+      return XRIF_ERROR_BADARG;
+   }
    
-      return minSz;
+   if(lz4hc_level > XRIF_LZ4HC_LEVEL_MAX)
+   {
+      XRIF_ERROR_PRINT("xrif_set_lz4hc_level", "LZ4HC level can't be greater than XRIF_LZ4HC_LEVEL_MAX.  Setting to XRIF_LZ4HC_LEVEL_MAX.");
+      handle->lz4hc_level = XRIF_LZ4HC_LEVEL_MAX;
+      return XRIF_ERROR_BADARG;
    }
    
-   return 0;
+   handle->lz4hc_level = lz4hc_level;
+   
+   return XRIF_NOERROR;
 }
 
-// Calculate the minimum size of the reordered buffer.
-size_t xrif_min_reordered_size(xrif_t handle)
+// Set the Zstandard compression level
+xrif_error_t xrif_set_zstd_level( xrif_t handle,
+                                  int32_t zstd_level
+                                )
 {
-   if(handle == NULL) return 0;
-   
-   if(handle->reorder_method == XRIF_REORDER_NONE)
+   if( handle == NULL)
    {
-      return handle->width * handle->height * handle->depth * handle->frames * handle->data_size;
+      XRIF_ERROR_PRINT("xrif_set_zstd_level", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
    }
    
-   if(handle->reorder_method == XRIF_REORDER_BYTEPACK)
+   if(zstd_level < XRIF_ZSTD_LEVEL_MIN)
    {
-      size_t one_frame = handle->width*handle->height*handle->depth*handle->data_size;
-   
-      return one_frame * (handle->frames);
+      XRIF_ERROR_PRINT("xrif_set_zstd_level", "zstd level can't be less than XRIF_ZSTD_LEVEL_MIN.  Setting to XRIF_ZSTD_LEVEL_MIN.");
+      handle->zstd_level = XRIF_ZSTD_LEVEL_MIN;
+      return XRIF_ERROR_BADARG;
    }
    
-   if(handle->reorder_method == XRIF_REORDER_BYTEPACK_RENIBBLE)
+   if(zstd_level > XRIF_ZSTD_LEVEL_MAX)
    {
-      size_t one_frame = handle->width * handle->height * handle->depth * handle->data_size;
-      
-      return one_frame * (handle->frames+1); //Allocating an extra frame to allow for odd number of pixels in reorder step   
+      XRIF_ERROR_PRINT("xrif_set_zstd_level", "zstd level can't be greater than XRIF_ZSTD_LEVEL_MAX.  Setting to XRIF_ZSTD_LEVEL_MAX.");
+      handle->zstd_level = XRIF_ZSTD_LEVEL_MAX;
+      return XRIF_ERROR_BADARG;
    }
    
-   if(handle->reorder_method == XRIF_REORDER_BITPACK)
-   {
-      size_t one_frame = handle->width * handle->height * handle->depth * handle->data_size;
-
-      if(one_frame < 16) one_frame = 16; //Handle cases where too little data is available for bitpacking.
-   
-      return one_frame * (handle->frames+1); //Allocating an extra frame to allow for odd number of pixels in reorder step   
-   }
+   handle->zstd_level = zstd_level;
    
-   return 0;
+   return XRIF_NOERROR;
 }
 
-/// Calculate the minimum size of the compressed buffer.
-size_t xrif_min_compressed_size(xrif_t handle)
+// Set the number of Zstandard worker threads
+xrif_error_t xrif_set_zstd_workers( xrif_t handle,
+                                    int zstd_workers
+                                  )
 {
-   if(handle->compress_method == XRIF_COMPRESS_NONE)
+   if( handle == NULL)
    {
-      return handle->width * handle->height * handle->depth * handle->frames * handle->data_size;
+      XRIF_ERROR_PRINT("xrif_set_zstd_workers", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
    }
    
-   if(handle->compress_method == XRIF_COMPRESS_LZ4)
+   if(zstd_workers < 0)
    {
-      //We compress the reordered buffer, and it can be the largest buffer.
-      return LZ4_compressBound(xrif_min_reordered_size(handle));   
+      XRIF_ERROR_PRINT("xrif_set_zstd_workers", "zstd workers can't be negative.  Setting to 0.");
+      handle->zstd_workers = 0;
+      return XRIF_ERROR_BADARG;
    }
    
-   return 0;
+   handle->zstd_workers = zstd_workers;
+   
+   return XRIF_NOERROR;
 }
 
-// Set the raw data buffer to a pre-allocated pointer
-xrif_error_t xrif_set_raw( xrif_t handle,
-                           void * raw,          
-                           size_t size          
-                         )
+// Set the LZ4 hash table size
+xrif_error_t xrif_set_lz4_memory_usage( xrif_t handle,
+                                        int lz4_memory_usage
+                                      )
 {
    if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_set_raw", "can not configure null pointer");
+      XRIF_ERROR_PRINT("xrif_set_lz4_memory_usage", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   if(handle->raw_buffer && handle->own_raw )
+   if(lz4_memory_usage < XRIF_LZ4_MEMORY_USAGE_MIN)
    {
-      free(handle->raw_buffer);
+      XRIF_ERROR_PRINT("xrif_set_lz4_memory_usage", "LZ4 memory usage can't be less than XRIF_LZ4_MEMORY_USAGE_MIN.  Setting to XRIF_LZ4_MEMORY_USAGE_MIN.");
+      handle->lz4_memory_usage = XRIF_LZ4_MEMORY_USAGE_MIN;
+      return XRIF_ERROR_BADARG;
    }
-
-   handle->own_raw = 0;
-
-   handle->raw_buffer = raw;
-   
-   handle->raw_buffer_size = size;
    
-   if((handle->raw_buffer != NULL && handle->raw_buffer_size == 0) || (handle->raw_buffer == 0 && handle->raw_buffer_size != 0)) 
+   if(lz4_memory_usage > XRIF_LZ4_MEMORY_USAGE_MAX)
    {
-      XRIF_ERROR_PRINT("xrif_set_raw", "the size is not valid");
-      return XRIF_ERROR_INVALID_SIZE;
+      XRIF_ERROR_PRINT("xrif_set_lz4_memory_usage", "LZ4 memory usage can't be greater than XRIF_LZ4_MEMORY_USAGE_MAX.  Setting to XRIF_LZ4_MEMORY_USAGE_MAX.");
+      handle->lz4_memory_usage = XRIF_LZ4_MEMORY_USAGE_MAX;
+      return XRIF_ERROR_BADARG;
    }
    
-   //Check if we meet minimum size requirement based on compress_on_raw value
-   size_t minSz = xrif_min_raw_size(handle);
-   if(minSz == 0)
+   if(lz4_memory_usage % 2 != 0)
    {
-      XRIF_ERROR_PRINT("xrif_set_raw", "error calculating minimum raw buffer size - check configuration.");
-      return XRIF_ERROR_INVALID_SIZE;
+      XRIF_ERROR_PRINT("xrif_set_lz4_memory_usage", "LZ4 memory usage must be even.  Rounding up.");
+      handle->lz4_memory_usage = lz4_memory_usage + 1;
+      return XRIF_ERROR_BADARG;
    }
    
-   if(handle->raw_buffer_size < minSz) 
-   {
-      XRIF_ERROR_PRINT("xrif_set_raw", "the raw buffer size is too small for configured parameters");
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
-   }
+   handle->lz4_memory_usage = lz4_memory_usage;
    
    return XRIF_NOERROR;
 }
 
-// Allocate the raw buffer based on the already set stream dimensions.
-xrif_error_t xrif_allocate_raw( xrif_t handle )
+// Set the compression block size
+xrif_error_t xrif_set_compress_block_size( xrif_t handle,
+                                           size_t block_size
+                                         )
 {
    if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_allocate_raw", "can not configure null pointer");
+      XRIF_ERROR_PRINT("xrif_set_compress_block_size", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   if(handle->width * handle->height * handle->depth * handle->frames * handle->data_size == 0)
+   if(block_size > XRIF_COMPRESS_BLOCK_SIZE_MAX)
    {
-      XRIF_ERROR_PRINT("xrif_allocate_raw", "the handle is not setup for allocation");
-      return XRIF_ERROR_NOT_SETUP;
+      XRIF_ERROR_PRINT("xrif_set_compress_block_size", "block size can't be greater than XRIF_COMPRESS_BLOCK_SIZE_MAX.  Setting to XRIF_COMPRESS_BLOCK_SIZE_MAX.");
+      handle->compress_block_size = XRIF_COMPRESS_BLOCK_SIZE_MAX;
+      return XRIF_ERROR_BADARG;
    }
    
-   if(handle->raw_buffer && handle->own_raw )
+   if(block_size % XRIF_COMPRESS_BLOCK_UNIT != 0)
    {
-      free(handle->raw_buffer);
+      XRIF_ERROR_PRINT("xrif_set_compress_block_size", "block size must be a multiple of XRIF_COMPRESS_BLOCK_UNIT.  Rounding up.");
+      handle->compress_block_size = (block_size/XRIF_COMPRESS_BLOCK_UNIT + 1)*XRIF_COMPRESS_BLOCK_UNIT;
+      return XRIF_ERROR_BADARG;
    }
    
-   handle->raw_buffer_size = xrif_min_raw_size(handle);
-   if(handle->raw_buffer_size == 0)
+   handle->compress_block_size = block_size;
+   
+   return XRIF_NOERROR;
+}
+
+// Set the tile size for tiled encoding
+xrif_error_t xrif_set_tile_size( xrif_t handle,
+                                 size_t tile_size
+                               )
+{
+   if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_allocate_raw", "error calculating minimum raw buffer size - check configuration.");
-      return XRIF_ERROR_INVALID_SIZE;
+      XRIF_ERROR_PRINT("xrif_set_tile_size", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
    }
    
-   handle->raw_buffer = (char *) malloc( handle->raw_buffer_size );
+   if(tile_size > XRIF_COMPRESS_BLOCK_SIZE_MAX)
+   {
+      XRIF_ERROR_PRINT("xrif_set_tile_size", "tile size can't be greater than XRIF_COMPRESS_BLOCK_SIZE_MAX.  Setting to XRIF_COMPRESS_BLOCK_SIZE_MAX.");
+      handle->tile_size = XRIF_COMPRESS_BLOCK_SIZE_MAX;
+      return XRIF_ERROR_BADARG;
+   }
    
-   if(handle->raw_buffer == NULL) 
+   if(tile_size % XRIF_COMPRESS_BLOCK_UNIT != 0)
    {
-      handle->own_raw = 0;
-      
-      XRIF_ERROR_PRINT("xrif_allocate_raw", "error from malloc");
-      
-      return XRIF_ERROR_MALLOC;
+      XRIF_ERROR_PRINT("xrif_set_tile_size", "tile size must be a multiple of XRIF_COMPRESS_BLOCK_UNIT.  Rounding up.");
+      handle->tile_size = (tile_size/XRIF_COMPRESS_BLOCK_UNIT + 1)*XRIF_COMPRESS_BLOCK_UNIT;
+      return XRIF_ERROR_BADARG;
    }
    
-   handle->own_raw = 1;
+   handle->tile_size = tile_size;
    
    return XRIF_NOERROR;
 }
 
-// Set the rordered (working) data buffer to a pre-allocated pointer
-xrif_error_t xrif_set_reordered( xrif_t handle,
-                                 void * reordered,
-                                 size_t size
-                               )
+// Set whether successive cubes are chained together.
+xrif_error_t xrif_set_chain_cubes( xrif_t handle,
+                                   int chain_cubes
+                                 )
 {
    if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_set_reordered", "can not configure null pointer");
+      XRIF_ERROR_PRINT("xrif_set_chain_cubes", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   if(handle->reordered_buffer && handle->own_reordered )
+   //The key frame interval takes the place of the chain index in the header
+   if(chain_cubes && handle->keyframe_interval > 0)
    {
-      free(handle->reordered_buffer);
+      XRIF_ERROR_PRINT("xrif_set_chain_cubes", "can not chain cubes with a key frame interval.");
+      return XRIF_ERROR_BADARG;
    }
    
-   handle->reordered_buffer = reordered;
-   
-   handle->reordered_buffer_size = size;
-   
-   handle->own_reordered = 0;
+   handle->chain_cubes = (chain_cubes != 0);
    
-   if((handle->reordered_buffer != NULL && handle->reordered_buffer_size == 0) || (handle->reordered_buffer == 0 && handle->reordered_buffer_size != 0))
+   return XRIF_NOERROR;
+}
+
+// Set whether LZ4 compression continues from the previous cube.
+xrif_error_t xrif_set_lz4_stream( xrif_t handle,
+                                  int lz4_stream
+                                )
+{
+   if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_set_reordered", "the size is not valid");
-      return XRIF_ERROR_INVALID_SIZE;
+      XRIF_ERROR_PRINT("xrif_set_lz4_stream", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
    }
    
-   //Check minimum size for reordering algorithms to work.
-   size_t minSz = xrif_min_reordered_size(handle);
-   if(minSz == 0)
+   //The key frame interval takes the place of the chain index in the header
+   if(lz4_stream && handle->keyframe_interval > 0)
    {
-      XRIF_ERROR_PRINT("xrif_set_reordered", "error calculating minimum reordered buffer size - check configuration.");
-      return XRIF_ERROR_INVALID_SIZE;
+      XRIF_ERROR_PRINT("xrif_set_lz4_stream", "can not stream LZ4 with a key frame interval.");
+      return XRIF_ERROR_BADARG;
    }
    
-   if(handle->reordered_buffer_size < minSz)
-   {
-      XRIF_ERROR_PRINT("xrif_set_reordered", "the reordered buffer size is too small for configured parameters");
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
-   }
+   handle->lz4_stream = (lz4_stream != 0);
    
    return XRIF_NOERROR;
 }
 
-// Allocate the reordered buffer based on the already set stream dimensions.
-xrif_error_t xrif_allocate_reordered( xrif_t handle )
+// Set whether the reordered planes are compressed separately.
+xrif_error_t xrif_set_compress_planes( xrif_t handle,
+                                       int compress_planes
+                                     )
 {
-   if( handle == NULL) 
+   if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_allocate_reordered", "can not configure null pointer");
+      XRIF_ERROR_PRINT("xrif_set_compress_planes", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   if(handle->width * handle->height * handle->depth * handle->frames * handle->data_size == 0)
-   {
-      XRIF_ERROR_PRINT("xrif_allocate_reordered", "the handle is not setup for allocation");
-      return XRIF_ERROR_NOT_SETUP;
-   }
+   handle->compress_planes = (compress_planes != 0);
    
-   if(handle->reordered_buffer && handle->own_reordered)
-   {
-      free(handle->reordered_buffer);
-   }
+   return XRIF_NOERROR;
+}
 
-   handle->reordered_buffer_size = xrif_min_reordered_size(handle);
-   if(handle->reordered_buffer_size == 0)
+// Set the entropy above which blocks and planes are stored without trying to compress them.
+xrif_error_t xrif_set_skip_entropy( xrif_t handle,
+                                    double skip_entropy
+                                  )
+{
+   if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_allocate_reordered", "error calculating minimum reordered buffer size - check configuration.");
-      return XRIF_ERROR_INVALID_SIZE;
+      XRIF_ERROR_PRINT("xrif_set_skip_entropy", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
    }
    
-   handle->reordered_buffer = (char *) malloc( handle->reordered_buffer_size );
+   if(skip_entropy < 0)
+   {
+      XRIF_ERROR_PRINT("xrif_set_skip_entropy", "entropy threshold can't be negative.  Setting to 0.");
+      handle->skip_entropy = 0;
+      return XRIF_ERROR_BADARG;
+   }
    
-   if(handle->reordered_buffer == NULL) 
+   if(skip_entropy > 8)
    {
-      handle->reordered_buffer_size = 0;
-      handle->own_reordered = 0;
-      
-      XRIF_ERROR_PRINT("xrif_allocate_reordered", "error from malloc");
-      return XRIF_ERROR_MALLOC;
+      XRIF_ERROR_PRINT("xrif_set_skip_entropy", "entropy threshold can't be greater than 8 bits per byte.  Setting to 8.");
+      handle->skip_entropy = 8;
+      return XRIF_ERROR_BADARG;
    }
    
-   handle->own_reordered = 1;
+   handle->skip_entropy = skip_entropy;
    
    return XRIF_NOERROR;
 }
 
-xrif_error_t xrif_set_compressed( xrif_t handle, 
-                                  void * compressed,    
-                                  size_t size           
-                                )
+// Set the minimum number of pixels in a cube for the differencing kernels to use threads.
+xrif_error_t xrif_set_omp_min_pixels( xrif_t handle,
+                                      size_t omp_min_pixels
+                                    )
 {
-
-   if( handle == NULL) 
+   if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_set_compressed", "can not configure null pointer");
+      XRIF_ERROR_PRINT("xrif_set_omp_min_pixels", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   if(handle->compressed_buffer && handle->own_compressed )
-   {
-      free(handle->compressed_buffer);
-   }
+   handle->omp_min_pixels = omp_min_pixels;
+   
+   return XRIF_NOERROR;
+}
 
-   handle->own_compressed = 0;
+int xrif_use_omp( xrif_t handle,
+                  size_t npix
+                )
+{
+   return (handle->omp_parallel > 0 && npix >= handle->omp_min_pixels);
+}
 
-   handle->compressed_buffer = compressed;
-   
-   handle->compressed_buffer_size = size;
-   
-   if((handle->compressed_buffer != NULL && handle->compressed_buffer_size == 0) || (handle->compressed_buffer == 0 && handle->compressed_buffer_size != 0)) 
+// Set the key frame interval within the cube.
+xrif_error_t xrif_set_keyframe_interval( xrif_t handle,
+                                         xrif_dimension_t keyframe_interval
+                                       )
+{
+   if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_set_compressed", "the size is not valid");
-      return XRIF_ERROR_INVALID_SIZE;
+      XRIF_ERROR_PRINT("xrif_set_keyframe_interval", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
    }
    
-   size_t minSz = xrif_min_compressed_size(handle);
-   if(minSz == 0)
+   //The interval is stored in 16 bits in the header
+   if(keyframe_interval > UINT16_MAX)
    {
-      XRIF_ERROR_PRINT("xrif_set_compressed", "error calculating minimum compressed buffer size - check configuration.");
-      return XRIF_ERROR_INVALID_SIZE;
+      XRIF_ERROR_PRINT("xrif_set_keyframe_interval", "key frame interval can't be greater than 65535.  Setting to 65535.");
+      handle->keyframe_interval = UINT16_MAX;
+      return XRIF_ERROR_BADARG;
    }
    
-   if(handle->compressed_buffer_size < minSz) 
+   //The interval takes the place of the chain index in the header
+   if(keyframe_interval > 0 && (handle->chain_cubes || handle->lz4_stream))
    {
-      XRIF_ERROR_PRINT("xrif_set_compressed", "the compressed buffer size is too small for configured parameters");
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      XRIF_ERROR_PRINT("xrif_set_keyframe_interval", "can not use a key frame interval with cube chaining or LZ4 streaming.");
+      return XRIF_ERROR_BADARG;
    }
    
+   handle->keyframe_interval = keyframe_interval;
+   
    return XRIF_NOERROR;
 }
 
-xrif_error_t xrif_allocate_compressed( xrif_t handle )
+size_t xrif_segment_frames( xrif_t handle )
 {
-   if( handle == NULL) 
+   if(handle->keyframe_interval > 0 && handle->keyframe_interval < handle->frames) return handle->keyframe_interval;
+   
+   return handle->frames;
+}
+
+int xrif_has_keyframe_interval( xrif_t handle )
+{
+   if(handle->keyframe_interval == 0) return 0;
+   
+   int method = handle->difference_method;
+   if(method == 0) method = XRIF_DIFFERENCE_DEFAULT;
+   
+   return (method == XRIF_DIFFERENCE_PREVIOUS || method == XRIF_DIFFERENCE_FIRST || method == XRIF_DIFFERENCE_PREVIOUS_MED || 
+           method == XRIF_DIFFERENCE_LINEAR);
+}
+
+// Set the reference frame for XRIF_DIFFERENCE_REFERENCE
+xrif_error_t xrif_set_reference( xrif_t handle,
+                                 void * reference,
+                                 size_t size,
+                                 uint64_t id
+                               )
+{
+   if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_allocate_compressed", "can not configure null pointer");
+      XRIF_ERROR_PRINT("xrif_set_reference", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   if(handle->compressed_buffer && handle->own_compressed )
+   handle->reference_frame = reference;
+   handle->reference_frame_size = size;
+   handle->reference_frame_id = id;
+   
+   if((handle->reference_frame != NULL && handle->reference_frame_size == 0) || (handle->reference_frame == 0 && handle->reference_frame_size != 0)) 
    {
-      free(handle->compressed_buffer);
+      XRIF_ERROR_PRINT("xrif_set_reference", "the size is not valid");
+      return XRIF_ERROR_INVALID_SIZE;
    }
    
-   if(handle->width * handle->height * handle->depth * handle->frames * handle->data_size == 0) 
+   return XRIF_NOERROR;
+}
+
+// Set the size of the blocks for XRIF_DIFFERENCE_ADAPTIVE
+xrif_error_t xrif_set_adaptive_block_size( xrif_t handle,
+                                           xrif_dimension_t block_size
+                                         )
+{
+   if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_allocate_compressed", "the handle is not setup for allocation");
-      return XRIF_ERROR_NOT_SETUP;
+      XRIF_ERROR_PRINT("xrif_set_adaptive_block_size", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
    }
    
-   handle->compressed_buffer_size = xrif_min_compressed_size(handle);
-   if(handle->compressed_buffer_size == 0)
+   if(block_size == 0)
    {
-      XRIF_ERROR_PRINT("xrif_allocate_compressed", "error calculating minimum compressed buffer size - check configuration.");
-      return XRIF_ERROR_INVALID_SIZE;
+      XRIF_ERROR_PRINT("xrif_set_adaptive_block_size", "block size can't be 0.  Setting default.");
+      handle->adaptive_block_size = XRIF_ADAPTIVE_BLOCK_SIZE_DEFAULT;
+      return XRIF_ERROR_BADARG;
    }
-      
-   handle->compressed_buffer = (char *) malloc( handle->compressed_buffer_size );
    
-   if(handle->compressed_buffer == NULL) 
+   //The block size is stored in 16 bits in the header
+   if(block_size > UINT16_MAX)
    {
-      handle->own_compressed = 0;
-      
-      XRIF_ERROR_PRINT("xrif_allocate_compressed", "error from malloc");
-      return XRIF_ERROR_MALLOC;
+      XRIF_ERROR_PRINT("xrif_set_adaptive_block_size", "block size can't be greater than 65535.  Setting to 65535.");
+      handle->adaptive_block_size = UINT16_MAX;
+      return XRIF_ERROR_BADARG;
    }
    
-   handle->own_compressed = 1;
+   handle->adaptive_block_size = block_size;
    
    return XRIF_NOERROR;
 }
 
-xrif_dimension_t xrif_width( xrif_t handle )
+size_t xrif_adaptive_blocks( xrif_t handle )
 {
-   if( handle == NULL)
-   {
-      XRIF_ERROR_PRINT("xrif_width", "can not access a null pointer");
-      return XRIF_ERROR_NULLPTR;
-   }
+   size_t bsz = handle->adaptive_block_size;
    
-   return handle->width;
-}   
+   if(bsz == 0) return 0;
+   
+   //The planes of a frame are treated as more rows
+   return ((handle->width + bsz - 1)/bsz) * ((handle->height*handle->depth + bsz - 1)/bsz);
+}
 
-xrif_dimension_t xrif_height( xrif_t handle )
+// Make the next encoded cube a keyframe.
+xrif_error_t xrif_keyframe( xrif_t handle )
 {
    if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_height", "can not access a null pointer");
+      XRIF_ERROR_PRINT("xrif_keyframe", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   return handle->height;
+   handle->chain_encode_valid = 0;
+   
+   return XRIF_NOERROR;
 }
 
-xrif_dimension_t xrif_depth( xrif_t handle )
+// Calculate the minimum size of the raw buffer.
+size_t xrif_min_raw_size(xrif_t handle)
 {
-   if( handle == NULL)
+   if(handle->compress_on_raw == 0) //Won't use raw to store compressed data
    {
-      XRIF_ERROR_PRINT("xrif_depth", "can not access a null pointer");
-      return XRIF_ERROR_NULLPTR;
+      return handle->width * handle->height * handle->depth * handle->frames * handle->data_size;
+   }
+   else
+   {
+      //In this case it depends on size needed for compression.
+      size_t minSz = xrif_min_compressed_size(handle);
+      
+      if(minSz < handle->width * handle->height * handle->depth * handle->frames * handle->data_size) 
+      {
+         minSz = handle->width * handle->height * handle->depth * handle->frames * handle->data_size;
+      }
+   
+      return minSz;
    }
    
-   return handle->depth;
+   return 0;
 }
 
-xrif_dimension_t xrif_frames( xrif_t handle )
+// Calculate the minimum size of the reordered buffer.
+size_t xrif_min_reordered_size(xrif_t handle)
 {
-   if( handle == NULL)
+   if(handle == NULL) return 0;
+   
+   size_t minSz = xrif_reordered_size(handle);
+   
+   //A chained cube also reorders its first frame, which can take more space with bitpack, and whether a cube is chained 
+   //is only known during xrif_encode or from the header.  So size the buffers for either layout.
+   if(handle->chain_cubes || handle->lz4_stream)
    {
-      XRIF_ERROR_PRINT("xrif_frames", "can not access a null pointer");
-      return XRIF_ERROR_NULLPTR;
+      int chained = handle->chained;
+      
+      handle->chained = !chained;
+      size_t altSz = xrif_reordered_size(handle);
+      handle->chained = chained;
+      
+      if(altSz > minSz) minSz = altSz;
    }
    
-   return handle->frames;
-}   
+   return minSz;
+}
 
-// Populate a header buffer with the xrif protocol details.
-xrif_error_t xrif_write_header( char * header,
-                                xrif_t handle 
-                              )
+// Calculate the size of the reordered data.
+size_t xrif_reordered_size(xrif_t handle)
 {
-   if( header == NULL)
+   if(handle == NULL) return 0;
+   
+   if(xrif_tiled(handle))
    {
-      XRIF_ERROR_PRINT("xrif_write_header", "can not write to a null pointer");
-      return XRIF_ERROR_NULLPTR;
+      //Encoding stages each compressed tile in a tile-sized slot, and decoding copies the compressed data here when it is on the raw buffer.
+      size_t ntiles = xrif_ntiles(handle);
+      size_t slots = ntiles * handle->tile_size;
+      size_t packed = xrif_min_compressed_size(handle);
+      
+      return (slots > packed) ? slots : packed;
    }
    
-   if( handle == NULL)
+   if(handle->reorder_method == XRIF_REORDER_NONE)
    {
-      XRIF_ERROR_PRINT("xrif_write_header", "can not read from a null pointer handle");
-      return XRIF_ERROR_NULLPTR;
+      return handle->width * handle->height * handle->depth * handle->frames * handle->data_size;
    }
    
-   header[0] = 'x';
-   header[1] = 'r';
-   header[2] = 'i';
-   header[3] = 'f';
-   
-   *((uint32_t *) &header[4]) = XRIF_VERSION;
-   
-   *((uint32_t *) &header[8]) = XRIF_HEADER_SIZE; 
-
-   *((uint32_t *) &header[12]) = handle->width;
+   if(handle->reorder_method == XRIF_REORDER_BYTEPACK)
+   {
+      size_t one_frame = handle->width*handle->height*handle->depth*handle->data_size;
    
-   *((uint32_t *) &header[16]) = handle->height;
+      return one_frame * (handle->frames);
+   }
    
-   *((uint32_t *) &header[20]) = handle->depth;
+   if(handle->reorder_method == XRIF_REORDER_BYTEPACK_RENIBBLE)
+   {
+      size_t one_frame = handle->width * handle->height * handle->depth * handle->data_size;
+      
+      return one_frame * (handle->frames+1); //Allocating an extra frame to allow for odd number of pixels in reorder step   
+   }
    
-   *((uint32_t *) &header[24]) = handle->frames;
+   if(handle->reorder_method == XRIF_REORDER_BITPACK)
+   {
+      size_t one_frame = handle->width * handle->height * handle->depth;
+      size_t npix = one_frame * handle->frames;
+      size_t first = 0;
+      
+      //The first frame is stored as is unless it is reordered too
+      if(!xrif_reorder_first_frame(handle))
+      {
+         first = one_frame * handle->data_size;
+         npix -= one_frame;
+      }
+      
+      //One plane per bit, each padded to a whole number of bytes
+      return first + 8*handle->data_size*((npix + 7)/8);
+   }
    
-   *((uint16_t *) &header[28]) = handle->type_code;
+   return 0;
+}
 
-   *((int16_t *) &header[30]) = handle->difference_method;
+/// Calculate the minimum size of the compressed buffer.
+size_t xrif_min_compressed_size(xrif_t handle)
+{
+   if(handle->compress_method == XRIF_COMPRESS_NONE)
+   {
+      //The reordered data is copied as is, and bitpack and renibble pad it beyond the raw size.
+      return xrif_min_reordered_size(handle);
+   }
    
-   *((int16_t *) &header[32]) = handle->reorder_method;
-
-   *((int16_t *) &header[34]) = handle->compress_method;
-
-   *((uint32_t *) &header[36]) = handle->compressed_size;
+   if(xrif_tiled(handle))
+   {
+      //Each tile is either compressed or stored as is, after the tile table.  A renibbled tile with an odd number of pixels has a padding nibble.
+      return XRIF_BLOCK_TABLE_SIZE(xrif_ntiles(handle)) + handle->width * handle->height * handle->depth * handle->frames * handle->data_size + 1;
+   }
    
-   memset(&header[40], 0, 8);
+   if(xrif_compress_by_plane(handle))
+   {
+      //Each plane is compressed into a slot the size of the plane, after the plane table.
+      return XRIF_BLOCK_TABLE_SIZE(3*xrif_compress_nplanes(handle)) + xrif_min_reordered_size(handle);
+   }
    
-   if(handle->compress_method == XRIF_COMPRESS_LZ4)
+   if(handle->compress_method == XRIF_COMPRESS_LZ4 || handle->compress_method == XRIF_COMPRESS_LZ4HC)
    {
-      *((uint16_t *) &header[40]) = handle->lz4_acceleration;
+      if(handle->compress_block_size > 0)
+      {
+         //Each block is compressed into its own worst-case slot, after the block table.
+         size_t nblocks = xrif_compress_nblocks(handle);
+         if(nblocks == 0) return 0;
+         
+         return XRIF_BLOCK_TABLE_SIZE(nblocks) + nblocks*LZ4_compressBound(handle->compress_block_size);
+      }
+      
+      //We compress the reordered buffer, and it can be the largest buffer.
+      return LZ4_compressBound(xrif_min_reordered_size(handle));   
    }
    
-   return XRIF_NOERROR;
+   #ifdef XRIF_USE_ZSTD
+   if(handle->compress_method == XRIF_COMPRESS_ZSTD)
+   {
+      return ZSTD_compressBound(xrif_min_reordered_size(handle));
+   }
+   #endif
    
+   if(handle->compress_method == XRIF_COMPRESS_RANS)
+   {
+      //Each plane is coded into its own worst-case slot, after the plane table.
+      size_t nplanes = xrif_compress_nplanes(handle);
+      
+      return XRIF_BLOCK_TABLE_SIZE(2*nplanes) + xrif_min_reordered_size(handle) + nplanes*XRIF_RANS_PLANE_OVERHEAD;
+   }
+   
+   return 0;
 }
 
-//Configure an xrif handle by reading a xrif protocol header
-xrif_error_t xrif_read_header( xrif_t handle,
-                               uint32_t * header_size,
-                               char * header
-                             )
+// Set the raw data buffer to a pre-allocated pointer
+xrif_error_t xrif_set_raw( xrif_t handle,
+                           void * raw,          
+                           size_t size          
+                         )
 {
    if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_read_header", "can not configure a null pointer handle");
+      XRIF_ERROR_PRINT("xrif_set_raw", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   if( header_size == NULL)
+   if(handle->raw_buffer && handle->own_raw )
    {
-      XRIF_ERROR_PRINT("xrif_read_header", "can not configure a null pointer uint32_t");
-      return XRIF_ERROR_NULLPTR;
+      free(handle->raw_buffer);
    }
+
+   handle->own_raw = 0;
+
+   handle->raw_buffer = raw;
    
-   if( header == NULL)
+   handle->raw_buffer_size = size;
+   
+   if((handle->raw_buffer != NULL && handle->raw_buffer_size == 0) || (handle->raw_buffer == 0 && handle->raw_buffer_size != 0)) 
    {
-      XRIF_ERROR_PRINT("xrif_read_header", "can not read from a null pointer");
-      return XRIF_ERROR_NULLPTR;
+      XRIF_ERROR_PRINT("xrif_set_raw", "the size is not valid");
+      return XRIF_ERROR_INVALID_SIZE;
    }
    
-   if( header[0] != 'x' || header[1] != 'r' || header[2] != 'i' || header[3] != 'f')
+   //Check if we meet minimum size requirement based on compress_on_raw value
+   size_t minSz = xrif_min_raw_size(handle);
+   if(minSz == 0)
    {
-      XRIF_ERROR_PRINT("xrif_read_header", "xrif magic number not present");
-      return XRIF_ERROR_BADHEADER;
+      XRIF_ERROR_PRINT("xrif_set_raw", "error calculating minimum raw buffer size - check configuration.");
+      return XRIF_ERROR_INVALID_SIZE;
    }
    
-   if( *((uint32_t *) &header[4]) > XRIF_VERSION)
+   if(handle->raw_buffer_size < minSz) 
    {
-      XRIF_ERROR_PRINT("xrif_read_header", "xrif version too high");
-      return XRIF_ERROR_WRONGVERSION;
+      XRIF_ERROR_PRINT("xrif_set_raw", "the raw buffer size is too small for configured parameters");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
    }
    
-   *header_size = *((uint32_t *) &header[8]); 
+   return XRIF_NOERROR;
+}
 
-   handle->width = *((uint32_t *) &header[12]);
-   
-   handle->height = *((uint32_t *) &header[16]);
-   
-   handle->depth = *((uint32_t *) &header[20]);
+// Allocate the raw buffer based on the already set stream dimensions.
+xrif_error_t xrif_allocate_raw( xrif_t handle )
+{
+   if( handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_raw", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
    
-   handle->frames = *((uint32_t *) &header[24]);
+   if(handle->width * handle->height * handle->depth * handle->frames * handle->data_size == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_raw", "the handle is not setup for allocation");
+      return XRIF_ERROR_NOT_SETUP;
+   }
    
-   handle->type_code = *((uint16_t *) &header[28]);
-
-   handle->data_size = xrif_typesize(handle->type_code);
+   if(handle->raw_buffer && handle->own_raw )
+   {
+      free(handle->raw_buffer);
+   }
    
-   handle->difference_method = *((int16_t *) &header[30]);
+   handle->raw_buffer_size = xrif_min_raw_size(handle);
+   if(handle->raw_buffer_size == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_raw", "error calculating minimum raw buffer size - check configuration.");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
    
-   handle->reorder_method = *((int16_t *) &header[32]);
-
-   handle->compress_method = *((int16_t *) &header[34]);
-
-   handle->compressed_size = *((uint32_t *) &header[36]);
+   handle->raw_buffer = (char *) malloc( handle->raw_buffer_size );
    
-   if(handle->compress_method == XRIF_COMPRESS_LZ4)
+   if(handle->raw_buffer == NULL) 
    {
-      handle->lz4_acceleration = *((uint16_t *) &header[40]);
+      handle->own_raw = 0;
+      
+      XRIF_ERROR_PRINT("xrif_allocate_raw", "error from malloc");
+      
+      return XRIF_ERROR_MALLOC;
    }
    
+   handle->own_raw = 1;
+   
    return XRIF_NOERROR;
 }
 
-xrif_error_t xrif_encode( xrif_t handle )
+// Set the rordered (working) data buffer to a pre-allocated pointer
+xrif_error_t xrif_set_reordered( xrif_t handle,
+                                 void * reordered,
+                                 size_t size
+                               )
 {
-   if( handle == NULL) 
+   if( handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_encode", "can not use a null pointer");
+      XRIF_ERROR_PRINT("xrif_set_reordered", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   xrif_error_t rv; 
+   if(handle->reordered_buffer && handle->own_reordered )
+   {
+      free(handle->reordered_buffer);
+   }
    
-   clock_gettime(CLOCK_REALTIME, &handle->ts_difference_start);
+   handle->reordered_buffer = reordered;
    
-   if( handle->difference_method == XRIF_DIFFERENCE_NONE && handle->reorder_method == XRIF_REORDER_NONE && handle->compress_method == XRIF_COMPRESS_NONE)
+   handle->reordered_buffer_size = size;
+   
+   handle->own_reordered = 0;
+   
+   if((handle->reordered_buffer != NULL && handle->reordered_buffer_size == 0) || (handle->reordered_buffer == 0 && handle->reordered_buffer_size != 0))
    {
-      //Set compressed size.
-      handle->compressed_size = handle->width * handle->height * handle->depth * handle->frames * handle->data_size;
-
-            
-      if(handle->calc_performance)
-      {
-         //So that we have some non-inifinities in the performance metrics.
-         clock_gettime(CLOCK_REALTIME, &handle->ts_reorder_start);
-         clock_gettime(CLOCK_REALTIME, &handle->ts_compress_start);
-         clock_gettime(CLOCK_REALTIME, &handle->ts_compress_done);
-      }
-      
-      //but otherwise do nothing.
+      XRIF_ERROR_PRINT("xrif_set_reordered", "the size is not valid");
+      return XRIF_ERROR_INVALID_SIZE;
    }
-   else
-   {
-      rv = xrif_difference( handle);
    
-      if( rv != XRIF_NOERROR ) 
-      {
-         XRIF_ERROR_PRINT("xrif_encode", "error in xrif_difference");
-         return rv;
-      }
-      
-      clock_gettime(CLOCK_REALTIME, &handle->ts_reorder_start);
-      
-      rv = xrif_reorder(handle);
-      
-      if( rv != XRIF_NOERROR ) 
-      {
-         XRIF_ERROR_PRINT("xrif_encode", "error in xrif_reorder");
-         return rv;
-      }
-      
-      clock_gettime(CLOCK_REALTIME, &handle->ts_compress_start);
-      
-      rv = xrif_compress(handle);
-      
-      if( rv != XRIF_NOERROR ) 
-      {
-         XRIF_ERROR_PRINT("xrif_encode", "error in xrif_compress");
-         return rv;
-      }
-      
-      clock_gettime(CLOCK_REALTIME, &handle->ts_compress_done);
+   //Check minimum size for reordering algorithms to work.
+   size_t minSz = xrif_min_reordered_size(handle);
+   if(minSz == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_set_reordered", "error calculating minimum reordered buffer size - check configuration.");
+      return XRIF_ERROR_INVALID_SIZE;
    }
    
-   if(handle->calc_performance)
+   if(handle->reordered_buffer_size < minSz)
    {
-      handle->compression_ratio = xrif_compression_ratio(handle);
-      handle->encode_time = xrif_encode_time(handle);
-      handle->encode_rate = xrif_encode_rate(handle);
-      handle->difference_time = xrif_difference_time(handle);
-      handle->difference_rate = xrif_difference_rate(handle);
-      handle->reorder_time = xrif_reorder_time(handle);
-      handle->reorder_rate = xrif_reorder_rate(handle);
-      handle->compress_time = xrif_compress_time(handle);
-      handle->compress_rate = xrif_compress_rate(handle);
+      XRIF_ERROR_PRINT("xrif_set_reordered", "the reordered buffer size is too small for configured parameters");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
    }
    
    return XRIF_NOERROR;
 }
 
-xrif_error_t xrif_decode( xrif_t handle )
+// Allocate the reordered buffer based on the already set stream dimensions.
+xrif_error_t xrif_allocate_reordered( xrif_t handle )
 {
    if( handle == NULL) 
    {
-      XRIF_ERROR_PRINT("xrif_encode", "can not use a null pointer");
+      XRIF_ERROR_PRINT("xrif_allocate_reordered", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   xrif_error_t rv;
-   
-   clock_gettime(CLOCK_REALTIME, &handle->ts_decompress_start);
-   
-   if( handle->difference_method == XRIF_DIFFERENCE_NONE && handle->reorder_method == XRIF_REORDER_NONE && handle->compress_method == XRIF_COMPRESS_NONE)
+   if(handle->width * handle->height * handle->depth * handle->frames * handle->data_size == 0)
    {
-      if(handle->calc_performance)
-      {
-         //So that we have some non-inifinities in the performance metrics.
-         clock_gettime(CLOCK_REALTIME, &handle->ts_unreorder_start);
-         clock_gettime(CLOCK_REALTIME, &handle->ts_undifference_start);
-         clock_gettime(CLOCK_REALTIME, &handle->ts_undifference_done);
-      }
-      
-      //but otherwise do nothing.
+      XRIF_ERROR_PRINT("xrif_allocate_reordered", "the handle is not setup for allocation");
+      return XRIF_ERROR_NOT_SETUP;
    }
-   else
+   
+   if(handle->reordered_buffer && handle->own_reordered)
    {
-      rv = xrif_decompress(handle);
-      
-      if( rv != XRIF_NOERROR ) 
-      {
-         fprintf(stderr, "xrif_decode: error returned by xrif_decompress\n");
-         return rv;
-      }
-      clock_gettime(CLOCK_REALTIME, &handle->ts_unreorder_start);
-      
-      rv = xrif_unreorder(handle);
-      
-      if( rv != XRIF_NOERROR )
-      {
-         fprintf(stderr, "xrif_decode: error returned by xrif_unreorder\n");
-         return rv;
-      }
+      free(handle->reordered_buffer);
+   }
 
-      clock_gettime(CLOCK_REALTIME, &handle->ts_undifference_start);
-         
-      rv = xrif_undifference(handle);
+   handle->reordered_buffer_size = xrif_min_reordered_size(handle);
+   if(handle->reordered_buffer_size == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_reordered", "error calculating minimum reordered buffer size - check configuration.");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   handle->reordered_buffer = (char *) malloc( handle->reordered_buffer_size );
+   
+   if(handle->reordered_buffer == NULL) 
+   {
+      handle->reordered_buffer_size = 0;
+      handle->own_reordered = 0;
       
-      if( rv != XRIF_NOERROR )
-      {
-         fprintf(stderr, "xrif_decode: error returned by xrif_undifference\n");
-         return rv;
-      }
-
-      clock_gettime(CLOCK_REALTIME, &handle->ts_undifference_done);
+      XRIF_ERROR_PRINT("xrif_allocate_reordered", "error from malloc");
+      return XRIF_ERROR_MALLOC;
    }
    
+   handle->own_reordered = 1;
+   
    return XRIF_NOERROR;
 }
 
-xrif_error_t xrif_difference( xrif_t handle )
+xrif_error_t xrif_set_compressed( xrif_t handle, 
+                                  void * compressed,    
+                                  size_t size           
+                                )
 {
+
    if( handle == NULL) 
    {
-      XRIF_ERROR_PRINT("xrif_difference", "can not use a null pointer");
+      XRIF_ERROR_PRINT("xrif_set_compressed", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   int method = handle->difference_method;
+   if(handle->compressed_buffer && handle->own_compressed )
+   {
+      free(handle->compressed_buffer);
+   }
+
+   handle->own_compressed = 0;
+
+   handle->compressed_buffer = compressed;
    
-   if(method == 0) method = XRIF_DIFFERENCE_DEFAULT;
+   handle->compressed_buffer_size = size;
    
-   switch( method )
+   if((handle->compressed_buffer != NULL && handle->compressed_buffer_size == 0) || (handle->compressed_buffer == 0 && handle->compressed_buffer_size != 0)) 
    {
-      case XRIF_DIFFERENCE_NONE:
-         return XRIF_NOERROR;
-      case XRIF_DIFFERENCE_PREVIOUS:
-         return xrif_difference_previous(handle);
-      case XRIF_DIFFERENCE_FIRST:
-         return xrif_difference_first(handle);
-      case XRIF_DIFFERENCE_PIXEL:
-         return xrif_difference_pixel(handle);
-      default:
-         return XRIF_ERROR_NOTIMPL;
+      XRIF_ERROR_PRINT("xrif_set_compressed", "the size is not valid");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   size_t minSz = xrif_min_compressed_size(handle);
+   if(minSz == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_set_compressed", "error calculating minimum compressed buffer size - check configuration.");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   if(handle->compressed_buffer_size < minSz) 
+   {
+      XRIF_ERROR_PRINT("xrif_set_compressed", "the compressed buffer size is too small for configured parameters");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
    }
+   
+   return XRIF_NOERROR;
 }
 
-xrif_error_t xrif_undifference( xrif_t handle )
+xrif_error_t xrif_allocate_compressed( xrif_t handle )
 {
    if( handle == NULL) 
    {
-      XRIF_ERROR_PRINT("xrif_undifference", "can not use a null pointer");
+      XRIF_ERROR_PRINT("xrif_allocate_compressed", "can not configure null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   int method = handle->difference_method;
-   
-   if(method == 0) method = XRIF_DIFFERENCE_DEFAULT;
+   if(handle->compressed_buffer && handle->own_compressed )
+   {
+      free(handle->compressed_buffer);
+   }
+   
+   if(handle->width * handle->height * handle->depth * handle->frames * handle->data_size == 0) 
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_compressed", "the handle is not setup for allocation");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+   
+   handle->compressed_buffer_size = xrif_min_compressed_size(handle);
+   if(handle->compressed_buffer_size == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_compressed", "error calculating minimum compressed buffer size - check configuration.");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+      
+   handle->compressed_buffer = (char *) malloc( handle->compressed_buffer_size );
+   
+   if(handle->compressed_buffer == NULL) 
+   {
+      handle->own_compressed = 0;
+      
+      XRIF_ERROR_PRINT("xrif_allocate_compressed", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   handle->own_compressed = 1;
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_allocate_chain( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_chain", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   size_t chain_size = 3 * handle->width * handle->height * handle->depth * handle->data_size;
+   
+   if(chain_size == 0) 
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_chain", "the handle is not setup for allocation");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+   
+   //Keep the reference frames if the frame size has not changed
+   if(handle->chain_buffer && handle->chain_buffer_size == chain_size)
+   {
+      return XRIF_NOERROR;
+   }
+   
+   if(handle->chain_buffer)
+   {
+      free(handle->chain_buffer);
+   }
+   
+   handle->chain_encode_valid = 0;
+   handle->chain_decode_valid = 0;
+   
+   handle->chain_buffer = (char *) malloc( chain_size );
+   
+   if(handle->chain_buffer == NULL) 
+   {
+      handle->chain_buffer_size = 0;
+      
+      XRIF_ERROR_PRINT("xrif_allocate_chain", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   handle->chain_buffer_size = chain_size;
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_allocate_adaptive( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_adaptive", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   size_t nblocks = xrif_adaptive_blocks(handle);
+   
+   if(nblocks == 0) 
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_adaptive", "the handle is not setup for allocation");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+   
+   if(handle->adaptive_methods && handle->adaptive_methods_size == nblocks)
+   {
+      return XRIF_NOERROR;
+   }
+   
+   if(handle->adaptive_methods)
+   {
+      free(handle->adaptive_methods);
+   }
+   
+   handle->adaptive_methods = (unsigned char *) malloc( nblocks );
+   
+   if(handle->adaptive_methods == NULL) 
+   {
+      handle->adaptive_methods_size = 0;
+      
+      XRIF_ERROR_PRINT("xrif_allocate_adaptive", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   handle->adaptive_methods_size = nblocks;
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_allocate_lz4_state( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_lz4_state", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   int method = handle->compress_method;
+   if(method == 0) method = XRIF_COMPRESS_DEFAULT;
+   
+   if(method != XRIF_COMPRESS_LZ4 && method != XRIF_COMPRESS_LZ4HC) return XRIF_NOERROR;
+   
+   //One state for each thread which can compress blocks, planes, or tiles
+   int nstates = 1;
+   
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   if(handle->omp_parallel > 0 && (handle->compress_block_size > 0 || handle->compress_planes || xrif_tiled(handle))) nstates = omp_get_max_threads();
+   #endif
+   
+   if(handle->lz4_state && handle->lz4_nstates >= nstates && handle->lz4_state_method == method 
+                         && (method == XRIF_COMPRESS_LZ4HC || handle->lz4_state_memory_usage == handle->lz4_memory_usage))
+   {
+      return XRIF_NOERROR;
+   }
+   
+   if(handle->lz4_state)
+   {
+      free(handle->lz4_state);
+   }
+   
+   handle->lz4_state = NULL;
+   handle->lz4_state_size = 0;
+   handle->lz4_nstates = 0;
+   
+   size_t state_size;
+   if(method == XRIF_COMPRESS_LZ4HC) state_size = LZ4_sizeofStateHC();
+   else state_size = xrif_lz4_sizeofState(handle->lz4_memory_usage);
+   
+   //Keep each thread's state on its own cache lines
+   state_size = ((state_size + 63)/64)*64;
+   
+   handle->lz4_state = (char *) malloc( nstates*state_size );
+   
+   if(handle->lz4_state == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_lz4_state", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   //The fast reset requires that each state is fully initialized once
+   for(int n = 0; n < nstates; ++n)
+   {
+      if(method == XRIF_COMPRESS_LZ4HC) LZ4_resetStreamHC( (LZ4_streamHC_t *) (handle->lz4_state + n*state_size), handle->lz4hc_level);
+      else xrif_lz4_resetState(handle->lz4_memory_usage, handle->lz4_state + n*state_size);
+   }
+   
+   handle->lz4_state_size = state_size;
+   handle->lz4_nstates = nstates;
+   handle->lz4_state_method = method;
+   handle->lz4_state_memory_usage = handle->lz4_memory_usage;
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_allocate_lz4_stream( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_allocate_lz4_stream", "can not configure null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(handle->lz4_dict_buffer == NULL)
+   {
+      handle->lz4_dict_buffer = (char *) malloc( 2*XRIF_LZ4_DICT_SIZE );
+      
+      if(handle->lz4_dict_buffer == NULL) 
+      {
+         XRIF_ERROR_PRINT("xrif_allocate_lz4_stream", "error from malloc");
+         return XRIF_ERROR_MALLOC;
+      }
+      
+      handle->lz4_dict_encode_size = 0;
+      handle->lz4_dict_decode_size = 0;
+   }
+   
+   if(handle->lz4_stream_decode == NULL)
+   {
+      handle->lz4_stream_decode = LZ4_createStreamDecode();
+      
+      if(handle->lz4_stream_decode == NULL) 
+      {
+         XRIF_ERROR_PRINT("xrif_allocate_lz4_stream", "error from LZ4_createStreamDecode");
+         return XRIF_ERROR_MALLOC;
+      }
+   }
+   
+   return XRIF_NOERROR;
+}
+
+xrif_dimension_t xrif_width( xrif_t handle )
+{
+   if( handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_width", "can not access a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   return handle->width;
+}   
+
+xrif_dimension_t xrif_height( xrif_t handle )
+{
+   if( handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_height", "can not access a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   return handle->height;
+}
+
+xrif_dimension_t xrif_depth( xrif_t handle )
+{
+   if( handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_depth", "can not access a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   return handle->depth;
+}
+
+xrif_dimension_t xrif_frames( xrif_t handle )
+{
+   if( handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_frames", "can not access a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   return handle->frames;
+}   
+
+// Populate a header buffer with the xrif protocol details.
+xrif_error_t xrif_write_header( char * header,
+                                xrif_t handle 
+                              )
+{
+   if( header == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_write_header", "can not write to a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_write_header", "can not read from a null pointer handle");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   header[0] = 'x';
+   header[1] = 'r';
+   header[2] = 'i';
+   header[3] = 'f';
+   
+   *((uint32_t *) &header[4]) = XRIF_VERSION;
+   
+   *((uint32_t *) &header[8]) = xrif_header_size(handle);
+
+   *((uint32_t *) &header[12]) = handle->width;
+   
+   *((uint32_t *) &header[16]) = handle->height;
+   
+   *((uint32_t *) &header[20]) = handle->depth;
+   
+   *((uint32_t *) &header[24]) = handle->frames;
+   
+   *((uint16_t *) &header[28]) = handle->type_code;
+
+   *((int16_t *) &header[30]) = handle->difference_method;
+   
+   *((int16_t *) &header[32]) = handle->reorder_method;
+
+   *((int16_t *) &header[34]) = handle->compress_method;
+
+   *((uint32_t *) &header[36]) = handle->compressed_size;
+   
+   memset(&header[40], 0, 8);
+   
+   uint16_t flags = 0;
+   if(handle->chained) flags |= XRIF_HEADER_FLAG_CHAINED;
+   if(handle->lz4_chained) flags |= XRIF_HEADER_FLAG_LZ4_CHAINED;
+   if(xrif_compress_by_plane(handle)) flags |= XRIF_HEADER_FLAG_PLANES;
+   if(xrif_tiled(handle)) flags |= XRIF_HEADER_FLAG_TILED;
+   if(xrif_has_keyframe_interval(handle)) flags |= XRIF_HEADER_FLAG_KEYFRAMES;
+   
+   *((uint16_t *) &header[44]) = flags;
+   
+   //A cube with a key frame interval is not chained, so the interval takes the place of the chain index
+   if(xrif_has_keyframe_interval(handle)) *((uint16_t *) &header[46]) = handle->keyframe_interval;
+   else *((uint16_t *) &header[46]) = handle->chain_index;
+   
+   if(handle->compress_method == XRIF_COMPRESS_LZ4)
+   {
+      *((uint16_t *) &header[40]) = handle->lz4_acceleration;
+      if(xrif_tiled(handle)) *((uint16_t *) &header[42]) = handle->tile_size / XRIF_COMPRESS_BLOCK_UNIT;
+      else if(!xrif_compress_by_plane(handle)) *((uint16_t *) &header[42]) = handle->compress_block_size / XRIF_COMPRESS_BLOCK_UNIT;
+   }
+   else if(handle->compress_method == XRIF_COMPRESS_LZ4HC)
+   {
+      *((uint16_t *) &header[40]) = handle->lz4hc_level;
+      if(xrif_tiled(handle)) *((uint16_t *) &header[42]) = handle->tile_size / XRIF_COMPRESS_BLOCK_UNIT;
+      else if(!xrif_compress_by_plane(handle)) *((uint16_t *) &header[42]) = handle->compress_block_size / XRIF_COMPRESS_BLOCK_UNIT;
+   }
+   else if(handle->compress_method == XRIF_COMPRESS_ZSTD)
+   {
+      *((int16_t *) &header[40]) = handle->zstd_level;
+   }
+   
+   //The reference frame is identified by its ID, which follows the fixed part of the header
+   if(handle->difference_method == XRIF_DIFFERENCE_REFERENCE)
+   {
+      memcpy(&header[XRIF_HEADER_SIZE], &handle->reference_id, sizeof(uint64_t));
+   }
+   
+   //The block size and the number of blocks are followed by the method table, padded to a multiple of 8 bytes
+   if(handle->difference_method == XRIF_DIFFERENCE_ADAPTIVE)
+   {
+      uint32_t nblocks = xrif_adaptive_blocks(handle);
+      
+      *((uint16_t *) &header[48]) = handle->adaptive_block_size;
+      *((uint16_t *) &header[50]) = 0;
+      *((uint32_t *) &header[52]) = nblocks;
+      
+      memset(&header[XRIF_HEADER_SIZE_EXT], 0, xrif_header_size(handle) - XRIF_HEADER_SIZE_EXT);
+      
+      if(handle->adaptive_methods && handle->adaptive_methods_size == nblocks)
+      {
+         memcpy(&header[XRIF_HEADER_SIZE_EXT], handle->adaptive_methods, nblocks);
+      }
+   }
+   
+   return XRIF_NOERROR;
+   
+}
+
+//Configure an xrif handle by reading a xrif protocol header
+xrif_error_t xrif_read_header( xrif_t handle,
+                               uint32_t * header_size,
+                               char * header
+                             )
+{
+   if( handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header", "can not configure a null pointer handle");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( header_size == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header", "can not configure a null pointer uint32_t");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( header == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header", "can not read from a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( header[0] != 'x' || header[1] != 'r' || header[2] != 'i' || header[3] != 'f')
+   {
+      XRIF_ERROR_PRINT("xrif_read_header", "xrif magic number not present");
+      return XRIF_ERROR_BADHEADER;
+   }
+   
+   if( *((uint32_t *) &header[4]) > XRIF_VERSION)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header", "xrif version too high");
+      return XRIF_ERROR_WRONGVERSION;
+   }
+   
+   if(*((uint16_t *) &header[44]) & ~XRIF_HEADER_FLAG_MASK)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header", "unknown header flags");
+      return XRIF_ERROR_BADHEADER;
+   }
+   
+   *header_size = *((uint32_t *) &header[8]); 
+
+   handle->width = *((uint32_t *) &header[12]);
+   
+   handle->height = *((uint32_t *) &header[16]);
+   
+   handle->depth = *((uint32_t *) &header[20]);
+   
+   handle->frames = *((uint32_t *) &header[24]);
+   
+   handle->type_code = *((uint16_t *) &header[28]);
+
+   handle->data_size = xrif_typesize(handle->type_code);
+   
+   handle->difference_method = *((int16_t *) &header[30]);
+   
+   handle->reorder_method = *((int16_t *) &header[32]);
+
+   handle->compress_method = *((int16_t *) &header[34]);
+
+   handle->compressed_size = *((uint32_t *) &header[36]);
+   
+   if(handle->compress_method == XRIF_COMPRESS_LZ4)
+   {
+      handle->lz4_acceleration = *((uint16_t *) &header[40]);
+      handle->compress_block_size = ((size_t) *((uint16_t *) &header[42])) * XRIF_COMPRESS_BLOCK_UNIT;
+   }
+   else if(handle->compress_method == XRIF_COMPRESS_LZ4HC)
+   {
+      handle->lz4hc_level = *((uint16_t *) &header[40]);
+      handle->compress_block_size = ((size_t) *((uint16_t *) &header[42])) * XRIF_COMPRESS_BLOCK_UNIT;
+   }
+   else if(handle->compress_method == XRIF_COMPRESS_ZSTD)
+   {
+      handle->zstd_level = *((int16_t *) &header[40]);
+   }
+   
+   handle->chained = ((*((uint16_t *) &header[44]) & XRIF_HEADER_FLAG_CHAINED) != 0);
+   handle->lz4_chained = ((*((uint16_t *) &header[44]) & XRIF_HEADER_FLAG_LZ4_CHAINED) != 0);
+   handle->compress_planes = ((*((uint16_t *) &header[44]) & XRIF_HEADER_FLAG_PLANES) != 0);
+   
+   if(*((uint16_t *) &header[44]) & XRIF_HEADER_FLAG_KEYFRAMES)
+   {
+      handle->keyframe_interval = *((uint16_t *) &header[46]);
+      handle->chain_index = 0;
+   }
+   else
+   {
+      handle->keyframe_interval = 0;
+      handle->chain_index = *((uint16_t *) &header[46]);
+   }
+   
+   //A tiled cube has the tile size in place of the block size
+   if(*((uint16_t *) &header[44]) & XRIF_HEADER_FLAG_TILED)
+   {
+      handle->tile_size = ((size_t) *((uint16_t *) &header[42])) * XRIF_COMPRESS_BLOCK_UNIT;
+      handle->compress_block_size = 0;
+   }
+   else
+   {
+      handle->tile_size = 0;
+   }
+   
+   //The reference ID follows the fixed part of the header, and is read by xrif_read_header_ext
+   handle->reference_id = 0;
+   
+   if(handle->difference_method == XRIF_DIFFERENCE_REFERENCE && *header_size < XRIF_HEADER_SIZE_EXT)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header", "header too short for the reference ID");
+      return XRIF_ERROR_BADHEADER;
+   }
+   
+   //The method table follows the fixed part of the header, and is read by xrif_read_header_ext.  Until then a cube can not be undifferenced.
+   if(handle->adaptive_methods)
+   {
+      free(handle->adaptive_methods);
+      handle->adaptive_methods = NULL;
+      handle->adaptive_methods_size = 0;
+   }
+   
+   if(handle->difference_method == XRIF_DIFFERENCE_ADAPTIVE && *header_size < XRIF_HEADER_SIZE_EXT)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header", "header too short for the adaptive block size");
+      return XRIF_ERROR_BADHEADER;
+   }
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_read_header_ext( xrif_t handle,
+                                   char * header,
+                                   size_t size
+                                 )
+{
+   if(handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header_ext", "can not configure a null pointer handle");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(header == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header_ext", "can not read from a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(size < XRIF_HEADER_SIZE)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header_ext", "buffer too short for the header");
+      return XRIF_ERROR_BADHEADER;
+   }
+   
+   //The whole header, as given in the header itself, must be in the buffer
+   uint32_t header_size = *((uint32_t *) &header[8]);
+   
+   if(header_size > size)
+   {
+      XRIF_ERROR_PRINT("xrif_read_header_ext", "header does not fit in the buffer");
+      return XRIF_ERROR_BADHEADER;
+   }
+   
+   if(handle->difference_method == XRIF_DIFFERENCE_REFERENCE)
+   {
+      if(header_size < XRIF_HEADER_SIZE_EXT)
+      {
+         XRIF_ERROR_PRINT("xrif_read_header_ext", "header too short for the reference ID");
+         return XRIF_ERROR_BADHEADER;
+      }
+      
+      memcpy(&handle->reference_id, &header[XRIF_HEADER_SIZE], sizeof(uint64_t));
+   }
+   
+   if(handle->difference_method == XRIF_DIFFERENCE_ADAPTIVE)
+   {
+      if(header_size < XRIF_HEADER_SIZE_EXT)
+      {
+         XRIF_ERROR_PRINT("xrif_read_header_ext", "header too short for the adaptive block size");
+         return XRIF_ERROR_BADHEADER;
+      }
+      
+      handle->adaptive_block_size = *((uint16_t *) &header[48]);
+      
+      //The number of blocks must match the frame size, and the whole table must be inside the header
+      size_t nblocks = xrif_adaptive_blocks(handle);
+      
+      if(nblocks == 0 || nblocks != *((uint32_t *) &header[52]) || header_size < xrif_header_size(handle))
+      {
+         XRIF_ERROR_PRINT("xrif_read_header_ext", "adaptive method table does not match the header");
+         return XRIF_ERROR_BADHEADER;
+      }
+      
+      xrif_error_t rv = xrif_allocate_adaptive(handle);
+      if(rv != XRIF_NOERROR)
+      {
+         XRIF_ERROR_PRINT("xrif_read_header_ext", "error from xrif_allocate_adaptive");
+         return rv;
+      }
+      
+      memcpy(handle->adaptive_methods, &header[XRIF_HEADER_SIZE_EXT], nblocks);
+      
+      for(size_t b = 0; b < nblocks; ++b)
+      {
+         if(handle->adaptive_methods[b] > XRIF_ADAPTIVE_PIXEL)
+         {
+            XRIF_ERROR_PRINT("xrif_read_header_ext", "invalid method in the adaptive method table");
+            
+            free(handle->adaptive_methods);
+            handle->adaptive_methods = NULL;
+            handle->adaptive_methods_size = 0;
+            
+            return XRIF_ERROR_BADHEADER;
+         }
+      }
+   }
+   
+   return XRIF_NOERROR;
+}
+
+uint32_t xrif_header_size( xrif_t handle )
+{
+   if(handle->difference_method == XRIF_DIFFERENCE_REFERENCE) return XRIF_HEADER_SIZE_EXT;
+   
+   if(handle->difference_method == XRIF_DIFFERENCE_ADAPTIVE) return XRIF_HEADER_SIZE_EXT + ((xrif_adaptive_blocks(handle) + 7)/8)*8;
+   
+   return XRIF_HEADER_SIZE;
+}
+
+xrif_error_t xrif_encode( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_encode", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   xrif_error_t rv; 
+   
+   clock_gettime(CLOCK_REALTIME, &handle->ts_difference_start);
+   
+   //A cube with a key frame interval can not depend on the previous cube, since the header has no room for the chain index
+   if(xrif_has_keyframe_interval(handle) && (handle->chain_cubes || handle->lz4_stream))
+   {
+      XRIF_ERROR_PRINT("xrif_encode", "can not use a key frame interval with cube chaining or LZ4 streaming");
+      return XRIF_ERROR_BADARG;
+   }
+   
+   //Count the cubes since the last keyframe.  The stages decide whether this cube actually depends on the previous one.
+   if(handle->chain_encode_valid && (handle->chain_cubes || handle->lz4_stream)) handle->chain_index = handle->chain_encode_index + 1;
+   else handle->chain_index = 0;
+   
+   handle->chained = 0;
+   handle->lz4_chained = 0;
+   
+   if( handle->difference_method == XRIF_DIFFERENCE_NONE && handle->reorder_method == XRIF_REORDER_NONE && handle->compress_method == XRIF_COMPRESS_NONE)
+   {
+      //Set compressed size.
+      handle->compressed_size = handle->width * handle->height * handle->depth * handle->frames * handle->data_size;
+      
+      //Nothing is kept for the next cube
+      handle->chain_encode_valid = 0;
+
+            
+      if(handle->calc_performance)
+      {
+         //So that we have some non-inifinities in the performance metrics.
+         clock_gettime(CLOCK_REALTIME, &handle->ts_reorder_start);
+         clock_gettime(CLOCK_REALTIME, &handle->ts_compress_start);
+         clock_gettime(CLOCK_REALTIME, &handle->ts_compress_done);
+      }
+      
+      //but otherwise do nothing.
+   }
+   else if(xrif_tiled(handle))
+   {
+      //All three stages are done tile by tile, so the whole time is counted as difference time
+      rv = xrif_encode_tiles(handle);
+      
+      if( rv != XRIF_NOERROR ) 
+      {
+         XRIF_ERROR_PRINT("xrif_encode", "error in xrif_encode_tiles");
+         handle->chain_encode_valid = 0;
+         return rv;
+      }
+      
+      clock_gettime(CLOCK_REALTIME, &handle->ts_reorder_start);
+      clock_gettime(CLOCK_REALTIME, &handle->ts_compress_start);
+      clock_gettime(CLOCK_REALTIME, &handle->ts_compress_done);
+      
+      //The next cube can depend on this one
+      handle->chain_encode_valid = (handle->chain_cubes || handle->lz4_stream);
+      handle->chain_encode_index = handle->chain_index;
+   }
+   else
+   {
+      if(xrif_difference_reorder_supported(handle))
+      {
+         //One pass over the raw buffer, the reorder time is included in the difference time
+         rv = xrif_difference_reorder(handle);
+         
+         if( rv != XRIF_NOERROR ) 
+         {
+            XRIF_ERROR_PRINT("xrif_encode", "error in xrif_difference_reorder");
+            handle->chain_encode_valid = 0;
+            return rv;
+         }
+         
+         clock_gettime(CLOCK_REALTIME, &handle->ts_reorder_start);
+      }
+      else
+      {
+         rv = xrif_difference( handle);
+      
+         if( rv != XRIF_NOERROR ) 
+         {
+            XRIF_ERROR_PRINT("xrif_encode", "error in xrif_difference");
+            handle->chain_encode_valid = 0;
+            return rv;
+         }
+         
+         clock_gettime(CLOCK_REALTIME, &handle->ts_reorder_start);
+         
+         rv = xrif_reorder(handle);
+         
+         if( rv != XRIF_NOERROR ) 
+         {
+            XRIF_ERROR_PRINT("xrif_encode", "error in xrif_reorder");
+            handle->chain_encode_valid = 0;
+            return rv;
+         }
+      }
+      
+      clock_gettime(CLOCK_REALTIME, &handle->ts_compress_start);
+      
+      rv = xrif_compress(handle);
+      
+      if( rv != XRIF_NOERROR ) 
+      {
+         XRIF_ERROR_PRINT("xrif_encode", "error in xrif_compress");
+         handle->chain_encode_valid = 0;
+         return rv;
+      }
+      
+      clock_gettime(CLOCK_REALTIME, &handle->ts_compress_done);
+      
+      //The next cube can depend on this one
+      handle->chain_encode_valid = (handle->chain_cubes || handle->lz4_stream);
+      handle->chain_encode_index = handle->chain_index;
+   }
+   
+   if(handle->calc_performance)
+   {
+      handle->compression_ratio = xrif_compression_ratio(handle);
+      handle->encode_time = xrif_encode_time(handle);
+      handle->encode_rate = xrif_encode_rate(handle);
+      handle->difference_time = xrif_difference_time(handle);
+      handle->difference_rate = xrif_difference_rate(handle);
+      handle->reorder_time = xrif_reorder_time(handle);
+      handle->reorder_rate = xrif_reorder_rate(handle);
+      handle->compress_time = xrif_compress_time(handle);
+      handle->compress_rate = xrif_compress_rate(handle);
+   }
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_decode( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_encode", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   xrif_error_t rv;
+   
+   //A cube which depends on the previous cube can only be decoded right after it.
+   if(handle->chained || handle->lz4_chained)
+   {
+      if( !handle->chain_decode_valid || handle->chain_index != (uint16_t) (handle->chain_decode_index + 1) )
+      {
+         XRIF_ERROR_PRINT("xrif_decode", "the previous cube in the chain has not been decoded");
+         return XRIF_ERROR_NOREFERENCE;
+      }
+   }
+   
+   handle->chain_decode_valid = 0;
+   
+   clock_gettime(CLOCK_REALTIME, &handle->ts_decompress_start);
+   
+   if( handle->difference_method == XRIF_DIFFERENCE_NONE && handle->reorder_method == XRIF_REORDER_NONE && handle->compress_method == XRIF_COMPRESS_NONE)
+   {
+      if(handle->calc_performance)
+      {
+         //So that we have some non-inifinities in the performance metrics.
+         clock_gettime(CLOCK_REALTIME, &handle->ts_unreorder_start);
+         clock_gettime(CLOCK_REALTIME, &handle->ts_undifference_start);
+         clock_gettime(CLOCK_REALTIME, &handle->ts_undifference_done);
+      }
+      
+      //but otherwise do nothing.
+   }
+   else if(xrif_tiled(handle))
+   {
+      //All three stages are done tile by tile, so the whole time is counted as decompression time
+      rv = xrif_decode_tiles(handle);
+      
+      if( rv != XRIF_NOERROR ) 
+      {
+         fprintf(stderr, "xrif_decode: error returned by xrif_decode_tiles\n");
+         return rv;
+      }
+      
+      clock_gettime(CLOCK_REALTIME, &handle->ts_unreorder_start);
+      clock_gettime(CLOCK_REALTIME, &handle->ts_undifference_start);
+      clock_gettime(CLOCK_REALTIME, &handle->ts_undifference_done);
+      
+      //The next cube can depend on this one
+      handle->chain_decode_valid = (handle->chain_cubes || handle->lz4_stream);
+      handle->chain_decode_index = handle->chain_index;
+   }
+   else
+   {
+      rv = xrif_decompress(handle);
+      
+      if( rv != XRIF_NOERROR ) 
+      {
+         fprintf(stderr, "xrif_decode: error returned by xrif_decompress\n");
+         return rv;
+      }
+      clock_gettime(CLOCK_REALTIME, &handle->ts_unreorder_start);
+      
+      rv = xrif_unreorder(handle);
+      
+      if( rv != XRIF_NOERROR )
+      {
+         fprintf(stderr, "xrif_decode: error returned by xrif_unreorder\n");
+         return rv;
+      }
+
+      clock_gettime(CLOCK_REALTIME, &handle->ts_undifference_start);
+         
+      rv = xrif_undifference(handle);
+      
+      if( rv != XRIF_NOERROR )
+      {
+         fprintf(stderr, "xrif_decode: error returned by xrif_undifference\n");
+         return rv;
+      }
+
+      clock_gettime(CLOCK_REALTIME, &handle->ts_undifference_done);
+      
+      //The next cube can depend on this one
+      handle->chain_decode_valid = (handle->chain_cubes || handle->lz4_stream);
+      handle->chain_decode_index = handle->chain_index;
+   }
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_difference( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_difference", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   xrif_error_t rv;
+   
+   int method = handle->difference_method;
+   
+   if(method == 0) method = XRIF_DIFFERENCE_DEFAULT;
+   
+   size_t one_frame = handle->width*handle->height*handle->depth*handle->data_size; //bytes
+   
+   if(handle->chain_cubes)
+   {
+      rv = xrif_allocate_chain(handle);
+      if(rv != XRIF_NOERROR)
+      {
+         XRIF_ERROR_PRINT("xrif_difference", "error from xrif_allocate_chain");
+         return rv;
+      }
+      
+      //Save the last frame before it is differenced, it is the reference for the next cube.
+      memcpy(handle->chain_buffer + one_frame, handle->raw_buffer + (handle->frames-1)*one_frame, one_frame);
+   }
+   
+   switch( method )
+   {
+      case XRIF_DIFFERENCE_NONE:
+         rv = XRIF_NOERROR;
+         break;
+      case XRIF_DIFFERENCE_PREVIOUS:
+         rv = xrif_difference_previous(handle);
+         break;
+      case XRIF_DIFFERENCE_FIRST:
+         rv = xrif_difference_first(handle);
+         break;
+      case XRIF_DIFFERENCE_PIXEL:
+         rv = xrif_difference_pixel(handle);
+         break;
+      case XRIF_DIFFERENCE_MED:
+      case XRIF_DIFFERENCE_PAETH:
+      case XRIF_DIFFERENCE_AVERAGE:
+         rv = xrif_difference_spatial(handle);
+         break;
+      case XRIF_DIFFERENCE_PREVIOUS_MED:
+         rv = xrif_difference_previous_med(handle);
+         break;
+      case XRIF_DIFFERENCE_LINEAR:
+         rv = xrif_difference_linear(handle);
+         break;
+      case XRIF_DIFFERENCE_REFERENCE:
+         rv = xrif_difference_reference(handle);
+         break;
+      case XRIF_DIFFERENCE_ADAPTIVE:
+         rv = xrif_difference_adaptive(handle);
+         break;
+      default:
+         rv = XRIF_ERROR_NOTIMPL;
+   }
+   
+   handle->chained = 0;
+   
+   if(rv != XRIF_NOERROR || !handle->chain_cubes) return rv;
+   
+   //Only the previous and first methods leave the first frame as a reference which can be chained
+   if(handle->chain_encode_valid && (method == XRIF_DIFFERENCE_PREVIOUS || method == XRIF_DIFFERENCE_FIRST))
+   {
+      handle->chained = 1;
+      
+      rv = xrif_difference_chain(handle);
+      if(rv != XRIF_NOERROR)
+      {
+         handle->chained = 0;
+         return rv;
+      }
+   }
+   
+   memcpy(handle->chain_buffer, handle->chain_buffer + one_frame, one_frame);
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_undifference( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_undifference", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   xrif_error_t rv;
+   
+   int method = handle->difference_method;
+   
+   if(method == 0) method = XRIF_DIFFERENCE_DEFAULT;
+   
+   if(handle->chained)
+   {
+      rv = xrif_undifference_chain(handle);
+      if(rv != XRIF_NOERROR)
+      {
+         XRIF_ERROR_PRINT("xrif_undifference", "error from xrif_undifference_chain");
+         return rv;
+      }
+   }
+   
+   switch( method )
+   {
+      case XRIF_DIFFERENCE_NONE:
+         rv = XRIF_NOERROR;
+         break;
+      case XRIF_DIFFERENCE_PREVIOUS:
+         rv = xrif_undifference_previous(handle);
+         break;
+      case XRIF_DIFFERENCE_FIRST:
+         rv = xrif_undifference_first(handle);
+         break;
+      case XRIF_DIFFERENCE_PIXEL:
+         rv = xrif_undifference_pixel(handle);
+         break;
+      case XRIF_DIFFERENCE_MED:
+      case XRIF_DIFFERENCE_PAETH:
+      case XRIF_DIFFERENCE_AVERAGE:
+         rv = xrif_undifference_spatial(handle);
+         break;
+      case XRIF_DIFFERENCE_PREVIOUS_MED:
+         rv = xrif_undifference_previous_med(handle);
+         break;
+      case XRIF_DIFFERENCE_LINEAR:
+         rv = xrif_undifference_linear(handle);
+         break;
+      case XRIF_DIFFERENCE_REFERENCE:
+         rv = xrif_undifference_reference(handle);
+         break;
+      case XRIF_DIFFERENCE_ADAPTIVE:
+         rv = xrif_undifference_adaptive(handle);
+         break;
+      default:
+         rv = XRIF_ERROR_NOTIMPL;
+   }
+   
+   if(rv != XRIF_NOERROR) return rv;
+   
+   //Keep the last frame as the reference for the next cube.
+   if(handle->chain_cubes)
+   {
+      rv = xrif_allocate_chain(handle);
+      if(rv != XRIF_NOERROR)
+      {
+         XRIF_ERROR_PRINT("xrif_undifference", "error from xrif_allocate_chain");
+         return rv;
+      }
+      
+      size_t one_frame = handle->width*handle->height*handle->depth*handle->data_size; //bytes
+      
+      memcpy(handle->chain_buffer + 2*one_frame, handle->raw_buffer + (handle->frames-1)*one_frame, one_frame);
+   }
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_difference_sint16_rgb( xrif_t handle )
+{
+   size_t npix = handle->width*handle->height;
+   
+   for(int n=0; n < handle->frames-1; ++n)
+   {
+      if( (handle->frames - 1 - n) % 3 == 0)
+      {
+         size_t n_stride0 = (handle->frames - 4 - n) * npix;
+         size_t n_stride =  (handle->frames - 1 - n) * npix;
+      
+         for(int ii=0; ii< handle->width; ++ii)
+         {
+            size_t ii_stride = ii*handle->height;
+        
+            for(int jj=0; jj< handle->height; ++jj)
+            {
+               size_t idx0 =  n_stride0  + ii_stride  + jj;
+               size_t idx = n_stride + ii_stride  + jj;
+            
+               ((int16_t *) handle->raw_buffer)[idx] = (((int16_t *)handle->raw_buffer)[idx] - ((int16_t*)handle->raw_buffer)[idx0]);
+            }
+         }
+      }
+      else
+      {
+         size_t n_stride0 = (handle->frames - 2 - n) * npix;
+         size_t n_stride =  (handle->frames - 1 - n) * npix;
+      
+         
+         for(int ii=0; ii< handle->width; ++ii)
+         {
+            size_t ii_stride = ii*handle->height;
+        
+            for(int jj=0; jj< handle->height; ++jj)
+            {
+               size_t idx0 =  n_stride0  + ii_stride  + jj;
+               size_t idx = n_stride + ii_stride  + jj;
+            
+               ((int16_t *) handle->raw_buffer)[idx] = (((int16_t *)handle->raw_buffer)[idx] - ((int16_t*)handle->raw_buffer)[idx0]);
+            }
+         }
+      }
+   }
+   
+   for(int n=0; n < handle->frames-3; ++n)
+   {
+      if( (handle->frames - 1 - n) % 3 == 0) continue;
+      else
+      {
+         size_t n_stride0 = (handle->frames - 4 - n) * npix;
+         size_t n_stride =  (handle->frames - 1 - n) * npix;
+      
+         
+         for(int ii=0; ii< handle->width; ++ii)
+         {
+            size_t ii_stride = ii*handle->height;
+        
+            for(int jj=0; jj< handle->height; ++jj)
+            {
+               size_t idx0 =  n_stride0  + ii_stride  + jj;
+               size_t idx = n_stride + ii_stride  + jj;
+            
+               ((int16_t *) handle->raw_buffer)[idx] = (((int16_t *)handle->raw_buffer)[idx] - ((int16_t*)handle->raw_buffer)[idx0]);
+            }
+         }
+      }
+   }
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_reorder( xrif_t handle )
+{
+   int method = handle->reorder_method;
+   
+   if(method == 0) method = XRIF_REORDER_DEFAULT;
+   
+   switch( method )
+   {
+      case XRIF_REORDER_NONE:
+         return xrif_reorder_none(handle);
+      case XRIF_REORDER_BYTEPACK:
+         return xrif_reorder_bytepack(handle);
+      case XRIF_REORDER_BYTEPACK_RENIBBLE:
+         return xrif_reorder_bytepack_renibble(handle);
+      case XRIF_REORDER_BITPACK:
+         return xrif_reorder_bitpack(handle);
+      default:
+         return XRIF_ERROR_NOTIMPL;
+   }
+}
+
+int xrif_reorder_first_frame( xrif_t handle )
+{
+   return (handle->difference_method == XRIF_DIFFERENCE_PIXEL || xrif_difference_spatial_method(handle->difference_method) || 
+           handle->difference_method == XRIF_DIFFERENCE_PREVIOUS_MED || handle->difference_method == XRIF_DIFFERENCE_REFERENCE || 
+           handle->difference_method == XRIF_DIFFERENCE_ADAPTIVE || handle->chained);
+}
+
+xrif_error_t xrif_unreorder( xrif_t handle )
+{
+   int method = handle->reorder_method;
+   
+   if(method == 0) method = XRIF_REORDER_DEFAULT;
+   
+   switch( method )
+   {
+      case XRIF_REORDER_NONE:
+         return xrif_unreorder_none(handle);
+      case XRIF_REORDER_BYTEPACK:
+         return xrif_unreorder_bytepack(handle);
+      case XRIF_REORDER_BYTEPACK_RENIBBLE:
+         return xrif_unreorder_bytepack_renibble(handle);
+      case XRIF_REORDER_BITPACK:
+         return xrif_unreorder_bitpack(handle); 
+      default:
+         return XRIF_ERROR_NOTIMPL;
+   }
+}
+
+/// Perform no re-ordering, simply copy raw to reordered.
+xrif_error_t xrif_reorder_none( xrif_t handle )
+{
+   size_t npix = handle->width * handle->height * handle->depth * handle->frames; 
+   
+   if( handle == NULL)
+   {
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle->raw_buffer_size < npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   memcpy(handle->reordered_buffer, handle->raw_buffer, npix*handle->data_size);
+   
+   //Zero the rest of the reordered buffer.
+   if(handle->reordered_buffer_size > npix*handle->data_size)
+   {
+      memset(handle->reordered_buffer + npix*handle->data_size, 0, handle->reordered_buffer_size-npix*handle->data_size); 
+   }
+   
+   return XRIF_NOERROR;
+}
+
+//--------------------------------------------------------------------
+//  bytepack reodering
+//--------------------------------------------------------------------
+
+//Dispatch bytepack reordering according to type
+xrif_error_t xrif_reorder_bytepack( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bytepack", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_reorder_bytepack_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   {
+      return xrif_reorder_bytepack_sint32(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_reorder_bytepack_sint64(handle);
+   }
+   else if(xrif_typeisfloat(handle->type_code))
+   {
+      return xrif_reorder_bytepack_shuffle(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bytepack", "bytepack reordering not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+   
+}
+
+//Bytepack reodering for 16 bit ints
+xrif_error_t xrif_reorder_bytepack_sint16( xrif_t handle )
+{
+   size_t one_frame, npix;
+ 
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bytepack_sint16", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+
+   char * raw_buffer = handle->raw_buffer + one_frame ;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+   char * reordered_buffer2 = reordered_buffer + npix;
+
+   ///\todo is this actually necessary, and can this can be just the extra pixels?
+   //Zero the reordered buffer.
+   //memset(handle->reordered_buffer, 0, handle->reordered_buffer_size); 
+   
+   //Set the first part of the reordered buffer to the first frame (always the reference frame)
+   memcpy(handle->reordered_buffer,handle->raw_buffer, one_frame);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      xrif_reorder_bytepack_sint16_kernel( reordered_buffer + pix, reordered_buffer2 + pix, raw_buffer + 2*pix, n, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+
+   return XRIF_NOERROR;
+}
+
+//Bytepack reodering for 32 bit ints
+xrif_error_t xrif_reorder_bytepack_sint32( xrif_t handle )
+{
+   size_t one_frame, npix;
+ 
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bytepack_sint32", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+
+   char * raw_buffer = handle->raw_buffer + one_frame ;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+   
+   //Set the first part of the reordered buffer to the first frame (always the reference frame)
+   memcpy(handle->reordered_buffer,handle->raw_buffer, one_frame);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      //The 4 byte planes are each npix long
+      xrif_reorder_bytepack_sint32_kernel( reordered_buffer + pix, npix, raw_buffer + 4*pix, n, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+
+   return XRIF_NOERROR;
+}
+
+//Bytepack reodering for 64 bit ints
+xrif_error_t xrif_reorder_bytepack_sint64( xrif_t handle )
+{
+   size_t one_frame, npix;
+ 
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bytepack_sint64", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+
+   char * raw_buffer = handle->raw_buffer + one_frame ;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+   
+   //Set the first part of the reordered buffer to the first frame (always the reference frame)
+   memcpy(handle->reordered_buffer,handle->raw_buffer, one_frame);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      //The 8 byte planes are each npix long
+      xrif_reorder_bytepack_sint64_kernel( reordered_buffer + pix, npix, raw_buffer + 8*pix, n, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+
+   return XRIF_NOERROR;
+}
+
+//Bytepack reodering for floating point types, which are split into byte planes without sign folding
+xrif_error_t xrif_reorder_bytepack_shuffle( xrif_t handle )
+{
+   size_t one_frame, npix;
+ 
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bytepack_shuffle", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+
+   size_t nbytes = handle->data_size;
+   char * raw_buffer = handle->raw_buffer + one_frame;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+   
+   //Set the first part of the reordered buffer to the first frame (always the reference frame)
+   memcpy(handle->reordered_buffer,handle->raw_buffer, one_frame);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      xrif_reorder_byteshuffle_kernel( reordered_buffer + pix, npix, raw_buffer + nbytes*pix, n, nbytes, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+
+   return XRIF_NOERROR;
+}
+
+/* Renibble for 32 and 64 bit ints.  Same layout as for 16 bits: the low byte of each sign-magnitude folded pixel goes in the first plane,
+ * then each higher byte is split into two nibble planes of (npix+1)/2 bytes, a pair of pixels sharing a byte in each.  Working on
+ * whole pairs means no two iterations write the same byte.
+ */
+static xrif_error_t xrif_reorder_bytepack_renibble_wide( xrif_t handle )
+{
+   size_t one_frame, npix;
+   
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+   
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < xrif_reordered_size(handle) )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   int nbytes = handle->data_size;
+   size_t halfoff = (npix + 1)/2;
+   size_t used = one_frame + npix + (nbytes-1)*2*halfoff;
+   
+   const char * raw_buffer = handle->raw_buffer + one_frame;
+   unsigned char * reordered_buffer = (unsigned char *) handle->reordered_buffer + one_frame;
+   unsigned char * nibbles = reordered_buffer + npix;
+   
+   memcpy(handle->reordered_buffer, handle->raw_buffer, one_frame);
+   
+   //Zero the unused end so that compression sees the same bytes every time
+   memset(handle->reordered_buffer + used, 0, xrif_reordered_size(handle) - used);
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t q = 0; q < halfoff; ++q)
+   {
+      uint64_t us[2] = {0,0};
+      
+      for(int k = 0; k < 2 && 2*q + k < npix; ++k)
+      {
+         int64_t s;
+         if(nbytes == 4) s = *((const int32_t *) (raw_buffer + (2*q+k)*4));
+         else s = *((const int64_t *) (raw_buffer + (2*q+k)*8));
+         
+         uint64_t sbit = (s < 0);
+         uint64_t mag = sbit ? -((uint64_t) s) : (uint64_t) s;
+         
+         //The most negative value folds to 1, and is restored from that on unreordering
+         us[k] = (mag << 1) | sbit;
+         if(nbytes == 4) us[k] &= 0xFFFFFFFF;
+         
+         reordered_buffer[2*q+k] = (unsigned char) us[k];
+      }
+      
+      for(int j = 1; j < nbytes; ++j)
+      {
+         unsigned char b0 = (unsigned char) (us[0] >> (8*j));
+         unsigned char b1 = (unsigned char) (us[1] >> (8*j));
+         
+         unsigned char * plane = nibbles + (j-1)*2*halfoff;
+         plane[q] = (unsigned char) ((b0 << 4) | (b1 & 15));
+         plane[q + halfoff] = (unsigned char) ((b0 & 240) | (b1 >> 4));
+      }
+   }
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+}
+
+//Dispatch bytepack renibble reordering according to type
+xrif_error_t xrif_reorder_bytepack_renibble( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bytepack_renibble", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_reorder_bytepack_renibble_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32 ||
+              handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_reorder_bytepack_renibble_wide(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bytepack_renibble", "bytepack renibble reordering not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+}
+
+//Renibble reordering for 16 bit ints
+xrif_error_t xrif_reorder_bytepack_renibble_sint16( xrif_t handle )
+{
+   size_t one_frame, npix;
+   
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bytepack_renibble_sint16", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+   
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   //The reordered buffer must be frames+1 big to be sure it can handle odd sizes. 
+   if( handle->reordered_buffer_size < xrif_reordered_size(handle) )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   //The low byte plane is followed by the two nibble planes, each with one byte per pair of pixels
+   size_t halfoff = (npix + 1)/2;
+   size_t used = one_frame + npix + 2*halfoff;
+   
+   const char * raw_buffer = handle->raw_buffer + one_frame;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+   char * nibbles = reordered_buffer + npix;
+   
+   //Set the first part of the reordered buffer to the first frame (always the reference frame)
+   memcpy(handle->reordered_buffer, handle->raw_buffer, one_frame);
+   
+   //Zero the unused end so that compression sees the same bytes every time
+   memset(handle->reordered_buffer + used, 0, xrif_reordered_size(handle) - used);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   //Chunks start on even pixels, so they never share a nibble byte
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      xrif_reorder_bytepack_renibble_sint16_kernel( reordered_buffer + pix, nibbles + pix/2, nibbles + halfoff + pix/2, raw_buffer + 2*pix, n, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+}
+
+//Dispatch bitpack reordering according to type
+xrif_error_t xrif_reorder_bitpack( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bitpack", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_reorder_bitpack_sint16(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bitpack", "bitpack reordering not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+}
+
+//Bitpack reordering for 16 bit ints
+xrif_error_t xrif_reorder_bitpack_sint16( xrif_t handle )
+{
+   size_t one_frame, npix;
+   
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_reorder_bitpack_sint16", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+   
+   //Each of the 16 bit planes is padded to a whole number of bytes
+   size_t stride = (npix + 7)/8;
+   
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < one_frame + 16*stride )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   char * raw_buffer = handle->raw_buffer + one_frame;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+   
+   //Set the first part of the reordered buffer to the first frame (always the reference frame)
+   memcpy(handle->reordered_buffer, handle->raw_buffer, one_frame);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   //Chunks start on whole bytes of the planes, so they never share a byte
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      xrif_reorder_bitpack_sint16_kernel( reordered_buffer + pix/8, stride, raw_buffer + 2*pix, n, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+}
+
+/// Perform no un-re-ordering, simply copy reordered to raw.
+xrif_error_t xrif_unreorder_none( xrif_t handle )
+{
+   size_t npix = handle->width * handle->height * handle->depth * handle->frames; 
+   
+   if( handle == NULL)
+   {
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle->raw_buffer_size < npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   memcpy(handle->raw_buffer, handle->reordered_buffer, npix*handle->data_size);
+   
+   //Zero the rest of the raw buffer.
+   if(handle->raw_buffer_size > npix*handle->data_size)
+   {
+      memset(handle->raw_buffer + npix*handle->data_size, 0, handle->raw_buffer_size-npix*handle->data_size); 
+   }
+   
+   return XRIF_NOERROR;
+}
+
+//--------------------------------------------------------------------
+//  bytepack unreodering
+//--------------------------------------------------------------------
+
+//Dispatch bytepack unreordering according to type
+xrif_error_t xrif_unreorder_bytepack( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bytepack", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_unreorder_bytepack_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   {
+      return xrif_unreorder_bytepack_sint32(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_unreorder_bytepack_sint64(handle);
+   }
+   else if(xrif_typeisfloat(handle->type_code))
+   {
+      return xrif_unreorder_bytepack_shuffle(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bytepack", "bytepack unreordering not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+   
+}
+
+//Unreorder bytepack for signed 16 bit ints
+xrif_error_t xrif_unreorder_bytepack_sint16( xrif_t handle )
+{
+   
+
+   size_t one_frame, npix;
+   
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bytepack_sint16", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+   
+   char * raw_buffer = handle->raw_buffer + one_frame;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+      
+   for(size_t pix=0; pix<one_frame; ++pix)
+   {
+      handle->raw_buffer[pix] = handle->reordered_buffer[pix];
+   }
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      xrif_unreorder_bytepack_sint16_kernel( raw_buffer + 2*pix, reordered_buffer + pix, reordered_buffer + npix + pix, n, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+      
+   return XRIF_NOERROR;
+}
+
+//Unreorder bytepack for signed 32 bit ints
+xrif_error_t xrif_unreorder_bytepack_sint32( xrif_t handle )
+{
+   size_t one_frame, npix;
+   
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bytepack_sint32", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+   
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   char * raw_buffer = handle->raw_buffer + one_frame;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+   
+   memcpy(handle->raw_buffer, handle->reordered_buffer, one_frame);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      xrif_unreorder_bytepack_sint32_kernel( raw_buffer + 4*pix, reordered_buffer + pix, npix, n, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+      
+   return XRIF_NOERROR;
+}
+
+//Unreorder bytepack for signed 64 bit ints
+xrif_error_t xrif_unreorder_bytepack_sint64( xrif_t handle )
+{
+   size_t one_frame, npix;
+   
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bytepack_sint64", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+   
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   char * raw_buffer = handle->raw_buffer + one_frame;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+   
+   memcpy(handle->raw_buffer, handle->reordered_buffer, one_frame);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      xrif_unreorder_bytepack_sint64_kernel( raw_buffer + 8*pix, reordered_buffer + pix, npix, n, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+      
+   return XRIF_NOERROR;
+}
+
+//Unreorder bytepack for floating point types
+xrif_error_t xrif_unreorder_bytepack_shuffle( xrif_t handle )
+{
+   size_t one_frame, npix;
+ 
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bytepack_shuffle", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+
+   size_t nbytes = handle->data_size;
+   char * raw_buffer = handle->raw_buffer + one_frame;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+   
+   memcpy(handle->raw_buffer, handle->reordered_buffer, one_frame);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      xrif_unreorder_byteshuffle_kernel( raw_buffer + nbytes*pix, reordered_buffer + pix, npix, n, nbytes, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+
+   return XRIF_NOERROR;
+}
+
+//Unreorder renibble for 32 and 64 bit ints, see xrif_reorder_bytepack_renibble_wide
+static xrif_error_t xrif_unreorder_bytepack_renibble_wide( xrif_t handle )
+{
+   size_t one_frame, npix;
+   
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+   
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < xrif_reordered_size(handle) )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   int nbytes = handle->data_size;
+   size_t halfoff = (npix + 1)/2;
+   
+   char * raw_buffer = handle->raw_buffer + one_frame;
+   const unsigned char * reordered_buffer = (const unsigned char *) handle->reordered_buffer + one_frame;
+   const unsigned char * nibbles = reordered_buffer + npix;
+   
+   memcpy(handle->raw_buffer, handle->reordered_buffer, one_frame);
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t q = 0; q < halfoff; ++q)
+   {
+      uint64_t us[2] = {0,0};
+      
+      for(int j = 1; j < nbytes; ++j)
+      {
+         const unsigned char * plane = nibbles + (j-1)*2*halfoff;
+         unsigned char A = plane[q];
+         unsigned char B = plane[q + halfoff];
+         
+         us[0] |= ((uint64_t) ((A >> 4) | (B & 240))) << (8*j);
+         us[1] |= ((uint64_t) ((A & 15) | ((B << 4) & 240))) << (8*j);
+      }
+      
+      for(int k = 0; k < 2 && 2*q + k < npix; ++k)
+      {
+         us[k] |= reordered_buffer[2*q+k];
+         
+         uint64_t sbit = us[k] & 1;
+         uint64_t mag = us[k] >> 1;
+         
+         //The most negative value was folded to 0 with the sign bit set
+         if(sbit && mag == 0) mag = (nbytes == 4) ? 0x80000000 : 0x8000000000000000;
+         
+         uint64_t s = sbit ? -mag : mag;
+         
+         if(nbytes == 4) *((int32_t *) (raw_buffer + (2*q+k)*4)) = (int32_t) (uint32_t) s;
+         else *((int64_t *) (raw_buffer + (2*q+k)*8)) = (int64_t) s;
+      }
+   }
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+}
+
+//Dispatch bytepack renibble unreordering according to type
+xrif_error_t xrif_unreorder_bytepack_renibble( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bytepack_renibble", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_unreorder_bytepack_renibble_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32 ||
+              handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_unreorder_bytepack_renibble_wide(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bytepack_renibble", "bytepack renibble unreordering not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+}
+
+//Renibble unreordering for 16 bit ints
+xrif_error_t xrif_unreorder_bytepack_renibble_sint16( xrif_t handle )
+{
+   size_t one_frame, npix;
+   
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bytepack_renibble_sint16", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+   
+   size_t halfoff = (npix + 1)/2;
+   
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < one_frame + npix + 2*halfoff )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   char * raw_buffer = handle->raw_buffer + one_frame;
+   const char * reordered_buffer = handle->reordered_buffer + one_frame;
+   const char * nibbles = reordered_buffer + npix;
+   
+   memcpy(handle->raw_buffer, handle->reordered_buffer, one_frame);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   //Chunks start on even pixels, so they never share a nibble byte
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      xrif_unreorder_bytepack_renibble_sint16_kernel( raw_buffer + 2*pix, reordered_buffer + pix, nibbles + pix/2, nibbles + halfoff + pix/2, n, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+
+   return XRIF_NOERROR;
+}
+
+//Dispatch bitpack unreordering according to type
+xrif_error_t xrif_unreorder_bitpack( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bitpack", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_unreorder_bitpack_sint16(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bitpack", "bitpack unreordering not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+}
+
+//Bitpack unreordering for 16 bit ints
+xrif_error_t xrif_unreorder_bitpack_sint16( xrif_t handle )
+{
+   size_t one_frame, npix;
+   
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_unreorder_bitpack_sint16", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   //If it's pixel or chained, we reorder the first frame too.
+   if(xrif_reorder_first_frame(handle))
+   {
+      one_frame = 0;
+      npix = handle->width * handle->height * handle->depth * handle->frames;
+   }
+   else //Otherwise we don't include the first frame in the re-ordering
+   {
+      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
+      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+   }
+   
+   //Each of the 16 bit planes is padded to a whole number of bytes
+   size_t stride = (npix + 7)/8;
+   
+   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( handle->reordered_buffer_size < one_frame + 16*stride )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   char * raw_buffer = handle->raw_buffer + one_frame;
+   char * reordered_buffer = handle->reordered_buffer + one_frame;
+   
+   memcpy(handle->raw_buffer, handle->reordered_buffer, one_frame);
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   
+   //Chunks start on whole bytes of the planes, so they never share a byte
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      xrif_unreorder_bitpack_sint16_kernel( raw_buffer + 2*pix, reordered_buffer + pix/8, stride, n, simd);
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_compress( xrif_t handle )
+{
+   int method = handle->compress_method;
+   
+   if(method == 0) method = XRIF_COMPRESS_DEFAULT;
+   
+   handle->compress_skipped = 0;
+   
+   //Only xrif_compress_lz4_stream leaves a dictionary for the next cube
+   handle->lz4_chained = 0;
+   if(!handle->lz4_stream || handle->compress_block_size > 0 || xrif_compress_by_plane(handle) || (method != XRIF_COMPRESS_LZ4 && method != XRIF_COMPRESS_LZ4HC))
+   {
+      handle->lz4_dict_encode_size = 0;
+   }
+   
+   if(xrif_compress_by_plane(handle))
+   {
+      return xrif_compress_planes(handle);
+   }
    
    switch( method )
    {
-      case XRIF_DIFFERENCE_NONE:
-         return XRIF_NOERROR;
-      case XRIF_DIFFERENCE_PREVIOUS:
-         return xrif_undifference_previous(handle);
-      case XRIF_DIFFERENCE_FIRST:
-         return xrif_undifference_first(handle);
-      case XRIF_DIFFERENCE_PIXEL:
-         return xrif_undifference_pixel(handle);
+      case XRIF_COMPRESS_NONE:
+         return xrif_compress_none(handle);
+      case XRIF_COMPRESS_LZ4:
+         return xrif_compress_lz4(handle);
+      case XRIF_COMPRESS_LZ4HC:
+         return xrif_compress_lz4hc(handle);
+      case XRIF_COMPRESS_ZSTD:
+         return xrif_compress_zstd(handle);
+      case XRIF_COMPRESS_RANS:
+         return xrif_compress_rans(handle);
       default:
          return XRIF_ERROR_NOTIMPL;
    }
+      
 }
 
-xrif_error_t xrif_difference_sint16_rgb( xrif_t handle )
+xrif_error_t xrif_decompress( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   int method = handle->compress_method;
    
-   for(int n=0; n < handle->frames-1; ++n)
+   if(method == 0) method = XRIF_COMPRESS_DEFAULT;
+   
+   //Only xrif_decompress_lz4_stream keeps a dictionary for the next cube
+   if(!handle->lz4_stream || handle->compress_block_size > 0 || xrif_compress_by_plane(handle) || (method != XRIF_COMPRESS_LZ4 && method != XRIF_COMPRESS_LZ4HC))
    {
-      if( (handle->frames - 1 - n) % 3 == 0)
-      {
-         size_t n_stride0 = (handle->frames - 4 - n) * npix;
-         size_t n_stride =  (handle->frames - 1 - n) * npix;
-      
-         for(int ii=0; ii< handle->width; ++ii)
-         {
-            size_t ii_stride = ii*handle->height;
-        
-            for(int jj=0; jj< handle->height; ++jj)
-            {
-               size_t idx0 =  n_stride0  + ii_stride  + jj;
-               size_t idx = n_stride + ii_stride  + jj;
-            
-               ((int16_t *) handle->raw_buffer)[idx] = (((int16_t *)handle->raw_buffer)[idx] - ((int16_t*)handle->raw_buffer)[idx0]);
-            }
-         }
-      }
-      else
-      {
-         size_t n_stride0 = (handle->frames - 2 - n) * npix;
-         size_t n_stride =  (handle->frames - 1 - n) * npix;
+      handle->lz4_dict_decode_size = 0;
+   }
+   
+   if(xrif_compress_by_plane(handle))
+   {
+      return xrif_decompress_planes(handle);
+   }
+   
+   switch( method )
+   {
+      case XRIF_COMPRESS_NONE:
+         return xrif_decompress_none(handle);
+      case XRIF_COMPRESS_LZ4:
+      case XRIF_COMPRESS_LZ4HC: //LZ4HC produces a standard LZ4 block
+         return xrif_decompress_lz4(handle);
+      case XRIF_COMPRESS_ZSTD:
+         return xrif_decompress_zstd(handle);
+      case XRIF_COMPRESS_RANS:
+         return xrif_decompress_rans(handle);
+      default:
+         fprintf(stderr, "xrif_decompress: unknown compression method (%d)\n", method);
+         return XRIF_ERROR_NOTIMPL;
+   }
       
-         
-         for(int ii=0; ii< handle->width; ++ii)
-         {
-            size_t ii_stride = ii*handle->height;
-        
-            for(int jj=0; jj< handle->height; ++jj)
-            {
-               size_t idx0 =  n_stride0  + ii_stride  + jj;
-               size_t idx = n_stride + ii_stride  + jj;
-            
-               ((int16_t *) handle->raw_buffer)[idx] = (((int16_t *)handle->raw_buffer)[idx] - ((int16_t*)handle->raw_buffer)[idx0]);
-            }
-         }
-      }
+}
+
+///\todo xrif_compress_none needs size checks
+xrif_error_t xrif_compress_none( xrif_t handle )
+{
+   char *compressed_buffer;
+   size_t compressed_size;
+   size_t reordered_size = xrif_reordered_size(handle);
+   
+   if(handle->compress_on_raw) 
+   {
+      compressed_buffer = handle->raw_buffer;
+      compressed_size = handle->raw_buffer_size;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+      compressed_size = handle->compressed_buffer_size;
+   }
+   
+   //Make sure there is enough space
+   if( compressed_size < reordered_size )
+   {
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+
+   //Zero extra pixels
+   if(compressed_size > reordered_size)
+   {
+      ///\todo this can be just the xtra pixels
+      memset(compressed_buffer, 0, compressed_size);
+   }
+   
+   handle->compressed_size = reordered_size;
+   
+   memcpy( compressed_buffer, handle->reordered_buffer, handle->compressed_size);
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_decompress_none( xrif_t handle )
+{
+   char *compressed_buffer;
+   
+   if(handle->compress_on_raw) 
+   {
+      compressed_buffer = handle->raw_buffer;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+   }
+   
+   //The reordered buffer must be big enough to old the compressed data
+   if(handle->reordered_buffer_size < handle->compressed_size) 
+   {
+      fprintf(stderr, "xrif_decompress_none: reordered_buffer is too small (%ld < %ld).\n", handle->reordered_buffer_size, handle->compressed_size);
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   //If the reordered buffer is larger than needed to hold the compressed buffer, set extras to 0
+   if(handle->reordered_buffer_size > handle->compressed_size)
+   {
+      ///\todo this can be just the extra bytes
+      memset(handle->reordered_buffer, 0, handle->reordered_buffer_size);
+   }
+
+   //Now it's just a straight copy from compressed to reordered buffer.
+   memcpy( handle->reordered_buffer, compressed_buffer, handle->compressed_size);
+   
+   return XRIF_NOERROR;
+}
+
+///\todo xrif_compress_lz4 needs size checks
+xrif_error_t xrif_compress_lz4( xrif_t handle )
+{
+   if(handle->compress_block_size > 0)
+   {
+      return xrif_compress_lz4_blocks(handle);
+   }
+   
+   if(handle->lz4_stream)
+   {
+      return xrif_compress_lz4_stream(handle);
+   }
+   
+   xrif_error_t rv = xrif_allocate_lz4_state(handle);
+   if(rv != XRIF_NOERROR)
+   {
+      XRIF_ERROR_PRINT("xrif_compress_lz4", "error from xrif_allocate_lz4_state");
+      return rv;
    }
    
-   for(int n=0; n < handle->frames-3; ++n)
+   char *compressed_buffer;
+   size_t compressed_size;
+   
+   if(handle->compress_on_raw) 
+   {
+      compressed_buffer = handle->raw_buffer;
+      compressed_size = handle->raw_buffer_size;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+      compressed_size = handle->compressed_buffer_size;
+   }
+   
+   //LZ4 only takes ints for sizes
+   int srcSize = xrif_reordered_size(handle); //This tells us how much memory is actually used by the reordering algorithm.
+   
+   handle->compressed_size = xrif_lz4_compress_state( handle, 0, handle->reordered_buffer, compressed_buffer, srcSize, compressed_size);
+   
+   if(handle->compressed_size == 0 )
    {
-      if( (handle->frames - 1 - n) % 3 == 0) continue;
-      else
-      {
-         size_t n_stride0 = (handle->frames - 4 - n) * npix;
-         size_t n_stride =  (handle->frames - 1 - n) * npix;
-      
-         
-         for(int ii=0; ii< handle->width; ++ii)
-         {
-            size_t ii_stride = ii*handle->height;
-        
-            for(int jj=0; jj< handle->height; ++jj)
-            {
-               size_t idx0 =  n_stride0  + ii_stride  + jj;
-               size_t idx = n_stride + ii_stride  + jj;
-            
-               ((int16_t *) handle->raw_buffer)[idx] = (((int16_t *)handle->raw_buffer)[idx] - ((int16_t*)handle->raw_buffer)[idx0]);
-            }
-         }
-      }
+      fprintf(stderr, "xrif_compress_lz4: compression failed.\n");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
    }
+   
+   
    return XRIF_NOERROR;
 }
 
-xrif_error_t xrif_reorder( xrif_t handle )
+xrif_error_t xrif_compress_lz4hc( xrif_t handle )
 {
-   int method = handle->reorder_method;
+   if(handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_compress_lz4hc", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
    
-   if(method == 0) method = XRIF_REORDER_DEFAULT;
+   if(handle->compress_block_size > 0)
+   {
+      return xrif_compress_lz4_blocks(handle);
+   }
    
-   switch( method )
+   if(handle->lz4_stream)
    {
-      case XRIF_REORDER_NONE:
-         return xrif_reorder_none(handle);
-      case XRIF_REORDER_BYTEPACK:
-         return xrif_reorder_bytepack(handle);
-      case XRIF_REORDER_BYTEPACK_RENIBBLE:
-         return xrif_reorder_bytepack_renibble(handle);
-      case XRIF_REORDER_BITPACK:
-         return xrif_reorder_bitpack(handle);
-      default:
-         return XRIF_ERROR_NOTIMPL;
+      return xrif_compress_lz4_stream(handle);
    }
-}
-
-xrif_error_t xrif_unreorder( xrif_t handle )
-{
-   int method = handle->reorder_method;
    
-   if(method == 0) method = XRIF_REORDER_DEFAULT;
+   xrif_error_t rv = xrif_allocate_lz4_state(handle);
+   if(rv != XRIF_NOERROR)
+   {
+      XRIF_ERROR_PRINT("xrif_compress_lz4hc", "error from xrif_allocate_lz4_state");
+      return rv;
+   }
    
-   switch( method )
+   char *compressed_buffer;
+   size_t compressed_size;
+   
+   if(handle->compress_on_raw) 
    {
-      case XRIF_REORDER_NONE:
-         return xrif_unreorder_none(handle);
-      case XRIF_REORDER_BYTEPACK:
-         return xrif_unreorder_bytepack(handle);
-      case XRIF_REORDER_BYTEPACK_RENIBBLE:
-         return xrif_unreorder_bytepack_renibble(handle);
-      case XRIF_REORDER_BITPACK:
-         return xrif_unreorder_bitpack(handle); 
-      default:
-         return XRIF_ERROR_NOTIMPL;
+      compressed_buffer = handle->raw_buffer;
+      compressed_size = handle->raw_buffer_size;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+      compressed_size = handle->compressed_buffer_size;
+   }
+   
+   //LZ4 only takes ints for sizes
+   int srcSize = xrif_reordered_size(handle); //This tells us how much memory is actually used by the reordering algorithm.
+   
+   handle->compressed_size = xrif_lz4_compress_state( handle, 0, handle->reordered_buffer, compressed_buffer, srcSize, compressed_size);
+   
+   if(handle->compressed_size == 0 )
+   {
+      XRIF_ERROR_PRINT("xrif_compress_lz4hc", "compression failed");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
    }
+   
+   return XRIF_NOERROR;
 }
 
-/// Perform no re-ordering, simply copy raw to reordered.
-xrif_error_t xrif_reorder_none( xrif_t handle )
+xrif_error_t xrif_decompress_lz4( xrif_t handle )
 {
-   size_t npix = handle->width * handle->height * handle->depth * handle->frames; 
-   
-   if( handle == NULL)
+   if(handle == NULL)
    {
+      XRIF_ERROR_PRINT("xrif_decompress_lz4", "can not use a null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   if( handle->raw_buffer_size < npix*handle->data_size )
+   if(handle->compress_block_size > 0)
    {
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      return xrif_decompress_lz4_blocks(handle);
    }
    
-   if( handle->reordered_buffer_size < npix*handle->data_size )
+   if(handle->lz4_stream || handle->lz4_chained)
    {
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      return xrif_decompress_lz4_stream(handle);
    }
    
-   memcpy(handle->reordered_buffer, handle->raw_buffer, npix*handle->data_size);
+   char *compressed_buffer;
    
-   //Zero the rest of the reordered buffer.
-   if(handle->reordered_buffer_size > npix*handle->data_size)
+   if(handle->compress_on_raw) 
    {
-      memset(handle->reordered_buffer + npix*handle->data_size, 0, handle->reordered_buffer_size-npix*handle->data_size); 
+      compressed_buffer = handle->raw_buffer;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+   }
+   
+   int size_decomp = LZ4_decompress_safe (compressed_buffer, handle->reordered_buffer, handle->compressed_size, handle->reordered_buffer_size);
+
+   if(size_decomp < 0)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_lz4", "error in LZ4_decompress_safe");
+      return (XRIF_ERROR_LIBERR + size_decomp);
+   }
+   
+   //Make sure we have the correct amount of data
+   if(xrif_reordered_size(handle) != size_decomp) 
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_lz4", "size mismatch after decompression.");
+      return XRIF_ERROR_INVALID_SIZE;
    }
    
    return XRIF_NOERROR;
 }
 
 //--------------------------------------------------------------------
-//  bytepack reodering
+//  Zstandard compression
 //--------------------------------------------------------------------
 
-//Dispatch bytepack reordering according to type
-xrif_error_t xrif_reorder_bytepack( xrif_t handle )
+xrif_error_t xrif_compress_zstd( xrif_t handle )
 {
-   if( handle == NULL) 
+   if(handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_reorder_bytepack", "can not use a null pointer");
+      XRIF_ERROR_PRINT("xrif_compress_zstd", "can not use a null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   #ifdef XRIF_USE_ZSTD
+   if(handle->zstd_cctx == NULL)
    {
-      return xrif_reorder_bytepack_sint16(handle);
+      handle->zstd_cctx = ZSTD_createCCtx();
+      if(handle->zstd_cctx == NULL)
+      {
+         XRIF_ERROR_PRINT("xrif_compress_zstd", "error from ZSTD_createCCtx");
+         return XRIF_ERROR_MALLOC;
+      }
    }
-   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   
+   ZSTD_CCtx * cctx = (ZSTD_CCtx *) handle->zstd_cctx;
+   
+   char *compressed_buffer;
+   size_t compressed_size;
+   
+   if(handle->compress_on_raw) 
    {
-      XRIF_ERROR_PRINT("xrif_reorder_bytepack", "bytepack reordering not implemented for 32 bit ints");
-      return XRIF_ERROR_NOTIMPL;
+      compressed_buffer = handle->raw_buffer;
+      compressed_size = handle->raw_buffer_size;
    }
-   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   else 
    {
-      XRIF_ERROR_PRINT("xrif_reorder_bytepack", "bytepack reordering not implemented for 64 bit ints");
-      return XRIF_ERROR_NOTIMPL;
+      compressed_buffer = handle->compressed_buffer;
+      compressed_size = handle->compressed_buffer_size;
    }
-   else
+   
+   size_t srcSize = xrif_reordered_size(handle);
+   
+   size_t zrv = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, handle->zstd_level);
+   if(ZSTD_isError(zrv))
    {
-      XRIF_ERROR_PRINT("xrif_reorder_bytepack", "bytepack reordering not implemented for type");
-      return XRIF_ERROR_NOTIMPL;
+      XRIF_ERROR_PRINT("xrif_compress_zstd", ZSTD_getErrorName(zrv));
+      return XRIF_ERROR_LIBERR;
+   }
+   
+   //This fails if libzstd was built without multithreading, in which case compression is done in this thread.
+   ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, handle->zstd_workers);
+   
+   zrv = ZSTD_compress2(cctx, compressed_buffer, compressed_size, handle->reordered_buffer, srcSize);
+   
+   if(ZSTD_isError(zrv))
+   {
+      handle->compressed_size = 0;
+      XRIF_ERROR_PRINT("xrif_compress_zstd", ZSTD_getErrorName(zrv));
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
    }
    
+   handle->compressed_size = zrv;
+   
+   return XRIF_NOERROR;
+   #else
+   XRIF_ERROR_PRINT("xrif_compress_zstd", "xrif was built without zstd");
+   return XRIF_ERROR_NOTIMPL;
+   #endif
 }
 
-//Bytepack reodering for 16 bit ints
-xrif_error_t xrif_reorder_bytepack_sint16( xrif_t handle )
+xrif_error_t xrif_decompress_zstd( xrif_t handle )
 {
-   size_t one_frame, npix;
- 
-   if( handle == NULL) 
+   if(handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_reorder_bytepack_sint16", "can not use a null pointer");
+      XRIF_ERROR_PRINT("xrif_decompress_zstd", "can not use a null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   //If it's pixel, we reorder the first frame too.
-   if(handle->difference_method == XRIF_DIFFERENCE_PIXEL)
+   #ifdef XRIF_USE_ZSTD
+   if(handle->zstd_dctx == NULL)
    {
-      one_frame = 0;
-      npix = handle->width * handle->height * handle->depth * handle->frames;
+      handle->zstd_dctx = ZSTD_createDCtx();
+      if(handle->zstd_dctx == NULL)
+      {
+         XRIF_ERROR_PRINT("xrif_decompress_zstd", "error from ZSTD_createDCtx");
+         return XRIF_ERROR_MALLOC;
+      }
    }
-   else //Otherwise we don't include the first frame in the re-ordering
+   
+   char *compressed_buffer;
+   
+   if(handle->compress_on_raw) 
    {
-      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
-      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+      compressed_buffer = handle->raw_buffer;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+   }
+   
+   size_t size_decomp = ZSTD_decompressDCtx( (ZSTD_DCtx *) handle->zstd_dctx, handle->reordered_buffer, handle->reordered_buffer_size, compressed_buffer, handle->compressed_size);
+   
+   if(ZSTD_isError(size_decomp))
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_zstd", ZSTD_getErrorName(size_decomp));
+      return XRIF_ERROR_LIBERR;
    }
+   
+   //Make sure we have the correct amount of data
+   if(xrif_reordered_size(handle) != size_decomp) 
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_zstd", "size mismatch after decompression.");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   return XRIF_NOERROR;
+   #else
+   XRIF_ERROR_PRINT("xrif_decompress_zstd", "xrif was built without zstd");
+   return XRIF_ERROR_NOTIMPL;
+   #endif
+}
 
-   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+//--------------------------------------------------------------------
+//  LZ4 compression with preallocated states
+//--------------------------------------------------------------------
+
+int xrif_lz4_sizeofState( int lz4_memory_usage )
+{
+   switch(lz4_memory_usage)
+   {
+      case 12:
+         return xrif_lz4_sizeofState_12();
+      case 16:
+         return xrif_lz4_sizeofState_16();
+      case 18:
+         return xrif_lz4_sizeofState_18();
+      case 20:
+         return xrif_lz4_sizeofState_20();
+      default:
+         return xrif_lz4_sizeofState_14();
+   }
+}
+
+void xrif_lz4_resetState( int lz4_memory_usage,
+                          void * state
+                        )
+{
+   switch(lz4_memory_usage)
+   {
+      case 12:
+         xrif_lz4_resetState_12(state);
+         return;
+      case 16:
+         xrif_lz4_resetState_16(state);
+         return;
+      case 18:
+         xrif_lz4_resetState_18(state);
+         return;
+      case 20:
+         xrif_lz4_resetState_20(state);
+         return;
+      default:
+         xrif_lz4_resetState_14(state);
+         return;
+   }
+}
+
+int xrif_lz4_compress_state( xrif_t handle,
+                             int thread,
+                             const char * src,
+                             char * dst,
+                             int srcSize,
+                             int dstCapacity
+                           )
+{
+   int method = handle->compress_method;
+   if(method == 0) method = XRIF_COMPRESS_DEFAULT;
+   
+   //If the states do not match the configuration, use the stateless functions.
+   if(handle->lz4_state == NULL || thread < 0 || thread >= handle->lz4_nstates || handle->lz4_state_method != method 
+                                || (method == XRIF_COMPRESS_LZ4 && handle->lz4_state_memory_usage != handle->lz4_memory_usage))
    {
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      if(method == XRIF_COMPRESS_LZ4HC) return LZ4_compress_HC( src, dst, srcSize, dstCapacity, handle->lz4hc_level);
+      else return LZ4_compress_fast( src, dst, srcSize, dstCapacity, handle->lz4_acceleration);
    }
    
-   if( handle->reordered_buffer_size < one_frame + npix*handle->data_size )
+   char * state = handle->lz4_state + thread*handle->lz4_state_size;
+   
+   if(method == XRIF_COMPRESS_LZ4HC)
    {
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      return LZ4_compress_HC_extStateHC_fastReset( state, src, dst, srcSize, dstCapacity, handle->lz4hc_level);
    }
+   
+   switch(handle->lz4_memory_usage)
+   {
+      case 12:
+         return xrif_lz4_compress_fastReset_12( state, src, dst, srcSize, dstCapacity, handle->lz4_acceleration);
+      case 16:
+         return xrif_lz4_compress_fastReset_16( state, src, dst, srcSize, dstCapacity, handle->lz4_acceleration);
+      case 18:
+         return xrif_lz4_compress_fastReset_18( state, src, dst, srcSize, dstCapacity, handle->lz4_acceleration);
+      case 20:
+         return xrif_lz4_compress_fastReset_20( state, src, dst, srcSize, dstCapacity, handle->lz4_acceleration);
+      default:
+         return xrif_lz4_compress_fastReset_14( state, src, dst, srcSize, dstCapacity, handle->lz4_acceleration);
+   }
+}
 
-   char * raw_buffer = handle->raw_buffer + one_frame ;
-   char * reordered_buffer = handle->reordered_buffer + one_frame;
-   char * reordered_buffer2 = reordered_buffer + npix;
+//--------------------------------------------------------------------
+//  LZ4 streaming compression
+//--------------------------------------------------------------------
 
-   ///\todo is this actually necessary, and can this can be just the extra pixels?
-   //Zero the reordered buffer.
-   //memset(handle->reordered_buffer, 0, handle->reordered_buffer_size); 
+xrif_error_t xrif_compress_lz4_stream( xrif_t handle )
+{
+   if(handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_compress_lz4_stream", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
    
-   //Set the first part of the reordered buffer to the first frame (always the reference frame)
-   memcpy(handle->reordered_buffer,handle->raw_buffer, one_frame);
+   int hc = (handle->compress_method == XRIF_COMPRESS_LZ4HC);
    
-   #ifndef XRIF_NO_OMP
-   #pragma omp parallel if (handle->omp_parallel > 0) 
+   xrif_error_t rv = xrif_allocate_lz4_stream(handle);
+   if(rv != XRIF_NOERROR)
    {
-   #pragma omp for
-   #endif
-   for(size_t pix = 0; pix < npix; ++pix)
+      XRIF_ERROR_PRINT("xrif_compress_lz4_stream", "error from xrif_allocate_lz4_stream");
+      return rv;
+   }
+   
+   if(hc && handle->lz4hc_stream_encode == NULL)
+   {
+      handle->lz4hc_stream_encode = LZ4_createStreamHC();
+      if(handle->lz4hc_stream_encode == NULL)
+      {
+         XRIF_ERROR_PRINT("xrif_compress_lz4_stream", "error from LZ4_createStreamHC");
+         return XRIF_ERROR_MALLOC;
+      }
+   }
+   else if(!hc && handle->lz4_stream_encode == NULL)
    {
-      //Note: a lookup table for this was found to be 2x slower than the following algorithm.
-      int_fast8_t x2 = raw_buffer[2*pix];
-      int_fast8_t x1 = raw_buffer[2*pix+1];
-
-      if(x2 < 0)
+      handle->lz4_stream_encode = LZ4_createStream();
+      if(handle->lz4_stream_encode == NULL)
       {
-         if(x1 == -1)  x1 = 0;
-         else if(x1 == 0) x1 = -1;
+         XRIF_ERROR_PRINT("xrif_compress_lz4_stream", "error from LZ4_createStream");
+         return XRIF_ERROR_MALLOC;
       }
-         
-      reordered_buffer[pix] = x2; 
-      reordered_buffer2[pix] = x1;
-      
-      
    }
    
-   #ifndef XRIF_NO_OMP
+   char *compressed_buffer;
+   size_t compressed_size;
+   
+   if(handle->compress_on_raw) 
+   {
+      compressed_buffer = handle->raw_buffer;
+      compressed_size = handle->raw_buffer_size;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+      compressed_size = handle->compressed_buffer_size;
    }
-   #endif
-
-   return XRIF_NOERROR;
-}
-
-xrif_error_t xrif_reorder_bytepack_renibble( xrif_t handle )
-{
-   //The lookup table, a static array
-   #include "bitshift_and_nibbles.inc"
    
-   size_t one_frame, npix;
+   //LZ4 only takes ints for sizes
+   int srcSize = xrif_reordered_size(handle); //This tells us how much memory is actually used by the reordering algorithm.
    
-   if(handle->difference_method == XRIF_DIFFERENCE_PIXEL)
+   //Continue from the previous cube if it left a dictionary in this context, otherwise start over.
+   if(handle->chain_encode_valid && handle->lz4_dict_encode_size > 0 && handle->lz4_dict_encode_method == handle->compress_method)
    {
-      one_frame = 0;
-      npix = handle->width * handle->height * handle->depth * handle->frames;
+      handle->lz4_chained = 1;
    }
    else
    {
-      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
-      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+      handle->lz4_chained = 0;
+      
+      if(hc) LZ4_resetStreamHC(handle->lz4hc_stream_encode, handle->lz4hc_level);
+      else LZ4_resetStream(handle->lz4_stream_encode);
    }
    
+   //The dictionary is invalid until it is saved below
+   handle->lz4_dict_encode_size = 0;
    
-   if( handle->raw_buffer_size < one_frame + npix*handle->data_size )
+   if(hc)
    {
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      LZ4_setCompressionLevel(handle->lz4hc_stream_encode, handle->lz4hc_level);
+      
+      handle->compressed_size = LZ4_compress_HC_continue( handle->lz4hc_stream_encode, handle->reordered_buffer, compressed_buffer, srcSize, compressed_size);
    }
-   
-   //The reordered buffer must be frames+1 big to be sure it can handle odd sizes. 
-   if( handle->reordered_buffer_size < xrif_min_reordered_size(handle) )
+   else
    {
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      handle->compressed_size = LZ4_compress_fast_continue( handle->lz4_stream_encode, handle->reordered_buffer, compressed_buffer, srcSize, compressed_size, handle->lz4_acceleration);
    }
-   //Zero the reordered buffer.
-   memset(handle->reordered_buffer,0, xrif_min_reordered_size(handle));
-   
-   int16_t * raw_buffer = (int16_t*)(handle->raw_buffer + one_frame);
    
-   //Get pointer that starts one image into the handle->reordered_buffer.  This area is 2*npix bytes long
-   unsigned char * reordered_buffer = (unsigned char *) handle->reordered_buffer + one_frame;
-   
-   //Get point that starts halfway through, splitting at npix bytes
-   unsigned char * reordered_buffer2 = (unsigned char*) reordered_buffer + npix; 
-   
-   //Set the first part of the reordered buffer to the first frame (always the reference frame)
-   /*for(size_t pix=0; pix< one_frame; ++pix)
+   if(handle->compressed_size == 0 )
    {
-      handle->reordered_buffer[pix] = handle->raw_buffer[pix];
-   }*/
-   memcpy(handle->reordered_buffer, handle->raw_buffer, one_frame);
+      XRIF_ERROR_PRINT("xrif_compress_lz4_stream", "compression failed");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
    
-   //Corrections necessary to handle odd numbers
-   size_t halfoff = ((double) npix)/2.0 + 0.5;
-   size_t oneoff = 0;
-   if(halfoff > npix/2) oneoff = 0;
+   //Save the end of the reordered data, since the reordered buffer will be overwritten by the next cube.
+   if(hc) handle->lz4_dict_encode_size = LZ4_saveDictHC(handle->lz4hc_stream_encode, handle->lz4_dict_buffer, XRIF_LZ4_DICT_SIZE);
+   else handle->lz4_dict_encode_size = LZ4_saveDict(handle->lz4_stream_encode, handle->lz4_dict_buffer, XRIF_LZ4_DICT_SIZE);
    
-   #ifndef XRIF_NO_OMP
-   #pragma omp parallel if (handle->omp_parallel > 0) 
-   {
-   #pragma omp for
-   #endif
-   for(size_t pix = 0; pix < npix; ++pix)
-   {
-      /* This block of commented code is left in to document the algorithm implemented in the lookup table.
-       * And maybe we'll implement some defines to avoid lookup tables . . .
-       */
-      
-      /*
-      int_fast16_t s = raw_buffer[pix]; //Get the first 2 bytes
-      int_fast16_t sbit = (s < 0); //and the signbit
-
-      s *= (1-2*sbit); //make it positive
-      
-      uint16_t us = ( (s) << 1) | sbit; //This moves the sign bit
-       
-      reordered_buffer[pix] = ((char *)(&us))[0]; //store first byte, which includes the sign bit?
-
-      // Note: A pre-calculated table look-up for just nibble values produced slightly slower code.
-      uint16_t nib1, nib2;
-      
-      if(pix % 2 == 0)
-      {
-         nib1 = ((unsigned char *)(&us))[1] << 4; //Move low 4 to high 4
-         nib2 = ((unsigned char *)(&us))[1] & 240; //Select the high 4
-      }
-      else
-      {
-         nib1 = (((unsigned char *)(&us))[1] & 15); //Select the low 4
-         nib2 = ((unsigned char *)(&us))[1] >> 4; //Move the high 4 to the low 4
-      }
-      
-      reordered_buffer2[pix/2] |= nib1;
-      reordered_buffer2[pix/2 + oneoff + halfoff] |= nib2;
-      */
-      /*
-      Here we use a lookup table calculated according to the above algorithm:
-      */
-
-      const unsigned char * bsn = &bitshift_and_nibbles[ ((uint16_t) raw_buffer[pix]) * 6 + (pix&1)*3];
-      reordered_buffer[pix] = (char) bsn[0];
-      reordered_buffer2[pix/2] += bsn[1];
-      reordered_buffer2[pix/2 + oneoff + halfoff] += bsn[2];
-
-   }
-   #ifndef XRIF_NO_OMP
-   }
-   #endif
+   handle->lz4_dict_encode_method = handle->compress_method;
    
    return XRIF_NOERROR;
 }
 
-///\todo xrif_reorder_bitpack needs a size check
-xrif_error_t xrif_reorder_bitpack( xrif_t handle )
+xrif_error_t xrif_decompress_lz4_stream( xrif_t handle )
 {
-   //The lookup tables (static arrays)
-   #include "bit_to_position.inc"
-   #include "set_bits.inc"
-   
-   size_t one_frame, npix;
-   
-   //If it's pixel, we reorder the first frame too.
-   if(handle->difference_method == XRIF_DIFFERENCE_PIXEL)
+   if(handle == NULL)
    {
-      one_frame = 0;
-      npix = handle->width * handle->height * handle->depth * handle->frames;
+      XRIF_ERROR_PRINT("xrif_decompress_lz4_stream", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
    }
-   else //Otherwise we don't include the first frame in the re-ordering
+   
+   char *compressed_buffer;
+   
+   if(handle->compress_on_raw) 
    {
-      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
-      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+      compressed_buffer = handle->raw_buffer;
    }
-   
-   for(size_t pix=0; pix < one_frame; ++pix)
+   else 
    {
-      handle->reordered_buffer[pix] = handle->raw_buffer[pix];
+      compressed_buffer = handle->compressed_buffer;
    }
    
-   int16_t * raw_buffer = (int16_t *) (handle->raw_buffer + one_frame);
-   uint16_t * reordered_buffer = (uint16_t *) (handle->reordered_buffer + one_frame);
-   
-   memset( (char *) reordered_buffer, 0, handle->reordered_buffer_size - one_frame);
-
-   size_t stride = (handle->reordered_buffer_size - one_frame)/16/2; //stride in 16-bit pixels, not bytes
+   int size_decomp;
    
-   #ifndef XRIF_NO_OMP
-   #pragma omp parallel if (handle->omp_parallel > 0) 
-   {
-   #pragma omp for
-   #endif
-      
-  
-   for(size_t pix = 0; pix<npix; ++pix)
+   if(handle->lz4_chained)
    {
-      size_t sbyte = pix/16; //This is the starting byte for this pixel
-      int_fast8_t bit = pix % 16; //This is the bit position for this pixel
-     
-      
-      //--- Reordering sign bit [left in to document]
-      //int16_t s = raw_buffer[pix];
-      //int8_t sbit = (s < 0);
-      //s *= (1-2*sbit); //make positive
-      //uint16_t us = ( (s) << 1) | sbit; //shift by 1, putting sign bit in highest entropy spot
-      
-      //--- Simpler way to reorder, this is equivalent to above
-      int8_t sbit = (raw_buffer[pix] < 0);
-      uint16_t us = 2*raw_buffer[pix]*(1-2*sbit)+sbit;
-     
-
-      //---- This is the basic algorithm, without lookup tables:
-      /*
-      for(int b=0; b < 16; ++b)
+      if(handle->lz4_dict_buffer == NULL || handle->lz4_stream_decode == NULL || handle->lz4_dict_decode_size == 0)
       {
-         reordered_buffer[sbyte + b*stride] += (((us >> b) & 1) << bit);
-      }
-      */
-      
-      //---- A full lookup table version
-      //Attempt with lookup table is slower, leaving this in to document this, possibly for future defines:
-      //uint16_t us = left_shift_one[*((uint16_t *) &raw_buffer[pix])];
-
-      //---- A faster lookup table version:
-      size_t sbyte8 = sbyte + 8*stride;
-      size_t st0 = ((unsigned char *) &us)[0]*16*8 + bit*8;
-      size_t st1 = ((unsigned char *) &us)[1]*16*8 + bit*8;
-      
-      for(int_fast8_t b = 0; b < 8; ++b)
-      {  
-         reordered_buffer[sbyte +  b*stride] += bit_to_position[st0 + b] ;
-      }
-      if(((unsigned char *) &us)[1] == 0) continue;
-      
-      //Get the number of set bits, and for this second byte we only process those bits.
-      unsigned char nbits2 = set_bits[((unsigned char *) &us)[1]*9];
-      const unsigned char* bits2 = &set_bits[((unsigned char *) &us)[1]*9 + 1];
-      for(int_fast8_t b = 0; b < nbits2; ++b)
-      {      
-         reordered_buffer[sbyte8 +  bits2[b]*stride] +=  bit_to_position[st1 + bits2[b]];
+         XRIF_ERROR_PRINT("xrif_decompress_lz4_stream", "no dictionary from the previous cube");
+         return XRIF_ERROR_NOREFERENCE;
       }
       
+      LZ4_setStreamDecode(handle->lz4_stream_decode, handle->lz4_dict_buffer + XRIF_LZ4_DICT_SIZE, handle->lz4_dict_decode_size);
       
-      
-   }
-   #ifndef XRIF_NO_OMP
+      size_decomp = LZ4_decompress_safe_continue(handle->lz4_stream_decode, compressed_buffer, handle->reordered_buffer, handle->compressed_size, handle->reordered_buffer_size);
    }
-   #endif
-   
-   return XRIF_NOERROR;
-}
-      
-
-/// Perform no un-re-ordering, simply copy reordered to raw.
-xrif_error_t xrif_unreorder_none( xrif_t handle )
-{
-   size_t npix = handle->width * handle->height * handle->depth * handle->frames; 
-   
-   if( handle == NULL)
+   else
    {
-      return XRIF_ERROR_NULLPTR;
+      size_decomp = LZ4_decompress_safe(compressed_buffer, handle->reordered_buffer, handle->compressed_size, handle->reordered_buffer_size);
    }
    
-   if( handle->raw_buffer_size < npix*handle->data_size )
+   //The dictionary is invalid until it is saved below
+   handle->lz4_dict_decode_size = 0;
+   
+   if(size_decomp < 0)
    {
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      XRIF_ERROR_PRINT("xrif_decompress_lz4_stream", "error in LZ4_decompress_safe");
+      return (XRIF_ERROR_LIBERR + size_decomp);
    }
    
-   if( handle->reordered_buffer_size < npix*handle->data_size )
+   //Make sure we have the correct amount of data
+   if(xrif_reordered_size(handle) != size_decomp) 
    {
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      XRIF_ERROR_PRINT("xrif_decompress_lz4_stream", "size mismatch after decompression.");
+      return XRIF_ERROR_INVALID_SIZE;
    }
    
-   memcpy(handle->raw_buffer, handle->reordered_buffer, npix*handle->data_size);
-   
-   //Zero the rest of the raw buffer.
-   if(handle->raw_buffer_size > npix*handle->data_size)
+   //Keep the end of the reordered data as the dictionary for the next cube.
+   if(handle->lz4_stream)
    {
-      memset(handle->raw_buffer + npix*handle->data_size, 0, handle->raw_buffer_size-npix*handle->data_size); 
+      xrif_error_t rv = xrif_allocate_lz4_stream(handle);
+      if(rv != XRIF_NOERROR)
+      {
+         XRIF_ERROR_PRINT("xrif_decompress_lz4_stream", "error from xrif_allocate_lz4_stream");
+         return rv;
+      }
+      
+      int dict_size = size_decomp;
+      if(dict_size > XRIF_LZ4_DICT_SIZE) dict_size = XRIF_LZ4_DICT_SIZE;
+      
+      memcpy(handle->lz4_dict_buffer + XRIF_LZ4_DICT_SIZE, handle->reordered_buffer + size_decomp - dict_size, dict_size);
+      handle->lz4_dict_decode_size = dict_size;
    }
    
    return XRIF_NOERROR;
 }
 
 //--------------------------------------------------------------------
-//  bytepack unreodering
+//  Incompressibility detection
 //--------------------------------------------------------------------
 
-//Dispatch bytepack unreordering according to type
-xrif_error_t xrif_unreorder_bytepack( xrif_t handle )
+double xrif_sample_entropy( const char * src,
+                            size_t len
+                          )
 {
-   if( handle == NULL) 
-   {
-      XRIF_ERROR_PRINT("xrif_unreorder_bytepack", "can not use a null pointer");
-      return XRIF_ERROR_NULLPTR;
-   }
+   if(src == NULL || len == 0) return 0;
    
-   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
-   {
-      return xrif_unreorder_bytepack_sint16(handle);
-   }
-   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   uint32_t hist[256];
+   memset(hist, 0, sizeof(hist));
+   
+   size_t nsamp = 0;
+   
+   if(len <= XRIF_SKIP_ENTROPY_SAMPLES)
    {
-      XRIF_ERROR_PRINT("xrif_unreorder_bytepack", "bytepack unreordering not implemented for 32 bit ints");
-      return XRIF_ERROR_NOTIMPL;
+      for(size_t i = 0; i < len; ++i) ++hist[(unsigned char) src[i]];
+      nsamp = len;
    }
-   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   else
    {
-      XRIF_ERROR_PRINT("xrif_unreorder_bytepack", "bytepack unreordering not implemented for 64 bit ints");
-      return XRIF_ERROR_NOTIMPL;
+      //Sample runs of consecutive bytes, so that the stride can't alias with the element size of interleaved data
+      size_t nruns = XRIF_SKIP_ENTROPY_SAMPLES / XRIF_SKIP_ENTROPY_RUN;
+      size_t stride = len / nruns;
+      
+      for(size_t r = 0; r < nruns; ++r)
+      {
+         const unsigned char * run = (const unsigned char *) src + r*stride;
+         for(size_t i = 0; i < XRIF_SKIP_ENTROPY_RUN; ++i) ++hist[run[i]];
+      }
+      
+      nsamp = nruns*XRIF_SKIP_ENTROPY_RUN;
    }
-   else
+   
+   double entropy = 0;
+   for(int s = 0; s < 256; ++s)
    {
-      XRIF_ERROR_PRINT("xrif_unreorder_bytepack", "bytepack unreordering not implemented for type");
-      return XRIF_ERROR_NOTIMPL;
+      if(hist[s] == 0) continue;
+      
+      double p = ((double) hist[s]) / nsamp;
+      entropy -= p * log2(p);
    }
    
+   return entropy;
 }
 
-//Unreorder bytepack for signed 16 bit ints
-xrif_error_t xrif_unreorder_bytepack_sint16( xrif_t handle )
+//Decide whether to store a block or plane as is without trying to compress it
+static int xrif_skip_compress( xrif_t handle,
+                               const char * src,
+                               size_t len
+                             )
 {
+   if(handle->skip_entropy <= 0) return 0;
    
+   return (xrif_sample_entropy(src, len) >= handle->skip_entropy);
+}
 
-   size_t one_frame, npix;
+//--------------------------------------------------------------------
+//  LZ4 block compression
+//--------------------------------------------------------------------
+
+size_t xrif_compress_nblocks( xrif_t handle )
+{
+   if(handle == NULL) return 0;
    
-   if( handle == NULL) 
+   if(handle->compress_block_size == 0) return 1;
+   
+   size_t srcSize = xrif_reordered_size(handle);
+   
+   return (srcSize + handle->compress_block_size - 1) / handle->compress_block_size;
+}
+
+xrif_error_t xrif_compress_lz4_blocks( xrif_t handle )
+{
+   if(handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_unreorder_bytepack_sint16", "can not use a null pointer");
+      XRIF_ERROR_PRINT("xrif_compress_lz4_blocks", "can not use a null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
-   //If it's pixel, we reorder the first frame too.
-   if(handle->difference_method == XRIF_DIFFERENCE_PIXEL)
-   {
-      one_frame = 0;
-      npix = handle->width * handle->height * handle->depth * handle->frames;
-   }
-   else //Otherwise we don't include the first frame in the re-ordering
-   {
-      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
-      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
-   }
+   char *compressed_buffer;
+   size_t compressed_size;
    
-   char * raw_buffer = handle->raw_buffer + one_frame;
-   char * reordered_buffer = handle->reordered_buffer + one_frame;
-      
-   for(size_t pix=0; pix<one_frame; ++pix)
+   if(handle->compress_on_raw) 
    {
-      handle->raw_buffer[pix] = handle->reordered_buffer[pix];
+      compressed_buffer = handle->raw_buffer;
+      compressed_size = handle->raw_buffer_size;
    }
-   
-   #ifndef XRIF_NO_OMP
-   #pragma omp parallel if (handle->omp_parallel > 0) 
-   {
-   #pragma omp for
-   #endif
-   for(size_t pix = 0; pix < npix; ++pix)
+   else 
    {
-      int_fast8_t x2 = reordered_buffer[pix]; 
-      int_fast8_t x1 = reordered_buffer[npix+pix];
-         
-      if(x2 < 0)
-      {
-         if(x1 == -1) x1 = 0;
-         else if(x1 == 0) x1 = -1;
-      }
-         
-      raw_buffer[2*pix] = x2;
-      raw_buffer[2*pix+1] = x1;
-         
+      compressed_buffer = handle->compressed_buffer;
+      compressed_size = handle->compressed_buffer_size;
    }
    
-   #ifndef XRIF_NO_OMP
-   }
-   #endif
-      
-   return XRIF_NOERROR;
-}
-
-xrif_error_t xrif_unreorder_bytepack_renibble( xrif_t handle )
-{
-   size_t one_frame, npix;
+   size_t srcSize = xrif_reordered_size(handle); 
+   size_t block_size = handle->compress_block_size;
+   size_t nblocks = xrif_compress_nblocks(handle);
+   size_t table_size = XRIF_BLOCK_TABLE_SIZE(nblocks);
    
-   //If it's pixel, we reorder the first frame too.
-   if(handle->difference_method == XRIF_DIFFERENCE_PIXEL)
-   {
-      one_frame = 0;
-      npix = handle->width * handle->height * handle->depth * handle->frames;
-   }
-   else //Otherwise we don't include the first frame in the re-ordering
+   //Each block is first compressed into a worst-case sized slot so the blocks are independent
+   int bound = LZ4_compressBound(block_size);
+   
+   if(nblocks == 0 || compressed_size < table_size + nblocks*bound)
    {
-      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
-      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+      XRIF_ERROR_PRINT("xrif_compress_lz4_blocks", "compressed buffer is too small");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
    }
    
-   int16_t * raw_buffer = (int16_t*)(handle->raw_buffer + one_frame);
-   unsigned char * reordered_buffer = (unsigned char *) handle->reordered_buffer + one_frame;
-   unsigned char * reordered_buffer2 = (unsigned char*) reordered_buffer + npix;
+   uint32_t * table = (uint32_t *) compressed_buffer;
+   char * blocks = compressed_buffer + table_size;
    
-   for(size_t pix=0; pix<one_frame; ++pix)
+   table[0] = nblocks;
+   
+   xrif_error_t rv = xrif_allocate_lz4_state(handle);
+   if(rv != XRIF_NOERROR)
    {
-      handle->raw_buffer[pix] = handle->reordered_buffer[pix];
+      XRIF_ERROR_PRINT("xrif_compress_lz4_blocks", "error from xrif_allocate_lz4_state");
+      return rv;
    }
    
-   size_t halfoff = ((double) npix)/2 + 0.5;
-   size_t oneoff = 0;
-   if(halfoff > npix/2) oneoff = 0;
+   int nskipped = 0;
    
    #ifndef XRIF_NO_OMP
    #pragma omp parallel if (handle->omp_parallel > 0) 
    {
-   #pragma omp for
+   #pragma omp for schedule(dynamic) reduction(+:nskipped)
    #endif
-   for(size_t pix = 0; pix < npix; ++pix)
+   for(size_t k = 0; k < nblocks; ++k)
    {
-      uint16_t byte1 = 0;
-      byte1 = reordered_buffer[pix];
+      size_t off = k*block_size;
+      int len = (off + block_size <= srcSize) ? block_size : srcSize - off;
       
-      uint16_t nib1 =0;
-      uint16_t nib2 = 0;
-      if(pix % 2 == 0)
-      {
-         nib1 |= ((reordered_buffer2[pix/2+oneoff])) >> 4;  
-         nib2 |= reordered_buffer2[pix/2+oneoff + halfoff] & 240; 
-      }
-      else
-      {
-         nib1 |= reordered_buffer2[pix/2] & 15;
-         nib2 |= (reordered_buffer2[pix/2 + oneoff + halfoff] & 15) << 4;
-      }
-      
-      byte1 |= (nib1 << 8);
-      byte1 |= (nib2 << 8);
+      int thread = 0;
+      #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+      thread = omp_get_thread_num();
+      #endif
       
+      int csize = 0;
       
-      unsigned int sbit = (byte1 & 1);
-
-      unsigned int s = (byte1 >> 1);
-      
+      if(xrif_skip_compress(handle, handle->reordered_buffer + off, len)) ++nskipped;
+      else 
+      {
+         //Limiting the output to less than the block lets LZ4 give up as soon as the block can't shrink
+         csize = xrif_lz4_compress_state( handle, thread, handle->reordered_buffer + off, blocks + k*bound, len, len - 1);
+      }
       
-      if(sbit == 1 && s == 0) 
+      if(csize > 0)
       {
-         raw_buffer[pix] = -32768;
+         table[1+k] = csize;
       }
       else
       {
-         raw_buffer[pix] = s*(1-2*sbit);
+         //Store the block as is
+         memcpy(blocks + k*bound, handle->reordered_buffer + off, len);
+         table[1+k] = len | XRIF_BLOCK_RAW;
       }
    }
-   
    #ifndef XRIF_NO_OMP
    }
    #endif
-
+   
+   handle->compress_skipped = nskipped;
+   
+   //Now pack the blocks down so they are contiguous.  Each block starts at or before its slot, so this never overwrites uncopied data.
+   size_t pos = table_size + (table[1] & ~XRIF_BLOCK_RAW);
+   for(size_t k = 1; k < nblocks; ++k)
+   {
+      size_t csize = table[1+k] & ~XRIF_BLOCK_RAW;
+      memmove(compressed_buffer + pos, blocks + k*bound, csize);
+      pos += csize;
+   }
+   
+   handle->compressed_size = pos;
+   
    return XRIF_NOERROR;
 }
 
-xrif_error_t xrif_unreorder_bitpack( xrif_t handle )
+xrif_error_t xrif_decompress_lz4_blocks( xrif_t handle )
 {
-   size_t one_frame, npix;
+   if(handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_lz4_blocks", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
    
-   //If it's pixel, we reorder the first frame too.
-   if(handle->difference_method == XRIF_DIFFERENCE_PIXEL)
+   char *compressed_buffer;
+   
+   if(handle->compress_on_raw) 
    {
-      one_frame = 0;
-      npix = handle->width * handle->height * handle->depth * handle->frames;
+      compressed_buffer = handle->raw_buffer;
    }
-   else //Otherwise we don't include the first frame in the re-ordering
+   else 
    {
-      one_frame = handle->width*handle->height* handle->depth *handle->data_size; //bytes
-      npix = handle->width * handle->height * handle->depth * (handle->frames-1); //pixels not bytes
+      compressed_buffer = handle->compressed_buffer;
    }
    
-   for(size_t pix=0; pix< one_frame; ++pix)
+   size_t dstSize = xrif_reordered_size(handle); 
+   size_t block_size = handle->compress_block_size;
+   size_t nblocks = xrif_compress_nblocks(handle);
+   size_t table_size = XRIF_BLOCK_TABLE_SIZE(nblocks);
+   
+   if(handle->reordered_buffer_size < dstSize)
    {
-      handle->raw_buffer[pix] = handle->reordered_buffer[pix];
+      XRIF_ERROR_PRINT("xrif_decompress_lz4_blocks", "reordered buffer is too small");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   uint32_t * table = (uint32_t *) compressed_buffer;
+   
+   if(nblocks == 0 || handle->compressed_size < table_size || table[0] != nblocks)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_lz4_blocks", "block table does not match configuration");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   //Find the start of each block
+   size_t * offsets = (size_t *) malloc(nblocks*sizeof(size_t));
+   if(offsets == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_lz4_blocks", "error from malloc");
+      return XRIF_ERROR_MALLOC;
    }
    
-   int16_t * raw_buffer = (int16_t *) (handle->raw_buffer + one_frame);
-   uint16_t * reordered_buffer = (uint16_t *) (handle->reordered_buffer + one_frame);
+   size_t pos = table_size;
+   for(size_t k = 0; k < nblocks; ++k)
+   {
+      offsets[k] = pos;
+      pos += table[1+k] & ~XRIF_BLOCK_RAW;
+   }
    
-   memset(raw_buffer, 0, npix*2);
+   if(pos != handle->compressed_size)
+   {
+      free(offsets);
+      XRIF_ERROR_PRINT("xrif_decompress_lz4_blocks", "block table does not match compressed size");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
    
-   //size_t stride = npix/16;
-   size_t stride = (handle->reordered_buffer_size - one_frame)/16/2;
-   //printf("strides: %ld %ld\n", npix/16, stride);
+   int nfail = 0;
    
    #ifndef XRIF_NO_OMP
    #pragma omp parallel if (handle->omp_parallel > 0) 
    {
-   #pragma omp for
+   #pragma omp for schedule(dynamic) reduction(+:nfail)
    #endif
-   for(size_t pix = 0; pix<npix; ++pix)
+   for(size_t k = 0; k < nblocks; ++k)
    {
+      size_t off = k*block_size;
+      int len = (off + block_size <= dstSize) ? block_size : dstSize - off;
       
-      size_t sbyte = pix/16;
-      size_t bit = pix % 16;
-
-      char sbit = (reordered_buffer[sbyte] >> bit) & 1;
-      
-      for(int_fast8_t b=1; b<16;++b)
-      {
-         raw_buffer[pix] |= ((reordered_buffer[sbyte +  b*stride] >> bit) & 1) << (b-1);
-      }
-      
-      //Check if sign change needed
-      if(sbit == 1)
+      if(table[1+k] & XRIF_BLOCK_RAW)
       {
-         //Check for -0, which is actually -32768
-         if(raw_buffer[pix] == 0) raw_buffer[pix] = -32768;
-         else raw_buffer[pix] *= -1;
+         if((int) (table[1+k] & ~XRIF_BLOCK_RAW) != len) ++nfail;
+         else memcpy(handle->reordered_buffer + off, compressed_buffer + offsets[k], len);
+         
+         continue;
       }
       
+      int size_decomp = LZ4_decompress_safe( compressed_buffer + offsets[k], handle->reordered_buffer + off, table[1+k], len);
       
+      if(size_decomp != len) ++nfail;
    }
-   
    #ifndef XRIF_NO_OMP
    }
    #endif
-
+   
+   free(offsets);
+   
+   if(nfail > 0)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_lz4_blocks", "size mismatch after decompression.");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
    return XRIF_NOERROR;
 }
 
+//--------------------------------------------------------------------
+//  Per-plane compression
+//--------------------------------------------------------------------
 
-
-xrif_error_t xrif_compress( xrif_t handle )
+int xrif_compress_by_plane( xrif_t handle )
 {
-   int method = handle->compress_method;
+   if(handle == NULL) return 0;
+   
+   if(!handle->compress_planes) return 0;
    
+   //Tiles are compressed whole
+   if(xrif_tiled(handle)) return 0;
+   
+   int method = handle->compress_method;
    if(method == 0) method = XRIF_COMPRESS_DEFAULT;
    
-   switch( method )
-   {
-      case XRIF_COMPRESS_NONE:
-         return xrif_compress_none(handle);
-      case XRIF_COMPRESS_LZ4:
-         return xrif_compress_lz4(handle);
-      default:
-         return XRIF_ERROR_NOTIMPL;
-   }
-      
+   return (method == XRIF_COMPRESS_LZ4 || method == XRIF_COMPRESS_LZ4HC || method == XRIF_COMPRESS_ZSTD);
 }
 
-xrif_error_t xrif_decompress( xrif_t handle )
+size_t xrif_compress_nplanes( xrif_t handle )
 {
-   int method = handle->compress_method;
+   if(handle == NULL) return 0;
    
-   if(method == 0) method = XRIF_COMPRESS_DEFAULT;
+   if(handle->reorder_method != XRIF_REORDER_BYTEPACK) return 1;
    
-   switch( method )
-   {
-      case XRIF_COMPRESS_NONE:
-         return xrif_decompress_none(handle);
-      case XRIF_COMPRESS_LZ4:
-         return xrif_decompress_lz4(handle);
-      default:
-         fprintf(stderr, "xrif_decompress: unknown compression method (%d)\n", method);
-         return XRIF_ERROR_NOTIMPL;
-   }
-      
+   //The bytepack planes, plus the first frame if it is stored verbatim
+   return handle->data_size + (xrif_reorder_first_frame(handle) ? 0 : 1);
 }
 
-///\todo xrif_compress_none needs size checks
-xrif_error_t xrif_compress_none( xrif_t handle )
+size_t xrif_compress_plane_sizes( xrif_t handle,
+                                  size_t * plane_sizes
+                                )
 {
-   char *compressed_buffer;
-   size_t compressed_size;
+   size_t nplanes = xrif_compress_nplanes(handle);
    
-   if(handle->compress_on_raw) 
+   if(nplanes == 1)
    {
-      compressed_buffer = handle->raw_buffer;
-      compressed_size = handle->raw_buffer_size;
+      plane_sizes[0] = xrif_reordered_size(handle);
+      return 1;
    }
-   else 
+   
+   size_t npix = handle->width * handle->height * handle->depth * handle->frames;
+   
+   size_t n = 0;
+   if(!xrif_reorder_first_frame(handle))
    {
-      compressed_buffer = handle->compressed_buffer;
-      compressed_size = handle->compressed_buffer_size;
+      plane_sizes[n++] = handle->width * handle->height * handle->depth * handle->data_size;
+      npix -= handle->width * handle->height * handle->depth;
    }
    
-   //Make sure there is enough space
-   if( compressed_size < handle->reordered_buffer_size )
+   for(size_t b = 0; b < handle->data_size; ++b)
    {
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      plane_sizes[n++] = npix;
    }
+   
+   return n;
+}
 
-   //Zero extra pixels
-   if(compressed_size > handle->reordered_buffer_size)
+//Trial compress one plane.  The output is limited to less than the plane size, so LZ4 gives up as soon as the plane can't shrink.  Returns 0 if it did not.
+static size_t xrif_compress_plane( xrif_t handle,
+                                   int method,
+                                   int thread,
+                                   char * dst,
+                                   const char * src,
+                                   size_t srcSize
+                                 )
+{
+   if(srcSize < 2) return 0;
+   
+   if(method == XRIF_COMPRESS_ZSTD)
    {
-      ///\todo this can be just the xtra pixels
-      memset(compressed_buffer, 0, compressed_size);
+      #ifdef XRIF_USE_ZSTD
+      size_t zrv = ZSTD_compress2( (ZSTD_CCtx *) handle->zstd_cctx, dst, srcSize - 1, src, srcSize);
+      if(ZSTD_isError(zrv)) return 0;
+      return zrv;
+      #else
+      return 0;
+      #endif
    }
    
-   handle->compressed_size = handle->reordered_buffer_size;
-   
-   memcpy( compressed_buffer, handle->reordered_buffer, handle->compressed_size);
+   int csize = xrif_lz4_compress_state( handle, thread, src, dst, srcSize, srcSize - 1);
+   if(csize <= 0) return 0;
    
-   return XRIF_NOERROR;
+   return csize;
 }
 
-xrif_error_t xrif_decompress_none( xrif_t handle )
+xrif_error_t xrif_compress_planes( xrif_t handle )
 {
+   if(handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_compress_planes", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   int method = handle->compress_method;
+   if(method == 0) method = XRIF_COMPRESS_DEFAULT;
+   
    char *compressed_buffer;
+   size_t compressed_size;
    
    if(handle->compress_on_raw) 
    {
       compressed_buffer = handle->raw_buffer;
+      compressed_size = handle->raw_buffer_size;
    }
    else 
    {
       compressed_buffer = handle->compressed_buffer;
+      compressed_size = handle->compressed_buffer_size;
    }
    
-   //The reordered buffer must be big enough to old the compressed data
-   if(handle->reordered_buffer_size < handle->compressed_size) 
+   size_t plane_sizes[XRIF_COMPRESS_PLANES_MAX];
+   size_t nplanes = xrif_compress_plane_sizes(handle, plane_sizes);
+   
+   size_t table_size = XRIF_BLOCK_TABLE_SIZE(3*nplanes);
+   
+   if(compressed_size < table_size + xrif_reordered_size(handle))
    {
-      fprintf(stderr, "xrif_decompress_none: reordered_buffer is too small (%ld < %ld).\n", handle->reordered_buffer_size, handle->compressed_size);
+      XRIF_ERROR_PRINT("xrif_compress_planes", "compressed buffer is too small");
       return XRIF_ERROR_INSUFFICIENT_SIZE;
    }
    
-   //If the reordered buffer is larger than needed to hold the compressed buffer, set extras to 0
-   if(handle->reordered_buffer_size > handle->compressed_size)
+   if(method == XRIF_COMPRESS_ZSTD)
    {
-      ///\todo this can be just the extra bytes
-      memset(handle->reordered_buffer, 0, handle->reordered_buffer_size);
+      #ifdef XRIF_USE_ZSTD
+      if(handle->zstd_cctx == NULL)
+      {
+         handle->zstd_cctx = ZSTD_createCCtx();
+         if(handle->zstd_cctx == NULL)
+         {
+            XRIF_ERROR_PRINT("xrif_compress_planes", "error from ZSTD_createCCtx");
+            return XRIF_ERROR_MALLOC;
+         }
+      }
+      
+      size_t zrv = ZSTD_CCtx_setParameter( (ZSTD_CCtx *) handle->zstd_cctx, ZSTD_c_compressionLevel, handle->zstd_level);
+      if(ZSTD_isError(zrv))
+      {
+         XRIF_ERROR_PRINT("xrif_compress_planes", ZSTD_getErrorName(zrv));
+         return XRIF_ERROR_LIBERR;
+      }
+      
+      ZSTD_CCtx_setParameter( (ZSTD_CCtx *) handle->zstd_cctx, ZSTD_c_nbWorkers, handle->zstd_workers);
+      #else
+      XRIF_ERROR_PRINT("xrif_compress_planes", "xrif was built without zstd");
+      return XRIF_ERROR_NOTIMPL;
+      #endif
+   }
+   else
+   {
+      xrif_error_t rv = xrif_allocate_lz4_state(handle);
+      if(rv != XRIF_NOERROR)
+      {
+         XRIF_ERROR_PRINT("xrif_compress_planes", "error from xrif_allocate_lz4_state");
+         return rv;
+      }
    }
-
-   //Now it's just a straight copy from compressed to reordered buffer.
-   memcpy( handle->reordered_buffer, compressed_buffer, handle->compressed_size);
    
-   return XRIF_NOERROR;
-}
-
-///\todo xrif_compress_lz4 needs size checks
-xrif_error_t xrif_compress_lz4( xrif_t handle )
-{
-   char *compressed_buffer;
-   size_t compressed_size;
+   //The table holds the number of planes, then the raw size, record size, and method of each plane
+   uint32_t * table = (uint32_t *) compressed_buffer;
    
-   if(handle->compress_on_raw) 
+   table[0] = nplanes;
+   
+   //Each plane is first compressed into a slot the size of the plane, so the planes are independent
+   size_t offs[XRIF_COMPRESS_PLANES_MAX];
+   
+   size_t off = 0;
+   for(size_t k = 0; k < nplanes; ++k)
    {
-      compressed_buffer = handle->raw_buffer;
-      compressed_size = handle->raw_buffer_size;
+      offs[k] = off;
+      off += plane_sizes[k];
    }
-   else 
+   
+   int nskipped = 0;
+   
+   //The zstd context is shared, so zstd planes are compressed in this thread
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0 && method != XRIF_COMPRESS_ZSTD) 
    {
-      compressed_buffer = handle->compressed_buffer;
-      compressed_size = handle->compressed_buffer_size;
+   #pragma omp for schedule(dynamic) reduction(+:nskipped)
+   #endif
+   for(size_t k = 0; k < nplanes; ++k)
+   {
+      int thread = 0;
+      #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+      thread = omp_get_thread_num();
+      #endif
+      
+      char * slot = compressed_buffer + table_size + offs[k];
+      const char * src = handle->reordered_buffer + offs[k];
+      
+      size_t csize = 0;
+      
+      if(xrif_skip_compress(handle, src, plane_sizes[k])) ++nskipped;
+      else csize = xrif_compress_plane(handle, method, thread, slot, src, plane_sizes[k]);
+      
+      if(csize > 0)
+      {
+         table[2 + 3*k] = csize;
+         table[3 + 3*k] = method;
+      }
+      else
+      {
+         //Store the plane as is
+         memcpy(slot, src, plane_sizes[k]);
+         table[2 + 3*k] = plane_sizes[k];
+         table[3 + 3*k] = (uint32_t) XRIF_COMPRESS_NONE;
+      }
+      
+      table[1 + 3*k] = plane_sizes[k];
    }
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
-   //LZ4 only takes ints for sizes
-   int srcSize = xrif_min_reordered_size(handle); //This tells us how much memory is actually used by the reordering algorithm.
-   
-   handle->compressed_size = LZ4_compress_fast ( handle->reordered_buffer, compressed_buffer, srcSize, compressed_size, handle->lz4_acceleration);
+   handle->compress_skipped = nskipped;
    
-   if(handle->compressed_size == 0 )
+   //Now pack the records down so they are contiguous.  Each record starts at or before its slot, so this never overwrites uncopied data.
+   size_t pos = table_size + table[2];
+   for(size_t k = 1; k < nplanes; ++k)
    {
-      fprintf(stderr, "xrif_compress_lz4: compression failed.\n");
-      return XRIF_ERROR_INSUFFICIENT_SIZE;
+      memmove(compressed_buffer + pos, compressed_buffer + table_size + offs[k], table[2 + 3*k]);
+      pos += table[2 + 3*k];
    }
    
+   handle->compressed_size = pos;
    
    return XRIF_NOERROR;
 }
 
-xrif_error_t xrif_decompress_lz4( xrif_t handle )
+xrif_error_t xrif_decompress_planes( xrif_t handle )
 {
    if(handle == NULL)
    {
-      XRIF_ERROR_PRINT("xrif_decompress_lz4", "can not use a null pointer");
+      XRIF_ERROR_PRINT("xrif_decompress_planes", "can not use a null pointer");
       return XRIF_ERROR_NULLPTR;
    }
    
@@ -2043,18 +4868,114 @@ xrif_error_t xrif_decompress_lz4( xrif_t handle )
       compressed_buffer = handle->compressed_buffer;
    }
    
-   int size_decomp = LZ4_decompress_safe (compressed_buffer, handle->reordered_buffer, handle->compressed_size, handle->reordered_buffer_size);
-
-   if(size_decomp < 0)
+   uint32_t * table = (uint32_t *) compressed_buffer;
+   
+   if(handle->compressed_size < sizeof(uint32_t) || table[0] == 0 || table[0] > XRIF_COMPRESS_PLANES_MAX)
    {
-      XRIF_ERROR_PRINT("xrif_decompress_lz4", "error in LZ4_decompress_safe");
-      return (XRIF_ERROR_LIBERR + size_decomp);
+      XRIF_ERROR_PRINT("xrif_decompress_planes", "invalid plane table");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   size_t nplanes = table[0];
+   size_t table_size = XRIF_BLOCK_TABLE_SIZE(3*nplanes);
+   
+   if(handle->compressed_size < table_size)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_planes", "invalid plane table");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   size_t dst_offs[XRIF_COMPRESS_PLANES_MAX];
+   size_t rec_offs[XRIF_COMPRESS_PLANES_MAX];
+   
+   int use_zstd = 0;
+   
+   size_t dst_off = 0;
+   size_t rec_off = table_size;
+   for(size_t k = 0; k < nplanes; ++k)
+   {
+      int pmethod = (int32_t) table[3 + 3*k];
+      
+      if(pmethod == XRIF_COMPRESS_ZSTD) use_zstd = 1;
+      else if(pmethod != XRIF_COMPRESS_NONE && pmethod != XRIF_COMPRESS_LZ4 && pmethod != XRIF_COMPRESS_LZ4HC)
+      {
+         XRIF_ERROR_PRINT("xrif_decompress_planes", "unknown plane compression method");
+         return XRIF_ERROR_NOTIMPL;
+      }
+      
+      dst_offs[k] = dst_off;
+      rec_offs[k] = rec_off;
+      dst_off += table[1 + 3*k];
+      rec_off += table[2 + 3*k];
    }
    
    //Make sure we have the correct amount of data
-   if(xrif_min_reordered_size(handle) != size_decomp) 
+   if(dst_off != xrif_reordered_size(handle) || dst_off > handle->reordered_buffer_size || rec_off != handle->compressed_size)
    {
-      XRIF_ERROR_PRINT("xrif_decompress_lz4", "size mismatch after decompression.");
+      XRIF_ERROR_PRINT("xrif_decompress_planes", "size mismatch in plane table");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   if(use_zstd)
+   {
+      #ifdef XRIF_USE_ZSTD
+      if(handle->zstd_dctx == NULL)
+      {
+         handle->zstd_dctx = ZSTD_createDCtx();
+         if(handle->zstd_dctx == NULL)
+         {
+            XRIF_ERROR_PRINT("xrif_decompress_planes", "error from ZSTD_createDCtx");
+            return XRIF_ERROR_MALLOC;
+         }
+      }
+      #else
+      XRIF_ERROR_PRINT("xrif_decompress_planes", "xrif was built without zstd");
+      return XRIF_ERROR_NOTIMPL;
+      #endif
+   }
+   
+   int nfail = 0;
+   
+   //The zstd context is shared, so zstd planes are decompressed in this thread
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0 && !use_zstd) 
+   {
+   #pragma omp for schedule(dynamic) reduction(+:nfail)
+   #endif
+   for(size_t k = 0; k < nplanes; ++k)
+   {
+      int pmethod = (int32_t) table[3 + 3*k];
+      
+      char * dst = handle->reordered_buffer + dst_offs[k];
+      const char * src = compressed_buffer + rec_offs[k];
+      
+      size_t len = table[1 + 3*k];
+      
+      if(pmethod == XRIF_COMPRESS_NONE)
+      {
+         if(table[2 + 3*k] != len) ++nfail;
+         else memcpy(dst, src, len);
+      }
+      else if(pmethod == XRIF_COMPRESS_ZSTD)
+      {
+         #ifdef XRIF_USE_ZSTD
+         size_t size_decomp = ZSTD_decompressDCtx( (ZSTD_DCtx *) handle->zstd_dctx, dst, len, src, table[2 + 3*k]);
+         if(ZSTD_isError(size_decomp) || size_decomp != len) ++nfail;
+         #endif
+      }
+      else //LZ4HC produces a standard LZ4 block
+      {
+         int size_decomp = LZ4_decompress_safe( src, dst, table[2 + 3*k], len);
+         if(size_decomp < 0 || (size_t) size_decomp != len) ++nfail;
+      }
+   }
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   if(nfail > 0)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_planes", "size mismatch after decompression.");
       return XRIF_ERROR_INVALID_SIZE;
    }
    
@@ -2182,6 +5103,11 @@ size_t xrif_typesize( xrif_typecode_t type_code)
    }
 }
 
+int xrif_typeisfloat( xrif_typecode_t type_code )
+{
+   return (type_code == XRIF_TYPECODE_HALF || type_code == XRIF_TYPECODE_FLOAT || type_code == XRIF_TYPECODE_DOUBLE);
+}
+
 double xrif_ts_difference( struct timespec * ts1,
                            struct timespec * ts0
                          )
@@ -2199,6 +5125,22 @@ const char * xrif_difference_method_string( int diff_method )
          return "previous";
       case XRIF_DIFFERENCE_FIRST:
          return "first";
+      case XRIF_DIFFERENCE_PIXEL:
+         return "pixel";
+      case XRIF_DIFFERENCE_MED:
+         return "median edge detector";
+      case XRIF_DIFFERENCE_PAETH:
+         return "Paeth";
+      case XRIF_DIFFERENCE_AVERAGE:
+         return "average";
+      case XRIF_DIFFERENCE_PREVIOUS_MED:
+         return "previous + median edge detector";
+      case XRIF_DIFFERENCE_LINEAR:
+         return "linear";
+      case XRIF_DIFFERENCE_REFERENCE:
+         return "reference";
+      case XRIF_DIFFERENCE_ADAPTIVE:
+         return "adaptive";
       default:
          return "unknown";
    }
@@ -2229,6 +5171,12 @@ const char * xrif_compress_method_string( int compress_method )
          return "none";
       case XRIF_COMPRESS_LZ4:
          return "LZ4";
+      case XRIF_COMPRESS_LZ4HC:
+         return "LZ4HC";
+      case XRIF_COMPRESS_ZSTD:
+         return "zstd";
+      case XRIF_COMPRESS_RANS:
+         return "rANS";
       default:
          return "unknown";
    }
@@ -97,10 +97,6 @@ extern "C"
 {
 #endif
 
-   
-#ifndef LZ4_MEMORY_USAGE
-#define LZ4_MEMORY_USAGE (20)
-#endif
 
 #include <stdlib.h>
 #include <string.h>
@@ -114,18 +110,43 @@ extern "C"
 #include "lz4/lz4.h"
 #include "lz4/lz4hc.h"
 
+#ifdef XRIF_USE_ZSTD
+#include <zstd.h>
+#endif
+
 
 
 
 
-#define XRIF_VERSION (0)
+//Version 1 uses bytes 42-47 for the compression block size and header flags, which version 0 readers would ignore
+#define XRIF_VERSION (1)
 #define XRIF_HEADER_SIZE (48)
+#define XRIF_HEADER_SIZE_EXT (56)
 
 #define XRIF_DIFFERENCE_NONE (-1)
 #define XRIF_DIFFERENCE_DEFAULT (100)
 #define XRIF_DIFFERENCE_PREVIOUS (100)
 #define XRIF_DIFFERENCE_FIRST (200)
 #define XRIF_DIFFERENCE_PIXEL (300)
+#define XRIF_DIFFERENCE_MED (400)
+#define XRIF_DIFFERENCE_PAETH (500)
+#define XRIF_DIFFERENCE_AVERAGE (600)
+#define XRIF_DIFFERENCE_PREVIOUS_MED (700)
+#define XRIF_DIFFERENCE_LINEAR (800)
+#define XRIF_DIFFERENCE_REFERENCE (900)
+#define XRIF_DIFFERENCE_ADAPTIVE (1000)
+
+/// The default width and height of the blocks of XRIF_DIFFERENCE_ADAPTIVE, in pixels.
+#define XRIF_ADAPTIVE_BLOCK_SIZE_DEFAULT (32)
+
+/// The number of frames sampled to choose the method of each block of XRIF_DIFFERENCE_ADAPTIVE.
+#define XRIF_ADAPTIVE_SAMPLE_FRAMES (4)
+
+//Codes in the method table of XRIF_DIFFERENCE_ADAPTIVE, which are the difference method divided by 100, with 0 for none
+#define XRIF_ADAPTIVE_NONE (0)
+#define XRIF_ADAPTIVE_PREVIOUS (XRIF_DIFFERENCE_PREVIOUS/100)
+#define XRIF_ADAPTIVE_FIRST (XRIF_DIFFERENCE_FIRST/100)
+#define XRIF_ADAPTIVE_PIXEL (XRIF_DIFFERENCE_PIXEL/100)
 
 #define XRIF_REORDER_NONE (-1)
 #define XRIF_REORDER_DEFAULT (100)
@@ -133,13 +154,91 @@ extern "C"
 #define XRIF_REORDER_BYTEPACK_RENIBBLE (200)
 #define XRIF_REORDER_BITPACK (300)
 
+/// The default minimum number of pixels in a cube for the differencing kernels to use threads.  Smaller cubes are faster without the fork/join.
+#define XRIF_OMP_MIN_PIXELS_DEFAULT (65536)
+
+/// The number of bytes of each frame restored per block by \ref xrif_undifference_previous.  A block is walked through all the frames before the next one, so two blocks should fit in the L1 cache.
+#define XRIF_UNDIFFERENCE_BLOCK (16384)
+
+/// The number of pixels reordered per call to a reordering kernel.  Chunks are distributed over threads if xrif_handle::omp_parallel is set.
+#define XRIF_REORDER_CHUNK (16384)
+
+/// No vector instructions, use the scalar kernels.
+#define XRIF_SIMD_NONE (0)
+
+/// Use SSE2 kernels.
+#define XRIF_SIMD_SSE2 (1)
+
+/// Use AVX2 kernels.
+#define XRIF_SIMD_AVX2 (2)
+
    
 #define XRIF_COMPRESS_NONE (-1)
 #define XRIF_COMPRESS_DEFAULT (100)
 #define XRIF_COMPRESS_LZ4 (100)
+#define XRIF_COMPRESS_LZ4HC (200)
+#define XRIF_COMPRESS_ZSTD (300)
+#define XRIF_COMPRESS_RANS (400)
 
 #define XRIF_LZ4_ACCEL_MIN (1)
 #define XRIF_LZ4_ACCEL_MAX (65537)
+
+#define XRIF_LZ4HC_LEVEL_MIN (1)
+#define XRIF_LZ4HC_LEVEL_DEFAULT (LZ4HC_CLEVEL_DEFAULT)
+#define XRIF_LZ4HC_LEVEL_MAX (LZ4HC_CLEVEL_MAX)
+
+#define XRIF_ZSTD_LEVEL_MIN (-32768)
+#define XRIF_ZSTD_LEVEL_DEFAULT (3)
+#define XRIF_ZSTD_LEVEL_MAX (22)
+
+#define XRIF_LZ4_MEMORY_USAGE_MIN (12)
+#define XRIF_LZ4_MEMORY_USAGE_DEFAULT (14)
+#define XRIF_LZ4_MEMORY_USAGE_MAX (20)
+
+#define XRIF_COMPRESS_BLOCK_UNIT (1024)
+#define XRIF_COMPRESS_BLOCK_SIZE_MAX (65535*XRIF_COMPRESS_BLOCK_UNIT)
+
+/// The size of the block table at the beginning of block-compressed data, for `nblocks` blocks.
+#define XRIF_BLOCK_TABLE_SIZE(nblocks) ((1+(nblocks))*sizeof(uint32_t))
+
+/// Flag set in the block table entry of a block which is stored as is rather than LZ4 compressed.
+#define XRIF_BLOCK_RAW (0x80000000)
+
+/// The maximum number of bytes sampled to estimate the entropy of a block or plane.
+#define XRIF_SKIP_ENTROPY_SAMPLES (4096)
+
+/// The number of consecutive bytes in each run sampled to estimate the entropy.  Must divide XRIF_SKIP_ENTROPY_SAMPLES.
+#define XRIF_SKIP_ENTROPY_RUN (64)
+
+/// The number of bits in the rANS probability scale.  Symbol frequencies are normalized to sum to 2^XRIF_RANS_PROB_BITS.
+#define XRIF_RANS_PROB_BITS (12)
+
+/// The maximum number of planes the reordered buffer is split into for per-plane and rANS compression.
+#define XRIF_COMPRESS_PLANES_MAX (17)
+
+/// The maximum size of a rANS plane record beyond the size of the plane: mode, symbol bitmap, frequencies, and the 4 final states.
+#define XRIF_RANS_PLANE_OVERHEAD (1 + 32 + 2*256 + 16)
+
+/// Header flag indicating that the first frame was differenced against the last frame of the previous cube.
+#define XRIF_HEADER_FLAG_CHAINED (0x0001)
+
+/// Header flag indicating that the LZ4 data continues from the previous cube, using its reordered data as a dictionary.
+#define XRIF_HEADER_FLAG_LZ4_CHAINED (0x0002)
+
+/// Header flag indicating that each plane of the reordered data was compressed separately, with its method recorded in the plane table.
+#define XRIF_HEADER_FLAG_PLANES (0x0004)
+
+/// Header flag indicating that the cube was encoded in tiles, with the tile size in place of the block size.
+#define XRIF_HEADER_FLAG_TILED (0x0008)
+
+/// Header flag indicating that the cube has a key frame interval, xrif_handle::keyframe_interval, in place of the chain index.
+#define XRIF_HEADER_FLAG_KEYFRAMES (0x0010)
+
+/// All of the header flags known to this version.  A header with any other flag set is rejected.
+#define XRIF_HEADER_FLAG_MASK (XRIF_HEADER_FLAG_CHAINED | XRIF_HEADER_FLAG_LZ4_CHAINED | XRIF_HEADER_FLAG_PLANES | XRIF_HEADER_FLAG_TILED | XRIF_HEADER_FLAG_KEYFRAMES)
+
+/// The maximum size of the dictionary LZ4 streaming keeps from the previous cube.  This is the LZ4 window size.
+#define XRIF_LZ4_DICT_SIZE (65536)
    
 /// The type used for storing the width and height and depth dimensions of images.
 typedef uint32_t xrif_dimension_t;
@@ -183,6 +282,9 @@ typedef int xrif_error_t;
 /// Return code indicating that a bad argument was passed.
 #define XRIF_ERROR_BADARG (-110)
 
+/// Return code indicating that the reference needed to decode a chained cube, or the reference frame for XRIF_DIFFERENCE_REFERENCE, is not available.
+#define XRIF_ERROR_NOREFERENCE (-120)
+
 /// Return code indicating that the header is bad.
 #define XRIF_ERROR_BADHEADER (-1000)
 
@@ -319,18 +421,71 @@ typedef struct
    
    int difference_method; ///< The difference method to use.
    
+   unsigned char chain_cubes; /**< Flag (true/false) controlling whether the first frame of each cube is differenced against the last frame of the previous cube.  
+                                *  Only applies to XRIF_DIFFERENCE_PREVIOUS and XRIF_DIFFERENCE_FIRST.  Must also be set when decoding, so that the reference is kept.  Default is false.*/
+   
+   unsigned char chained; ///< Flag (true/false) indicating whether the current cube depends on the previous cube.  A cube which does not is a keyframe.  Set during encoding or from the header.
+   
+   uint16_t chain_index; ///< The number of cubes since the last keyframe, modulo 65536.  Set during encoding or from the header.
+   
+   xrif_dimension_t keyframe_interval; /**< The key frame interval: the number of frames within the cube between the frames which are not differenced, so that the 
+                                         *  temporal difference methods restart from them.  At most 65535.  Can not be combined with cube chaining or LZ4 streaming.  
+                                         *  Set from the header when decoding.  Default is 0, meaning only the first frame is not differenced.*/
+   
+   char * reference_frame;      /**< One frame supplied by the caller, such as a dark or bias, which XRIF_DIFFERENCE_REFERENCE subtracts from every frame.  
+                                  *  Never owned by this handle.  Set with \ref xrif_set_reference.*/
+   
+   size_t reference_frame_size; ///< The size of reference_frame, in bytes.
+   
+   uint64_t reference_frame_id; ///< The caller's ID or hash identifying reference_frame.
+   
+   uint64_t reference_id;       ///< The ID of the reference frame the cube was differenced against.  Set during encoding or from the header.
+   
+   xrif_dimension_t adaptive_block_size; /**< Width and height of the blocks of XRIF_DIFFERENCE_ADAPTIVE, in pixels.  At most 65535.  Set from the header when decoding.
+                                           *  Default is XRIF_ADAPTIVE_BLOCK_SIZE_DEFAULT.*/
+   
    int reorder_method;   ///< The method to use for bit reordering.
    
    int compress_method; ///< The compression method used.
    
    int lz4_acceleration; ///< LZ4 acceleration parameter, >=1, higher is faster with less comporession.  Default is 1.
    
+   int lz4hc_level; ///< LZ4HC compression level, 1-12, higher is slower with more compression.  Decompression speed is unaffected.  Default is 9.
+   
+   int lz4_memory_usage; /**< Log2 of the size in bytes of the LZ4 hash table, an even number from 12 to 20.  Larger tables find more matches, smaller tables 
+                           *  are faster to reset and stay in cache.  Not used by LZ4HC or LZ4 streaming.  Default is 14.*/
+   
+   int zstd_level; ///< Zstandard compression level, -32768 to 22, higher is slower with more compression.  Negative levels are faster.  Default is 3.
+   
+   int zstd_workers; ///< Number of Zstandard worker threads.  If 0 compression is done in the calling thread.  Requires libzstd built with multithreading.  Default is 0.
+   
+   size_t compress_block_size; /**< Size in bytes of the independent blocks the reordered buffer is split into for compression.  Blocks are compressed
+                                 *  and decompressed in parallel if omp_parallel is set.  Must be a multiple of XRIF_COMPRESS_BLOCK_UNIT.  Default is 0, 
+                                 *  meaning the reordered buffer is compressed as a single block.*/
+   
+   size_t tile_size; /**< Size in bytes of the tiles of the raw buffer which are differenced, reordered, and compressed one at a time by \ref xrif_encode_tiles.
+                       *  Must be a multiple of XRIF_COMPRESS_BLOCK_UNIT.  Set from the header when decoding.  Default is 0, meaning the cube is not tiled.*/
+   
+   unsigned char lz4_stream; /**< Flag (true/false) controlling whether LZ4 and LZ4HC compression continue from the previous cube, so that matches can be found in
+                               *  the end of its reordered data.  Not used with compression blocks.  Must also be set when decoding, so that the dictionary is kept.  Default is false.*/
+   
+   unsigned char lz4_chained; ///< Flag (true/false) indicating whether the current cube's LZ4 data depends on the previous cube.  Set during encoding or from the header.
+   
+   unsigned char compress_planes; /**< Flag (true/false) controlling whether each plane of the reordered buffer is compressed separately with LZ4, LZ4HC, or Zstandard, 
+                                    *  with planes which do not shrink stored as is.  Takes precedence over compression blocks and LZ4 streaming.  Set from the header when decoding.  Default is false.*/
+   
+   double skip_entropy; /**< Estimated entropy, in bits per byte, at or above which a compression block or plane is stored as is without trying to compress it.
+                          *  Default is 0, which disables the estimate.*/
+   
    int omp_parallel;     /**< Flag controlling whether OMP parallelization is used to speed up.  This has no effect if XRIF_NO_OMP is defined at compile time, 
                               which completely removes OMP code. Default is 0.*/
    
    int omp_numthreads;   /**< Number of threads to use if omp_parallel is 1.  For this to be meaningful, 
                            *  XRIF_NO_OMP must NOT be defined at compile time, and XRIF_OMP_NUMTHREADS must be defined at compile time. Default is 1.*/
    
+   size_t omp_min_pixels; /**< Minimum number of pixels in the cube for the differencing kernels to use threads when omp_parallel is set.  Below this they run
+                            *  in the calling thread.  Default is XRIF_OMP_MIN_PIXELS_DEFAULT.*/
+   
    unsigned char compress_on_raw; ///< Flag (true/false) indicating whether the raw buffer is used for compression.  Default on initializeation is true.
    
    unsigned char own_raw;  ///< Flag (true/false) indicating whether the raw_buffer pointer is managed by this handle
@@ -351,6 +506,40 @@ typedef struct
                                     *  in size, but this is not a strict requirement in practice for most streams.  It must be at least width*height*depth*frames*data_size.  
                                     *  If this library is used to allocate it, it will be the larger of the two.*/
                                     
+   char * chain_buffer;      /**< Holds the encoding reference frame, one frame of working space, and the decoding reference frame, in that order.  Always owned by this handle, 
+                               *  and allocated as needed when chain_cubes is true.*/
+   size_t chain_buffer_size; ///< The size of the chain_buffer pointer.  It is 3*width*height*depth*data_size when allocated.
+   
+   unsigned char * adaptive_methods; /**< The method table of XRIF_DIFFERENCE_ADAPTIVE, one XRIF_ADAPTIVE_* code per block.  Always owned by this handle, and 
+                                       *  allocated as needed when differencing or reading the header.*/
+   size_t adaptive_methods_size;     ///< The size of the adaptive_methods pointer, which is the number of blocks.
+   
+   unsigned char chain_encode_valid; ///< Flag (true/false) indicating whether the next cube encoded can depend on the previous one.  If false the next cube encoded will be a keyframe.
+   uint16_t chain_encode_index;      ///< The chain_index of the previous cube encoded.
+   
+   unsigned char chain_decode_valid; ///< Flag (true/false) indicating whether the previous cube was decoded successfully, so that the next cube in the chain can be decoded.
+   uint16_t chain_decode_index;      ///< The chain_index of the previous cube decoded.
+   
+   LZ4_stream_t * lz4_stream_encode;       ///< The LZ4 streaming compression context, allocated as needed when lz4_stream is true.
+   LZ4_streamHC_t * lz4hc_stream_encode;   ///< The LZ4HC streaming compression context, allocated as needed when lz4_stream is true.
+   LZ4_streamDecode_t * lz4_stream_decode; ///< The LZ4 streaming decompression context, allocated as needed when lz4_stream is true.
+   
+   char * lz4_dict_buffer;   /**< Holds the encoding dictionary and the decoding dictionary, each XRIF_LZ4_DICT_SIZE bytes, which are the end of the previous cube's
+                               *  reordered data.  Always owned by this handle, and allocated as needed when lz4_stream is true.*/
+   int lz4_dict_encode_size; ///< The size of the encoding dictionary.  If 0 the next cube encoded will not depend on the previous one.
+   int lz4_dict_encode_method; ///< The compression method of the streaming context the encoding dictionary is saved in.
+   int lz4_dict_decode_size; ///< The size of the decoding dictionary.
+   
+   char * lz4_state;           /**< Preallocated LZ4 or LZ4HC compression states, one per thread, so the hash table is not re-initialized for each compression.
+                                 *  Always owned by this handle, and allocated by xrif_allocate or as needed.*/
+   size_t lz4_state_size;      ///< The size of one state in lz4_state, rounded up to a multiple of 64 bytes.
+   int lz4_nstates;            ///< The number of states in lz4_state.
+   int lz4_state_method;       ///< The compression method the states in lz4_state are for.
+   int lz4_state_memory_usage; ///< The lz4_memory_usage the states in lz4_state are for.
+   
+   void * zstd_cctx; ///< The Zstandard compression context (ZSTD_CCtx), allocated when first used.  Always owned by this handle.
+   void * zstd_dctx; ///< The Zstandard decompression context (ZSTD_DCtx), allocated when first used.  Always owned by this handle.
+   
                   
    /** \name Performance Measurements
      * @{ 
@@ -366,6 +555,7 @@ typedef struct
    double reorder_rate; ///< Rate at which the data was reordered in bytes per second
    double compress_time; ///< Time in seconds taken to compress the data
    double compress_rate; ///< Rate at which the data was compressed in bytes per second
+   int compress_skipped; ///< Number of blocks or planes stored as is without trying to compress them in the last compression, see xrif_handle::skip_entropy
    
    struct timespec ts_difference_start; ///< Timespec used to mark the beginning of differencing, which is also the beginning of encoding
    struct timespec ts_reorder_start; ///< Timespec used to mark the beginning of reordering, which is the end of differencing
@@ -512,10 +702,12 @@ xrif_error_t xrif_set_reorder_method( xrif_t handle,     ///< [in/out] the xrif
 
 /// Set the compress method.
 /** Sets the compress_method member of handle.
-  * Valid methods are XRIF_COMPRESS_NONE, XRIF_COMPRESS_DEFAULT, and XRIF_COMPRESS_LZ4.  XRIF_COMPRESS_DEFAULT is equivalent to XRIF_COMPRESS_LZ4.
+  * Valid methods are XRIF_COMPRESS_NONE, XRIF_COMPRESS_DEFAULT, XRIF_COMPRESS_LZ4, XRIF_COMPRESS_LZ4HC, XRIF_COMPRESS_ZSTD, and XRIF_COMPRESS_RANS.  XRIF_COMPRESS_DEFAULT is equivalent to XRIF_COMPRESS_LZ4.
+  * XRIF_COMPRESS_ZSTD is only available if xrif was built with XRIF_USE_ZSTD defined, which is done when libzstd is found.
   * 
   * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
   * \returns \ref XRIF_ERROR_BADARG if `compress_method` is not a valid compress method.  Will set method to XRIF_COMPRESS_DEFAULT.
+  * \returns \ref XRIF_ERROR_NOTIMPL if `compress_method` is XRIF_COMPRESS_ZSTD and xrif was built without it.  Will set method to XRIF_COMPRESS_DEFAULT.
   * \returns \ref XRIF_NOERROR on success.
   */ 
 xrif_error_t xrif_set_compress_method( xrif_t handle,      ///< [in/out] the xrif handle to be configured
@@ -535,6 +727,270 @@ xrif_error_t xrif_set_lz4_acceleration( xrif_t handle,    ///< [in/out] the xrif
                                         int32_t lz4_accel ///< [in] LZ4 acceleration parameter
                                       );
 
+/// Set the LZ4HC compression level
+/** The LZ4HC level is a number from 1 (XRIF_LZ4HC_LEVEL_MIN) to 12 (XRIF_LZ4HC_LEVEL_MAX).  Larger values
+  * give better compression but take longer.  The default is 9 (XRIF_LZ4HC_LEVEL_DEFAULT).  LZ4HC output is decompressed
+  * by the normal LZ4 decoder, so the level has no effect on decompression speed.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `lz4hc_level` is out of range.  Will set value to corresponding min or max limit.
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_lz4hc_level( xrif_t handle,      ///< [in/out] the xrif handle to be configured
+                                   int32_t lz4hc_level ///< [in] LZ4HC compression level
+                                 );
+
+/// Set the Zstandard compression level
+/** The level is a number from -32768 (XRIF_ZSTD_LEVEL_MIN) to 22 (XRIF_ZSTD_LEVEL_MAX).  Larger values give better compression
+  * but take longer, and negative values trade ratio for speed.  The default is 3 (XRIF_ZSTD_LEVEL_DEFAULT).  Levels above 19 use
+  * more memory for both compression and decompression.  The level is stored in the header.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `zstd_level` is out of range.  Will set value to corresponding min or max limit.
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_zstd_level( xrif_t handle,     ///< [in/out] the xrif handle to be configured
+                                  int32_t zstd_level ///< [in] Zstandard compression level
+                                );
+
+/// Set the number of Zstandard worker threads
+/** If greater than 0, Zstandard compression is split into jobs run by this many worker threads, which speeds up compression
+  * of large cubes at high levels.  This does not change decompression, and is not stored in the header.  If libzstd was built without
+  * multithreading support, compression is done in the calling thread.  The default is 0.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `zstd_workers` is negative.  Will set value to 0.
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_zstd_workers( xrif_t handle,   ///< [in/out] the xrif handle to be configured
+                                    int zstd_workers ///< [in] the number of worker threads
+                                  );
+
+/// Set the LZ4 hash table size
+/** The hash table used by LZ4 compression is 2^`lz4_memory_usage` bytes.  The value must be even, from 12 (XRIF_LZ4_MEMORY_USAGE_MIN, 4 KB) 
+  * to 20 (XRIF_LZ4_MEMORY_USAGE_MAX, 1 MB).  The default is 14 (XRIF_LZ4_MEMORY_USAGE_DEFAULT, 16 KB), the LZ4 default.  A larger table can 
+  * improve the compression ratio of large cubes, while a smaller table stays in L1 cache and is cheaper to reset for small cubes.  
+  * The table size has no effect on the compressed format or on decompression.  It is not used by LZ4HC or LZ4 streaming.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `lz4_memory_usage` is out of range or odd.  Will set value to corresponding min or max limit, or round up.
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_lz4_memory_usage( xrif_t handle,        ///< [in/out] the xrif handle to be configured
+                                        int lz4_memory_usage  ///< [in] log2 of the LZ4 hash table size in bytes
+                                      );
+
+/// Set the compression block size
+/** If non-zero, the reordered buffer is split into independent blocks of `block_size` bytes (the last block may be shorter).  
+  * Each block is compressed separately, and the blocks are compressed and decompressed in parallel if xrif_handle::omp_parallel is set.
+  * A table of the compressed block sizes is written at the beginning of the compressed data.  Splitting into blocks slightly 
+  * reduces the compression ratio, since matches can not be found across block boundaries.
+  * 
+  * The block size must be a multiple of XRIF_COMPRESS_BLOCK_UNIT (1024 bytes), and no larger than XRIF_COMPRESS_BLOCK_SIZE_MAX.
+  * Since it changes the minimum size of the compressed buffer, this must be called before allocating.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `block_size` is not a multiple of XRIF_COMPRESS_BLOCK_UNIT, or is too large.  Will round up to the next multiple, or set to the max.
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_compress_block_size( xrif_t handle,    ///< [in/out] the xrif handle to be configured
+                                           size_t block_size ///< [in] the block size in bytes, 0 for a single block
+                                         );
+
+/// Set the size of the tiles for tiled encoding.
+/** If non-zero, and \ref xrif_tiled is true for the configuration, \ref xrif_encode runs the difference, reorder, and compression stages on each 
+  * tile of `tile_size` bytes of the raw buffer before moving on to the next tile, rather than passing the whole cube through each stage.  
+  * A tile size which fits in the L2 cache, such as 256 KiB, keeps the intermediate data in cache, which speeds up encoding of large cubes.  
+  * Tiles are reordered and compressed independently, which slightly reduces the compression ratio.  Compression blocks, per-plane compression, 
+  * and LZ4 streaming are not used when tiling.  See \ref xrif_encode_tiles.
+  *
+  * The tile size must be a multiple of XRIF_COMPRESS_BLOCK_UNIT (1024 bytes), and no larger than XRIF_COMPRESS_BLOCK_SIZE_MAX.
+  * Since it changes the minimum size of the reordered and compressed buffers, this must be called before allocating.  It is set from the header when decoding.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `tile_size` is not a multiple of XRIF_COMPRESS_BLOCK_UNIT, or is too large.  Will round up to the next multiple, or set to the max.
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_tile_size( xrif_t handle,   ///< [in/out] the xrif handle to be configured
+                                 size_t tile_size ///< [in] the tile size in bytes, 0 to encode stage by stage
+                               );
+
+/// Set whether successive cubes are chained together.
+/** If true, the first frame of each cube is differenced against the last frame of the previous cube encoded with this handle, 
+  * rather than being stored verbatim.  The cube then depends on the previous cube, and the dependency is recorded in the header.
+  * The first cube encoded, and any cube encoded after a call to \ref xrif_keyframe, is a keyframe which can be decoded on its own. 
+  * This only applies to XRIF_DIFFERENCE_PREVIOUS and XRIF_DIFFERENCE_FIRST, for other methods the first frame is stored verbatim.
+  *
+  * This must also be set on a decoding handle, so that it keeps the last frame of each decoded cube as the reference for the next one.
+  * Chained cubes must be decoded in order starting from a keyframe.  Chaining is managed by \ref xrif_encode and \ref xrif_decode.
+  * It can not be used with a key frame interval, see \ref xrif_set_keyframe_interval.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `chain_cubes` is true and a key frame interval is set.  Chaining is not changed.
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_chain_cubes( xrif_t handle,  ///< [in/out] the xrif handle to be configured
+                                   int chain_cubes ///< [in] true (non-zero) to chain cubes, false (0) to make every cube a keyframe
+                                 );
+
+/// Set whether LZ4 compression continues from the previous cube.
+/** If true, LZ4 and LZ4HC compression use the end (up to XRIF_LZ4_DICT_SIZE bytes) of the previous cube's reordered data as a dictionary, 
+  * so that matches can be found in it.  This helps most for small cubes, which otherwise start each compression with an empty match window. 
+  * The cube then depends on the previous cube, and the dependency is recorded in the header.  Keyframes are as for \ref xrif_set_chain_cubes.
+  * This is not used with compression blocks (see \ref xrif_set_compress_block_size), which are always independent.
+  *
+  * This must also be set on a decoding handle, so that it keeps the dictionary for the next cube.  Streamed cubes must be decoded in order
+  * starting from a keyframe.  Streaming can not be used with a key frame interval, see \ref xrif_set_keyframe_interval.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `lz4_stream` is true and a key frame interval is set.  Streaming is not changed.
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_lz4_stream( xrif_t handle, ///< [in/out] the xrif handle to be configured
+                                  int lz4_stream ///< [in] true (non-zero) to continue LZ4 compression across cubes, false (0) to compress each cube independently
+                                );
+
+/// Set whether the reordered planes are compressed separately.
+/** If true, with LZ4, LZ4HC, or Zstandard the reordered buffer is split into planes (see \ref xrif_compress_nplanes) and each plane is compressed on its own.
+  * A plane whose compressed size would not be smaller than the plane is stored as is, and LZ4 stops early on such planes, so little time is spent on 
+  * the incompressible low-order bytes of noisy data.  The method used for each plane is recorded in the plane table, and the header flag \ref XRIF_HEADER_FLAG_PLANES is set.
+  * LZ4 and LZ4HC planes are compressed in parallel if xrif_handle::omp_parallel is set.  Compression blocks and LZ4 streaming are not used when this is set.
+  * 
+  * Since it changes the minimum size of the compressed buffer, this must be called before allocating.  It is set from the header when decoding.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_compress_planes( xrif_t handle,      ///< [in/out] the xrif handle to be configured
+                                       int compress_planes ///< [in] true (non-zero) to compress each plane separately, false (0) to compress the reordered buffer as a whole
+                                     );
+
+/// Set the entropy above which blocks and planes are stored without trying to compress them.
+/** Before each compression block (see \ref xrif_set_compress_block_size) or plane (see \ref xrif_set_compress_planes) is compressed, its order-0 entropy 
+  * is estimated from a sample of up to XRIF_SKIP_ENTROPY_SAMPLES bytes.  If the estimate is at or above `skip_entropy` bits per byte the block
+  * is stored as is, which saves the time LZ4 would spend on noise it can barely compress.  The number of blocks or planes skipped is reported in 
+  * xrif_handle::compress_skipped.  Uniformly random bytes give an estimate of about 7.95, so a threshold near 7.9 only skips nearly random data.
+  * Entropy does not account for repeated strings, so a lower threshold may skip data LZ4 could have compressed.
+  *
+  * This has no effect when compressing the reordered buffer as a single block.  It is not needed for decoding.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `skip_entropy` is negative or greater than 8.  Will set to 0 or 8.
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_skip_entropy( xrif_t handle,      ///< [in/out] the xrif handle to be configured
+                                    double skip_entropy ///< [in] the entropy threshold in bits per byte, 0 to always try to compress
+                                  );
+
+/// Set the minimum number of pixels in a cube for the differencing kernels to use threads.
+/** When xrif_handle::omp_parallel is set, the differencing and undifferencing kernels only start threads for cubes with at least `omp_min_pixels`
+  * pixels, since for small cubes starting the threads takes longer than the work.  0 always uses threads.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_NOERROR on success.
+  */ 
+xrif_error_t xrif_set_omp_min_pixels( xrif_t handle,        ///< [in/out] the xrif handle to be configured
+                                      size_t omp_min_pixels ///< [in] the minimum number of pixels, default is XRIF_OMP_MIN_PIXELS_DEFAULT
+                                    );
+
+/// Check whether a kernel working on `npix` pixels should use threads.
+/** 
+  * \returns 1 if xrif_handle::omp_parallel is set and `npix` is at least xrif_handle::omp_min_pixels
+  * \returns 0 otherwise
+  */ 
+int xrif_use_omp( xrif_t handle, ///< [in] the xrif handle
+                  size_t npix    ///< [in] the number of pixels the kernel works on
+                );
+
+/// Set the key frame interval within the cube.
+/** With a key frame interval of K, frames 0, K, 2K, ... of the cube are not differenced.  The temporal difference methods
+  * (XRIF_DIFFERENCE_PREVIOUS, XRIF_DIFFERENCE_FIRST, XRIF_DIFFERENCE_PREVIOUS_MED, and XRIF_DIFFERENCE_LINEAR) restart from each of them,
+  * so the cube is split into segments of K frames which do not depend on each other.  Undifferencing works on the segments in parallel, and a frame
+  * only depends on the frames of its own segment.  The interval is recorded in the header.
+  * 
+  * The interval takes the place of the chain index in the header, so a key frame interval can not be used with xrif_set_chain_cubes or 
+  * xrif_set_lz4_stream.  The other difference methods are not affected, and the interval is not written to their headers.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `keyframe_interval` is greater than 65535.  Will set to 65535.
+  * \returns \ref XRIF_ERROR_BADARG if `keyframe_interval` is not 0 and cube chaining or LZ4 streaming is set.  The interval is not changed.
+  * \returns \ref XRIF_NOERROR on success.
+  * 
+  * \test Verify the key frame interval with previous differencing \ref diff_previous_keyframes "[test doc]"
+  * \test Verify the key frame interval with each temporal method \ref encode_keyframes "[test doc]"
+  * \test Verify the key frame interval is written to and read from the header \ref header_read_keyframes "[test doc]"
+  */ 
+xrif_error_t xrif_set_keyframe_interval( xrif_t handle,                     ///< [in/out] the xrif handle to be configured
+                                         xrif_dimension_t keyframe_interval ///< [in] the key frame interval, 0 for only the first frame
+                                       );
+
+/// Get the number of frames in each segment of the cube set by the key frame interval.
+/** 
+  * \returns xrif_handle::keyframe_interval if it is set and less than xrif_handle::frames
+  * \returns xrif_handle::frames otherwise, since the whole cube is one segment
+  */ 
+size_t xrif_segment_frames( xrif_t handle /**< [in] the xrif handle */);
+
+/// Check whether the key frame interval applies to the cube.
+/** 
+  * \returns 1 if xrif_handle::keyframe_interval is set and the difference method is one of the temporal methods which use it
+  * \returns 0 otherwise
+  */ 
+int xrif_has_keyframe_interval( xrif_t handle /**< [in] the xrif handle */);
+
+/// Set the reference frame for XRIF_DIFFERENCE_REFERENCE.
+/** The frame is subtracted from every frame of the cube, including the first, so that a fixed pattern such as a detector bias is not
+  * stored in each cube.  Only `id` is written to the header.  A decoding handle must be given the same frame with the same ID after
+  * reading the header, so the ID should identify the frame in the caller's archive, e.g. a calibration file number or a hash.
+  * 
+  * The pointer is not copied or owned by the handle, so it must remain valid while cubes are encoded or decoded with it.  Floating 
+  * point types are XORed with the reference.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_INVALID_SIZE if bad values are passed for reference or size
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify the reference frame and its ID are needed to decode \ref encode_reference "[test doc]"
+  */
+xrif_error_t xrif_set_reference( xrif_t handle,   ///< [in/out] the xrif handle to be configured
+                                 void * reference, ///< [in] the reference frame, with the size and type of one frame of the cube
+                                 size_t size,      ///< [in] the size of the reference frame, in bytes
+                                 uint64_t id       ///< [in] the ID of the reference frame, written to the header
+                               );
+
+/// Set the size of the blocks for XRIF_DIFFERENCE_ADAPTIVE.
+/** Each frame is split into blocks of `block_size` x `block_size` pixels, treating the planes of a frame as more rows, and each block
+  * uses the difference method which is estimated to give the smallest residuals for it through the whole cube.  The method table
+  * takes one byte per block in the header, so smaller blocks follow the scene more closely at the cost of a larger header.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_ERROR_BADARG if `block_size` is 0, which sets the default, or greater than 65535, which sets 65535
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify adaptive differencing chooses the method of each block \ref diff_adaptive_choice "[test doc]"
+  */
+xrif_error_t xrif_set_adaptive_block_size( xrif_t handle,              ///< [in/out] the xrif handle to be configured
+                                           xrif_dimension_t block_size ///< [in] the width and height of the blocks, in pixels
+                                         );
+
+/// Get the number of blocks of XRIF_DIFFERENCE_ADAPTIVE in each frame.
+/** Each frame is split into blocks of xrif_handle::adaptive_block_size pixels on a side, treating the planes as more rows, and the 
+  * partial blocks at the right and bottom edges are counted.  This is the number of entries in the method table.
+  * 
+  * \returns the number of blocks in each frame, ceil(width / block size) x ceil(height x depth / block size)
+  * \returns 0 if xrif_handle::adaptive_block_size is 0, or the frame size is not set
+  */
+size_t xrif_adaptive_blocks( xrif_t handle /**< [in] the xrif handle */);
+
+/// Make the next encoded cube a keyframe.
+/** Discards the encoding reference frame and LZ4 dictionary, so that the next cube does not depend on the previous one.  Call this
+  * at the start of each new archive file, or at any point a decoder should be able to start from.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a NULL pointer
+  * \returns \ref XRIF_NOERROR on success.
+  */
+xrif_error_t xrif_keyframe( xrif_t handle /**< [in/out] the xrif handle */);
+
 /// Calculate the minimum size of the raw buffer.
 /** Result is based on current connfiguration of the handle.
   * 
@@ -544,13 +1000,24 @@ xrif_error_t xrif_set_lz4_acceleration( xrif_t handle,    ///< [in/out] the xrif
 size_t xrif_min_raw_size(xrif_t handle /**< [in] the xrif handle */ );
 
 /// Calculate the minimum size of the reordered buffer.
-/** Result is based on current connfiguration of the handle.
+/** Result is based on current connfiguration of the handle.  With xrif_set_chain_cubes or xrif_set_lz4_stream this covers cubes
+  * which are chained and cubes which are not, see xrif_reordered_size(xrif_t).
   * 
   * \returns the minimum size of the reordered buffer for a valid configuration.
   * \returns 0 for an invalid configuration. 
   */
 size_t xrif_min_reordered_size(xrif_t handle /**< [in] the xrif handle */ );
 
+/// Calculate the size of the reordered data.
+/** This is the number of bytes of the reordered buffer which are compressed for the current cube.  It is the same as 
+  * xrif_min_reordered_size(xrif_t) except for chained cubes with \ref XRIF_REORDER_BITPACK, where the buffer must also fit 
+  * the other layout of the first frame.
+  * 
+  * \returns the size of the reordered data for a valid configuration.
+  * \returns 0 for an invalid configuration. 
+  */
+size_t xrif_reordered_size(xrif_t handle /**< [in] the xrif handle */ );
+
 /// Calculate the minimum size of the compressed buffer.
 /** Result is based on current connfiguration of the handle.
   * 
@@ -662,6 +1129,51 @@ xrif_error_t xrif_set_compressed( xrif_t handle,  ///< [in/out] the xrif object
   */
 xrif_error_t xrif_allocate_compressed( xrif_t handle /**< [in/out] the xrif handle */);
 
+/// Allocate the chain buffer based on the already set frame dimensions.
+/** Called as needed by \ref xrif_difference and \ref xrif_undifference when xrif_handle::chain_cubes is true.
+  * 
+  * If the chain_buffer is already allocated with the correct size this does nothing, so the reference frames are kept.  
+  * Otherwise it is re-allocated and the reference frames are invalidated.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a null pointer
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the width, heigh, depth, and data_size parameters have not been set
+  * \returns \ref XRIF_ERROR_MALLOC if malloc returns a null pointer.
+  * \returns \ref XRIF_NOERROR on success
+  */
+xrif_error_t xrif_allocate_chain( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Allocate the method table of XRIF_DIFFERENCE_ADAPTIVE based on the already set frame dimensions and block size.
+/** Called as needed by \ref xrif_difference_adaptive and \ref xrif_read_header_ext.  If the table is already allocated with the 
+  * correct size this does nothing.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a null pointer
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the width, height, depth, and block size have not been set
+  * \returns \ref XRIF_ERROR_MALLOC if malloc returns a null pointer.
+  * \returns \ref XRIF_NOERROR on success
+  */
+xrif_error_t xrif_allocate_adaptive( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Allocate the LZ4 dictionary buffer and streaming decompression context.
+/** Called as needed by the LZ4 compression and decompression functions when xrif_handle::lz4_stream is true.  Does nothing if they are already allocated.
+  * The streaming compression context is allocated when it is first used, since it depends on the compression method.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a null pointer
+  * \returns \ref XRIF_ERROR_MALLOC if an allocation fails.
+  * \returns \ref XRIF_NOERROR on success
+  */
+xrif_error_t xrif_allocate_lz4_stream( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Allocate the preallocated LZ4 or LZ4HC compression states.
+/** Called by \ref xrif_allocate, and as needed by the LZ4 compression functions.  One state is allocated per thread which can compress
+  * blocks in parallel.  Does nothing if enough states are already allocated for the current compression method and xrif_handle::lz4_memory_usage.
+  * Otherwise the states are re-allocated and initialized, so that they can then be reused with a fast reset.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if `handle` is a null pointer
+  * \returns \ref XRIF_ERROR_MALLOC if malloc returns a null pointer.
+  * \returns \ref XRIF_NOERROR on success
+  */
+xrif_error_t xrif_allocate_lz4_state( xrif_t handle /**< [in/out] the xrif handle */);
+
 /// @}
 
 /** \defgroup access Current Configuration
@@ -707,18 +1219,31 @@ xrif_dimension_t xrif_frames( xrif_t handle /**< [in] the xrif handle*/);
   */
 
 /// Populate a header buffer with the xrif protocol details.
-/**
+/** The header is \ref XRIF_HEADER_SIZE bytes, except that \ref XRIF_DIFFERENCE_REFERENCE adds the 64-bit reference ID, and \ref XRIF_DIFFERENCE_ADAPTIVE
+  * adds its block size and method table, see \ref xrif_header_size.  The method table is written from the last cube encoded.
+  * 
   * \returns \ref XRIF_ERROR_NULLPTR if either header or handle is NULL
   * \returns \ref XRIF_NOERROR on success 
   */
-xrif_error_t xrif_write_header( char * header, ///< [out] the buffer to hold the protocol header. Must be at least 48 bytes long.
+xrif_error_t xrif_write_header( char * header, ///< [out] the buffer to hold the protocol header. Must be at least xrif_header_size(handle) bytes long.
                                 xrif_t handle  ///< [in] the xrif handle from which to populate the header.  This must have been created with xrif_new.
                               );
 
 /// Configure an xrif handle by reading a xrif protocol header
-/**
+/** Only the first \ref XRIF_HEADER_SIZE bytes are read.  If `header_size` is larger, the rest of the header holds parameters of the 
+  * difference method, such as the reference ID of \ref XRIF_DIFFERENCE_REFERENCE and the method table of \ref XRIF_DIFFERENCE_ADAPTIVE.  
+  * Read it into the same buffer and pass the whole header to \ref xrif_read_header_ext:
+  * \code
+  * char header[XRIF_HEADER_SIZE_EXT];
+  * fread(header, 1, XRIF_HEADER_SIZE, fp);
+  * rv = xrif_read_header(handle, &header_size, header);
+  * if(header_size > XRIF_HEADER_SIZE_EXT) ... //use a larger buffer
+  * fread(header + XRIF_HEADER_SIZE, 1, header_size - XRIF_HEADER_SIZE, fp);
+  * rv = xrif_read_header_ext(handle, header, header_size);
+  * \endcode
+  * 
   * \returns \ref XRIF_ERROR_NULLPTR if any of the arguments are NULL
-  * \returns \ref XRIF_ERROR_BADHEADER if the xrif magic number is not the first 4 bytes
+  * \returns \ref XRIF_ERROR_BADHEADER if the xrif magic number is not the first 4 bytes, or if the header is too short or does not match the size for the difference method
   * \returns \ref XRIF_ERROR_WRONGVERSION if the XRIF version in the header is too high for the compiled library
   * \returns \ref XRIF_NOERROR on success
   */
@@ -726,6 +1251,34 @@ xrif_error_t xrif_read_header( xrif_t handle,          ///< [out] the xrif heade
                                uint32_t * header_size, ///< [out] the total size of the header, read from the buffer.
                                char * header           ///< [in] the buffer containing the header
                              );
+
+/// Read the parameters which follow the first \ref XRIF_HEADER_SIZE bytes of the header.
+/** Call this after \ref xrif_read_header on the same header.  It does nothing for the difference methods which only use the first 
+  * \ref XRIF_HEADER_SIZE bytes, reads the reference ID of \ref XRIF_DIFFERENCE_REFERENCE, and reads the block size and method table of 
+  * \ref XRIF_DIFFERENCE_ADAPTIVE.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if any of the arguments are NULL
+  * \returns \ref XRIF_ERROR_BADHEADER if the total header size, in bytes 8-11, is larger than `size`, or too short for the difference method
+  * \returns \ref XRIF_ERROR_BADHEADER if the number of blocks of \ref XRIF_DIFFERENCE_ADAPTIVE does not match the frame size, the method table
+  *          does not fit in the header, or it has an invalid method
+  * \returns \ref XRIF_ERROR_MALLOC if the method table of \ref XRIF_DIFFERENCE_ADAPTIVE can not be allocated
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify encoding and decoding with a reference frame \ref encode_reference "[test doc]"
+  * \test Verify the method table is passed through the header \ref encode_adaptive "[test doc]"
+  */
+xrif_error_t xrif_read_header_ext( xrif_t handle, ///< [out] the xrif handle to configure, which has read the first part of the header with \ref xrif_read_header
+                                   char * header, ///< [in] the buffer containing the whole header
+                                   size_t size    ///< [in] the size of the buffer, which must be at least the header size
+                                 );
+
+/// Get the size of the header for the current configuration
+/** 
+  * \returns \ref XRIF_HEADER_SIZE_EXT for \ref XRIF_DIFFERENCE_REFERENCE
+  * \returns \ref XRIF_HEADER_SIZE_EXT plus the number of blocks, rounded up to a multiple of 8, for \ref XRIF_DIFFERENCE_ADAPTIVE
+  * \returns \ref XRIF_HEADER_SIZE otherwise
+  */
+uint32_t xrif_header_size( xrif_t handle /**< [in] the xrif handle */);
 ///@}
 
 /** \defgroup xrif_encode Encoding & Decoding
@@ -737,7 +1290,9 @@ xrif_error_t xrif_read_header( xrif_t handle,          ///< [out] the xrif heade
   */
 
 /// Encode data using the xrif format 
-/** Calls \ref xrif_difference(), \ref xrif_reorder(), and \ref xrif_compress().
+/** Calls \ref xrif_difference(), \ref xrif_reorder(), and \ref xrif_compress().  If \ref xrif_difference_reorder_supported() is true
+  * the first two are replaced by the single pass \ref xrif_difference_reorder(), and the reorder time is included in the difference time.
+  * If \ref xrif_tiled() is true all three are replaced by \ref xrif_encode_tiles(), and all of the time is included in the difference time.
   * If any of these returns an error, that error is returned.
   * If all methods are NONE, this is a no-op and returns immediately.
   * 
@@ -753,7 +1308,7 @@ xrif_error_t xrif_read_header( xrif_t handle,          ///< [out] the xrif heade
 xrif_error_t xrif_encode( xrif_t handle /**< [in/out] the xrif handle */);
 
 /// Decode data from the xrif format 
-/** Calls \ref xrif_decompress, \ref xrif_unreorder, and \ref xrif_undifference.
+/** Calls \ref xrif_decompress, \ref xrif_unreorder, and \ref xrif_undifference, or \ref xrif_decode_tiles if \ref xrif_tiled is true.
   * If any of these returns an error, that error is returned.
   * 
   * The timespecs are updated during this call.
@@ -770,6 +1325,68 @@ xrif_error_t xrif_decode( xrif_t handle /**< [in/out] the xrif handle */);
 
 /// @}
 
+/** \defgroup xrif_tiles Tiled Encoding & Decoding
+  * \ingroup xrif_encode
+  * 
+  * In tiled mode the cube is split into tiles of xrif_handle::tile_size bytes of the raw buffer, in pixel order.  Each tile is differenced,
+  * reordered, and LZ4 compressed before the next one is started, so the cube is read from memory once instead of once per stage.
+  * The output has the same layout as LZ4 block compression: a `uint32_t` number of tiles followed by the `uint32_t` compressed size of each tile, 
+  * with XRIF_BLOCK_RAW set for a tile stored as is, followed by the tiles.
+  * 
+  * @{
+  */
+
+/// Check whether the handle is configured for tiled encoding
+/** Tiling requires a non-zero xrif_handle::tile_size, LZ4 or LZ4HC compression, and a configuration supported by \ref xrif_difference_reorder.
+  * 
+  * \returns 1 if \ref xrif_encode and \ref xrif_decode will use tiles
+  * \returns 0 otherwise, including if handle is null
+  */
+int xrif_tiled( xrif_t handle /**< [in] the xrif handle */);
+
+/// Get the number of tiles the raw buffer is split into
+/** 
+  * \returns the number of tiles of size xrif_handle::tile_size needed to hold the cube
+  * \returns 0 if handle is null or xrif_handle::tile_size is 0
+  */
+size_t xrif_ntiles( xrif_t handle /**< [in] the xrif handle */);
+
+/// Difference, reorder, and compress the cube one tile at a time
+/** Tiles are encoded in parallel if xrif_handle::omp_parallel is set.  Each compressed tile is staged in a tile-sized slot of 
+  * xrif_handle::reordered_buffer, and the tiles are packed into the compressed buffer (the raw buffer if xrif_handle::compress_on_raw is set) 
+  * once all of the raw buffer has been read.  A tile which does not shrink, or which is skipped due to xrif_handle::skip_entropy, is stored as is.
+  * Chaining is as for \ref xrif_difference.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOTIMPL if \ref xrif_tiled is false
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if the raw, reordered, or compressed buffers are not big enough
+  * \returns \ref XRIF_ERROR_MALLOC if the tile buffers can not be allocated
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify tiled encoding and decoding \ref tiles_encode_decode "[test doc]"
+  */
+xrif_error_t xrif_encode_tiles( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Decompress, unreorder, and undifference a tiled cube one tile at a time
+/** Tiles are decoded in order, since each is undifferenced against earlier tiles.  If xrif_handle::compress_on_raw is set the compressed data 
+  * is first copied to xrif_handle::reordered_buffer, so that the tiles can be decoded into the raw buffer.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOTIMPL if \ref xrif_tiled is false
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if the raw or reordered buffers are not big enough
+  * \returns \ref XRIF_ERROR_INVALID_SIZE if the tile table does not match the configuration, or a tile decompresses to the wrong size
+  * \returns \ref XRIF_ERROR_NOREFERENCE if the cube is chained and the reference frame is not available
+  * \returns \ref XRIF_ERROR_MALLOC if the tile buffer can not be allocated
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify tiled encoding and decoding \ref tiles_encode_decode "[test doc]"
+  */
+xrif_error_t xrif_decode_tiles( xrif_t handle /**< [in/out] the xrif handle */);
+
+///@}
+
 /** \defgroup xrif_diff Differencing
   * \ingroup xrif_encode
   * 
@@ -798,52 +1415,150 @@ xrif_error_t xrif_difference( xrif_t handle /**< [in/out] the xrif handle */ );
   */
 xrif_error_t xrif_undifference( xrif_t handle /**< [in/out] the xrif handle */ );
 
-///@}
-
-/** \defgroup xrif_diff_previous Previous Differencing
-  * \ingroup xrif_diff
-  * 
-  * The previous differencing method uses the previous frame as the reference.
+/// Check whether differencing and reordering can be done in a single pass
+/** Fused kernels exist for previous, first, and pixel differencing of integer types, with bytepack reordering, or with bytepack renibble
+  * reordering for 16 bit integers.
   * 
-  * @{
+  * \returns 1 if \ref xrif_difference_reorder supports the configuration of the handle
+  * \returns 0 otherwise
   */
+int xrif_difference_reorder_supported( xrif_t handle /**< [in] the xrif handle */ );
 
-/// Difference the images using the previous image as a reference.
-/** This function calls the type specific difference function for the type specified by
-  * handle->type_code.
+/// Difference and reorder the image(s) in a single pass
+/** Computes the residuals of each chunk of \ref XRIF_REORDER_CHUNK pixels into a per-thread buffer and reorders them from there while they are
+  * in cache, so xrif_handle::raw_buffer is read once and is not modified.  The output, including chaining, is the same as from 
+  * \ref xrif_difference followed by \ref xrif_reorder.
   * 
   * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
   * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
-  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
-  * \returns \ref XRIF_ERROR_NOTIMPL if differencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_ERROR_NOTIMPL if \ref xrif_difference_reorder_supported is false
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reordered_buffer aren't big enough
+  * \returns \ref XRIF_ERROR_MALLOC if the residual buffer can not be allocated
   * \returns \ref XRIF_NOERROR on success
   * 
-  * \test Verify previous differencing for int16_t \ref diff_previous_int16_white "[test doc]"
-  * \test Verify previous differencing for uint16_t \ref diff_previous_uint16_white "[test doc]"
-  * \test Verify previous differencing for int32_t \ref diff_previous_int32_white "[test doc]"
-  * \test Verify previous differencing for uint32_t \ref diff_previous_uint32_white "[test doc]"
-  * \test Verify previous differencing for int64_t \ref diff_previous_int64_white "[test doc]"
-  * \test Verify previous differencing for uint64_t \ref diff_previous_uint64_white "[test doc]"
+  * \test Verify the fused stage matches differencing then reordering \ref difference_reorder_match "[test doc]"
   */
-xrif_error_t xrif_difference_previous( xrif_t handle /**< [in/out] the xrif handle */ );
+xrif_error_t xrif_difference_reorder( xrif_t handle /**< [in/out] the xrif handle */ );
+
+/// Compute the residuals of a run of 16 bit pixels
+/** The residuals are those \ref xrif_difference would produce for pixels `r` to `r+n-1` of xrif_handle::raw_buffer, which is not modified.
+  * The first frame is differenced against the chain reference if xrif_handle::chained is set.  Used by \ref xrif_difference_reorder and \ref xrif_encode_tiles.
+  */
+void xrif_residual_sint16( int16_t * res, ///< [out] the residuals, `n` pixels
+                          xrif_t handle, ///< [in] the xrif handle
+                          int method,    ///< [in] the difference method, not 0
+                          size_t r,      ///< [in] the index of the first pixel in the raw buffer
+                          size_t n       ///< [in] the number of pixels
+                        );
+
+/// Compute the residuals of a run of 32 bit pixels
+/** As \ref xrif_residual_sint16.
+  */
+void xrif_residual_sint32( int32_t * res, ///< [out] the residuals, `n` pixels
+                          xrif_t handle, ///< [in] the xrif handle
+                          int method,    ///< [in] the difference method, not 0
+                          size_t r,      ///< [in] the index of the first pixel in the raw buffer
+                          size_t n       ///< [in] the number of pixels
+                        );
+
+/// Compute the residuals of a run of 64 bit pixels
+/** As \ref xrif_residual_sint16.
+  */
+void xrif_residual_sint64( int64_t * res, ///< [out] the residuals, `n` pixels
+                          xrif_t handle, ///< [in] the xrif handle
+                          int method,    ///< [in] the difference method, not 0
+                          size_t r,      ///< [in] the index of the first pixel in the raw buffer
+                          size_t n       ///< [in] the number of pixels
+                        );
 
 ///@}
 
-/** \defgroup xrif_diff_first First Differencing
+/** \defgroup xrif_diff_chain Cube Chaining
   * \ingroup xrif_diff
   * 
-  * The first differencing method uses the first frame as the reference for all subsequent frames.
+  * When cubes are chained, the first frame of a cube is differenced against the last frame of the previous cube.  
+  * This is applied on top of the difference method, by \ref xrif_difference and \ref xrif_undifference.  See \ref xrif_set_chain_cubes.
   * 
   * @{
   */
 
-/// Difference the images using the first image as a reference.
-/** This function calls the type specific difference function for the type specified by
-  * handle->type_code.
+/// Difference the first frame against the encoding reference frame.
+/** This function calls the type specific function for the type specified by
+  * handle->type_code.  It is called by \ref xrif_difference after the difference method, and does not update the reference.
   * 
   * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
-  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
-  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured, or the chain buffer is not allocated
+  * \returns \ref XRIF_ERROR_NOTIMPL if differencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify chained encoding and decoding of a sequence of cubes \ref chain_previous_int16_white "[test doc]"
+  */
+xrif_error_t xrif_difference_chain( xrif_t handle /**< [in/out] the xrif handle */ );
+
+/// Undifference the first frame using the decoding reference frame.
+/** This function calls the type specific function for the type specified by
+  * handle->type_code.  It is called by \ref xrif_undifference before the difference method, and does not update the reference.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_NOREFERENCE if the decoding reference frame is not allocated with the correct size
+  * \returns \ref XRIF_ERROR_NOTIMPL if undifferencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify chained encoding and decoding of a sequence of cubes \ref chain_previous_int16_white "[test doc]"
+  * \test Verify a chained cube can not be decoded without its reference \ref chain_noreference "[test doc]"
+  */
+xrif_error_t xrif_undifference_chain( xrif_t handle /**< [in/out] the xrif handle */ );
+
+///@}
+
+/** \defgroup xrif_diff_previous Previous Differencing
+  * \ingroup xrif_diff
+  * 
+  * The previous differencing method uses the previous frame as the reference.
+  * 
+  * @{
+  */
+
+/// Difference the images using the previous image as a reference.
+/** This function calls the type specific difference function for the type specified by
+  * handle->type_code.
+  * Floating point types (see \ref xrif_typeisfloat) are XORed with the reference rather than subtracted, which is lossless for any bit pattern.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_NOTIMPL if differencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify previous differencing for int16_t \ref diff_previous_int16_white "[test doc]"
+  * \test Verify previous differencing for uint16_t \ref diff_previous_uint16_white "[test doc]"
+  * \test Verify previous differencing for int32_t \ref diff_previous_int32_white "[test doc]"
+  * \test Verify previous differencing for uint32_t \ref diff_previous_uint32_white "[test doc]"
+  * \test Verify previous differencing for int64_t \ref diff_previous_int64_white "[test doc]"
+  * \test Verify previous differencing for uint64_t \ref diff_previous_uint64_white "[test doc]"
+  * \test Verify threaded previous differencing \ref diff_previous_int16_omp "[test doc]"
+  */
+xrif_error_t xrif_difference_previous( xrif_t handle /**< [in/out] the xrif handle */ );
+
+///@}
+
+/** \defgroup xrif_diff_first First Differencing
+  * \ingroup xrif_diff
+  * 
+  * The first differencing method uses the first frame as the reference for all subsequent frames.
+  * 
+  * @{
+  */
+
+/// Difference the images using the first image as a reference.
+/** This function calls the type specific difference function for the type specified by
+  * handle->type_code.
+  * Floating point types (see \ref xrif_typeisfloat) are XORed with the reference rather than subtracted, which is lossless for any bit pattern.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
   * \returns \ref XRIF_ERROR_NOTIMPL if differencing is not implemented for the type specified in xrif_handle::type_code
   * \returns \ref XRIF_NOERROR on success
   * 
@@ -853,6 +1568,7 @@ xrif_error_t xrif_difference_previous( xrif_t handle /**< [in/out] the xrif hand
   * \test Verify first differencing for uint32_t \ref diff_first_uint32_white "[test doc]"
   * \test Verify first differencing for int64_t \ref diff_first_int64_white "[test doc]"
   * \test Verify first differencing for uint64_t \ref diff_first_uint64_white "[test doc]"
+  * \test Verify threaded first differencing \ref diff_first_int16_omp "[test doc]"
   */
 xrif_error_t xrif_difference_first( xrif_t handle /**< [in/out] the xrif handle */ );
 
@@ -869,6 +1585,8 @@ xrif_error_t xrif_difference_first( xrif_t handle /**< [in/out] the xrif handle
 /// Difference the images using the previous pixel as a reference.
 /** This function calls the type specific difference function for the type specified by
   * handle->type_code.
+  * The pixels of the cube are split into one contiguous range per thread.  Each thread reads the reference for the start of its range
+  * before any thread writes, and each range is differenced in blocks copied to the stack so the loop vectorizes.
   * 
   * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
   * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
@@ -882,6 +1600,7 @@ xrif_error_t xrif_difference_first( xrif_t handle /**< [in/out] the xrif handle
   * \test Verify pixel differencing for uint32_t \ref diff_pixel_uint32_white "[test doc]"
   * \test Verify pixel differencing for int64_t \ref diff_pixel_int64_white "[test doc]"
   * \test Verify pixel differencing for uint64_t \ref diff_pixel_uint64_white "[test doc]"
+  * \test Verify threaded pixel differencing \ref diff_pixel_int16_omp "[test doc]"
   * 
   */
 xrif_error_t xrif_difference_pixel( xrif_t handle /**< [in/out] the xrif handle */ );
@@ -892,6 +1611,8 @@ xrif_error_t xrif_difference_pixel( xrif_t handle /**< [in/out] the xrif handle
 /// Undifference the images using the previous image as a reference.
 /** This function calls the type specific undifference function for the type specified by
   * handle->type_code.
+  * Each pixel's time series is independent, so the frames are split into blocks of \ref XRIF_UNDIFFERENCE_BLOCK bytes which
+  * are distributed over threads, and each block is walked through all the frames.
   * 
   * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
   * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
@@ -905,6 +1626,7 @@ xrif_error_t xrif_difference_pixel( xrif_t handle /**< [in/out] the xrif handle
   * \test Verify previous differencing for uint32_t \ref diff_previous_uint32_white "[test doc]"
   * \test Verify previous differencing for int64_t \ref diff_previous_int64_white "[test doc]"
   * \test Verify previous differencing for uint64_t \ref diff_previous_uint64_white "[test doc]"
+  * \test Verify threaded previous differencing \ref diff_previous_int16_omp "[test doc]"
   * 
   * \ingroup xrif_diff_previous
   */
@@ -934,6 +1656,8 @@ xrif_error_t xrif_undifference_first( xrif_t handle /**< [in/out] the xrif handl
 /// Undifference the images using the previous pixel as a reference.
 /** This function calls the type specific undifference function for the type specified by
   * handle->type_code.
+  * Each thread sums its own range with \ref xrif_undifference_pixel_sint16_kernel and the like, then adds the sums of
+  * the ranges before it in the same image.
   * 
   * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
   * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
@@ -947,11 +1671,404 @@ xrif_error_t xrif_undifference_first( xrif_t handle /**< [in/out] the xrif handl
   * \test Verify pixel differencing for uint32_t \ref diff_pixel_uint32_white "[test doc]"
   * \test Verify pixel differencing for int64_t \ref diff_pixel_int64_white "[test doc]"
   * \test Verify pixel differencing for uint64_t \ref diff_pixel_uint64_white "[test doc]"
+  * \test Verify threaded pixel differencing \ref diff_pixel_int16_omp "[test doc]"
   * 
   * \ingroup xrif_diff_pixel
   */
 xrif_error_t xrif_undifference_pixel( xrif_t handle /**< [in/out] the xrif handle */ );
 
+/// Undifference a run of 8 bit pixels within one image
+/** Replaces each pixel with the running sum of the run, starting from `prev`.  The SSE2 kernel sums each register with shifts and adds.
+  *
+  * \test Verify the vector kernels match the scalar kernel \ref undifference_pixel_simd "[test doc]"
+  * 
+  * \ingroup xrif_diff_pixel
+  */
+void xrif_undifference_pixel_sint8_kernel( int8_t * pix, ///< [in/out] the differences, replaced by the pixel values
+                                           size_t npix,  ///< [in] the number of pixels
+                                           int8_t prev,  ///< [in] the value of the pixel before the run, 0 at the start of an image
+                                           int simd      ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                         );
+
+/// Undifference a run of 16 bit pixels within one image
+/** Replaces each pixel with the running sum of the run, starting from `prev`.  The SSE2 kernel sums each register with shifts and adds.
+  *
+  * \test Verify the vector kernels match the scalar kernel \ref undifference_pixel_simd "[test doc]"
+  * 
+  * \ingroup xrif_diff_pixel
+  */
+void xrif_undifference_pixel_sint16_kernel( int16_t * pix, ///< [in/out] the differences, replaced by the pixel values
+                                            size_t npix,   ///< [in] the number of pixels
+                                            int16_t prev,  ///< [in] the value of the pixel before the run, 0 at the start of an image
+                                            int simd       ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                          );
+
+/// Undifference a run of 32 bit pixels within one image
+/** Replaces each pixel with the running sum of the run, starting from `prev`.  The SSE2 kernel sums each register with shifts and adds.
+  *
+  * \test Verify the vector kernels match the scalar kernel \ref undifference_pixel_simd "[test doc]"
+  * 
+  * \ingroup xrif_diff_pixel
+  */
+void xrif_undifference_pixel_sint32_kernel( int32_t * pix, ///< [in/out] the differences, replaced by the pixel values
+                                            size_t npix,   ///< [in] the number of pixels
+                                            int32_t prev,  ///< [in] the value of the pixel before the run, 0 at the start of an image
+                                            int simd       ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                          );
+
+/// Undifference a run of 64 bit pixels within one image
+/** Replaces each pixel with the running sum of the run, starting from `prev`.  The SSE2 kernel sums each register with shifts and adds.
+  *
+  * \test Verify the vector kernels match the scalar kernel \ref undifference_pixel_simd "[test doc]"
+  * 
+  * \ingroup xrif_diff_pixel
+  */
+void xrif_undifference_pixel_sint64_kernel( int64_t * pix, ///< [in/out] the differences, replaced by the pixel values
+                                            size_t npix,   ///< [in] the number of pixels
+                                            int64_t prev,  ///< [in] the value of the pixel before the run, 0 at the start of an image
+                                            int simd       ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                          );
+
+
+/** \defgroup xrif_diff_spatial Spatial Predictor Differencing
+  * \ingroup xrif_diff
+  * 
+  * The spatial predictors use the pixels to the left (a), above (b), and above-left (c) in the same image as the reference.
+  * - \ref XRIF_DIFFERENCE_MED, the median edge detector of LOCO-I: min(a,b) if c >= max(a,b), max(a,b) if c <= min(a,b), and a + b - c otherwise.
+  * - \ref XRIF_DIFFERENCE_PAETH, whichever of a, b, and c is closest to a + b - c, with ties going to a then b.
+  * - \ref XRIF_DIFFERENCE_AVERAGE, (a + b)/2 rounded down.
+  * 
+  * The first row of each image is differenced with the pixel to the left, and the first pixel of the other rows with the pixel above.
+  * Every frame is differenced, so the whole cube is reordered.  Encoding is threaded over rows, but decoding only over images, 
+  * see \ref xrif_undifference_spatial.
+  * 
+  * \ref XRIF_DIFFERENCE_PREVIOUS_MED first subtracts the previous frame, and then applies the median edge detector to the temporal residuals.
+  * 
+  * @{
+  */
+
+/// Check if a difference method is one of the spatial predictors
+/**
+  * \returns 1 if `method` is \ref XRIF_DIFFERENCE_MED, \ref XRIF_DIFFERENCE_PAETH, or \ref XRIF_DIFFERENCE_AVERAGE
+  * \returns 0 otherwise
+  */
+int xrif_difference_spatial_method( int method /**< [in] the difference method */ );
+
+/// Difference the images using the spatial predictor in xrif_handle::difference_method.
+/** This function calls the type specific difference function for the type specified by
+  * handle->type_code.
+  * The rows of the cube are split into one contiguous range per thread.  Each thread copies the row above its range before any
+  * thread writes, and differences each row from copies of the original rows so the loops vectorize.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_BADARG if xrif_handle::difference_method is not a spatial predictor
+  * \returns \ref XRIF_ERROR_NOTIMPL if differencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_ERROR_MALLOC if the row buffers can not be allocated
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify spatial differencing for int16_t \ref diff_spatial_int16_white "[test doc]"
+  * \test Verify spatial differencing for uint16_t \ref diff_spatial_uint16_white "[test doc]"
+  * \test Verify spatial differencing for int32_t \ref diff_spatial_int32_white "[test doc]"
+  * \test Verify spatial differencing for int64_t \ref diff_spatial_int64_white "[test doc]"
+  * \test Verify threaded spatial differencing \ref diff_spatial_int16_omp "[test doc]"
+  * \test Verify the spatial predictors \ref diff_spatial_predictors "[test doc]"
+  */
+xrif_error_t xrif_difference_spatial( xrif_t handle /**< [in/out] the xrif handle */ );
+
+/// Undifference the images using the spatial predictor in xrif_handle::difference_method.
+/** This function calls the type specific undifference function for the type specified by
+  * handle->type_code.
+  * Each prediction needs the restored pixel to its left, so the images are distributed over threads and each is restored
+  * row by row.  The first row of each image is restored with \ref xrif_undifference_pixel_sint16_kernel and the like.
+  * 
+  * Decoding is therefore serial within an image: a cube with a single frame and plane is restored on one thread, while 
+  * encoding it is split over the rows.  Use several frames or planes per cube if decoding speed matters.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_BADARG if xrif_handle::difference_method is not a spatial predictor
+  * \returns \ref XRIF_ERROR_NOTIMPL if undifferencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify spatial differencing for int16_t \ref diff_spatial_int16_white "[test doc]"
+  * \test Verify spatial differencing for uint16_t \ref diff_spatial_uint16_white "[test doc]"
+  * \test Verify spatial differencing for int32_t \ref diff_spatial_int32_white "[test doc]"
+  * \test Verify spatial differencing for int64_t \ref diff_spatial_int64_white "[test doc]"
+  * \test Verify threaded spatial differencing \ref diff_spatial_int16_omp "[test doc]"
+  * \test Verify the spatial predictors \ref diff_spatial_predictors "[test doc]"
+  */
+xrif_error_t xrif_undifference_spatial( xrif_t handle /**< [in/out] the xrif handle */ );
+
+
+/// Difference the images using the previous frame, and then the median edge detector on the temporal residuals.
+/** This function calls the type specific difference function for the type specified by
+  * handle->type_code.
+  * Static structure is left by the temporal difference and turbulence by the spatial one.  The first frame is only differenced spatially.
+  * Both differences are taken in one pass: the temporal residuals of two rows are kept in per-thread buffers and the result is 
+  * written in place of the current row.  The frames are differenced from last to first, with the rows of each frame split over threads.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_NOTIMPL if differencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_ERROR_MALLOC if the row buffers can not be allocated
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify previous frame + MED differencing for int16_t \ref diff_previous_med_int16_white "[test doc]"
+  * \test Verify previous frame + MED differencing for int32_t \ref diff_previous_med_int32_white "[test doc]"
+  * \test Verify threaded previous frame + MED differencing \ref diff_previous_med_int16_omp "[test doc]"
+  * \test Verify the previous frame + MED residuals \ref diff_previous_med_residuals "[test doc]"
+  */
+xrif_error_t xrif_difference_previous_med( xrif_t handle /**< [in/out] the xrif handle */ );
+
+/// Undifference the images using the previous frame, and then the median edge detector on the temporal residuals.
+/** The temporal residuals of each image are independent, so they are restored as for \ref xrif_undifference_spatial, and then the
+  * frames are restored with \ref xrif_undifference_previous.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_NOTIMPL if undifferencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify previous frame + MED differencing for int16_t \ref diff_previous_med_int16_white "[test doc]"
+  * \test Verify previous frame + MED differencing for int32_t \ref diff_previous_med_int32_white "[test doc]"
+  * \test Verify threaded previous frame + MED differencing \ref diff_previous_med_int16_omp "[test doc]"
+  * \test Verify the previous frame + MED residuals \ref diff_previous_med_residuals "[test doc]"
+  */
+xrif_error_t xrif_undifference_previous_med( xrif_t handle /**< [in/out] the xrif handle */ );
+
+///@}
+
+/** \defgroup xrif_diff_linear Linear Differencing
+  * \ingroup xrif_diff
+  * 
+  * The linear differencing method extrapolates the line through the two frames before, predicting each pixel as 2*x[n-1] - x[n-2].
+  * This removes a steady drift, such as a thermal background or a ramping detector read, which is left in the residuals of
+  * \ref XRIF_DIFFERENCE_PREVIOUS.  The prediction is clamped to the range of the type, so a drift which would run past the end
+  * of the range does not wrap around.  The second frame is differenced w.r.t. the first, and the first frame is not differenced.
+  * 
+  * @{
+  */
+
+/// Difference the images using the linear prediction from the two frames before.
+/** This function calls the type specific difference function for the type specified by
+  * handle->type_code.  16 and 32 bit types use vector kernels when available.  Floating point types are not supported.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_NOTIMPL if differencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify linear differencing for int16_t \ref diff_linear_int16_white "[test doc]"
+  * \test Verify linear differencing for uint16_t \ref diff_linear_uint16_white "[test doc]"
+  * \test Verify linear differencing for int32_t \ref diff_linear_int32_white "[test doc]"
+  * \test Verify linear differencing for uint32_t \ref diff_linear_uint32_white "[test doc]"
+  * \test Verify linear differencing for int64_t \ref diff_linear_int64_white "[test doc]"
+  * \test Verify linear differencing for uint64_t \ref diff_linear_uint64_white "[test doc]"
+  * \test Verify threaded linear differencing \ref diff_linear_int16_omp "[test doc]"
+  * \test Verify linear differencing of ramps \ref diff_linear_ramp "[test doc]"
+  */
+xrif_error_t xrif_difference_linear( xrif_t handle /**< [in/out] the xrif handle */ );
+
+/// Undifference the images using the linear prediction from the two frames before.
+/** This function calls the type specific undifference function for the type specified by
+  * handle->type_code.  Blocks of pixels are walked through all the frames, as for \ref xrif_undifference_previous.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_NOTIMPL if undifferencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify linear differencing for int16_t \ref diff_linear_int16_white "[test doc]"
+  * \test Verify linear differencing for uint16_t \ref diff_linear_uint16_white "[test doc]"
+  * \test Verify linear differencing for int32_t \ref diff_linear_int32_white "[test doc]"
+  * \test Verify linear differencing for uint32_t \ref diff_linear_uint32_white "[test doc]"
+  * \test Verify linear differencing for int64_t \ref diff_linear_int64_white "[test doc]"
+  * \test Verify linear differencing for uint64_t \ref diff_linear_uint64_white "[test doc]"
+  * \test Verify threaded linear differencing \ref diff_linear_int16_omp "[test doc]"
+  * \test Verify linear differencing of ramps \ref diff_linear_ramp "[test doc]"
+  */
+xrif_error_t xrif_undifference_linear( xrif_t handle /**< [in/out] the xrif handle */ );
+
+///@}
+
+/// Difference a run of 16 bit pixels with the linear prediction from the two frames before
+/** Subtracts the prediction 2*x1 - x0, clamped to the range of the type, from each pixel.
+  *
+  * \test Verify the vector kernels match the scalar kernel \ref linear_simd "[test doc]"
+  * 
+  * \ingroup xrif_diff_linear
+  */
+void xrif_difference_linear_sint16_kernel( int16_t * x2,       ///< [in/out] the frame to difference, replaced by the residuals
+                                           const int16_t * x1, ///< [in] the same pixels in the frame before
+                                           const int16_t * x0, ///< [in] the same pixels two frames before
+                                           size_t npix,        ///< [in] the number of pixels
+                                           int16_t bias,       ///< [in] 0 for signed types, INT16_MIN for unsigned types
+                                           int simd            ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                         );
+
+/// Undifference a run of 16 bit pixels with the linear prediction from the two frames before
+/** Adds the prediction 2*x1 - x0, clamped to the range of the type, to each pixel.
+  *
+  * \test Verify the vector kernels match the scalar kernel \ref linear_simd "[test doc]"
+  * 
+  * \ingroup xrif_diff_linear
+  */
+void xrif_undifference_linear_sint16_kernel( int16_t * x2,       ///< [in/out] the residuals, replaced by the frame
+                                             const int16_t * x1, ///< [in] the same pixels in the frame before
+                                             const int16_t * x0, ///< [in] the same pixels two frames before
+                                             size_t npix,        ///< [in] the number of pixels
+                                             int16_t bias,       ///< [in] 0 for signed types, INT16_MIN for unsigned types
+                                             int simd            ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                           );
+
+/// Difference a run of 32 bit pixels with the linear prediction from the two frames before
+/** Subtracts the prediction 2*x1 - x0, clamped to the range of the type, from each pixel.
+  *
+  * \test Verify the vector kernels match the scalar kernel \ref linear_simd "[test doc]"
+  * 
+  * \ingroup xrif_diff_linear
+  */
+void xrif_difference_linear_sint32_kernel( int32_t * x2,       ///< [in/out] the frame to difference, replaced by the residuals
+                                           const int32_t * x1, ///< [in] the same pixels in the frame before
+                                           const int32_t * x0, ///< [in] the same pixels two frames before
+                                           size_t npix,        ///< [in] the number of pixels
+                                           int32_t bias,       ///< [in] 0 for signed types, INT32_MIN for unsigned types
+                                           int simd            ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                         );
+
+/// Undifference a run of 32 bit pixels with the linear prediction from the two frames before
+/** Adds the prediction 2*x1 - x0, clamped to the range of the type, to each pixel.
+  *
+  * \test Verify the vector kernels match the scalar kernel \ref linear_simd "[test doc]"
+  * 
+  * \ingroup xrif_diff_linear
+  */
+void xrif_undifference_linear_sint32_kernel( int32_t * x2,       ///< [in/out] the residuals, replaced by the frame
+                                             const int32_t * x1, ///< [in] the same pixels in the frame before
+                                             const int32_t * x0, ///< [in] the same pixels two frames before
+                                             size_t npix,        ///< [in] the number of pixels
+                                             int32_t bias,       ///< [in] 0 for signed types, INT32_MIN for unsigned types
+                                             int simd            ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                           );
+
+/** \defgroup xrif_diff_reference Reference Differencing
+  * \ingroup xrif_diff
+  * 
+  * The reference differencing method subtracts a frame supplied by the caller with \ref xrif_set_reference from every frame,
+  * including the first.  Only the ID of the reference is stored in the header.
+  * 
+  * @{
+  */
+
+/// Difference the images using the caller's reference frame.
+/** This function calls the type specific difference function for the type specified by
+  * handle->type_code, and records xrif_handle::reference_frame_id as the ID of the cube's reference.
+  * Floating point types (see \ref xrif_typeisfloat) are XORed with the reference rather than subtracted, which is lossless for any bit pattern.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_NOREFERENCE if the reference frame is not set, or is smaller than one frame
+  * \returns \ref XRIF_ERROR_NOTIMPL if differencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify reference differencing for int16_t \ref diff_reference_int16_white "[test doc]"
+  * \test Verify reference differencing for uint16_t \ref diff_reference_uint16_white "[test doc]"
+  * \test Verify reference differencing for int32_t \ref diff_reference_int32_white "[test doc]"
+  * \test Verify reference differencing for uint32_t \ref diff_reference_uint32_white "[test doc]"
+  * \test Verify reference differencing for int64_t \ref diff_reference_int64_white "[test doc]"
+  * \test Verify reference differencing for uint64_t \ref diff_reference_uint64_white "[test doc]"
+  * \test Verify threaded reference differencing \ref diff_reference_int16_omp "[test doc]"
+  */
+xrif_error_t xrif_difference_reference( xrif_t handle /**< [in/out] the xrif handle */ );
+
+/// Undifference the images using the caller's reference frame.
+/** This function calls the type specific undifference function for the type specified by
+  * handle->type_code.  The reference frame must have the ID read from the header.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_NOREFERENCE if the reference frame is not set, is smaller than one frame, or its ID is not xrif_handle::reference_id
+  * \returns \ref XRIF_ERROR_NOTIMPL if undifferencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify reference differencing for int16_t \ref diff_reference_int16_white "[test doc]"
+  * \test Verify reference differencing for uint16_t \ref diff_reference_uint16_white "[test doc]"
+  * \test Verify reference differencing for int32_t \ref diff_reference_int32_white "[test doc]"
+  * \test Verify reference differencing for uint32_t \ref diff_reference_uint32_white "[test doc]"
+  * \test Verify reference differencing for int64_t \ref diff_reference_int64_white "[test doc]"
+  * \test Verify reference differencing for uint64_t \ref diff_reference_uint64_white "[test doc]"
+  * \test Verify threaded reference differencing \ref diff_reference_int16_omp "[test doc]"
+  * \test Verify the reference frame and its ID are needed to decode \ref encode_reference "[test doc]"
+  */
+xrif_error_t xrif_undifference_reference( xrif_t handle /**< [in/out] the xrif handle */ );
+
+///@}
+
+/** \defgroup xrif_diff_adaptive Adaptive Differencing
+  * \ingroup xrif_diff
+  * 
+  * The adaptive differencing method splits each frame into square blocks (see \ref xrif_set_adaptive_block_size), and differences each block through
+  * the whole cube with the method which gives it the smallest residuals: none, previous frame, first frame, or previous pixel in the row of the block.
+  * The residuals are estimated on the first frame and up to \ref XRIF_ADAPTIVE_SAMPLE_FRAMES - 1 others, as the number of bits needed for each
+  * residual after folding the sign.  This lets static regions, such as vignetted corners, and changing regions, such as a pupil, use different methods.
+  * The choices are stored in the method table in the header.  The key frame interval does not apply.
+  * 
+  * @{
+  */
+
+/// Difference the images choosing the method of each block.
+/** This function calls the type specific difference function for the type specified by
+  * handle->type_code, and fills xrif_handle::adaptive_methods.  Floating point types are not supported.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_MALLOC if the method table can not be allocated
+  * \returns \ref XRIF_ERROR_NOTIMPL if differencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify adaptive differencing for int16_t \ref diff_adaptive_int16_white "[test doc]"
+  * \test Verify adaptive differencing for uint16_t \ref diff_adaptive_uint16_white "[test doc]"
+  * \test Verify adaptive differencing for int32_t \ref diff_adaptive_int32_white "[test doc]"
+  * \test Verify adaptive differencing for uint32_t \ref diff_adaptive_uint32_white "[test doc]"
+  * \test Verify adaptive differencing for int64_t \ref diff_adaptive_int64_white "[test doc]"
+  * \test Verify adaptive differencing for uint64_t \ref diff_adaptive_uint64_white "[test doc]"
+  * \test Verify threaded adaptive differencing \ref diff_adaptive_int16_omp "[test doc]"
+  * \test Verify adaptive differencing chooses the method of each block \ref diff_adaptive_choice "[test doc]"
+  */
+xrif_error_t xrif_difference_adaptive( xrif_t handle /**< [in/out] the xrif handle */ );
+
+/// Undifference the images using the method of each block.
+/** This function calls the type specific undifference function for the type specified by
+  * handle->type_code, using the method table in xrif_handle::adaptive_methods.  Each block is walked through all the frames.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if the handle is NULL
+  * \returns \ref XRIF_ERROR_NOT_SETUP if the handle is not configured, or the method table is not set
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if raw_buffer_size is not big enough given the configuration
+  * \returns \ref XRIF_ERROR_NOTIMPL if undifferencing is not implemented for the type specified in xrif_handle::type_code
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify adaptive differencing for int16_t \ref diff_adaptive_int16_white "[test doc]"
+  * \test Verify adaptive differencing for uint16_t \ref diff_adaptive_uint16_white "[test doc]"
+  * \test Verify adaptive differencing for int32_t \ref diff_adaptive_int32_white "[test doc]"
+  * \test Verify adaptive differencing for uint32_t \ref diff_adaptive_uint32_white "[test doc]"
+  * \test Verify adaptive differencing for int64_t \ref diff_adaptive_int64_white "[test doc]"
+  * \test Verify adaptive differencing for uint64_t \ref diff_adaptive_uint64_white "[test doc]"
+  * \test Verify threaded adaptive differencing \ref diff_adaptive_int16_omp "[test doc]"
+  * \test Verify the method table is passed through the header \ref encode_adaptive "[test doc]"
+  */
+xrif_error_t xrif_undifference_adaptive( xrif_t handle /**< [in/out] the xrif handle */ );
+
+///@}
 
 /** \defgroup xrif_reorder Reordering
   * \ingroup xrif_encode 
@@ -972,6 +2089,15 @@ xrif_error_t xrif_reorder( xrif_t handle /**< [in/out] the xrif handle */);
   */ 
 xrif_error_t xrif_unreorder( xrif_t handle /**< [in/out] the xrif handle */);
 
+/// Check whether the first frame is reordered along with the rest.
+/** The first frame is normally copied verbatim, since it is the reference for the other frames.  It is reordered if 
+  * it has been differenced too, as for XRIF_DIFFERENCE_PIXEL, the spatial predictors, XRIF_DIFFERENCE_PREVIOUS_MED, or a chained cube.
+  * 
+  * \returns 1 if the first frame is reordered
+  * \returns 0 if the first frame is copied verbatim
+  */ 
+int xrif_reorder_first_frame( xrif_t handle /**< [in] the xrif handle */);
+
 //xrif_reorder:
 ///@}
 
@@ -1022,17 +2148,225 @@ xrif_error_t xrif_reorder_bytepack( xrif_t handle /**< [in/out] the xrif handle
   */ 
 xrif_error_t xrif_reorder_bytepack_sint16( xrif_t handle /**< [in/out] the xrif handle */ );
 
+/// Perform bytepack reodering for signed 32 bit ints
+/** The pixels are sign-folded (zigzag encoded) and split into 4 byte planes, lowest byte first.
+  *
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  */ 
+xrif_error_t xrif_reorder_bytepack_sint32( xrif_t handle /**< [in/out] the xrif handle */ );
+
+/// Perform bytepack reodering for signed 64 bit ints
+/** The pixels are sign-folded (zigzag encoded) and split into 8 byte planes, lowest byte first.
+  *
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  */ 
+xrif_error_t xrif_reorder_bytepack_sint64( xrif_t handle /**< [in/out] the xrif handle */ );
+
+/// Get the vector instruction set available for the reordering kernels.
+/** Detected at runtime with cpuid, so the kernels used match the CPU the code runs on rather than the one it was compiled for.
+  * Always XRIF_SIMD_NONE if XRIF_NO_SIMD is defined at compile time, or on non-x86 platforms.
+  * 
+  * \returns XRIF_SIMD_AVX2, XRIF_SIMD_SSE2, or XRIF_SIMD_NONE.
+  */
+int xrif_simd_level(void);
+
+/// Bytepack reorder a run of 16 bit pixels
+/** Splits the pixels into a plane of low bytes and a plane of high bytes, swapping the high byte between 0 and -1 when the low byte is negative 
+  * so that small negative values have a zero high byte.  The vector kernels deinterleave with packs and apply the swap with compares, without branches.
+  * 
+  * \test Verify the vector kernels match the scalar kernel \ref reorder_simd_sint16 "[test doc]"
+  */
+void xrif_reorder_bytepack_sint16_kernel( char * lo,       ///< [out] the low byte plane, `npix` bytes
+                                          char * hi,       ///< [out] the high byte plane, `npix` bytes
+                                          const char * raw, ///< [in] the pixels, `2*npix` bytes
+                                          size_t npix,      ///< [in] the number of pixels
+                                          int simd          ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                        );
+
+/// Bytepack unreorder a run of 16 bit pixels
+/** The inverse of \ref xrif_reorder_bytepack_sint16_kernel.
+  * 
+  * \test Verify the vector kernels match the scalar kernel \ref reorder_simd_sint16 "[test doc]"
+  */
+void xrif_unreorder_bytepack_sint16_kernel( char * raw,      ///< [out] the pixels, `2*npix` bytes
+                                            const char * lo, ///< [in] the low byte plane, `npix` bytes
+                                            const char * hi, ///< [in] the high byte plane, `npix` bytes
+                                            size_t npix,     ///< [in] the number of pixels
+                                            int simd         ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                          );
+
+/// Bytepack reorder a run of 32 bit pixels
+/** Zigzag encodes each pixel, `(x << 1) ^ (x >> 31)`, so that small negative values have zero high bytes, then writes byte b of each pixel 
+  * to plane b.  The vector kernel transposes 16 pixels at a time with byte unpacks.
+  * 
+  * \test Verify the vector kernels match the scalar kernel \ref reorder_simd_wide "[test doc]"
+  */
+void xrif_reorder_bytepack_sint32_kernel( char * planes,    ///< [out] the first byte plane, followed by the others every `stride` bytes
+                                          size_t stride,    ///< [in] the distance between the start of the planes
+                                          const char * raw, ///< [in] the pixels, `4*npix` bytes
+                                          size_t npix,      ///< [in] the number of pixels
+                                          int simd          ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                        );
+
+/// Bytepack unreorder a run of 32 bit pixels
+/** The inverse of \ref xrif_reorder_bytepack_sint32_kernel.
+  * 
+  * \test Verify the vector kernels match the scalar kernel \ref reorder_simd_wide "[test doc]"
+  */
+void xrif_unreorder_bytepack_sint32_kernel( char * raw,          ///< [out] the pixels, `4*npix` bytes
+                                            const char * planes, ///< [in] the first byte plane, followed by the others every `stride` bytes
+                                            size_t stride,       ///< [in] the distance between the start of the planes
+                                            size_t npix,         ///< [in] the number of pixels
+                                            int simd             ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                          );
+
+/// Bytepack reorder a run of 64 bit pixels
+/** As \ref xrif_reorder_bytepack_sint32_kernel, with 8 byte planes.
+  * 
+  * \test Verify the vector kernels match the scalar kernel \ref reorder_simd_wide "[test doc]"
+  */
+void xrif_reorder_bytepack_sint64_kernel( char * planes,    ///< [out] the first byte plane, followed by the others every `stride` bytes
+                                          size_t stride,    ///< [in] the distance between the start of the planes
+                                          const char * raw, ///< [in] the pixels, `8*npix` bytes
+                                          size_t npix,      ///< [in] the number of pixels
+                                          int simd          ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                        );
+
+/// Bytepack unreorder a run of 64 bit pixels
+/** The inverse of \ref xrif_reorder_bytepack_sint64_kernel.
+  * 
+  * \test Verify the vector kernels match the scalar kernel \ref reorder_simd_wide "[test doc]"
+  */
+void xrif_unreorder_bytepack_sint64_kernel( char * raw,          ///< [out] the pixels, `8*npix` bytes
+                                            const char * planes, ///< [in] the first byte plane, followed by the others every `stride` bytes
+                                            size_t stride,       ///< [in] the distance between the start of the planes
+                                            size_t npix,         ///< [in] the number of pixels
+                                            int simd             ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                          );
+
 //xrif_reorder_bytepack:
 ///@}
 
+/// Perform bytepack reodering for floating point types
+/** The pixels are split into one plane per byte, lowest byte first, without sign folding.
+  *
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  */ 
+xrif_error_t xrif_reorder_bytepack_shuffle( xrif_t handle /**< [in/out] the xrif handle */ );
+
+/// Split a run of pixels into byte planes
+/** Writes byte b of each pixel to plane b, as is.  The vector kernel handles 2, 4, and 8 byte pixels, transposing 16 pixels at a time 
+  * with byte unpacks.
+  * 
+  * \test Verify the byte shuffle kernels \ref reorder_simd_shuffle "[test doc]"
+  */
+void xrif_reorder_byteshuffle_kernel( char * planes,    ///< [out] the first byte plane, followed by the others every `stride` bytes
+                                      size_t stride,    ///< [in] the distance between the start of the planes
+                                      const char * raw, ///< [in] the pixels, `nbytes*npix` bytes
+                                      size_t npix,      ///< [in] the number of pixels
+                                      size_t nbytes,    ///< [in] the size of each pixel
+                                      int simd          ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                    );
+
+/// Gather a run of pixels from byte planes
+/** The inverse of \ref xrif_reorder_byteshuffle_kernel.
+  * 
+  * \test Verify the byte shuffle kernels \ref reorder_simd_shuffle "[test doc]"
+  */
+void xrif_unreorder_byteshuffle_kernel( char * raw,          ///< [out] the pixels, `nbytes*npix` bytes
+                                        const char * planes, ///< [in] the first byte plane, followed by the others every `stride` bytes
+                                        size_t stride,       ///< [in] the distance between the start of the planes
+                                        size_t npix,         ///< [in] the number of pixels
+                                        size_t nbytes,       ///< [in] the size of each pixel
+                                        int simd             ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                      );
+
+/// Dispatch bytepack renibble reodering based on type
+/** 16 bit ints use \ref xrif_reorder_bytepack_renibble_sint16.  For 32 and 64 bit ints the low byte plane is followed by a pair of nibble planes 
+  * for each higher byte.
+  *
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  * \returns \ref XRIF_ERROR_NOTIMPL if not implemented for the type
+  */
 xrif_error_t xrif_reorder_bytepack_renibble( xrif_t handle /**< [in/out] the xrif handle */ );
 
+/// Perform bytepack renibble reodering for signed 16 bit ints
+/** Pixels are reordered in chunks of \ref XRIF_REORDER_CHUNK, distributed over threads if xrif_handle::omp_parallel is set.
+  *
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  */
 xrif_error_t xrif_reorder_bytepack_renibble_sint16( xrif_t handle /**< [in/out] the xrif handle */ );
 
+/// Renibble reorder a run of 16 bit pixels
+/** Sign-magnitude folds each pixel, with the sign in bit 0, and writes its low byte to `lo`.  The high bytes of each pair of pixels are 
+  * split into a byte of low nibbles in `nib1` and a byte of high nibbles in `nib2`, with the even pixel's nibble on top.  Runs starting on an
+  * even pixel can be reordered independently.  The vector kernel does the nibble arithmetic in registers, with no lookup table.
+  * 
+  * \test Verify the renibble kernels \ref reorder_simd_renibble "[test doc]"
+  */
+void xrif_reorder_bytepack_renibble_sint16_kernel( char * lo,       ///< [out] the low byte plane, `npix` bytes
+                                                   char * nib1,     ///< [out] the low nibble plane, `(npix+1)/2` bytes
+                                                   char * nib2,     ///< [out] the high nibble plane, `(npix+1)/2` bytes
+                                                   const char * raw, ///< [in] the pixels, `2*npix` bytes
+                                                   size_t npix,     ///< [in] the number of pixels
+                                                   int simd         ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                                 );
+
+/// Dispatch bitpack reodering based on type
+/** The pixels are zigzag encoded and split into one plane per bit, lowest bit first, so the upper planes of small values are all zero.
+  * Each plane is padded to a whole number of bytes.
+  *
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  * \returns \ref XRIF_ERROR_NOTIMPL if not implemented for the type
+  */
 xrif_error_t xrif_reorder_bitpack( xrif_t handle /**< [in/out] the xrif handle */ );
       
+/// Perform bitpack reodering for signed 16 bit ints
+/** 
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  */
 xrif_error_t xrif_reorder_bitpack_sint16( xrif_t handle /**< [in/out] the xrif handle */ );
 
+/// Bitpack reorder a run of 16 bit pixels
+/** Writes bit b of zigzag encoded pixel i to bit `i%8` of byte `i/8` of plane b.  Each group of 8 pixels fills one byte of each plane, so 
+  * runs starting on a multiple of 8 pixels can be reordered independently.  The scalar kernel transposes 8x8 bit blocks, and the vector 
+  * kernels take one bit of 16 or 32 pixels at a time with a movemask.
+  * 
+  * \test Verify the bitpack kernels \ref reorder_simd_bitpack "[test doc]"
+  */
+void xrif_reorder_bitpack_sint16_kernel( char * planes,    ///< [out] the byte of the first bit plane for the first pixel, followed by the others every `stride` bytes
+                                         size_t stride,    ///< [in] the distance between the start of the planes
+                                         const char * raw, ///< [in] the pixels, `2*npix` bytes
+                                         size_t npix,      ///< [in] the number of pixels
+                                         int simd          ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                       );
+
+/// Bitpack unreorder a run of 16 bit pixels
+/** The inverse of \ref xrif_reorder_bitpack_sint16_kernel.
+  * 
+  * \test Verify the bitpack kernels \ref reorder_simd_bitpack "[test doc]"
+  */
+void xrif_unreorder_bitpack_sint16_kernel( char * raw,          ///< [out] the pixels, `2*npix` bytes
+                                           const char * planes, ///< [in] the byte of the first bit plane for the first pixel, followed by the others every `stride` bytes
+                                           size_t stride,       ///< [in] the distance between the start of the planes
+                                           size_t npix,         ///< [in] the number of pixels
+                                           int simd             ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                         );
+
 /// Perform no un-re-ordering, simply copy reordered to raw.
 /** Also zeroes any excess in xrif_handle::raw_buffer.
   *
@@ -1067,10 +2401,83 @@ xrif_error_t xrif_unreorder_bytepack( xrif_t handle /**< [in/out] the xrif handl
   */ 
 xrif_error_t xrif_unreorder_bytepack_sint16( xrif_t handle /**< [in/out] the xrif handle */);
 
+/// Perform bytepack unreodering for signed 32 bit ints
+/** 
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  * 
+  * \ingroup xrif_reorder_bytepack
+  */ 
+xrif_error_t xrif_unreorder_bytepack_sint32( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Perform bytepack unreodering for signed 64 bit ints
+/** 
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  * 
+  * \ingroup xrif_reorder_bytepack
+  */ 
+xrif_error_t xrif_unreorder_bytepack_sint64( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Perform bytepack unreodering for floating point types
+/** 
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  * 
+  * \ingroup xrif_reorder_bytepack
+  */ 
+xrif_error_t xrif_unreorder_bytepack_shuffle( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Dispatch bytepack renibble unreodering based on type
+/** 
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  * \returns \ref XRIF_ERROR_NOTIMPL if not implemented for the type
+  */
 xrif_error_t xrif_unreorder_bytepack_renibble( xrif_t handle /**< [in/out] the xrif handle */);
 
+/// Perform bytepack renibble unreodering for signed 16 bit ints
+/** 
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  */
+xrif_error_t xrif_unreorder_bytepack_renibble_sint16( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Renibble unreorder a run of 16 bit pixels
+/** The inverse of \ref xrif_reorder_bytepack_renibble_sint16_kernel.
+  * 
+  * \test Verify the renibble kernels \ref reorder_simd_renibble "[test doc]"
+  */
+void xrif_unreorder_bytepack_renibble_sint16_kernel( char * raw,        ///< [out] the pixels, `2*npix` bytes
+                                                     const char * lo,   ///< [in] the low byte plane, `npix` bytes
+                                                     const char * nib1, ///< [in] the low nibble plane, `(npix+1)/2` bytes
+                                                     const char * nib2, ///< [in] the high nibble plane, `(npix+1)/2` bytes
+                                                     size_t npix,       ///< [in] the number of pixels
+                                                     int simd           ///< [in] the vector instruction set to use, limited to \ref xrif_simd_level
+                                                   );
+
+/// Dispatch bitpack unreodering based on type
+/** 
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  * \returns \ref XRIF_ERROR_NOTIMPL if not implemented for the type
+  */
 xrif_error_t xrif_unreorder_bitpack( xrif_t handle /**< [in/out] the xrif handle */);
 
+/// Perform bitpack unreodering for signed 16 bit ints
+/** 
+  * \returns \ref XRIF_NOERROR on success
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if either raw_buffer or reorderd_buffer aren't big enough
+  */
+xrif_error_t xrif_unreorder_bitpack_sint16( xrif_t handle /**< [in/out] the xrif handle */);
+
 ///@}
 
 /** \defgroup xrif_compress Compression & De-compression
@@ -1090,6 +2497,240 @@ xrif_error_t xrif_compress_lz4( xrif_t handle /**< [in/out] the xrif handle */);
 
 xrif_error_t xrif_decompress_lz4( xrif_t handle /**< [in/out] the xrif handle */);
 
+/// Get the number of blocks the reordered buffer is split into for compression.
+/** 
+  * \returns 1 if xrif_handle::compress_block_size is 0
+  * \returns the number of blocks of size xrif_handle::compress_block_size needed to hold the reordered data otherwise
+  * \returns 0 for an invalid configuration.
+  */
+size_t xrif_compress_nblocks( xrif_t handle /**< [in] the xrif handle */);
+
+/// Compress the reordered buffer in independent blocks using LZ4 or LZ4HC
+/** Called by \ref xrif_compress_lz4 and \ref xrif_compress_lz4hc when xrif_handle::compress_block_size is non-zero. 
+  * The output starts with the block table, a `uint32_t` number of blocks followed by the `uint32_t` compressed size of each block, 
+  * followed by the compressed blocks in order.  Blocks are compressed in parallel if xrif_handle::omp_parallel is set.
+  * A block which does not shrink, or which is skipped due to xrif_handle::skip_entropy, is stored as is with XRIF_BLOCK_RAW set in its table entry.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if the compressed buffer is too small.
+  * \returns \ref XRIF_NOERROR on success
+  */
+xrif_error_t xrif_compress_lz4_blocks( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Decompress data compressed with \ref xrif_compress_lz4_blocks
+/** Called by \ref xrif_decompress_lz4 when xrif_handle::compress_block_size is non-zero.  
+  * Blocks are decompressed in parallel if xrif_handle::omp_parallel is set.
+  * 
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INVALID_SIZE if the block table does not match the configuration, or a block decompresses to the wrong size.
+  * \returns \ref XRIF_NOERROR on success
+  */
+xrif_error_t xrif_decompress_lz4_blocks( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Compress the reordered buffer using LZ4HC at the level set by xrif_handle::lz4hc_level
+/** The output is a standard LZ4 block, so it is decompressed with \ref xrif_decompress_lz4.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if compression fails, which is normally due to insufficient space in the compressed buffer.
+  * \returns \ref XRIF_NOERROR on success
+  */
+xrif_error_t xrif_compress_lz4hc( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Compress the reordered buffer using LZ4 or LZ4HC, continuing from the previous cube
+/** Called by \ref xrif_compress_lz4 and \ref xrif_compress_lz4hc when xrif_handle::lz4_stream is true.  If the previous cube encoded left 
+  * a dictionary, and this cube is not a keyframe, compression continues from it and xrif_handle::lz4_chained is set.
+  * Otherwise the streaming context is reset.  In either case the end of this cube's reordered data is saved as the dictionary for the next.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_MALLOC if allocating the streaming context fails.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if compression fails, which is normally due to insufficient space in the compressed buffer.
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify LZ4 streaming across a sequence of cubes \ref chain_lz4_stream "[test doc]"
+  */
+xrif_error_t xrif_compress_lz4_stream( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Compress the reordered buffer using Zstandard at the level set by xrif_handle::zstd_level
+/** Uses xrif_handle::zstd_workers worker threads.  The compression context is allocated on first use and kept in the handle.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_NOTIMPL if xrif was built without Zstandard.
+  * \returns \ref XRIF_ERROR_MALLOC if creating the compression context fails.
+  * \returns \ref XRIF_ERROR_LIBERR if the compression level can not be set.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if compression fails, which is normally due to insufficient space in the compressed buffer.
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify Zstandard compression \ref compress_zstd_int16_white "[test doc]"
+  */
+xrif_error_t xrif_compress_zstd( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Decompress data compressed with \ref xrif_compress_zstd
+/** The decompression context is allocated on first use and kept in the handle.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_NOTIMPL if xrif was built without Zstandard.
+  * \returns \ref XRIF_ERROR_MALLOC if creating the decompression context fails.
+  * \returns \ref XRIF_ERROR_LIBERR if the data can not be decompressed.
+  * \returns \ref XRIF_ERROR_INVALID_SIZE if the data decompresses to the wrong size.
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify Zstandard compression \ref compress_zstd_int16_white "[test doc]"
+  */
+xrif_error_t xrif_decompress_zstd( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Compress the reordered buffer using an order-0 rANS entropy coder
+/** Each plane (see \ref xrif_compress_nplanes) is coded with its own byte histogram, since the planes of bytepacked data have very different statistics.  
+  * This compresses noisy data with skewed byte distributions but few repeated strings, which LZ4 can not.  Four rANS states are interleaved within each plane
+  * so that decoding is not limited by one serial dependency chain, and the planes are coded in parallel if xrif_handle::omp_parallel is set.
+  * A plane which does not compress is stored as is.
+  * 
+  * The output starts with a table: a `uint32_t` number of planes, followed by the `uint32_t` raw size and `uint32_t` record size of each plane.  
+  * The plane records follow in order.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if the compressed buffer is too small.
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify rANS compression \ref compress_rans_int16_white "[test doc]"
+  */
+xrif_error_t xrif_compress_rans( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Decompress data compressed with \ref xrif_compress_rans
+/** Planes are decoded in parallel if xrif_handle::omp_parallel is set.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_INVALID_SIZE if the plane table does not match the configuration, or a plane record is invalid.
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify rANS compression \ref compress_rans_int16_white "[test doc]"
+  */
+xrif_error_t xrif_decompress_rans( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Estimate the order-0 entropy of a buffer from a sample.
+/** Builds a byte histogram from up to XRIF_SKIP_ENTROPY_SAMPLES bytes, taken as runs of XRIF_SKIP_ENTROPY_RUN consecutive bytes evenly spaced 
+  * through the buffer.  Buffers no larger than the sample are used in full.
+  * 
+  * \returns the entropy of the sample in bits per byte, from 0 to 8.
+  * 
+  * \test Verify skipping incompressible blocks \ref compress_skip_entropy "[test doc]"
+  */
+double xrif_sample_entropy( const char * src, ///< [in] the buffer to sample
+                            size_t len        ///< [in] the size of the buffer
+                          );
+
+/// Check whether the reordered planes are compressed separately.
+/** 
+  * \returns true (1) if xrif_handle::compress_planes is set and the compression method is LZ4, LZ4HC, or Zstandard.
+  * \returns false (0) otherwise, including if handle is null.
+  */
+int xrif_compress_by_plane( xrif_t handle /**< [in] the xrif handle */);
+
+/// Get the number of planes the reordered buffer is split into for per-plane and rANS compression.
+/** With XRIF_REORDER_BYTEPACK each byte plane is a plane, as is the first frame if it is stored verbatim.  Otherwise the reordered buffer is one plane.
+  * 
+  * \returns the number of planes, 0 if handle is null.
+  */
+size_t xrif_compress_nplanes( xrif_t handle /**< [in] the xrif handle */);
+
+/// Get the sizes of the planes the reordered buffer is split into.
+/** The planes are contiguous in the reordered buffer, in order.
+  * 
+  * \returns the number of planes.
+  */
+size_t xrif_compress_plane_sizes( xrif_t handle,       ///< [in] the xrif handle
+                                  size_t * plane_sizes ///< [out] the size of each plane, must have room for XRIF_COMPRESS_PLANES_MAX entries
+                                );
+
+/// Compress each plane of the reordered buffer separately using LZ4, LZ4HC, or Zstandard
+/** Called by \ref xrif_compress when \ref xrif_compress_by_plane is true.  Each plane is trial compressed with the output limited to less than 
+  * the plane size, and a plane which does not shrink is stored as is.  LZ4 and LZ4HC planes are compressed in parallel if xrif_handle::omp_parallel is set.
+  * 
+  * The output starts with a table: a `uint32_t` number of planes, followed by the `uint32_t` raw size, `uint32_t` record size, and `int32_t` 
+  * compression method of each plane, which is XRIF_COMPRESS_NONE for a plane stored as is.  The plane records follow in order.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_NOTIMPL if the method is Zstandard and xrif was built without it.
+  * \returns \ref XRIF_ERROR_INSUFFICIENT_SIZE if the compressed buffer is too small.
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify per-plane compression \ref compress_planes_int16_white "[test doc]"
+  */
+xrif_error_t xrif_compress_planes( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Decompress data compressed with \ref xrif_compress_planes
+/** Planes are decompressed in parallel if xrif_handle::omp_parallel is set, unless a plane uses Zstandard.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_NOTIMPL if a plane uses an unknown method, or Zstandard and xrif was built without it.
+  * \returns \ref XRIF_ERROR_INVALID_SIZE if the plane table does not match the configuration, or a plane decompresses to the wrong size.
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify per-plane compression \ref compress_planes_int16_white "[test doc]"
+  */
+xrif_error_t xrif_decompress_planes( xrif_t handle /**< [in/out] the xrif handle */);
+
+/// Compress with LZ4 or LZ4HC using one of the preallocated compression states.
+/** The state is reset with the fast reset, which does not clear the hash table unless needed.  The LZ4 hash table size is set by
+  * xrif_handle::lz4_memory_usage.  Falls back to the stateless compressors if `thread` is beyond the allocated states.
+  * 
+  * \returns the compressed size, 0 on failure.
+  */
+int xrif_lz4_compress_state( xrif_t handle,      ///< [in] the xrif handle, with states allocated by \ref xrif_allocate_lz4_state
+                             int thread,         ///< [in] the thread number, selecting the state
+                             const char * src,   ///< [in] the data to compress
+                             char * dst,         ///< [out] the compressed data
+                             int srcSize,        ///< [in] the size of the data to compress
+                             int dstCapacity     ///< [in] the size of dst
+                           );
+
+/// Get the size of an LZ4 compression state for a hash table size
+/** \returns the size in bytes of the state, using the default size if `lz4_memory_usage` is not supported.
+  */
+int xrif_lz4_sizeofState( int lz4_memory_usage /**< [in] log2 of the LZ4 hash table size in bytes */);
+
+/// Fully initialize an LZ4 compression state for a hash table size
+void xrif_lz4_resetState( int lz4_memory_usage, ///< [in] log2 of the LZ4 hash table size in bytes
+                          void * state          ///< [out] the state to initialize
+                        );
+
+/** \name LZ4 compression for each hash table size
+  * Each of these is compiled from the LZ4 source with LZ4_MEMORY_USAGE set to the suffix, see xrif_lz4_memory.inc.
+  * @{
+  */
+int xrif_lz4_sizeofState_12( void );
+void xrif_lz4_resetState_12( void * state );
+int xrif_lz4_compress_fastReset_12( void * state, const char * src, char * dst, int srcSize, int dstCapacity, int acceleration );
+
+int xrif_lz4_sizeofState_14( void );
+void xrif_lz4_resetState_14( void * state );
+int xrif_lz4_compress_fastReset_14( void * state, const char * src, char * dst, int srcSize, int dstCapacity, int acceleration );
+
+int xrif_lz4_sizeofState_16( void );
+void xrif_lz4_resetState_16( void * state );
+int xrif_lz4_compress_fastReset_16( void * state, const char * src, char * dst, int srcSize, int dstCapacity, int acceleration );
+
+int xrif_lz4_sizeofState_18( void );
+void xrif_lz4_resetState_18( void * state );
+int xrif_lz4_compress_fastReset_18( void * state, const char * src, char * dst, int srcSize, int dstCapacity, int acceleration );
+
+int xrif_lz4_sizeofState_20( void );
+void xrif_lz4_resetState_20( void * state );
+int xrif_lz4_compress_fastReset_20( void * state, const char * src, char * dst, int srcSize, int dstCapacity, int acceleration );
+///@}
+
+/// Decompress data compressed with \ref xrif_compress_lz4_stream
+/** Called by \ref xrif_decompress_lz4 when xrif_handle::lz4_stream or xrif_handle::lz4_chained is true.  If the cube is chained,
+  * the dictionary kept from the previous cube is used.  If xrif_handle::lz4_stream is true, the end of the reordered data is kept as the dictionary for the next cube.
+  *
+  * \returns \ref XRIF_ERROR_NULLPTR if handle is null.
+  * \returns \ref XRIF_ERROR_NOREFERENCE if the cube is chained and there is no dictionary from the previous cube.
+  * \returns \ref XRIF_ERROR_INVALID_SIZE if the data decompresses to the wrong size.
+  * \returns \ref XRIF_NOERROR on success
+  * 
+  * \test Verify LZ4 streaming across a sequence of cubes \ref chain_lz4_stream "[test doc]"
+  */
+xrif_error_t xrif_decompress_lz4_stream( xrif_t handle /**< [in/out] the xrif handle */);
+
 ///@}
 
 
@@ -1218,6 +2859,14 @@ double xrif_decompress_rate( xrif_t handle /**< [in/out] the xrif handle */);
   */  
 size_t xrif_typesize( xrif_typecode_t type_code /**< [in] the type code*/);
 
+/// Check if the type specified by the code is a floating point type.
+/** Floating point types are differenced by XOR rather than subtraction, and bytepack reordering shuffles their bytes without sign folding.
+  * 
+  * \returns 1 for XRIF_TYPECODE_HALF, XRIF_TYPECODE_FLOAT, and XRIF_TYPECODE_DOUBLE
+  * \returns 0 otherwise
+  */
+int xrif_typeisfloat( xrif_typecode_t type_code /**< [in] the type code*/);
+
 /// Calculate the difference between two timespecs.
 /** Calculates `ts1-ts0` in `double` precision.
   * 
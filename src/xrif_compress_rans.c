@@ -0,0 +1,493 @@
+/** \file xrif_compress_rans.c
+  * \brief Implementation of the xrif order-0 rANS entropy coder
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include "xrif.h"
+
+//rANS with byte-wise renormalization, the state is kept in [RANS_L, 256*RANS_L)
+#define RANS_L (1u << 23)
+#define RANS_PROB_SCALE (1u << XRIF_RANS_PROB_BITS)
+
+//Plane record modes
+#define RANS_MODE_RAW (0)
+#define RANS_MODE_RANS (1)
+
+//Scale the histogram so the frequencies sum to RANS_PROB_SCALE, keeping every symbol which occurs.
+static void xrif_rans_normalize( uint32_t * freq,
+                                 size_t total
+                               )
+{
+   uint32_t sum = 0;
+   int maxs = 0;
+   
+   for(int s = 0; s < 256; ++s)
+   {
+      if(freq[s] == 0) continue;
+      
+      uint32_t f = (uint32_t) (((uint64_t) freq[s] * RANS_PROB_SCALE) / total);
+      if(f == 0) f = 1;
+      
+      freq[s] = f;
+      sum += f;
+      
+      if(f > freq[maxs]) maxs = s;
+   }
+   
+   if(sum < RANS_PROB_SCALE)
+   {
+      freq[maxs] += RANS_PROB_SCALE - sum;
+      return;
+   }
+   
+   //Rounding up rare symbols can overshoot, so take from the most probable symbols.
+   while(sum > RANS_PROB_SCALE)
+   {
+      maxs = 0;
+      for(int s = 1; s < 256; ++s) if(freq[s] > freq[maxs]) maxs = s;
+      
+      uint32_t d = sum - RANS_PROB_SCALE;
+      if(d > freq[maxs]/2) d = freq[maxs]/2;
+      if(d == 0) d = 1;
+      
+      freq[maxs] -= d;
+      sum -= d;
+   }
+}
+
+/* Encode one plane into dst, which has room for dst_size bytes.
+ * Returns the size of the record, which is a raw copy if the plane does not compress.
+ */
+static size_t xrif_rans_encode_plane( char * dst,
+                                      size_t dst_size,
+                                      const unsigned char * src,
+                                      size_t n
+                                    )
+{
+   uint32_t freq[256];
+   uint32_t cum[256];
+   
+   memset(freq, 0, sizeof(freq));
+   for(size_t i = 0; i < n; ++i) ++freq[src[i]];
+   
+   if(n > 0) xrif_rans_normalize(freq, n);
+   
+   uint32_t c = 0;
+   for(int s = 0; s < 256; ++s)
+   {
+      cum[s] = c;
+      c += freq[s];
+   }
+   
+   //The table: a bitmap of the symbols present, then the frequency of each present symbol in 1 or 2 bytes
+   unsigned char * rec = (unsigned char *) dst;
+   size_t hdr = 1 + 32;
+   
+   rec[0] = RANS_MODE_RANS;
+   memset(rec + 1, 0, 32);
+   
+   for(int s = 0; s < 256; ++s)
+   {
+      if(freq[s] == 0) continue;
+      
+      rec[1 + s/8] |= (1 << (s % 8));
+      
+      if(freq[s] < 128)
+      {
+         rec[hdr++] = freq[s];
+      }
+      else
+      {
+         rec[hdr++] = 0x80 | (freq[s] >> 8);
+         rec[hdr++] = freq[s] & 0xFF;
+      }
+   }
+   
+   //Encode backwards from the end of dst, with 4 interleaved states so the decoder has independent dependency chains.
+   unsigned char * end = (unsigned char *) dst + dst_size;
+   unsigned char * ptr = end;
+   unsigned char * limit = rec + hdr + 16;
+   
+   uint32_t x[4] = {RANS_L, RANS_L, RANS_L, RANS_L};
+   
+   int fits = 1;
+   
+   for(size_t i = n; i > 0 && fits; --i)
+   {
+      unsigned char s = src[i-1];
+      uint32_t * xs = &x[(i-1) & 3];
+      
+      uint32_t x_max = ((RANS_L >> XRIF_RANS_PROB_BITS) << 8) * freq[s];
+      while(*xs >= x_max)
+      {
+         if(ptr <= limit) 
+         {
+            fits = 0;
+            break;
+         }
+         
+         *--ptr = (unsigned char) (*xs & 0xFF);
+         *xs >>= 8;
+      }
+      
+      *xs = ((*xs / freq[s]) << XRIF_RANS_PROB_BITS) + (*xs % freq[s]) + cum[s];
+   }
+   
+   if(fits)
+   {
+      //State 0 is read first
+      for(int k = 3; k >= 0; --k)
+      {
+         ptr -= 4;
+         ptr[0] = (unsigned char) (x[k] >> 0);
+         ptr[1] = (unsigned char) (x[k] >> 8);
+         ptr[2] = (unsigned char) (x[k] >> 16);
+         ptr[3] = (unsigned char) (x[k] >> 24);
+      }
+      
+      size_t stream_size = end - ptr;
+      
+      if(hdr + stream_size < n + 1)
+      {
+         memmove(rec + hdr, ptr, stream_size);
+         return hdr + stream_size;
+      }
+   }
+   
+   //Store the plane as is
+   rec[0] = RANS_MODE_RAW;
+   memcpy(rec + 1, src, n);
+   
+   return n + 1;
+}
+
+/* Decode one plane record of size rec_size into n bytes at dst.
+ * Returns 0 on success, -1 if the record is invalid.
+ */
+static int xrif_rans_decode_plane( unsigned char * dst,
+                                   size_t n,
+                                   const unsigned char * rec,
+                                   size_t rec_size
+                                 )
+{
+   if(rec_size < 1) return -1;
+   
+   if(rec[0] == RANS_MODE_RAW)
+   {
+      if(rec_size != n + 1) return -1;
+      
+      memcpy(dst, rec + 1, n);
+      return 0;
+   }
+   
+   if(rec[0] != RANS_MODE_RANS || rec_size < 1 + 32 + 16) return -1;
+   
+   uint32_t freq[256];
+   uint32_t cum[256];
+   unsigned char sym[RANS_PROB_SCALE];
+   
+   const unsigned char * ptr = rec + 1 + 32;
+   const unsigned char * end = rec + rec_size;
+   
+   uint32_t c = 0;
+   for(int s = 0; s < 256; ++s)
+   {
+      freq[s] = 0;
+      cum[s] = c;
+      
+      if( (rec[1 + s/8] & (1 << (s % 8))) == 0) continue;
+      
+      if(ptr >= end) return -1;
+      
+      if(*ptr < 128)
+      {
+         freq[s] = *ptr++;
+      }
+      else
+      {
+         if(ptr + 1 >= end) return -1;
+         freq[s] = ((ptr[0] & 0x7F) << 8) | ptr[1];
+         ptr += 2;
+      }
+      
+      if(freq[s] == 0 || c + freq[s] > RANS_PROB_SCALE) return -1;
+      
+      memset(sym + c, s, freq[s]);
+      c += freq[s];
+   }
+   
+   if(c != RANS_PROB_SCALE || ptr + 16 > end) return -1;
+   
+   uint32_t x[4];
+   for(int k = 0; k < 4; ++k)
+   {
+      x[k] = ((uint32_t) ptr[0]) | ((uint32_t) ptr[1] << 8) | ((uint32_t) ptr[2] << 16) | ((uint32_t) ptr[3] << 24);
+      ptr += 4;
+   }
+   
+   for(size_t i = 0; i < n; ++i)
+   {
+      uint32_t * xs = &x[i & 3];
+      
+      uint32_t slot = *xs & (RANS_PROB_SCALE - 1);
+      unsigned char s = sym[slot];
+      
+      dst[i] = s;
+      
+      *xs = freq[s] * (*xs >> XRIF_RANS_PROB_BITS) + slot - cum[s];
+      
+      while(*xs < RANS_L)
+      {
+         if(ptr >= end) return -1;
+         *xs = (*xs << 8) | *ptr++;
+      }
+   }
+   
+   return 0;
+}
+
+xrif_error_t xrif_compress_rans( xrif_t handle )
+{
+   if(handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_compress_rans", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   char *compressed_buffer;
+   size_t compressed_size;
+   
+   if(handle->compress_on_raw) 
+   {
+      compressed_buffer = handle->raw_buffer;
+      compressed_size = handle->raw_buffer_size;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+      compressed_size = handle->compressed_buffer_size;
+   }
+   
+   size_t plane_sizes[XRIF_COMPRESS_PLANES_MAX];
+   size_t nplanes = xrif_compress_plane_sizes(handle, plane_sizes);
+   
+   if(compressed_size < xrif_min_compressed_size(handle))
+   {
+      XRIF_ERROR_PRINT("xrif_compress_rans", "compressed buffer is too small");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   //The table holds the number of planes, then the raw size and record size of each plane
+   uint32_t * table = (uint32_t *) compressed_buffer;
+   size_t table_size = XRIF_BLOCK_TABLE_SIZE(2*nplanes);
+   
+   table[0] = nplanes;
+   
+   //Each plane is first encoded into its own worst-case sized slot so the planes are independent
+   size_t src_offs[XRIF_COMPRESS_PLANES_MAX];
+   size_t slot_offs[XRIF_COMPRESS_PLANES_MAX];
+   
+   size_t src_off = 0;
+   size_t slot_off = table_size;
+   for(size_t k = 0; k < nplanes; ++k)
+   {
+      src_offs[k] = src_off;
+      slot_offs[k] = slot_off;
+      src_off += plane_sizes[k];
+      slot_off += plane_sizes[k] + XRIF_RANS_PLANE_OVERHEAD;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for schedule(dynamic)
+   #endif
+   for(size_t k = 0; k < nplanes; ++k)
+   {
+      size_t rsize = xrif_rans_encode_plane( compressed_buffer + slot_offs[k], plane_sizes[k] + XRIF_RANS_PLANE_OVERHEAD, 
+                                             (unsigned char *) handle->reordered_buffer + src_offs[k], plane_sizes[k]);
+      
+      table[1 + 2*k] = plane_sizes[k];
+      table[2 + 2*k] = rsize;
+   }
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   //Now pack the records down so they are contiguous.  Each record starts at or before its slot, so this never overwrites uncopied data.
+   size_t pos = table_size + table[2];
+   for(size_t k = 1; k < nplanes; ++k)
+   {
+      memmove(compressed_buffer + pos, compressed_buffer + slot_offs[k], table[2 + 2*k]);
+      pos += table[2 + 2*k];
+   }
+   
+   handle->compressed_size = pos;
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_decompress_rans( xrif_t handle )
+{
+   if(handle == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_rans", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   char *compressed_buffer;
+   
+   if(handle->compress_on_raw) 
+   {
+      compressed_buffer = handle->raw_buffer;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+   }
+   
+   uint32_t * table = (uint32_t *) compressed_buffer;
+   
+   if(handle->compressed_size < sizeof(uint32_t) || table[0] == 0 || table[0] > XRIF_COMPRESS_PLANES_MAX)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_rans", "invalid plane table");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   size_t nplanes = table[0];
+   size_t table_size = XRIF_BLOCK_TABLE_SIZE(2*nplanes);
+   
+   if(handle->compressed_size < table_size)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_rans", "invalid plane table");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   size_t dst_offs[XRIF_COMPRESS_PLANES_MAX];
+   size_t rec_offs[XRIF_COMPRESS_PLANES_MAX];
+   
+   size_t dst_off = 0;
+   size_t rec_off = table_size;
+   for(size_t k = 0; k < nplanes; ++k)
+   {
+      dst_offs[k] = dst_off;
+      rec_offs[k] = rec_off;
+      dst_off += table[1 + 2*k];
+      rec_off += table[2 + 2*k];
+   }
+   
+   //Make sure we have the correct amount of data
+   if(dst_off != xrif_reordered_size(handle) || dst_off > handle->reordered_buffer_size || rec_off != handle->compressed_size)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_rans", "size mismatch in plane table");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   int nfail = 0;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #pragma omp for schedule(dynamic) reduction(+:nfail)
+   #endif
+   for(size_t k = 0; k < nplanes; ++k)
+   {
+      if(xrif_rans_decode_plane( (unsigned char *) handle->reordered_buffer + dst_offs[k], table[1 + 2*k], 
+                                 (unsigned char *) compressed_buffer + rec_offs[k], table[2 + 2*k]) < 0) 
+      {
+         ++nfail;
+      }
+   }
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   if(nfail > 0)
+   {
+      XRIF_ERROR_PRINT("xrif_decompress_rans", "invalid rANS data");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   return XRIF_NOERROR;
+}
@@ -0,0 +1,875 @@
+/** \file xrif_difference_adaptive.c
+  * \brief Implementation of xrif adaptive per-block differencing
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include "xrif.h"
+
+//The number of bits needed for a residual, after folding the sign into the low bit.  This estimates the size of the residual after reordering.
+static inline uint64_t xrif_adaptive_bits( int64_t r )
+{
+   uint64_t z = ((uint64_t) r << 1) ^ (uint64_t) (r >> 63);
+   
+   #if defined(__GNUC__)
+   return (z == 0) ? 0 : 64 - __builtin_clzll(z);
+   #else
+   uint64_t b = 0;
+   while(z)
+   {
+      ++b;
+      z >>= 1;
+   }
+   return b;
+   #endif
+}
+
+//Choose the sample of frames used to estimate the cost of each method: the first frame, and up to XRIF_ADAPTIVE_SAMPLE_FRAMES-1 frames spread over the rest
+static int xrif_adaptive_sample( size_t * sample,
+                                 size_t nframes
+                               )
+{
+   int nsample = 1;
+   sample[0] = 0;
+   
+   if(nframes < 2) return nsample;
+   
+   size_t nrest = (nframes - 1 < XRIF_ADAPTIVE_SAMPLE_FRAMES - 1) ? nframes - 1 : XRIF_ADAPTIVE_SAMPLE_FRAMES - 1;
+   
+   for(size_t s = 0; s < nrest; ++s)
+   {
+      sample[nsample] = 1 + (s*(nframes - 1))/nrest;
+      ++nsample;
+   }
+   
+   return nsample;
+}
+
+//Choose the method with the fewest estimated bits for one block
+static unsigned char xrif_adaptive_choose_sint16( const int16_t * rb,
+                                                 size_t width,
+                                                 size_t fpix,
+                                                 size_t x0,
+                                                 size_t x1,
+                                                 size_t y0,
+                                                 size_t y1,
+                                                 const size_t * sample,
+                                                 int nsample
+                                               )
+{
+   uint64_t cost[4] = {0,0,0,0};
+   
+   for(int s = 0; s < nsample; ++s)
+   {
+      size_t n = sample[s];
+      
+      for(size_t y = y0; y < y1; ++y)
+      {
+         const int16_t * p = rb + n*fpix + y*width;
+         const int16_t * pp = (n > 0) ? p - fpix : p;
+         const int16_t * p0 = rb + y*width;
+         
+         for(size_t x = x0; x < x1; ++x)
+         {
+            cost[XRIF_ADAPTIVE_NONE] += xrif_adaptive_bits(p[x]);
+            
+            //The first frame is not differenced by the temporal methods
+            if(n > 0)
+            {
+               cost[XRIF_ADAPTIVE_PREVIOUS] += xrif_adaptive_bits((int16_t) (p[x] - pp[x]));
+               cost[XRIF_ADAPTIVE_FIRST] += xrif_adaptive_bits((int16_t) (p[x] - p0[x]));
+            }
+            else
+            {
+               cost[XRIF_ADAPTIVE_PREVIOUS] += xrif_adaptive_bits(p[x]);
+               cost[XRIF_ADAPTIVE_FIRST] += xrif_adaptive_bits(p[x]);
+            }
+            
+            if(x > x0) cost[XRIF_ADAPTIVE_PIXEL] += xrif_adaptive_bits((int16_t) (p[x] - p[x-1]));
+            else if(y > y0) cost[XRIF_ADAPTIVE_PIXEL] += xrif_adaptive_bits((int16_t) (p[x] - p[x-width]));
+            else cost[XRIF_ADAPTIVE_PIXEL] += xrif_adaptive_bits(p[x]);
+         }
+      }
+   }
+   
+   unsigned char method = XRIF_ADAPTIVE_NONE;
+   for(unsigned char m = 1; m < 4; ++m)
+   {
+      if(cost[m] < cost[method]) method = m;
+   }
+   
+   return method;
+}
+
+xrif_error_t xrif_difference_adaptive_sint16( xrif_t handle )
+{
+   size_t width = handle->width;
+   size_t nrows = handle->height*handle->depth;
+   size_t fpix = width*nrows;
+   size_t nframes = handle->frames;
+   
+   size_t bsz = handle->adaptive_block_size;
+   size_t nbx = (width + bsz - 1)/bsz;
+   size_t nblocks = xrif_adaptive_blocks(handle);
+   
+   size_t sample[XRIF_ADAPTIVE_SAMPLE_FRAMES];
+   int nsample = xrif_adaptive_sample(sample, nframes);
+   
+   int16_t * rb = (int16_t *) handle->raw_buffer;
+   unsigned char * methods = handle->adaptive_methods;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #endif
+   
+   //Each block is chosen from its own pixels and then differenced in place, so the blocks are independent
+   #ifndef XRIF_NO_OMP
+   #pragma omp for schedule(dynamic)
+   #endif
+   for(size_t b = 0; b < nblocks; ++b)
+   {
+      size_t x0 = (b % nbx)*bsz;
+      size_t x1 = (x0 + bsz < width) ? x0 + bsz : width;
+      size_t y0 = (b / nbx)*bsz;
+      size_t y1 = (y0 + bsz < nrows) ? y0 + bsz : nrows;
+      
+      unsigned char method = xrif_adaptive_choose_sint16(rb, width, fpix, x0, x1, y0, y1, sample, nsample);
+      methods[b] = method;
+      
+      if(method == XRIF_ADAPTIVE_PREVIOUS)
+      {
+         //Go backwards so each frame is differenced against the original of the frame before
+         for(size_t n = nframes - 1; n > 0; --n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int16_t * restrict p = rb + n*fpix + y*width;
+               const int16_t * restrict pp = p - fpix;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] - pp[x];
+            }
+         }
+      }
+      else if(method == XRIF_ADAPTIVE_FIRST)
+      {
+         for(size_t n = 1; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int16_t * restrict p = rb + n*fpix + y*width;
+               const int16_t * restrict p0 = rb + y*width;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] - p0[x];
+            }
+         }
+      }
+      else if(method == XRIF_ADAPTIVE_PIXEL)
+      {
+         //The first pixel of each row of the block is differenced with the pixel above, and the first pixel of the block is not differenced.
+         //Go backwards so each pixel is differenced against the originals.
+         for(size_t n = 0; n < nframes; ++n)
+         {
+            for(size_t y = y1 - 1; y + 1 > y0; --y)
+            {
+               int16_t * p = rb + n*fpix + y*width;
+               for(size_t x = x1 - 1; x > x0; --x) p[x] = p[x] - p[x-1];
+               if(y > y0) p[x0] = p[x0] - p[x0 - width];
+            }
+         }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_difference_adaptive_sint16
+
+//Choose the method with the fewest estimated bits for one block
+static unsigned char xrif_adaptive_choose_sint32( const int32_t * rb,
+                                                 size_t width,
+                                                 size_t fpix,
+                                                 size_t x0,
+                                                 size_t x1,
+                                                 size_t y0,
+                                                 size_t y1,
+                                                 const size_t * sample,
+                                                 int nsample
+                                               )
+{
+   uint64_t cost[4] = {0,0,0,0};
+   
+   for(int s = 0; s < nsample; ++s)
+   {
+      size_t n = sample[s];
+      
+      for(size_t y = y0; y < y1; ++y)
+      {
+         const int32_t * p = rb + n*fpix + y*width;
+         const int32_t * pp = (n > 0) ? p - fpix : p;
+         const int32_t * p0 = rb + y*width;
+         
+         for(size_t x = x0; x < x1; ++x)
+         {
+            cost[XRIF_ADAPTIVE_NONE] += xrif_adaptive_bits(p[x]);
+            
+            //The first frame is not differenced by the temporal methods
+            if(n > 0)
+            {
+               cost[XRIF_ADAPTIVE_PREVIOUS] += xrif_adaptive_bits((int32_t) (p[x] - pp[x]));
+               cost[XRIF_ADAPTIVE_FIRST] += xrif_adaptive_bits((int32_t) (p[x] - p0[x]));
+            }
+            else
+            {
+               cost[XRIF_ADAPTIVE_PREVIOUS] += xrif_adaptive_bits(p[x]);
+               cost[XRIF_ADAPTIVE_FIRST] += xrif_adaptive_bits(p[x]);
+            }
+            
+            if(x > x0) cost[XRIF_ADAPTIVE_PIXEL] += xrif_adaptive_bits((int32_t) (p[x] - p[x-1]));
+            else if(y > y0) cost[XRIF_ADAPTIVE_PIXEL] += xrif_adaptive_bits((int32_t) (p[x] - p[x-width]));
+            else cost[XRIF_ADAPTIVE_PIXEL] += xrif_adaptive_bits(p[x]);
+         }
+      }
+   }
+   
+   unsigned char method = XRIF_ADAPTIVE_NONE;
+   for(unsigned char m = 1; m < 4; ++m)
+   {
+      if(cost[m] < cost[method]) method = m;
+   }
+   
+   return method;
+}
+
+xrif_error_t xrif_difference_adaptive_sint32( xrif_t handle )
+{
+   size_t width = handle->width;
+   size_t nrows = handle->height*handle->depth;
+   size_t fpix = width*nrows;
+   size_t nframes = handle->frames;
+   
+   size_t bsz = handle->adaptive_block_size;
+   size_t nbx = (width + bsz - 1)/bsz;
+   size_t nblocks = xrif_adaptive_blocks(handle);
+   
+   size_t sample[XRIF_ADAPTIVE_SAMPLE_FRAMES];
+   int nsample = xrif_adaptive_sample(sample, nframes);
+   
+   int32_t * rb = (int32_t *) handle->raw_buffer;
+   unsigned char * methods = handle->adaptive_methods;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #endif
+   
+   //Each block is chosen from its own pixels and then differenced in place, so the blocks are independent
+   #ifndef XRIF_NO_OMP
+   #pragma omp for schedule(dynamic)
+   #endif
+   for(size_t b = 0; b < nblocks; ++b)
+   {
+      size_t x0 = (b % nbx)*bsz;
+      size_t x1 = (x0 + bsz < width) ? x0 + bsz : width;
+      size_t y0 = (b / nbx)*bsz;
+      size_t y1 = (y0 + bsz < nrows) ? y0 + bsz : nrows;
+      
+      unsigned char method = xrif_adaptive_choose_sint32(rb, width, fpix, x0, x1, y0, y1, sample, nsample);
+      methods[b] = method;
+      
+      if(method == XRIF_ADAPTIVE_PREVIOUS)
+      {
+         //Go backwards so each frame is differenced against the original of the frame before
+         for(size_t n = nframes - 1; n > 0; --n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int32_t * restrict p = rb + n*fpix + y*width;
+               const int32_t * restrict pp = p - fpix;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] - pp[x];
+            }
+         }
+      }
+      else if(method == XRIF_ADAPTIVE_FIRST)
+      {
+         for(size_t n = 1; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int32_t * restrict p = rb + n*fpix + y*width;
+               const int32_t * restrict p0 = rb + y*width;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] - p0[x];
+            }
+         }
+      }
+      else if(method == XRIF_ADAPTIVE_PIXEL)
+      {
+         //The first pixel of each row of the block is differenced with the pixel above, and the first pixel of the block is not differenced.
+         //Go backwards so each pixel is differenced against the originals.
+         for(size_t n = 0; n < nframes; ++n)
+         {
+            for(size_t y = y1 - 1; y + 1 > y0; --y)
+            {
+               int32_t * p = rb + n*fpix + y*width;
+               for(size_t x = x1 - 1; x > x0; --x) p[x] = p[x] - p[x-1];
+               if(y > y0) p[x0] = p[x0] - p[x0 - width];
+            }
+         }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_difference_adaptive_sint32
+
+//Choose the method with the fewest estimated bits for one block
+static unsigned char xrif_adaptive_choose_sint64( const int64_t * rb,
+                                                 size_t width,
+                                                 size_t fpix,
+                                                 size_t x0,
+                                                 size_t x1,
+                                                 size_t y0,
+                                                 size_t y1,
+                                                 const size_t * sample,
+                                                 int nsample
+                                               )
+{
+   uint64_t cost[4] = {0,0,0,0};
+   
+   for(int s = 0; s < nsample; ++s)
+   {
+      size_t n = sample[s];
+      
+      for(size_t y = y0; y < y1; ++y)
+      {
+         const int64_t * p = rb + n*fpix + y*width;
+         const int64_t * pp = (n > 0) ? p - fpix : p;
+         const int64_t * p0 = rb + y*width;
+         
+         for(size_t x = x0; x < x1; ++x)
+         {
+            cost[XRIF_ADAPTIVE_NONE] += xrif_adaptive_bits(p[x]);
+            
+            //The first frame is not differenced by the temporal methods
+            if(n > 0)
+            {
+               cost[XRIF_ADAPTIVE_PREVIOUS] += xrif_adaptive_bits((int64_t) (p[x] - pp[x]));
+               cost[XRIF_ADAPTIVE_FIRST] += xrif_adaptive_bits((int64_t) (p[x] - p0[x]));
+            }
+            else
+            {
+               cost[XRIF_ADAPTIVE_PREVIOUS] += xrif_adaptive_bits(p[x]);
+               cost[XRIF_ADAPTIVE_FIRST] += xrif_adaptive_bits(p[x]);
+            }
+            
+            if(x > x0) cost[XRIF_ADAPTIVE_PIXEL] += xrif_adaptive_bits((int64_t) (p[x] - p[x-1]));
+            else if(y > y0) cost[XRIF_ADAPTIVE_PIXEL] += xrif_adaptive_bits((int64_t) (p[x] - p[x-width]));
+            else cost[XRIF_ADAPTIVE_PIXEL] += xrif_adaptive_bits(p[x]);
+         }
+      }
+   }
+   
+   unsigned char method = XRIF_ADAPTIVE_NONE;
+   for(unsigned char m = 1; m < 4; ++m)
+   {
+      if(cost[m] < cost[method]) method = m;
+   }
+   
+   return method;
+}
+
+xrif_error_t xrif_difference_adaptive_sint64( xrif_t handle )
+{
+   size_t width = handle->width;
+   size_t nrows = handle->height*handle->depth;
+   size_t fpix = width*nrows;
+   size_t nframes = handle->frames;
+   
+   size_t bsz = handle->adaptive_block_size;
+   size_t nbx = (width + bsz - 1)/bsz;
+   size_t nblocks = xrif_adaptive_blocks(handle);
+   
+   size_t sample[XRIF_ADAPTIVE_SAMPLE_FRAMES];
+   int nsample = xrif_adaptive_sample(sample, nframes);
+   
+   int64_t * rb = (int64_t *) handle->raw_buffer;
+   unsigned char * methods = handle->adaptive_methods;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #endif
+   
+   //Each block is chosen from its own pixels and then differenced in place, so the blocks are independent
+   #ifndef XRIF_NO_OMP
+   #pragma omp for schedule(dynamic)
+   #endif
+   for(size_t b = 0; b < nblocks; ++b)
+   {
+      size_t x0 = (b % nbx)*bsz;
+      size_t x1 = (x0 + bsz < width) ? x0 + bsz : width;
+      size_t y0 = (b / nbx)*bsz;
+      size_t y1 = (y0 + bsz < nrows) ? y0 + bsz : nrows;
+      
+      unsigned char method = xrif_adaptive_choose_sint64(rb, width, fpix, x0, x1, y0, y1, sample, nsample);
+      methods[b] = method;
+      
+      if(method == XRIF_ADAPTIVE_PREVIOUS)
+      {
+         //Go backwards so each frame is differenced against the original of the frame before
+         for(size_t n = nframes - 1; n > 0; --n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int64_t * restrict p = rb + n*fpix + y*width;
+               const int64_t * restrict pp = p - fpix;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] - pp[x];
+            }
+         }
+      }
+      else if(method == XRIF_ADAPTIVE_FIRST)
+      {
+         for(size_t n = 1; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int64_t * restrict p = rb + n*fpix + y*width;
+               const int64_t * restrict p0 = rb + y*width;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] - p0[x];
+            }
+         }
+      }
+      else if(method == XRIF_ADAPTIVE_PIXEL)
+      {
+         //The first pixel of each row of the block is differenced with the pixel above, and the first pixel of the block is not differenced.
+         //Go backwards so each pixel is differenced against the originals.
+         for(size_t n = 0; n < nframes; ++n)
+         {
+            for(size_t y = y1 - 1; y + 1 > y0; --y)
+            {
+               int64_t * p = rb + n*fpix + y*width;
+               for(size_t x = x1 - 1; x > x0; --x) p[x] = p[x] - p[x-1];
+               if(y > y0) p[x0] = p[x0] - p[x0 - width];
+            }
+         }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_difference_adaptive_sint64
+
+//Dispatch adaptive differencing according to type
+xrif_error_t xrif_difference_adaptive( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_difference_adaptive", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_adaptive", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+      
+   if(handle->raw_buffer_size < handle->width*handle->height*handle->depth*handle->frames)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_adaptive", "raw buffer size not sufficient");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if(xrif_typeisfloat(handle->type_code))
+   {
+      XRIF_ERROR_PRINT("xrif_difference_adaptive", "adaptive differencing not implemented for floating point types");
+      return XRIF_ERROR_NOTIMPL;
+   }
+   
+   xrif_error_t rv = xrif_allocate_adaptive(handle);
+   if(rv != XRIF_NOERROR)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_adaptive", "error from xrif_allocate_adaptive");
+      return rv;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_difference_adaptive_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   {
+      return xrif_difference_adaptive_sint32(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_difference_adaptive_sint64(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_difference_adaptive", "adaptive differencing not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+} //xrif_difference_adaptive
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// undifferencing
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+xrif_error_t xrif_undifference_adaptive_sint16( xrif_t handle )
+{
+   size_t width = handle->width;
+   size_t nrows = handle->height*handle->depth;
+   size_t fpix = width*nrows;
+   size_t nframes = handle->frames;
+   
+   size_t bsz = handle->adaptive_block_size;
+   size_t nbx = (width + bsz - 1)/bsz;
+   size_t nblocks = xrif_adaptive_blocks(handle);
+   
+   int16_t * rb = (int16_t *) handle->raw_buffer;
+   const unsigned char * methods = handle->adaptive_methods;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #endif
+   
+   //Each block is walked through all the frames while it is in cache
+   #ifndef XRIF_NO_OMP
+   #pragma omp for schedule(dynamic)
+   #endif
+   for(size_t b = 0; b < nblocks; ++b)
+   {
+      size_t x0 = (b % nbx)*bsz;
+      size_t x1 = (x0 + bsz < width) ? x0 + bsz : width;
+      size_t y0 = (b / nbx)*bsz;
+      size_t y1 = (y0 + bsz < nrows) ? y0 + bsz : nrows;
+      
+      if(methods[b] == XRIF_ADAPTIVE_PREVIOUS)
+      {
+         for(size_t n = 1; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int16_t * restrict p = rb + n*fpix + y*width;
+               const int16_t * restrict pp = p - fpix;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] + pp[x];
+            }
+         }
+      }
+      else if(methods[b] == XRIF_ADAPTIVE_FIRST)
+      {
+         for(size_t n = 1; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int16_t * restrict p = rb + n*fpix + y*width;
+               const int16_t * restrict p0 = rb + y*width;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] + p0[x];
+            }
+         }
+      }
+      else if(methods[b] == XRIF_ADAPTIVE_PIXEL)
+      {
+         for(size_t n = 0; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int16_t * p = rb + n*fpix + y*width;
+               if(y > y0) p[x0] = p[x0] + p[x0 - width];
+               for(size_t x = x0 + 1; x < x1; ++x) p[x] = p[x] + p[x-1];
+            }
+         }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_undifference_adaptive_sint16
+
+xrif_error_t xrif_undifference_adaptive_sint32( xrif_t handle )
+{
+   size_t width = handle->width;
+   size_t nrows = handle->height*handle->depth;
+   size_t fpix = width*nrows;
+   size_t nframes = handle->frames;
+   
+   size_t bsz = handle->adaptive_block_size;
+   size_t nbx = (width + bsz - 1)/bsz;
+   size_t nblocks = xrif_adaptive_blocks(handle);
+   
+   int32_t * rb = (int32_t *) handle->raw_buffer;
+   const unsigned char * methods = handle->adaptive_methods;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #endif
+   
+   //Each block is walked through all the frames while it is in cache
+   #ifndef XRIF_NO_OMP
+   #pragma omp for schedule(dynamic)
+   #endif
+   for(size_t b = 0; b < nblocks; ++b)
+   {
+      size_t x0 = (b % nbx)*bsz;
+      size_t x1 = (x0 + bsz < width) ? x0 + bsz : width;
+      size_t y0 = (b / nbx)*bsz;
+      size_t y1 = (y0 + bsz < nrows) ? y0 + bsz : nrows;
+      
+      if(methods[b] == XRIF_ADAPTIVE_PREVIOUS)
+      {
+         for(size_t n = 1; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int32_t * restrict p = rb + n*fpix + y*width;
+               const int32_t * restrict pp = p - fpix;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] + pp[x];
+            }
+         }
+      }
+      else if(methods[b] == XRIF_ADAPTIVE_FIRST)
+      {
+         for(size_t n = 1; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int32_t * restrict p = rb + n*fpix + y*width;
+               const int32_t * restrict p0 = rb + y*width;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] + p0[x];
+            }
+         }
+      }
+      else if(methods[b] == XRIF_ADAPTIVE_PIXEL)
+      {
+         for(size_t n = 0; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int32_t * p = rb + n*fpix + y*width;
+               if(y > y0) p[x0] = p[x0] + p[x0 - width];
+               for(size_t x = x0 + 1; x < x1; ++x) p[x] = p[x] + p[x-1];
+            }
+         }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_undifference_adaptive_sint32
+
+xrif_error_t xrif_undifference_adaptive_sint64( xrif_t handle )
+{
+   size_t width = handle->width;
+   size_t nrows = handle->height*handle->depth;
+   size_t fpix = width*nrows;
+   size_t nframes = handle->frames;
+   
+   size_t bsz = handle->adaptive_block_size;
+   size_t nbx = (width + bsz - 1)/bsz;
+   size_t nblocks = xrif_adaptive_blocks(handle);
+   
+   int64_t * rb = (int64_t *) handle->raw_buffer;
+   const unsigned char * methods = handle->adaptive_methods;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #endif
+   
+   //Each block is walked through all the frames while it is in cache
+   #ifndef XRIF_NO_OMP
+   #pragma omp for schedule(dynamic)
+   #endif
+   for(size_t b = 0; b < nblocks; ++b)
+   {
+      size_t x0 = (b % nbx)*bsz;
+      size_t x1 = (x0 + bsz < width) ? x0 + bsz : width;
+      size_t y0 = (b / nbx)*bsz;
+      size_t y1 = (y0 + bsz < nrows) ? y0 + bsz : nrows;
+      
+      if(methods[b] == XRIF_ADAPTIVE_PREVIOUS)
+      {
+         for(size_t n = 1; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int64_t * restrict p = rb + n*fpix + y*width;
+               const int64_t * restrict pp = p - fpix;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] + pp[x];
+            }
+         }
+      }
+      else if(methods[b] == XRIF_ADAPTIVE_FIRST)
+      {
+         for(size_t n = 1; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int64_t * restrict p = rb + n*fpix + y*width;
+               const int64_t * restrict p0 = rb + y*width;
+               for(size_t x = x0; x < x1; ++x) p[x] = p[x] + p0[x];
+            }
+         }
+      }
+      else if(methods[b] == XRIF_ADAPTIVE_PIXEL)
+      {
+         for(size_t n = 0; n < nframes; ++n)
+         {
+            for(size_t y = y0; y < y1; ++y)
+            {
+               int64_t * p = rb + n*fpix + y*width;
+               if(y > y0) p[x0] = p[x0] + p[x0 - width];
+               for(size_t x = x0 + 1; x < x1; ++x) p[x] = p[x] + p[x-1];
+            }
+         }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_undifference_adaptive_sint64
+
+//Dispatch adaptive undifferencing according to type
+xrif_error_t xrif_undifference_adaptive( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_adaptive", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_adaptive", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+      
+   if(handle->raw_buffer_size < handle->width*handle->height*handle->depth*handle->frames)
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_adaptive", "raw buffer size not sufficient");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   //The method table comes from encoding or from the header
+   if( handle->adaptive_methods == NULL || handle->adaptive_methods_size != xrif_adaptive_blocks(handle) )
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_adaptive", "method table not set");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_undifference_adaptive_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   {
+      return xrif_undifference_adaptive_sint32(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_undifference_adaptive_sint64(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_adaptive", "adaptive undifferencing not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+} //xrif_undifference_adaptive
@@ -90,128 +90,158 @@ matter of this Agreement.
 
 xrif_error_t xrif_difference_first_sint16( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int16_t * rb = (int16_t *) handle->raw_buffer;
    
-   for(int n=0; n < handle->frames-1; ++n)
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
    {
-      size_t n_stride0 = 0;
-      size_t n_stride =  (handle->frames - 1 - n) * npix*handle->depth;
-
-      for(int kk=0; kk< handle->depth; ++kk)
+   #endif
+   
+   //The key frames are not changed, so the frames are independent and no barrier is needed between them.
+   for(size_t n = 1; n < nframes; ++n)
+   {
+      //Key frames are not differenced, and the other frames use the key frame which starts their segment
+      if(n % sframes == 0) continue;
+      
+      int16_t * restrict rb0 = rb + (n - n % sframes)*fpix;
+      int16_t * restrict rb1 = rb + n*fpix;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < fpix; ++qq)
       {
-         size_t kk_stride = kk*npix;
-
-         int16_t * rb0 = &rb[n_stride0 + kk_stride];
-         int16_t * rb1 = &rb[n_stride + kk_stride];
-         
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
-         #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-
-         for(int qq=0; qq < npix; ++qq)
-         {
-            rb1[qq] = (rb1[qq] - rb0[qq]);
-         }
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         rb1[qq] = rb1[qq] - rb0[qq];
       }
-   } 
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
    return XRIF_NOERROR;
 } //xrif_difference_first_sint16
 
 xrif_error_t xrif_difference_first_sint32( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int32_t * rb = (int32_t *) handle->raw_buffer;
    
-   for(int n=0; n < handle->frames-1; ++n)
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
    {
-      size_t n_stride0 = 0;
-      size_t n_stride =  (handle->frames - 1 - n) * npix*handle->depth;
-
-      for(int kk=0; kk< handle->depth; ++kk)
+   #endif
+   
+   //The key frames are not changed, so the frames are independent and no barrier is needed between them.
+   for(size_t n = 1; n < nframes; ++n)
+   {
+      //Key frames are not differenced, and the other frames use the key frame which starts their segment
+      if(n % sframes == 0) continue;
+      
+      int32_t * restrict rb0 = rb + (n - n % sframes)*fpix;
+      int32_t * restrict rb1 = rb + n*fpix;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < fpix; ++qq)
       {
-         size_t kk_stride = kk*npix;
-   
-         int32_t * rb0 = &rb[n_stride0 + kk_stride];
-         int32_t * rb1 = &rb[n_stride + kk_stride];
-         
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
-         #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int qq=0; qq < npix; ++qq)
-         {
-            rb1[qq] = (rb1[qq] - rb0[qq]);
-         } 
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         rb1[qq] = rb1[qq] - rb0[qq];
       }
-   } 
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
    return XRIF_NOERROR;
 } //xrif_difference_first_sint32
 
 xrif_error_t xrif_difference_first_sint64( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int64_t * rb = (int64_t *) handle->raw_buffer;
    
-   for(int n=0; n < handle->frames-1; ++n)
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
    {
-      size_t n_stride0 = 0;
-      size_t n_stride =  (handle->frames - 1 - n) * npix*handle->depth;
-
-      for(int kk=0; kk< handle->depth; ++kk)
+   #endif
+   
+   //The key frames are not changed, so the frames are independent and no barrier is needed between them.
+   for(size_t n = 1; n < nframes; ++n)
+   {
+      //Key frames are not differenced, and the other frames use the key frame which starts their segment
+      if(n % sframes == 0) continue;
+      
+      int64_t * restrict rb0 = rb + (n - n % sframes)*fpix;
+      int64_t * restrict rb1 = rb + n*fpix;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < fpix; ++qq)
       {
-         size_t kk_stride = kk*npix;
-         
-         int64_t * rb0 = &rb[n_stride0 + kk_stride];
-         int64_t * rb1 = &rb[n_stride + kk_stride];
-         
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
-         #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int qq=0; qq< npix;++qq)
-         {
-            rb1[qq] = (rb1[qq] - rb0[qq]);
-         }
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         rb1[qq] = rb1[qq] - rb0[qq];
       }
-   } 
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
    return XRIF_NOERROR;
 } //xrif_difference_first_sint64
 
 
+//Floating point types are differenced by XOR with the first frame
+xrif_error_t xrif_difference_first_xor( xrif_t handle )
+{
+   size_t nbytes = handle->width*handle->height*handle->depth*handle->data_size;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   unsigned char * rb = (unsigned char *) handle->raw_buffer;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, handle->width*handle->height*handle->depth*nframes))
+   {
+   #endif
+   
+   //The key frames are not changed, so the frames are independent and no barrier is needed between them.
+   for(size_t n = 1; n < nframes; ++n)
+   {
+      //Key frames are not differenced, and the other frames use the key frame which starts their segment
+      if(n % sframes == 0) continue;
+      
+      unsigned char * restrict rb0 = rb + (n - n % sframes)*nbytes;
+      unsigned char * restrict rb1 = rb + n*nbytes;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < nbytes; ++qq)
+      {
+         rb1[qq] ^= rb0[qq];
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_difference_first_xor
+
 //Dispatch differencing w.r.t. previous according to type
 xrif_error_t xrif_difference_first( xrif_t handle )
 {
@@ -245,6 +275,10 @@ xrif_error_t xrif_difference_first( xrif_t handle )
    {
       return xrif_difference_first_sint64(handle);
    }
+   else if(xrif_typeisfloat(handle->type_code))
+   {
+      return xrif_difference_first_xor(handle);
+   }
    else
    {
       XRIF_ERROR_PRINT("xrif_difference_first", "previous differencing not implemented for type");
@@ -260,128 +294,157 @@ xrif_error_t xrif_difference_first( xrif_t handle )
 
 xrif_error_t xrif_undifference_first_sint16( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int16_t * rb = (int16_t *) handle->raw_buffer;
    
-   for(int n=1; n < handle->frames; ++n)
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #endif
+   
+   //The key frames are not changed, so the frames are independent and no barrier is needed between them.
+   for(size_t n = 1; n < nframes; ++n)
    {
-      size_t n_stride0 = 0;
-      size_t n_stride =  n * npix*handle->depth;
+      //Key frames are not differenced, and the other frames use the key frame which starts their segment
+      if(n % sframes == 0) continue;
+      
+      int16_t * restrict rb0 = rb + (n - n % sframes)*fpix;
+      int16_t * restrict rb1 = rb + n*fpix;
       
-      for(int kk=0; kk<handle->depth; ++kk)
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < fpix; ++qq)
       {
-         size_t kk_stride = kk*npix;
-         
-         int16_t * rb0 = &rb[n_stride0 + kk_stride];
-         int16_t * rb1 = &rb[n_stride + kk_stride];
-         
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
-         #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int qq=0; qq< handle->width*handle->height; ++qq)
-         {
-            rb1[qq] = rb1[qq] + rb0[qq];
-         }
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         rb1[qq] = rb1[qq] + rb0[qq];
       }
    }
    
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
    return XRIF_NOERROR;
 }//xrif_undifference_first_sint16
 
 xrif_error_t xrif_undifference_first_sint32( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int32_t * rb = (int32_t *) handle->raw_buffer;
    
-   for(int n=1; n < handle->frames; ++n)
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
    {
-      size_t n_stride0 = 0;
-      size_t n_stride =  n * npix*handle->depth;
+   #endif
+   
+   //The key frames are not changed, so the frames are independent and no barrier is needed between them.
+   for(size_t n = 1; n < nframes; ++n)
+   {
+      //Key frames are not differenced, and the other frames use the key frame which starts their segment
+      if(n % sframes == 0) continue;
+      
+      int32_t * restrict rb0 = rb + (n - n % sframes)*fpix;
+      int32_t * restrict rb1 = rb + n*fpix;
       
-      for(int kk=0; kk<handle->depth; ++kk)
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < fpix; ++qq)
       {
-         size_t kk_stride = kk*npix;
-         
-         int32_t * rb0 = &rb[n_stride0 + kk_stride];
-         int32_t * rb1 = &rb[n_stride + kk_stride];
-         
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
-         #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int qq=0; qq< handle->width*handle->height; ++qq)
-         {
-            rb1[qq] = rb1[qq] + rb0[qq];
-         }
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         rb1[qq] = rb1[qq] + rb0[qq];
       }
    }
    
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
    return XRIF_NOERROR;
 } //xrif_undifference_first_sint32
 
 xrif_error_t xrif_undifference_first_sint64( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int64_t * rb = (int64_t *) handle->raw_buffer;
    
-   for(int n=1; n < handle->frames; ++n)
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
    {
-      size_t n_stride0 = 0;
-      size_t n_stride =  n * npix*handle->depth;
+   #endif
+   
+   //The key frames are not changed, so the frames are independent and no barrier is needed between them.
+   for(size_t n = 1; n < nframes; ++n)
+   {
+      //Key frames are not differenced, and the other frames use the key frame which starts their segment
+      if(n % sframes == 0) continue;
+      
+      int64_t * restrict rb0 = rb + (n - n % sframes)*fpix;
+      int64_t * restrict rb1 = rb + n*fpix;
       
-      for(int kk=0; kk<handle->depth; ++kk)
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < fpix; ++qq)
       {
-         size_t kk_stride = kk*npix;
-         
-         int64_t * rb0 = &rb[n_stride0 + kk_stride];
-         int64_t * rb1 = &rb[n_stride + kk_stride];
-         
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
-         #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int qq=0; qq< npix; ++qq)
-         {
-            rb1[qq] = rb1[qq] + rb0[qq];
-         }
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         rb1[qq] = rb1[qq] + rb0[qq];
       }
    }
    
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
    return XRIF_NOERROR;
 }//xrif_undifference_first_sint64
 
 
+xrif_error_t xrif_undifference_first_xor( xrif_t handle )
+{
+   size_t nbytes = handle->width*handle->height*handle->depth*handle->data_size;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   unsigned char * rb = (unsigned char *) handle->raw_buffer;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, handle->width*handle->height*handle->depth*nframes))
+   {
+   #endif
+   
+   //The key frames are not changed, so the frames are independent and no barrier is needed between them.
+   for(size_t n = 1; n < nframes; ++n)
+   {
+      //Key frames are not differenced, and the other frames use the key frame which starts their segment
+      if(n % sframes == 0) continue;
+      
+      unsigned char * restrict rb0 = rb + (n - n % sframes)*nbytes;
+      unsigned char * restrict rb1 = rb + n*nbytes;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < nbytes; ++qq)
+      {
+         rb1[qq] ^= rb0[qq];
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+}//xrif_undifference_first_xor
+
 //Dispatch undifferencing w.r.t. previous according to type
 xrif_error_t xrif_undifference_first( xrif_t handle )
 {
@@ -415,6 +478,10 @@ xrif_error_t xrif_undifference_first( xrif_t handle )
    {
       return xrif_undifference_first_sint64(handle);
    }
+   else if(xrif_typeisfloat(handle->type_code))
+   {
+      return xrif_undifference_first_xor(handle);
+   }
    else
    {
       XRIF_ERROR_PRINT("xrif_difference_first", "previous undifferencing not implemented for type");
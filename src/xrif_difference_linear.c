@@ -0,0 +1,931 @@
+/** \file xrif_difference_linear.c
+  * \brief Implementation of xrif linear extrapolation differencing
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include "xrif.h"
+
+#if !defined(XRIF_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define XRIF_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/* Each pixel is predicted by extrapolating the line through its values in the two frames before, 2*x1 - x0.  The prediction
+ * is clamped to the range of the type, so a trend which would run past the end of the range does not wrap around.  Unsigned types
+ * are clamped in their own range by flipping the sign bit (the bias) of both values and the prediction.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// scalar predictors
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+static inline int16_t xrif_predict_linear_sint16( int16_t x1,
+                                                  int16_t x0,
+                                                  int16_t bias
+                                                )
+{
+   int32_t p = 2*(int32_t)(int16_t)(x1 ^ bias) - (int32_t)(int16_t)(x0 ^ bias);
+   
+   p = (p > INT16_MAX) ? INT16_MAX : p;
+   p = (p < INT16_MIN) ? INT16_MIN : p;
+   
+   return ((int16_t) p) ^ bias;
+}
+
+static inline int32_t xrif_predict_linear_sint32( int32_t x1,
+                                                  int32_t x0,
+                                                  int32_t bias
+                                                )
+{
+   int64_t p = 2*(int64_t)(x1 ^ bias) - (int64_t)(x0 ^ bias);
+   
+   p = (p > INT32_MAX) ? INT32_MAX : p;
+   p = (p < INT32_MIN) ? INT32_MIN : p;
+   
+   return ((int32_t) p) ^ bias;
+}
+
+//There is no wider type, so x1 + (x1 - x0) is taken with wrap around and saturated if either step overflowed.  Both overflows
+//go past the end of the range on the side of the sign of x1.
+static inline int64_t xrif_predict_linear_sint64( int64_t x1,
+                                                  int64_t x0,
+                                                  int64_t bias
+                                                )
+{
+   uint64_t a = (uint64_t) (x1 ^ bias);
+   uint64_t b = (uint64_t) (x0 ^ bias);
+   
+   uint64_t d = a - b;
+   uint64_t p = a + d;
+   
+   int ov = ((int64_t) ((a ^ b) & (a ^ d)) < 0) | ((int64_t) ((a ^ p) & (d ^ p)) < 0);
+   
+   if(ov) p = ((int64_t) a < 0) ? (uint64_t) INT64_MIN : (uint64_t) INT64_MAX;
+   
+   return ((int64_t) p) ^ bias;
+}
+
+static void xrif_linear_sint16_scalar( int16_t * restrict x2,
+                                    const int16_t * restrict x1,
+                                    const int16_t * restrict x0,
+                                    size_t npix,
+                                    int16_t bias,
+                                    int undo
+                                  )
+{
+   if(undo)
+   {
+      for(size_t i = 0; i < npix; ++i) x2[i] = x2[i] + xrif_predict_linear_sint16(x1[i], x0[i], bias);
+   }
+   else
+   {
+      for(size_t i = 0; i < npix; ++i) x2[i] = x2[i] - xrif_predict_linear_sint16(x1[i], x0[i], bias);
+   }
+}
+
+static void xrif_linear_sint32_scalar( int32_t * restrict x2,
+                                    const int32_t * restrict x1,
+                                    const int32_t * restrict x0,
+                                    size_t npix,
+                                    int32_t bias,
+                                    int undo
+                                  )
+{
+   if(undo)
+   {
+      for(size_t i = 0; i < npix; ++i) x2[i] = x2[i] + xrif_predict_linear_sint32(x1[i], x0[i], bias);
+   }
+   else
+   {
+      for(size_t i = 0; i < npix; ++i) x2[i] = x2[i] - xrif_predict_linear_sint32(x1[i], x0[i], bias);
+   }
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// vector predictors
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+#ifdef XRIF_SIMD_X86
+
+//16 bit predictions are taken in 32 bits and packed back with signed saturation, which is the clamp.
+__attribute__((target("sse2")))
+static inline __m128i xrif_predict_linear_epi16_sse2( __m128i x1,
+                                                      __m128i x0,
+                                                      __m128i bias
+                                                    )
+{
+   x1 = _mm_xor_si128(x1, bias);
+   x0 = _mm_xor_si128(x0, bias);
+   
+   __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(x1, x1), 16);
+   __m128i b = _mm_srai_epi32(_mm_unpacklo_epi16(x0, x0), 16);
+   __m128i lo = _mm_sub_epi32(_mm_add_epi32(a, a), b);
+   
+   a = _mm_srai_epi32(_mm_unpackhi_epi16(x1, x1), 16);
+   b = _mm_srai_epi32(_mm_unpackhi_epi16(x0, x0), 16);
+   __m128i hi = _mm_sub_epi32(_mm_add_epi32(a, a), b);
+   
+   return _mm_xor_si128(_mm_packs_epi32(lo, hi), bias);
+}
+
+//32 bit predictions use the overflow tests of xrif_predict_linear_sint64.
+__attribute__((target("sse2")))
+static inline __m128i xrif_predict_linear_epi32_sse2( __m128i x1,
+                                                      __m128i x0,
+                                                      __m128i bias
+                                                    )
+{
+   __m128i a = _mm_xor_si128(x1, bias);
+   __m128i b = _mm_xor_si128(x0, bias);
+   
+   __m128i d = _mm_sub_epi32(a, b);
+   __m128i p = _mm_add_epi32(a, d);
+   
+   __m128i ov = _mm_or_si128( _mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, d)),
+                              _mm_and_si128(_mm_xor_si128(a, p), _mm_xor_si128(d, p)) );
+   ov = _mm_srai_epi32(ov, 31);
+   
+   __m128i sat = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(INT32_MAX));
+   
+   p = _mm_or_si128(_mm_and_si128(ov, sat), _mm_andnot_si128(ov, p));
+   
+   return _mm_xor_si128(p, bias);
+}
+
+//The unpacks and packs both work within each 128 bit lane, so the pixel order is kept.
+__attribute__((target("avx2")))
+static inline __m256i xrif_predict_linear_epi16_avx2( __m256i x1,
+                                                      __m256i x0,
+                                                      __m256i bias
+                                                    )
+{
+   x1 = _mm256_xor_si256(x1, bias);
+   x0 = _mm256_xor_si256(x0, bias);
+   
+   __m256i a = _mm256_srai_epi32(_mm256_unpacklo_epi16(x1, x1), 16);
+   __m256i b = _mm256_srai_epi32(_mm256_unpacklo_epi16(x0, x0), 16);
+   __m256i lo = _mm256_sub_epi32(_mm256_add_epi32(a, a), b);
+   
+   a = _mm256_srai_epi32(_mm256_unpackhi_epi16(x1, x1), 16);
+   b = _mm256_srai_epi32(_mm256_unpackhi_epi16(x0, x0), 16);
+   __m256i hi = _mm256_sub_epi32(_mm256_add_epi32(a, a), b);
+   
+   return _mm256_xor_si256(_mm256_packs_epi32(lo, hi), bias);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i xrif_predict_linear_epi32_avx2( __m256i x1,
+                                                      __m256i x0,
+                                                      __m256i bias
+                                                    )
+{
+   __m256i a = _mm256_xor_si256(x1, bias);
+   __m256i b = _mm256_xor_si256(x0, bias);
+   
+   __m256i d = _mm256_sub_epi32(a, b);
+   __m256i p = _mm256_add_epi32(a, d);
+   
+   __m256i ov = _mm256_or_si256( _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, d)),
+                                 _mm256_and_si256(_mm256_xor_si256(a, p), _mm256_xor_si256(d, p)) );
+   ov = _mm256_srai_epi32(ov, 31);
+   
+   __m256i sat = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(INT32_MAX));
+   
+   p = _mm256_blendv_epi8(p, sat, ov);
+   
+   return _mm256_xor_si256(p, bias);
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_linear_sint16_sse2( int16_t * x2,
+                                       const int16_t * x1,
+                                       const int16_t * x0,
+                                       size_t npix,
+                                       int16_t bias,
+                                       int undo
+                                     )
+{
+   __m128i vb = _mm_set1_epi16(bias);
+   
+   size_t i = 0;
+   for(; i + 8 <= npix; i += 8)
+   {
+      __m128i p = xrif_predict_linear_epi16_sse2( _mm_loadu_si128( (const __m128i *) (x1 + i)),
+                                                  _mm_loadu_si128( (const __m128i *) (x0 + i)), vb);
+      
+      __m128i x = _mm_loadu_si128( (const __m128i *) (x2 + i));
+      
+      x = (undo) ? _mm_add_epi16(x, p) : _mm_sub_epi16(x, p);
+      
+      _mm_storeu_si128( (__m128i *) (x2 + i), x);
+   }
+   
+   return i;
+}
+
+__attribute__((target("avx2")))
+static size_t xrif_linear_sint16_avx2( int16_t * x2,
+                                       const int16_t * x1,
+                                       const int16_t * x0,
+                                       size_t npix,
+                                       int16_t bias,
+                                       int undo
+                                     )
+{
+   __m256i vb = _mm256_set1_epi16(bias);
+   
+   size_t i = 0;
+   for(; i + 16 <= npix; i += 16)
+   {
+      __m256i p = xrif_predict_linear_epi16_avx2( _mm256_loadu_si256( (const __m256i *) (x1 + i)),
+                                                  _mm256_loadu_si256( (const __m256i *) (x0 + i)), vb);
+      
+      __m256i x = _mm256_loadu_si256( (const __m256i *) (x2 + i));
+      
+      x = (undo) ? _mm256_add_epi16(x, p) : _mm256_sub_epi16(x, p);
+      
+      _mm256_storeu_si256( (__m256i *) (x2 + i), x);
+   }
+   
+   return i;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_linear_sint32_sse2( int32_t * x2,
+                                       const int32_t * x1,
+                                       const int32_t * x0,
+                                       size_t npix,
+                                       int32_t bias,
+                                       int undo
+                                     )
+{
+   __m128i vb = _mm_set1_epi32(bias);
+   
+   size_t i = 0;
+   for(; i + 4 <= npix; i += 4)
+   {
+      __m128i p = xrif_predict_linear_epi32_sse2( _mm_loadu_si128( (const __m128i *) (x1 + i)),
+                                                  _mm_loadu_si128( (const __m128i *) (x0 + i)), vb);
+      
+      __m128i x = _mm_loadu_si128( (const __m128i *) (x2 + i));
+      
+      x = (undo) ? _mm_add_epi32(x, p) : _mm_sub_epi32(x, p);
+      
+      _mm_storeu_si128( (__m128i *) (x2 + i), x);
+   }
+   
+   return i;
+}
+
+__attribute__((target("avx2")))
+static size_t xrif_linear_sint32_avx2( int32_t * x2,
+                                       const int32_t * x1,
+                                       const int32_t * x0,
+                                       size_t npix,
+                                       int32_t bias,
+                                       int undo
+                                     )
+{
+   __m256i vb = _mm256_set1_epi32(bias);
+   
+   size_t i = 0;
+   for(; i + 8 <= npix; i += 8)
+   {
+      __m256i p = xrif_predict_linear_epi32_avx2( _mm256_loadu_si256( (const __m256i *) (x1 + i)),
+                                                  _mm256_loadu_si256( (const __m256i *) (x0 + i)), vb);
+      
+      __m256i x = _mm256_loadu_si256( (const __m256i *) (x2 + i));
+      
+      x = (undo) ? _mm256_add_epi32(x, p) : _mm256_sub_epi32(x, p);
+      
+      _mm256_storeu_si256( (__m256i *) (x2 + i), x);
+   }
+   
+   return i;
+}
+
+#endif //XRIF_SIMD_X86
+
+void xrif_difference_linear_sint16_kernel( int16_t * x2,
+                                           const int16_t * x1,
+                                           const int16_t * x0,
+                                           size_t npix,
+                                           int16_t bias,
+                                           int simd
+                                         )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_AVX2) done = xrif_linear_sint16_avx2(x2, x1, x0, npix, bias, 0);
+   else if(simd >= XRIF_SIMD_SSE2) done = xrif_linear_sint16_sse2(x2, x1, x0, npix, bias, 0);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_linear_sint16_scalar(x2 + done, x1 + done, x0 + done, npix - done, bias, 0);
+}
+
+void xrif_undifference_linear_sint16_kernel( int16_t * x2,
+                                             const int16_t * x1,
+                                             const int16_t * x0,
+                                             size_t npix,
+                                             int16_t bias,
+                                             int simd
+                                           )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_AVX2) done = xrif_linear_sint16_avx2(x2, x1, x0, npix, bias, 1);
+   else if(simd >= XRIF_SIMD_SSE2) done = xrif_linear_sint16_sse2(x2, x1, x0, npix, bias, 1);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_linear_sint16_scalar(x2 + done, x1 + done, x0 + done, npix - done, bias, 1);
+}
+
+void xrif_difference_linear_sint32_kernel( int32_t * x2,
+                                           const int32_t * x1,
+                                           const int32_t * x0,
+                                           size_t npix,
+                                           int32_t bias,
+                                           int simd
+                                         )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_AVX2) done = xrif_linear_sint32_avx2(x2, x1, x0, npix, bias, 0);
+   else if(simd >= XRIF_SIMD_SSE2) done = xrif_linear_sint32_sse2(x2, x1, x0, npix, bias, 0);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_linear_sint32_scalar(x2 + done, x1 + done, x0 + done, npix - done, bias, 0);
+}
+
+void xrif_undifference_linear_sint32_kernel( int32_t * x2,
+                                             const int32_t * x1,
+                                             const int32_t * x0,
+                                             size_t npix,
+                                             int32_t bias,
+                                             int simd
+                                           )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_AVX2) done = xrif_linear_sint32_avx2(x2, x1, x0, npix, bias, 1);
+   else if(simd >= XRIF_SIMD_SSE2) done = xrif_linear_sint32_sse2(x2, x1, x0, npix, bias, 1);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_linear_sint32_scalar(x2 + done, x1 + done, x0 + done, npix - done, bias, 1);
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// differencing
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+xrif_error_t xrif_difference_linear_sint16( xrif_t handle )
+{
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   int16_t * rb = (int16_t *) handle->raw_buffer;
+   
+   int16_t bias = (handle->type_code == XRIF_TYPECODE_UINT16) ? INT16_MIN : 0;
+   
+   int simd = xrif_simd_level();
+   
+   size_t bpix = XRIF_UNDIFFERENCE_BLOCK / sizeof(int16_t);
+   size_t nblocks = (fpix + bpix - 1) / bpix;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t b = 0; b < nblocks; ++b)
+   {
+      size_t pix = b*bpix;
+      size_t np = (pix + bpix <= fpix) ? bpix : fpix - pix;
+      
+      //Going backwards, each frame is differenced while the two frames before it are still unchanged.  Key frames are not differenced,
+      //and the frame after a key frame is differenced w.r.t. previous.
+      for(size_t n = nframes-1; n > 0; --n)
+      {
+         if(n % sframes == 0) continue;
+         
+         if(n % sframes > 1)
+         {
+            xrif_difference_linear_sint16_kernel(rb + n*fpix + pix, rb + (n-1)*fpix + pix, rb + (n-2)*fpix + pix, np, bias, simd);
+         }
+         else
+         {
+            int16_t * restrict rb0 = rb + (n-1)*fpix + pix;
+            int16_t * restrict rb1 = rb + n*fpix + pix;
+            
+            #ifndef XRIF_NO_OMP
+            #pragma omp simd
+            #endif
+            for(size_t qq = 0; qq < np; ++qq)
+            {
+               rb1[qq] = rb1[qq] - rb0[qq];
+            }
+         }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_difference_linear_sint16
+
+xrif_error_t xrif_difference_linear_sint32( xrif_t handle )
+{
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   int32_t * rb = (int32_t *) handle->raw_buffer;
+   
+   int32_t bias = (handle->type_code == XRIF_TYPECODE_UINT32) ? INT32_MIN : 0;
+   
+   int simd = xrif_simd_level();
+   
+   size_t bpix = XRIF_UNDIFFERENCE_BLOCK / sizeof(int32_t);
+   size_t nblocks = (fpix + bpix - 1) / bpix;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t b = 0; b < nblocks; ++b)
+   {
+      size_t pix = b*bpix;
+      size_t np = (pix + bpix <= fpix) ? bpix : fpix - pix;
+      
+      //Going backwards, each frame is differenced while the two frames before it are still unchanged.  Key frames are not differenced,
+      //and the frame after a key frame is differenced w.r.t. previous.
+      for(size_t n = nframes-1; n > 0; --n)
+      {
+         if(n % sframes == 0) continue;
+         
+         if(n % sframes > 1)
+         {
+            xrif_difference_linear_sint32_kernel(rb + n*fpix + pix, rb + (n-1)*fpix + pix, rb + (n-2)*fpix + pix, np, bias, simd);
+         }
+         else
+         {
+            int32_t * restrict rb0 = rb + (n-1)*fpix + pix;
+            int32_t * restrict rb1 = rb + n*fpix + pix;
+            
+            #ifndef XRIF_NO_OMP
+            #pragma omp simd
+            #endif
+            for(size_t qq = 0; qq < np; ++qq)
+            {
+               rb1[qq] = rb1[qq] - rb0[qq];
+            }
+         }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_difference_linear_sint32
+
+xrif_error_t xrif_difference_linear_sint64( xrif_t handle )
+{
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   int64_t * rb = (int64_t *) handle->raw_buffer;
+   
+   int64_t bias = (handle->type_code == XRIF_TYPECODE_UINT64) ? INT64_MIN : 0;
+   
+   size_t bpix = XRIF_UNDIFFERENCE_BLOCK / sizeof(int64_t);
+   size_t nblocks = (fpix + bpix - 1) / bpix;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t b = 0; b < nblocks; ++b)
+   {
+      size_t pix = b*bpix;
+      size_t np = (pix + bpix <= fpix) ? bpix : fpix - pix;
+      
+      //Going backwards, each frame is differenced while the two frames before it are still unchanged.  Key frames are not differenced,
+      //and the frame after a key frame is differenced w.r.t. previous.
+      for(size_t n = nframes-1; n > 0; --n)
+      {
+         if(n % sframes == 0) continue;
+         
+         if(n % sframes > 1)
+         {
+            int64_t * restrict rb0 = rb + (n-2)*fpix + pix;
+            int64_t * restrict rb1 = rb + (n-1)*fpix + pix;
+            int64_t * restrict rb2 = rb + n*fpix + pix;
+            
+            #ifndef XRIF_NO_OMP
+            #pragma omp simd
+            #endif
+            for(size_t qq = 0; qq < np; ++qq)
+            {
+               rb2[qq] = rb2[qq] - xrif_predict_linear_sint64(rb1[qq], rb0[qq], bias);
+            }
+         }
+         else
+         {
+            int64_t * restrict rb0 = rb + (n-1)*fpix + pix;
+            int64_t * restrict rb1 = rb + n*fpix + pix;
+            
+            #ifndef XRIF_NO_OMP
+            #pragma omp simd
+            #endif
+            for(size_t qq = 0; qq < np; ++qq)
+            {
+               rb1[qq] = rb1[qq] - rb0[qq];
+            }
+         }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_difference_linear_sint64
+
+//Dispatch linear differencing according to type
+xrif_error_t xrif_difference_linear( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_difference_linear", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_linear", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+      
+   if(handle->raw_buffer_size < handle->width*handle->height*handle->depth*handle->frames*handle->data_size)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_linear", "raw buffer size not sufficient");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_difference_linear_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   {
+      return xrif_difference_linear_sint32(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_difference_linear_sint64(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_difference_linear", "linear differencing not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+} //xrif_difference_linear
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// undifferencing
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+xrif_error_t xrif_undifference_linear_sint16( xrif_t handle )
+{
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   int16_t * rb = (int16_t *) handle->raw_buffer;
+   
+   int16_t bias = (handle->type_code == XRIF_TYPECODE_UINT16) ? INT16_MIN : 0;
+   
+   int simd = xrif_simd_level();
+   
+   size_t bpix = XRIF_UNDIFFERENCE_BLOCK / sizeof(int16_t);
+   size_t nblocks = (fpix + bpix - 1) / bpix;
+   size_t nsegs = (nframes + sframes - 1) / sframes;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t sb = 0; sb < nsegs*nblocks; ++sb)
+   {
+      size_t seg = sb / nblocks;
+      size_t pix = (sb % nblocks)*bpix;
+      size_t np = (pix + bpix <= fpix) ? bpix : fpix - pix;
+      
+      size_t n0 = seg*sframes;
+      size_t n1 = (n0 + sframes < nframes) ? n0 + sframes : nframes;
+      
+      //The segments between key frames are independent.  The frame after the key frame was differenced w.r.t. previous.
+      if(n0 + 1 < n1)
+      {
+         int16_t * restrict rb0 = rb + n0*fpix + pix;
+         int16_t * restrict rb1 = rb + (n0+1)*fpix + pix;
+         
+         #ifndef XRIF_NO_OMP
+         #pragma omp simd
+         #endif
+         for(size_t qq = 0; qq < np; ++qq)
+         {
+            rb1[qq] = rb1[qq] + rb0[qq];
+         }
+      }
+      
+      //A block of pixels is walked through all the frames of its segment while the two frames before are still in cache.
+      for(size_t n = n0+2; n < n1; ++n)
+      {
+         xrif_undifference_linear_sint16_kernel(rb + n*fpix + pix, rb + (n-1)*fpix + pix, rb + (n-2)*fpix + pix, np, bias, simd);
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_undifference_linear_sint16
+
+xrif_error_t xrif_undifference_linear_sint32( xrif_t handle )
+{
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   int32_t * rb = (int32_t *) handle->raw_buffer;
+   
+   int32_t bias = (handle->type_code == XRIF_TYPECODE_UINT32) ? INT32_MIN : 0;
+   
+   int simd = xrif_simd_level();
+   
+   size_t bpix = XRIF_UNDIFFERENCE_BLOCK / sizeof(int32_t);
+   size_t nblocks = (fpix + bpix - 1) / bpix;
+   size_t nsegs = (nframes + sframes - 1) / sframes;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t sb = 0; sb < nsegs*nblocks; ++sb)
+   {
+      size_t seg = sb / nblocks;
+      size_t pix = (sb % nblocks)*bpix;
+      size_t np = (pix + bpix <= fpix) ? bpix : fpix - pix;
+      
+      size_t n0 = seg*sframes;
+      size_t n1 = (n0 + sframes < nframes) ? n0 + sframes : nframes;
+      
+      //The segments between key frames are independent.  The frame after the key frame was differenced w.r.t. previous.
+      if(n0 + 1 < n1)
+      {
+         int32_t * restrict rb0 = rb + n0*fpix + pix;
+         int32_t * restrict rb1 = rb + (n0+1)*fpix + pix;
+         
+         #ifndef XRIF_NO_OMP
+         #pragma omp simd
+         #endif
+         for(size_t qq = 0; qq < np; ++qq)
+         {
+            rb1[qq] = rb1[qq] + rb0[qq];
+         }
+      }
+      
+      //A block of pixels is walked through all the frames of its segment while the two frames before are still in cache.
+      for(size_t n = n0+2; n < n1; ++n)
+      {
+         xrif_undifference_linear_sint32_kernel(rb + n*fpix + pix, rb + (n-1)*fpix + pix, rb + (n-2)*fpix + pix, np, bias, simd);
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_undifference_linear_sint32
+
+xrif_error_t xrif_undifference_linear_sint64( xrif_t handle )
+{
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   int64_t * rb = (int64_t *) handle->raw_buffer;
+   
+   int64_t bias = (handle->type_code == XRIF_TYPECODE_UINT64) ? INT64_MIN : 0;
+   
+   size_t bpix = XRIF_UNDIFFERENCE_BLOCK / sizeof(int64_t);
+   size_t nblocks = (fpix + bpix - 1) / bpix;
+   size_t nsegs = (nframes + sframes - 1) / sframes;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t sb = 0; sb < nsegs*nblocks; ++sb)
+   {
+      size_t seg = sb / nblocks;
+      size_t pix = (sb % nblocks)*bpix;
+      size_t np = (pix + bpix <= fpix) ? bpix : fpix - pix;
+      
+      size_t n0 = seg*sframes;
+      size_t n1 = (n0 + sframes < nframes) ? n0 + sframes : nframes;
+      
+      //The segments between key frames are independent.  The frame after the key frame was differenced w.r.t. previous.
+      if(n0 + 1 < n1)
+      {
+         int64_t * restrict rb0 = rb + n0*fpix + pix;
+         int64_t * restrict rb1 = rb + (n0+1)*fpix + pix;
+         
+         #ifndef XRIF_NO_OMP
+         #pragma omp simd
+         #endif
+         for(size_t qq = 0; qq < np; ++qq)
+         {
+            rb1[qq] = rb1[qq] + rb0[qq];
+         }
+      }
+      
+      //A block of pixels is walked through all the frames of its segment while the two frames before are still in cache.
+      for(size_t n = n0+2; n < n1; ++n)
+      {
+         int64_t * restrict rb0 = rb + (n-2)*fpix + pix;
+         int64_t * restrict rb1 = rb + (n-1)*fpix + pix;
+         int64_t * restrict rb2 = rb + n*fpix + pix;
+         
+         #ifndef XRIF_NO_OMP
+         #pragma omp simd
+         #endif
+         for(size_t qq = 0; qq < np; ++qq)
+         {
+            rb2[qq] = rb2[qq] + xrif_predict_linear_sint64(rb1[qq], rb0[qq], bias);
+         }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_undifference_linear_sint64
+
+//Dispatch linear undifferencing according to type
+xrif_error_t xrif_undifference_linear( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_linear", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_linear", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+      
+   if(handle->raw_buffer_size < handle->width*handle->height*handle->depth*handle->frames*handle->data_size)
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_linear", "raw buffer size not sufficient");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_undifference_linear_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   {
+      return xrif_undifference_linear_sint32(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_undifference_linear_sint64(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_linear", "linear undifferencing not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+} //xrif_undifference_linear
@@ -86,143 +86,330 @@ matter of this Agreement.
 
 #include "xrif.h"
 
-xrif_error_t xrif_difference_pixel_sint8( xrif_t handle )
+#if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#if !defined(XRIF_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define XRIF_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/* The pixels of the whole cube are split into one contiguous range per thread.  Each image is differenced on its own, so a
+ * range can start and end anywhere in an image, and only the first image in a range depends on the thread before.
+ */
+static void xrif_pixel_range( size_t * start,
+                              size_t * end,
+                              size_t npix
+                            )
 {
-   size_t npix = handle->width*handle->height;
+   size_t t = 0;
+   size_t nt = 1;
    
-   for(size_t n=0; n < handle->frames; ++n)
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   t = omp_get_thread_num();
+   nt = omp_get_num_threads();
+   #endif
+   
+   *start = npix*t/nt;
+   *end = npix*(t+1)/nt;
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// differencing
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//The number of pixels copied at a time while differencing, small enough to stay on the stack and in the L1 cache
+#define XRIF_PIXEL_BLOCK (512)
+
+//Difference the pixels s to e-1 of the cube in place.  prev is the original value of pixel s-1, unused if s starts an image.
+static void xrif_difference_pixel_sint8_range( int8_t * rb,
+                                               size_t s,
+                                               size_t e,
+                                               size_t ppix,
+                                               int8_t prev
+                                             )
+{
+   while(s < e)
    {
-      for(size_t kk=0; kk< handle->depth; ++kk)
+      size_t j = s % ppix;
+      size_t n = (e - s < ppix - j) ? e - s : ppix - j;
+      
+      //The first pixel of each image is its own reference
+      if(j == 0) prev = 0;
+      
+      int8_t * pix = rb + s;
+      
+      //Each block is copied first, so the references are the original values and the differences vectorize
+      for(size_t b = 0; b < n; b += XRIF_PIXEL_BLOCK)
       {
-         int8_t * rboff = (int8_t*) handle->raw_buffer + n * npix * handle->depth + kk*npix;
+         size_t m = (n - b < XRIF_PIXEL_BLOCK) ? n - b : XRIF_PIXEL_BLOCK;
          
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0) 
-         {
-         #endif
-   
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-
-         for(size_t nn = 0; nn < npix-1; ++nn)
-         {
-            rboff[npix - nn - 1] -= rboff[npix - nn - 2];
-         }   
+         int8_t ref[XRIF_PIXEL_BLOCK];
+         memcpy(ref, pix + b, m*sizeof(int8_t));
          
-         #ifndef XRIF_NO_OMP
+         pix[b] = ref[0] - prev;
+         
+         for(size_t i = 1; i < m; ++i)
+         {
+            pix[b+i] = ref[i] - ref[i-1];
          }
-         #endif
+         
+         prev = ref[m-1];
       }
-   }  
+      
+      s += n;
+   }
+}
+
+xrif_error_t xrif_difference_pixel_sint8( xrif_t handle )
+{
+   size_t ppix = handle->width*handle->height;
+   size_t npix = ppix*handle->depth*handle->frames;
+   
+   int8_t * rb = (int8_t *) handle->raw_buffer;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, npix))
+   {
+   #endif
+   
+   size_t s, e;
+   xrif_pixel_range(&s, &e, npix);
+   
+   //The reference for the first pixel of the range is the last pixel of the range before, so it is read before any thread changes it.
+   int8_t prev = (s < e && s % ppix != 0) ? rb[s-1] : 0;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   xrif_difference_pixel_sint8_range(rb, s, e, ppix, prev);
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
    return XRIF_NOERROR;
    
 } //xrif_difference_pixel_sint8
 
-xrif_error_t xrif_difference_pixel_sint16( xrif_t handle )
+//Difference the pixels s to e-1 of the cube in place.  prev is the original value of pixel s-1, unused if s starts an image.
+static void xrif_difference_pixel_sint16_range( int16_t * rb,
+                                                size_t s,
+                                                size_t e,
+                                                size_t ppix,
+                                                int16_t prev
+                                              )
 {
-   size_t npix = handle->width*handle->height;
-   
-   for(size_t n=0; n < handle->frames; ++n)
+   while(s < e)
    {
-      for(size_t kk=0; kk< handle->depth; ++kk)
+      size_t j = s % ppix;
+      size_t n = (e - s < ppix - j) ? e - s : ppix - j;
+      
+      //The first pixel of each image is its own reference
+      if(j == 0) prev = 0;
+      
+      int16_t * pix = rb + s;
+      
+      //Each block is copied first, so the references are the original values and the differences vectorize
+      for(size_t b = 0; b < n; b += XRIF_PIXEL_BLOCK)
       {
-         int16_t * rboff = (int16_t*) handle->raw_buffer + n * npix * handle->depth + kk*npix;
+         size_t m = (n - b < XRIF_PIXEL_BLOCK) ? n - b : XRIF_PIXEL_BLOCK;
          
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0) 
-         {
-         #endif
-   
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-
-         for(size_t nn = 0; nn < npix-1; ++nn)
-         {
-            rboff[npix - nn - 1] -= rboff[npix - nn - 2];
-         }   
+         int16_t ref[XRIF_PIXEL_BLOCK];
+         memcpy(ref, pix + b, m*sizeof(int16_t));
          
-         #ifndef XRIF_NO_OMP
+         pix[b] = ref[0] - prev;
+         
+         for(size_t i = 1; i < m; ++i)
+         {
+            pix[b+i] = ref[i] - ref[i-1];
          }
-         #endif
+         
+         prev = ref[m-1];
       }
-   }  
+      
+      s += n;
+   }
+}
+
+xrif_error_t xrif_difference_pixel_sint16( xrif_t handle )
+{
+   size_t ppix = handle->width*handle->height;
+   size_t npix = ppix*handle->depth*handle->frames;
+   
+   int16_t * rb = (int16_t *) handle->raw_buffer;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, npix))
+   {
+   #endif
+   
+   size_t s, e;
+   xrif_pixel_range(&s, &e, npix);
+   
+   //The reference for the first pixel of the range is the last pixel of the range before, so it is read before any thread changes it.
+   int16_t prev = (s < e && s % ppix != 0) ? rb[s-1] : 0;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   xrif_difference_pixel_sint16_range(rb, s, e, ppix, prev);
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
    return XRIF_NOERROR;
    
 } //xrif_difference_pixel_sint16
 
-xrif_error_t xrif_difference_pixel_sint32( xrif_t handle )
+//Difference the pixels s to e-1 of the cube in place.  prev is the original value of pixel s-1, unused if s starts an image.
+static void xrif_difference_pixel_sint32_range( int32_t * rb,
+                                                size_t s,
+                                                size_t e,
+                                                size_t ppix,
+                                                int32_t prev
+                                              )
 {
-   size_t npix = handle->width*handle->height;
-   
-   for(size_t n=0; n < handle->frames; ++n)
+   while(s < e)
    {
-      for(size_t kk=0; kk< handle->depth; ++kk)
+      size_t j = s % ppix;
+      size_t n = (e - s < ppix - j) ? e - s : ppix - j;
+      
+      //The first pixel of each image is its own reference
+      if(j == 0) prev = 0;
+      
+      int32_t * pix = rb + s;
+      
+      //Each block is copied first, so the references are the original values and the differences vectorize
+      for(size_t b = 0; b < n; b += XRIF_PIXEL_BLOCK)
       {
-         int32_t * rboff = (int32_t*) handle->raw_buffer + n * npix * handle->depth + kk*npix;
+         size_t m = (n - b < XRIF_PIXEL_BLOCK) ? n - b : XRIF_PIXEL_BLOCK;
          
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0) 
-         {
-         #endif
-   
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-
-         for(size_t nn = 0; nn < npix-1; ++nn)
-         {
-            rboff[npix - nn - 1] -= rboff[npix - nn - 2];
-         }   
+         int32_t ref[XRIF_PIXEL_BLOCK];
+         memcpy(ref, pix + b, m*sizeof(int32_t));
          
-         #ifndef XRIF_NO_OMP
+         pix[b] = ref[0] - prev;
+         
+         for(size_t i = 1; i < m; ++i)
+         {
+            pix[b+i] = ref[i] - ref[i-1];
          }
-         #endif
+         
+         prev = ref[m-1];
       }
-   }  
+      
+      s += n;
+   }
+}
+
+xrif_error_t xrif_difference_pixel_sint32( xrif_t handle )
+{
+   size_t ppix = handle->width*handle->height;
+   size_t npix = ppix*handle->depth*handle->frames;
+   
+   int32_t * rb = (int32_t *) handle->raw_buffer;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, npix))
+   {
+   #endif
+   
+   size_t s, e;
+   xrif_pixel_range(&s, &e, npix);
+   
+   //The reference for the first pixel of the range is the last pixel of the range before, so it is read before any thread changes it.
+   int32_t prev = (s < e && s % ppix != 0) ? rb[s-1] : 0;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   xrif_difference_pixel_sint32_range(rb, s, e, ppix, prev);
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
    return XRIF_NOERROR;
    
 } //xrif_difference_pixel_sint32
 
-xrif_error_t xrif_difference_pixel_sint64( xrif_t handle )
+//Difference the pixels s to e-1 of the cube in place.  prev is the original value of pixel s-1, unused if s starts an image.
+static void xrif_difference_pixel_sint64_range( int64_t * rb,
+                                                size_t s,
+                                                size_t e,
+                                                size_t ppix,
+                                                int64_t prev
+                                              )
 {
-   size_t npix = handle->width*handle->height;
-   
-   for(size_t n=0; n < handle->frames; ++n)
+   while(s < e)
    {
-      for(size_t kk=0; kk< handle->depth; ++kk)
+      size_t j = s % ppix;
+      size_t n = (e - s < ppix - j) ? e - s : ppix - j;
+      
+      //The first pixel of each image is its own reference
+      if(j == 0) prev = 0;
+      
+      int64_t * pix = rb + s;
+      
+      //Each block is copied first, so the references are the original values and the differences vectorize
+      for(size_t b = 0; b < n; b += XRIF_PIXEL_BLOCK)
       {
-         int64_t * rboff = (int64_t*) handle->raw_buffer + n * npix * handle->depth + kk*npix;
+         size_t m = (n - b < XRIF_PIXEL_BLOCK) ? n - b : XRIF_PIXEL_BLOCK;
          
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0) 
-         {
-         #endif
-   
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-
-         for(size_t nn = 0; nn < npix-1; ++nn)
-         {
-            rboff[npix - nn - 1] -= rboff[npix - nn - 2];
-         }   
+         int64_t ref[XRIF_PIXEL_BLOCK];
+         memcpy(ref, pix + b, m*sizeof(int64_t));
+         
+         pix[b] = ref[0] - prev;
          
-         #ifndef XRIF_NO_OMP
+         for(size_t i = 1; i < m; ++i)
+         {
+            pix[b+i] = ref[i] - ref[i-1];
          }
-         #endif
+         
+         prev = ref[m-1];
       }
-   }  
+      
+      s += n;
+   }
+}
+
+xrif_error_t xrif_difference_pixel_sint64( xrif_t handle )
+{
+   size_t ppix = handle->width*handle->height;
+   size_t npix = ppix*handle->depth*handle->frames;
+   
+   int64_t * rb = (int64_t *) handle->raw_buffer;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, npix))
+   {
+   #endif
+   
+   size_t s, e;
+   xrif_pixel_range(&s, &e, npix);
+   
+   //The reference for the first pixel of the range is the last pixel of the range before, so it is read before any thread changes it.
+   int64_t prev = (s < e && s % ppix != 0) ? rb[s-1] : 0;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   xrif_difference_pixel_sint64_range(rb, s, e, ppix, prev);
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
    return XRIF_NOERROR;
    
 } //xrif_difference_pixel_sint64
 
-
 //Dispatch differencing w.r.t. previous according to type
 xrif_error_t xrif_difference_pixel( xrif_t handle )
 {
@@ -271,144 +458,580 @@ xrif_error_t xrif_difference_pixel( xrif_t handle )
 // undifferencing
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
+/* Undifferencing is a running sum.  The vector kernels sum each register in log2(lanes) shift-and-add steps, 
+ * add the running total broadcast to all lanes, and then broadcast the last lane as the total for the next register.
+ */
+
+static void xrif_undifference_pixel_sint8_scalar( int8_t * pix,
+                                                  size_t npix,
+                                                  int8_t prev
+                                                )
+{
+   for(size_t i = 0; i < npix; ++i)
+   {
+      prev = prev + pix[i];
+      pix[i] = prev;
+   }
+}
+
+static void xrif_undifference_pixel_sint16_scalar( int16_t * pix,
+                                                   size_t npix,
+                                                   int16_t prev
+                                                 )
+{
+   for(size_t i = 0; i < npix; ++i)
+   {
+      prev = prev + pix[i];
+      pix[i] = prev;
+   }
+}
+
+static void xrif_undifference_pixel_sint32_scalar( int32_t * pix,
+                                                   size_t npix,
+                                                   int32_t prev
+                                                 )
+{
+   for(size_t i = 0; i < npix; ++i)
+   {
+      prev = prev + pix[i];
+      pix[i] = prev;
+   }
+}
+
+static void xrif_undifference_pixel_sint64_scalar( int64_t * pix,
+                                                   size_t npix,
+                                                   int64_t prev
+                                                 )
+{
+   for(size_t i = 0; i < npix; ++i)
+   {
+      prev = prev + pix[i];
+      pix[i] = prev;
+   }
+}
+
+#ifdef XRIF_SIMD_X86
+
+__attribute__((target("sse2")))
+static size_t xrif_undifference_pixel_sint8_sse2( int8_t * pix,
+                                                  size_t npix,
+                                                  int8_t * prev
+                                                )
+{
+   __m128i c = _mm_set1_epi8(*prev);
+   
+   size_t i = 0;
+   for(; i + 16 <= npix; i += 16)
+   {
+      __m128i x = _mm_loadu_si128( (const __m128i *) (pix + i));
+      
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+      x = _mm_add_epi8(x, c);
+      
+      _mm_storeu_si128( (__m128i *) (pix + i), x);
+      
+      c = _mm_shuffle_epi32( _mm_shufflehi_epi16( _mm_unpackhi_epi8(x, x), 0xFF), 0xFF);
+   }
+   
+   if(i > 0) *prev = pix[i-1];
+   
+   return i;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_undifference_pixel_sint16_sse2( int16_t * pix,
+                                                   size_t npix,
+                                                   int16_t * prev
+                                                 )
+{
+   __m128i c = _mm_set1_epi16(*prev);
+   
+   size_t i = 0;
+   for(; i + 8 <= npix; i += 8)
+   {
+      __m128i x = _mm_loadu_si128( (const __m128i *) (pix + i));
+      
+      x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+      x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+      x = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+      x = _mm_add_epi16(x, c);
+      
+      _mm_storeu_si128( (__m128i *) (pix + i), x);
+      
+      c = _mm_shuffle_epi32( _mm_shufflehi_epi16(x, 0xFF), 0xFF);
+   }
+   
+   if(i > 0) *prev = pix[i-1];
+   
+   return i;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_undifference_pixel_sint32_sse2( int32_t * pix,
+                                                   size_t npix,
+                                                   int32_t * prev
+                                                 )
+{
+   __m128i c = _mm_set1_epi32(*prev);
+   
+   size_t i = 0;
+   for(; i + 4 <= npix; i += 4)
+   {
+      __m128i x = _mm_loadu_si128( (const __m128i *) (pix + i));
+      
+      x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+      x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+      x = _mm_add_epi32(x, c);
+      
+      _mm_storeu_si128( (__m128i *) (pix + i), x);
+      
+      c = _mm_shuffle_epi32(x, 0xFF);
+   }
+   
+   if(i > 0) *prev = pix[i-1];
+   
+   return i;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_undifference_pixel_sint64_sse2( int64_t * pix,
+                                                   size_t npix,
+                                                   int64_t * prev
+                                                 )
+{
+   __m128i c = _mm_set1_epi64x(*prev);
+   
+   size_t i = 0;
+   for(; i + 2 <= npix; i += 2)
+   {
+      __m128i x = _mm_loadu_si128( (const __m128i *) (pix + i));
+      
+      x = _mm_add_epi64(x, _mm_slli_si128(x, 8));
+      x = _mm_add_epi64(x, c);
+      
+      _mm_storeu_si128( (__m128i *) (pix + i), x);
+      
+      c = _mm_shuffle_epi32(x, 0xEE);
+   }
+   
+   if(i > 0) *prev = pix[i-1];
+   
+   return i;
+}
+
+#endif //XRIF_SIMD_X86
+
+void xrif_undifference_pixel_sint8_kernel( int8_t * pix,
+                                           size_t npix,
+                                           int8_t prev,
+                                           int simd
+                                         )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_undifference_pixel_sint8_sse2(pix, npix, &prev);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_undifference_pixel_sint8_scalar(pix + done, npix - done, prev);
+}
+
+void xrif_undifference_pixel_sint16_kernel( int16_t * pix,
+                                            size_t npix,
+                                            int16_t prev,
+                                            int simd
+                                          )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_undifference_pixel_sint16_sse2(pix, npix, &prev);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_undifference_pixel_sint16_scalar(pix + done, npix - done, prev);
+}
+
+void xrif_undifference_pixel_sint32_kernel( int32_t * pix,
+                                            size_t npix,
+                                            int32_t prev,
+                                            int simd
+                                          )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_undifference_pixel_sint32_sse2(pix, npix, &prev);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_undifference_pixel_sint32_scalar(pix + done, npix - done, prev);
+}
+
+void xrif_undifference_pixel_sint64_kernel( int64_t * pix,
+                                            size_t npix,
+                                            int64_t prev,
+                                            int simd
+                                          )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_undifference_pixel_sint64_sse2(pix, npix, &prev);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_undifference_pixel_sint64_scalar(pix + done, npix - done, prev);
+}
 
 xrif_error_t xrif_undifference_pixel_sint8( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
-               
-   for(int n=0; n < handle->frames; ++n)
+   size_t ppix = handle->width*handle->height;
+   size_t npix = ppix*handle->depth*handle->frames;
+   
+   int8_t * rb = (int8_t *) handle->raw_buffer;
+   
+   int simd = xrif_simd_level();
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, npix))
    {
-      for(int kk=0; kk< handle->depth; ++kk)
+   #endif
+   
+   size_t s, e;
+   xrif_pixel_range(&s, &e, npix);
+   
+   //First each range is summed on its own, starting over at the first pixel of each image
+   size_t q = s;
+   while(q < e)
+   {
+      size_t j = q % ppix;
+      size_t n = (e - q < ppix - j) ? e - q : ppix - j;
+      
+      xrif_undifference_pixel_sint8_kernel(rb + q, n, 0, simd);
+      
+      q += n;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   //If the range does not start an image it still needs the sums of the ranges before it in the same image, 
+   //which are the last pixels of those ranges.
+   size_t img = s - s % ppix;
+   int8_t carry = 0;
+   
+   if(s < e && s > img)
+   {
+      size_t t = 0;
+      size_t nt = 1;
+      #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+      t = omp_get_thread_num();
+      nt = omp_get_num_threads();
+      #endif
+      
+      for(size_t u = t; u > 0; --u)
       {
-         int8_t * rboff = (int8_t*)handle->raw_buffer + n * npix * handle->depth + kk*npix;
+         size_t us = npix*(u-1)/nt;
+         size_t ue = npix*u/nt;
          
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0) 
-         {
-         #endif
-   
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int nn = 1; nn < npix; ++nn)
-         {
-            rboff[nn] += rboff[nn-1] ;
-         }    
+         if(ue > us) carry = carry + rb[ue-1];
          
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         if(us <= img) break;
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   if(carry != 0)
+   {
+      size_t fe = (e < img + ppix) ? e : img + ppix;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp simd
+      #endif
+      for(size_t i = s; i < fe; ++i)
+      {
+         rb[i] = rb[i] + carry;
       }
    }
    
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
    return XRIF_NOERROR;
    
 }//xrif_undifference_pixel_sint8
 
 xrif_error_t xrif_undifference_pixel_sint16( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
-               
-   for(int n=0; n < handle->frames; ++n)
+   size_t ppix = handle->width*handle->height;
+   size_t npix = ppix*handle->depth*handle->frames;
+   
+   int16_t * rb = (int16_t *) handle->raw_buffer;
+   
+   int simd = xrif_simd_level();
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, npix))
+   {
+   #endif
+   
+   size_t s, e;
+   xrif_pixel_range(&s, &e, npix);
+   
+   //First each range is summed on its own, starting over at the first pixel of each image
+   size_t q = s;
+   while(q < e)
+   {
+      size_t j = q % ppix;
+      size_t n = (e - q < ppix - j) ? e - q : ppix - j;
+      
+      xrif_undifference_pixel_sint16_kernel(rb + q, n, 0, simd);
+      
+      q += n;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   //If the range does not start an image it still needs the sums of the ranges before it in the same image, 
+   //which are the last pixels of those ranges.
+   size_t img = s - s % ppix;
+   int16_t carry = 0;
+   
+   if(s < e && s > img)
    {
-      for(int kk=0; kk< handle->depth; ++kk)
+      size_t t = 0;
+      size_t nt = 1;
+      #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+      t = omp_get_thread_num();
+      nt = omp_get_num_threads();
+      #endif
+      
+      for(size_t u = t; u > 0; --u)
       {
-         int16_t * rboff = (int16_t*)handle->raw_buffer + n * npix * handle->depth + kk*npix;
+         size_t us = npix*(u-1)/nt;
+         size_t ue = npix*u/nt;
          
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0) 
-         {
-         #endif
-   
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int nn = 1; nn < npix; ++nn)
-         {
-            rboff[nn] += rboff[nn-1] ;
-         }    
+         if(ue > us) carry = carry + rb[ue-1];
          
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         if(us <= img) break;
       }
    }
    
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   if(carry != 0)
+   {
+      size_t fe = (e < img + ppix) ? e : img + ppix;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp simd
+      #endif
+      for(size_t i = s; i < fe; ++i)
+      {
+         rb[i] = rb[i] + carry;
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
    return XRIF_NOERROR;
    
 }//xrif_undifference_pixel_sint16
 
 xrif_error_t xrif_undifference_pixel_sint32( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
-               
-   for(int n=0; n < handle->frames; ++n)
+   size_t ppix = handle->width*handle->height;
+   size_t npix = ppix*handle->depth*handle->frames;
+   
+   int32_t * rb = (int32_t *) handle->raw_buffer;
+   
+   int simd = xrif_simd_level();
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, npix))
+   {
+   #endif
+   
+   size_t s, e;
+   xrif_pixel_range(&s, &e, npix);
+   
+   //First each range is summed on its own, starting over at the first pixel of each image
+   size_t q = s;
+   while(q < e)
    {
-      for(int kk=0; kk< handle->depth; ++kk)
+      size_t j = q % ppix;
+      size_t n = (e - q < ppix - j) ? e - q : ppix - j;
+      
+      xrif_undifference_pixel_sint32_kernel(rb + q, n, 0, simd);
+      
+      q += n;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   //If the range does not start an image it still needs the sums of the ranges before it in the same image, 
+   //which are the last pixels of those ranges.
+   size_t img = s - s % ppix;
+   int32_t carry = 0;
+   
+   if(s < e && s > img)
+   {
+      size_t t = 0;
+      size_t nt = 1;
+      #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+      t = omp_get_thread_num();
+      nt = omp_get_num_threads();
+      #endif
+      
+      for(size_t u = t; u > 0; --u)
       {
-         int32_t * rboff = (int32_t*)handle->raw_buffer + n * npix * handle->depth + kk*npix;
+         size_t us = npix*(u-1)/nt;
+         size_t ue = npix*u/nt;
          
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0) 
-         {
-         #endif
-   
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int nn = 1; nn < npix; ++nn)
-         {
-            rboff[nn] += rboff[nn-1] ;
-         }    
+         if(ue > us) carry = carry + rb[ue-1];
          
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         if(us <= img) break;
       }
    }
    
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   if(carry != 0)
+   {
+      size_t fe = (e < img + ppix) ? e : img + ppix;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp simd
+      #endif
+      for(size_t i = s; i < fe; ++i)
+      {
+         rb[i] = rb[i] + carry;
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
    return XRIF_NOERROR;
    
-} //xrif_undifference_pixel_sint32
+}//xrif_undifference_pixel_sint32
 
 xrif_error_t xrif_undifference_pixel_sint64( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
-               
-   for(int n=0; n < handle->frames; ++n)
+   size_t ppix = handle->width*handle->height;
+   size_t npix = ppix*handle->depth*handle->frames;
+   
+   int64_t * rb = (int64_t *) handle->raw_buffer;
+   
+   int simd = xrif_simd_level();
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, npix))
+   {
+   #endif
+   
+   size_t s, e;
+   xrif_pixel_range(&s, &e, npix);
+   
+   //First each range is summed on its own, starting over at the first pixel of each image
+   size_t q = s;
+   while(q < e)
    {
-      for(int kk=0; kk< handle->depth; ++kk)
+      size_t j = q % ppix;
+      size_t n = (e - q < ppix - j) ? e - q : ppix - j;
+      
+      xrif_undifference_pixel_sint64_kernel(rb + q, n, 0, simd);
+      
+      q += n;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   //If the range does not start an image it still needs the sums of the ranges before it in the same image, 
+   //which are the last pixels of those ranges.
+   size_t img = s - s % ppix;
+   int64_t carry = 0;
+   
+   if(s < e && s > img)
+   {
+      size_t t = 0;
+      size_t nt = 1;
+      #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+      t = omp_get_thread_num();
+      nt = omp_get_num_threads();
+      #endif
+      
+      for(size_t u = t; u > 0; --u)
       {
-         int64_t * rboff = (int64_t*)handle->raw_buffer + n * npix * handle->depth + kk*npix;
+         size_t us = npix*(u-1)/nt;
+         size_t ue = npix*u/nt;
          
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0) 
-         {
-         #endif
-   
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int nn = 1; nn < npix; ++nn)
-         {
-            rboff[nn] += rboff[nn-1] ;
-         }    
+         if(ue > us) carry = carry + rb[ue-1];
          
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         if(us <= img) break;
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   if(carry != 0)
+   {
+      size_t fe = (e < img + ppix) ? e : img + ppix;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp simd
+      #endif
+      for(size_t i = s; i < fe; ++i)
+      {
+         rb[i] = rb[i] + carry;
       }
    }
    
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
    return XRIF_NOERROR;
    
 }//xrif_undifference_pixel_sint64
 
-
 //Dispatch undifferencing w.r.t. previous according to type
 xrif_error_t xrif_undifference_pixel( xrif_t handle )
 {
@@ -90,128 +90,162 @@ matter of this Agreement.
 
 xrif_error_t xrif_difference_previous_sint16( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int16_t * rb = (int16_t *) handle->raw_buffer;
    
-   for(int n=0; n < handle->frames-1; ++n)
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
    {
-      size_t n_stride0 = (handle->frames - 2 - n) * npix*handle->depth;
-      size_t n_stride =  (handle->frames - 1 - n) * npix*handle->depth;
-
-      for(int kk=0; kk< handle->depth; ++kk)
+   #endif
+   
+   //Going backwards, each frame is differenced while the frame before it is still unchanged.  The static schedule gives each thread the same
+   //pixels in every frame, so a thread only depends on its own earlier iterations and no barrier is needed between frames.
+   for(size_t n = nframes-1; n > 0; --n)
+   {
+      //Key frames are not differenced
+      if(n % sframes == 0) continue;
+      
+      int16_t * restrict rb0 = rb + (n-1)*fpix;
+      int16_t * restrict rb1 = rb + n*fpix;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < fpix; ++qq)
       {
-         size_t kk_stride = kk*npix;
-
-         int16_t * rb0 = &rb[n_stride0 + kk_stride];
-         int16_t * rb1 = &rb[n_stride + kk_stride];
-         
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
-         #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-
-         for(int qq=0; qq < npix; ++qq)
-         {
-            rb1[qq] = (rb1[qq] - rb0[qq]);
-         }
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         rb1[qq] = rb1[qq] - rb0[qq];
       }
-   } 
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
    return XRIF_NOERROR;
 } //xrif_difference_previous_sint16
 
 xrif_error_t xrif_difference_previous_sint32( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int32_t * rb = (int32_t *) handle->raw_buffer;
    
-   for(int n=0; n < handle->frames-1; ++n)
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
    {
-      size_t n_stride0 = (handle->frames - 2 - n) * npix*handle->depth;
-      size_t n_stride =  (handle->frames - 1 - n) * npix*handle->depth;
-
-      for(int kk=0; kk< handle->depth; ++kk)
-      {
-         size_t kk_stride = kk*npix;
+   #endif
    
-         int32_t * rb0 = &rb[n_stride0 + kk_stride];
-         int32_t * rb1 = &rb[n_stride + kk_stride];
-         
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
-         #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int qq=0; qq < npix; ++qq)
-         {
-            rb1[qq] = (rb1[qq] - rb0[qq]);
-         } 
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+   //Going backwards, each frame is differenced while the frame before it is still unchanged.  The static schedule gives each thread the same
+   //pixels in every frame, so a thread only depends on its own earlier iterations and no barrier is needed between frames.
+   for(size_t n = nframes-1; n > 0; --n)
+   {
+      //Key frames are not differenced
+      if(n % sframes == 0) continue;
+      
+      int32_t * restrict rb0 = rb + (n-1)*fpix;
+      int32_t * restrict rb1 = rb + n*fpix;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < fpix; ++qq)
+      {
+         rb1[qq] = rb1[qq] - rb0[qq];
       }
-   } 
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
    return XRIF_NOERROR;
 } //xrif_difference_previous_sint32
 
 xrif_error_t xrif_difference_previous_sint64( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int64_t * rb = (int64_t *) handle->raw_buffer;
    
-   for(int n=0; n < handle->frames-1; ++n)
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
    {
-      size_t n_stride0 = (handle->frames - 2 - n) * npix*handle->depth;
-      size_t n_stride =  (handle->frames - 1 - n) * npix*handle->depth;
-
-      for(int kk=0; kk< handle->depth; ++kk)
+   #endif
+   
+   //Going backwards, each frame is differenced while the frame before it is still unchanged.  The static schedule gives each thread the same
+   //pixels in every frame, so a thread only depends on its own earlier iterations and no barrier is needed between frames.
+   for(size_t n = nframes-1; n > 0; --n)
+   {
+      //Key frames are not differenced
+      if(n % sframes == 0) continue;
+      
+      int64_t * restrict rb0 = rb + (n-1)*fpix;
+      int64_t * restrict rb1 = rb + n*fpix;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < fpix; ++qq)
       {
-         size_t kk_stride = kk*npix;
-         
-         int64_t * rb0 = &rb[n_stride0 + kk_stride];
-         int64_t * rb1 = &rb[n_stride + kk_stride];
-         
-         #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
-         #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int qq=0; qq< npix;++qq)
-         {
-            rb1[qq] = (rb1[qq] - rb0[qq]);
-         }
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
+         rb1[qq] = rb1[qq] - rb0[qq];
       }
-   } 
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
    
    return XRIF_NOERROR;
 } //xrif_difference_previous_sint64
 
 
+//Floating point types are differenced by XOR with the previous frame, which zeroes the sign, exponent, and leading mantissa bits that did not change.
+xrif_error_t xrif_difference_previous_xor( xrif_t handle )
+{
+   size_t nbytes = handle->width*handle->height*handle->depth*handle->data_size;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   unsigned char * rb = (unsigned char *) handle->raw_buffer;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, handle->width*handle->height*handle->depth*nframes))
+   {
+   #endif
+   
+   //Going backwards, each frame is differenced while the frame before it is still unchanged.  The static schedule gives each thread the same
+   //pixels in every frame, so a thread only depends on its own earlier iterations and no barrier is needed between frames.
+   for(size_t n = nframes-1; n > 0; --n)
+   {
+      //Key frames are not differenced
+      if(n % sframes == 0) continue;
+      
+      unsigned char * restrict rb0 = rb + (n-1)*nbytes;
+      unsigned char * restrict rb1 = rb + n*nbytes;
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp for simd schedule(static) nowait
+      #endif
+      for(size_t qq = 0; qq < nbytes; ++qq)
+      {
+         rb1[qq] ^= rb0[qq];
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+} //xrif_difference_previous_xor
+
 //Dispatch differencing w.r.t. previous according to type
 xrif_error_t xrif_difference_previous( xrif_t handle )
 {
@@ -245,6 +279,10 @@ xrif_error_t xrif_difference_previous( xrif_t handle )
    {
       return xrif_difference_previous_sint64(handle);
    }
+   else if(xrif_typeisfloat(handle->type_code))
+   {
+      return xrif_difference_previous_xor(handle);
+   }
    else
    {
       XRIF_ERROR_PRINT("xrif_difference_previous", "previous differencing not implemented for type");
@@ -258,127 +296,208 @@ xrif_error_t xrif_difference_previous( xrif_t handle )
 
 xrif_error_t xrif_undifference_previous_sint16( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int16_t * rb = (int16_t *) handle->raw_buffer;
    
-   for(int n=1; n < handle->frames; ++n)
+   size_t bpix = XRIF_UNDIFFERENCE_BLOCK / sizeof(int16_t);
+   size_t nblocks = (fpix + bpix - 1) / bpix;
+   size_t nsegs = (nframes + sframes - 1) / sframes;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t sb = 0; sb < nsegs*nblocks; ++sb)
    {
-      size_t n_stride0 = (n-1) * npix*handle->depth;
-      size_t n_stride =  n * npix*handle->depth;
+      size_t seg = sb / nblocks;
+      size_t pix = (sb % nblocks)*bpix;
+      size_t np = (pix + bpix <= fpix) ? bpix : fpix - pix;
+      
+      size_t n0 = seg*sframes;
+      size_t n1 = (n0 + sframes < nframes) ? n0 + sframes : nframes;
       
-      for(int kk=0; kk<handle->depth; ++kk)
+      //Each pixel's time series is independent, and restarts at each key frame, so the segments between key frames are
+      //restored in parallel along with the blocks.  A block of pixels is walked through all the frames of its segment while
+      //the restored values of the frame before are still in cache.
+      for(size_t n = n0+1; n < n1; ++n)
       {
-         size_t kk_stride = kk*npix;
-         
-         int16_t * rb0 = &rb[n_stride0 + kk_stride];
-         int16_t * rb1 = &rb[n_stride + kk_stride];
+         int16_t * restrict rb0 = rb + (n-1)*fpix + pix;
+         int16_t * restrict rb1 = rb + n*fpix + pix;
          
          #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
+         #pragma omp simd
          #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int qq=0; qq< handle->width*handle->height; ++qq)
+         for(size_t qq = 0; qq < np; ++qq)
          {
             rb1[qq] = rb1[qq] + rb0[qq];
          }
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
       }
    }
    
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
    return XRIF_NOERROR;
 }//xrif_undifference_previous_sint16
 
 xrif_error_t xrif_undifference_previous_sint32( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int32_t * rb = (int32_t *) handle->raw_buffer;
    
-   for(int n=1; n < handle->frames; ++n)
+   size_t bpix = XRIF_UNDIFFERENCE_BLOCK / sizeof(int32_t);
+   size_t nblocks = (fpix + bpix - 1) / bpix;
+   size_t nsegs = (nframes + sframes - 1) / sframes;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t sb = 0; sb < nsegs*nblocks; ++sb)
    {
-      size_t n_stride0 = (n-1) * npix*handle->depth;
-      size_t n_stride =  n * npix*handle->depth;
+      size_t seg = sb / nblocks;
+      size_t pix = (sb % nblocks)*bpix;
+      size_t np = (pix + bpix <= fpix) ? bpix : fpix - pix;
       
-      for(int kk=0; kk<handle->depth; ++kk)
+      size_t n0 = seg*sframes;
+      size_t n1 = (n0 + sframes < nframes) ? n0 + sframes : nframes;
+      
+      //Each pixel's time series is independent, and restarts at each key frame, so the segments between key frames are
+      //restored in parallel along with the blocks.  A block of pixels is walked through all the frames of its segment while
+      //the restored values of the frame before are still in cache.
+      for(size_t n = n0+1; n < n1; ++n)
       {
-         size_t kk_stride = kk*npix;
-         
-         int32_t * rb0 = &rb[n_stride0 + kk_stride];
-         int32_t * rb1 = &rb[n_stride + kk_stride];
+         int32_t * restrict rb0 = rb + (n-1)*fpix + pix;
+         int32_t * restrict rb1 = rb + n*fpix + pix;
          
          #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
+         #pragma omp simd
          #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
-         #endif
-            
-         for(int qq=0; qq< handle->width*handle->height; ++qq)
+         for(size_t qq = 0; qq < np; ++qq)
          {
             rb1[qq] = rb1[qq] + rb0[qq];
          }
-         
-         #ifndef XRIF_NO_OMP
-         }
-         #endif
       }
    }
    
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
    return XRIF_NOERROR;
-} //xrif_undifference_previous_sint32
+}//xrif_undifference_previous_sint32
 
 xrif_error_t xrif_undifference_previous_sint64( xrif_t handle )
 {
-   size_t npix = handle->width*handle->height;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
    
    int64_t * rb = (int64_t *) handle->raw_buffer;
    
-   for(int n=1; n < handle->frames; ++n)
+   size_t bpix = XRIF_UNDIFFERENCE_BLOCK / sizeof(int64_t);
+   size_t nblocks = (fpix + bpix - 1) / bpix;
+   size_t nsegs = (nframes + sframes - 1) / sframes;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, fpix*nframes))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t sb = 0; sb < nsegs*nblocks; ++sb)
    {
-      size_t n_stride0 = (n-1) * npix*handle->depth;
-      size_t n_stride =  n * npix*handle->depth;
+      size_t seg = sb / nblocks;
+      size_t pix = (sb % nblocks)*bpix;
+      size_t np = (pix + bpix <= fpix) ? bpix : fpix - pix;
       
-      for(int kk=0; kk<handle->depth; ++kk)
+      size_t n0 = seg*sframes;
+      size_t n1 = (n0 + sframes < nframes) ? n0 + sframes : nframes;
+      
+      //Each pixel's time series is independent, and restarts at each key frame, so the segments between key frames are
+      //restored in parallel along with the blocks.  A block of pixels is walked through all the frames of its segment while
+      //the restored values of the frame before are still in cache.
+      for(size_t n = n0+1; n < n1; ++n)
       {
-         size_t kk_stride = kk*npix;
-         
-         int64_t * rb0 = &rb[n_stride0 + kk_stride];
-         int64_t * rb1 = &rb[n_stride + kk_stride];
+         int64_t * restrict rb0 = rb + (n-1)*fpix + pix;
+         int64_t * restrict rb1 = rb + n*fpix + pix;
          
          #ifndef XRIF_NO_OMP
-         #pragma omp parallel if (handle->omp_parallel > 0)
-         {
-         #endif
-
-         #ifndef XRIF_NO_OMP
-         #pragma omp for
+         #pragma omp simd
          #endif
-            
-         for(int qq=0; qq< npix; ++qq)
+         for(size_t qq = 0; qq < np; ++qq)
          {
             rb1[qq] = rb1[qq] + rb0[qq];
          }
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+}//xrif_undifference_previous_sint64
+
+
+xrif_error_t xrif_undifference_previous_xor( xrif_t handle )
+{
+   size_t fpix = handle->width*handle->height*handle->depth*handle->data_size;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   unsigned char * rb = (unsigned char *) handle->raw_buffer;
+   
+   size_t bpix = XRIF_UNDIFFERENCE_BLOCK / sizeof(unsigned char);
+   size_t nblocks = (fpix + bpix - 1) / bpix;
+   size_t nsegs = (nframes + sframes - 1) / sframes;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, handle->width*handle->height*handle->depth*nframes))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t sb = 0; sb < nsegs*nblocks; ++sb)
+   {
+      size_t seg = sb / nblocks;
+      size_t pix = (sb % nblocks)*bpix;
+      size_t np = (pix + bpix <= fpix) ? bpix : fpix - pix;
+      
+      size_t n0 = seg*sframes;
+      size_t n1 = (n0 + sframes < nframes) ? n0 + sframes : nframes;
+      
+      //Each pixel's time series is independent, and restarts at each key frame, so the segments between key frames are
+      //restored in parallel along with the blocks.  A block of pixels is walked through all the frames of its segment while
+      //the restored values of the frame before are still in cache.
+      for(size_t n = n0+1; n < n1; ++n)
+      {
+         unsigned char * restrict rb0 = rb + (n-1)*fpix + pix;
+         unsigned char * restrict rb1 = rb + n*fpix + pix;
          
          #ifndef XRIF_NO_OMP
-         }
+         #pragma omp simd
          #endif
+         for(size_t qq = 0; qq < np; ++qq)
+         {
+            rb1[qq] ^= rb0[qq];
+         }
       }
    }
    
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
    return XRIF_NOERROR;
-}//xrif_undifference_previous_sint64
-
+}//xrif_undifference_previous_xor
 
 //Dispatch undifferencing w.r.t. previous according to type
 xrif_error_t xrif_undifference_previous( xrif_t handle )
@@ -413,6 +532,10 @@ xrif_error_t xrif_undifference_previous( xrif_t handle )
    {
       return xrif_undifference_previous_sint64(handle);
    }
+   else if(xrif_typeisfloat(handle->type_code))
+   {
+      return xrif_undifference_previous_xor(handle);
+   }
    else
    {
       XRIF_ERROR_PRINT("xrif_difference_previous", "previous undifferencing not implemented for type");
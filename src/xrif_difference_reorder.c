@@ -0,0 +1,448 @@
+/** \file xrif_difference_reorder.c
+  * \brief Implementation of fused xrif differencing and reordering
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+
+#include "xrif.h"
+
+/* The fused stage computes the residuals of one reordering chunk at a time into a small per-thread buffer, and reorders them from there
+ * while they are still in cache.  The raw buffer is read once and is not modified.  Residual index r counts pixels from the start of 
+ * the raw buffer, so the reference pixel can be found for any chunk.  The tiled pipeline in xrif_tiles.c uses the same residuals.
+ */
+
+void xrif_residual_sint16( int16_t * res,
+                          xrif_t handle,
+                          int method,
+                          size_t r,
+                          size_t n
+                        )
+{
+   const int16_t * rb = (const int16_t *) handle->raw_buffer;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t i = 0;
+   
+   //The first frame of a chained cube is differenced against the last frame of the previous cube, otherwise it is its own residual
+   if(method != XRIF_DIFFERENCE_PIXEL)
+   {
+      if(handle->chained)
+      {
+         const int16_t * ref = (const int16_t *) handle->chain_buffer;
+         for(; i < n && r + i < fpix; ++i) res[i] = rb[r+i] - ref[r+i];
+      }
+      else
+      {
+         for(; i < n && r + i < fpix; ++i) res[i] = rb[r+i];
+      }
+   }
+   
+   if(method == XRIF_DIFFERENCE_PREVIOUS)
+   {
+      for(; i < n; ++i) res[i] = rb[r+i] - rb[r+i-fpix];
+   }
+   else if(method == XRIF_DIFFERENCE_FIRST)
+   {
+      while(i < n)
+      {
+         size_t j = (r+i) % fpix;
+         size_t e = (n - i < fpix - j) ? n : i + fpix - j;
+         
+         for(; i < e; ++i, ++j) res[i] = rb[r+i] - rb[j];
+      }
+   }
+   else //XRIF_DIFFERENCE_PIXEL
+   {
+      size_t ppix = handle->width*handle->height;
+      
+      while(i < n)
+      {
+         size_t j = (r+i) % ppix;
+         size_t e = (n - i < ppix - j) ? n : i + ppix - j;
+         
+         //The first pixel of each image is its own reference
+         if(j == 0) 
+         {
+            res[i] = rb[r+i];
+            ++i;
+         }
+         
+         for(; i < e; ++i) res[i] = rb[r+i] - rb[r+i-1];
+      }
+   }
+}
+
+void xrif_residual_sint32( int32_t * res,
+                          xrif_t handle,
+                          int method,
+                          size_t r,
+                          size_t n
+                        )
+{
+   const int32_t * rb = (const int32_t *) handle->raw_buffer;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t i = 0;
+   
+   if(method != XRIF_DIFFERENCE_PIXEL)
+   {
+      if(handle->chained)
+      {
+         const int32_t * ref = (const int32_t *) handle->chain_buffer;
+         for(; i < n && r + i < fpix; ++i) res[i] = rb[r+i] - ref[r+i];
+      }
+      else
+      {
+         for(; i < n && r + i < fpix; ++i) res[i] = rb[r+i];
+      }
+   }
+   
+   if(method == XRIF_DIFFERENCE_PREVIOUS)
+   {
+      for(; i < n; ++i) res[i] = rb[r+i] - rb[r+i-fpix];
+   }
+   else if(method == XRIF_DIFFERENCE_FIRST)
+   {
+      while(i < n)
+      {
+         size_t j = (r+i) % fpix;
+         size_t e = (n - i < fpix - j) ? n : i + fpix - j;
+         
+         for(; i < e; ++i, ++j) res[i] = rb[r+i] - rb[j];
+      }
+   }
+   else //XRIF_DIFFERENCE_PIXEL
+   {
+      size_t ppix = handle->width*handle->height;
+      
+      while(i < n)
+      {
+         size_t j = (r+i) % ppix;
+         size_t e = (n - i < ppix - j) ? n : i + ppix - j;
+         
+         if(j == 0) 
+         {
+            res[i] = rb[r+i];
+            ++i;
+         }
+         
+         for(; i < e; ++i) res[i] = rb[r+i] - rb[r+i-1];
+      }
+   }
+}
+
+void xrif_residual_sint64( int64_t * res,
+                          xrif_t handle,
+                          int method,
+                          size_t r,
+                          size_t n
+                        )
+{
+   const int64_t * rb = (const int64_t *) handle->raw_buffer;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t i = 0;
+   
+   if(method != XRIF_DIFFERENCE_PIXEL)
+   {
+      if(handle->chained)
+      {
+         const int64_t * ref = (const int64_t *) handle->chain_buffer;
+         for(; i < n && r + i < fpix; ++i) res[i] = rb[r+i] - ref[r+i];
+      }
+      else
+      {
+         for(; i < n && r + i < fpix; ++i) res[i] = rb[r+i];
+      }
+   }
+   
+   if(method == XRIF_DIFFERENCE_PREVIOUS)
+   {
+      for(; i < n; ++i) res[i] = rb[r+i] - rb[r+i-fpix];
+   }
+   else if(method == XRIF_DIFFERENCE_FIRST)
+   {
+      while(i < n)
+      {
+         size_t j = (r+i) % fpix;
+         size_t e = (n - i < fpix - j) ? n : i + fpix - j;
+         
+         for(; i < e; ++i, ++j) res[i] = rb[r+i] - rb[j];
+      }
+   }
+   else //XRIF_DIFFERENCE_PIXEL
+   {
+      size_t ppix = handle->width*handle->height;
+      
+      while(i < n)
+      {
+         size_t j = (r+i) % ppix;
+         size_t e = (n - i < ppix - j) ? n : i + ppix - j;
+         
+         if(j == 0) 
+         {
+            res[i] = rb[r+i];
+            ++i;
+         }
+         
+         for(; i < e; ++i) res[i] = rb[r+i] - rb[r+i-1];
+      }
+   }
+}
+
+int xrif_difference_reorder_supported( xrif_t handle )
+{
+   if(handle == NULL) return 0;
+   
+   int method = handle->difference_method;
+   if(method == 0) method = XRIF_DIFFERENCE_DEFAULT;
+   
+   int reorder = handle->reorder_method;
+   if(reorder == 0) reorder = XRIF_REORDER_DEFAULT;
+   
+   if(method != XRIF_DIFFERENCE_PREVIOUS && method != XRIF_DIFFERENCE_FIRST && method != XRIF_DIFFERENCE_PIXEL) return 0;
+   
+   //The fused kernels difference every frame but the first
+   if(xrif_has_keyframe_interval(handle)) return 0;
+   
+   switch(handle->type_code)
+   {
+      case XRIF_TYPECODE_INT16:
+      case XRIF_TYPECODE_UINT16:
+         return (reorder == XRIF_REORDER_BYTEPACK || reorder == XRIF_REORDER_BYTEPACK_RENIBBLE);
+      case XRIF_TYPECODE_INT32:
+      case XRIF_TYPECODE_UINT32:
+      case XRIF_TYPECODE_INT64:
+      case XRIF_TYPECODE_UINT64:
+         return (reorder == XRIF_REORDER_BYTEPACK);
+      default:
+         return 0;
+   }
+}
+
+xrif_error_t xrif_difference_reorder( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_difference_reorder", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(!xrif_difference_reorder_supported(handle))
+   {
+      XRIF_ERROR_PRINT("xrif_difference_reorder", "fused differencing and reordering not implemented for this configuration");
+      return XRIF_ERROR_NOTIMPL;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->reordered_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_reorder", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+   
+   int method = handle->difference_method;
+   if(method == 0) method = XRIF_DIFFERENCE_DEFAULT;
+   
+   int reorder = handle->reorder_method;
+   if(reorder == 0) reorder = XRIF_REORDER_DEFAULT;
+   
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t one_frame = fpix*handle->data_size; //bytes
+   
+   if( handle->raw_buffer_size < one_frame*handle->frames )
+   {
+      XRIF_ERROR_PRINT("xrif_difference_reorder", "raw buffer is too small");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   size_t min_reordered = (reorder == XRIF_REORDER_BYTEPACK_RENIBBLE) ? one_frame*(handle->frames+1) : one_frame*handle->frames;
+   
+   if( handle->reordered_buffer_size < min_reordered )
+   {
+      XRIF_ERROR_PRINT("xrif_difference_reorder", "reordered buffer is too small");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   //Set up chaining as xrif_difference does.  The raw buffer is not modified, so the last frame is saved afterwards.
+   if(handle->chain_cubes)
+   {
+      xrif_error_t rv = xrif_allocate_chain(handle);
+      if(rv != XRIF_NOERROR)
+      {
+         XRIF_ERROR_PRINT("xrif_difference_reorder", "error from xrif_allocate_chain");
+         return rv;
+      }
+   }
+   
+   handle->chained = (handle->chain_cubes && handle->chain_encode_valid && (method == XRIF_DIFFERENCE_PREVIOUS || method == XRIF_DIFFERENCE_FIRST));
+   
+   //Index of the first reordered pixel in the raw buffer
+   size_t off = xrif_reorder_first_frame(handle) ? 0 : fpix;
+   size_t npix = fpix*handle->frames - off;
+   size_t halfoff = (npix + 1)/2;
+   
+   char * reordered_buffer = handle->reordered_buffer + off*handle->data_size;
+   
+   //Set the first part of the reordered buffer to the first frame (always the reference frame)
+   memcpy(handle->reordered_buffer, handle->raw_buffer, off*handle->data_size);
+   
+   if(reorder == XRIF_REORDER_BYTEPACK_RENIBBLE)
+   {
+      //Zero the unused end so that compression sees the same bytes every time
+      size_t used = off*handle->data_size + npix + 2*halfoff;
+      memset(handle->reordered_buffer + used, 0, min_reordered - used);
+   }
+   
+   int simd = xrif_simd_level();
+   size_t nchunks = (npix + XRIF_REORDER_CHUNK - 1) / XRIF_REORDER_CHUNK;
+   int nomem = 0;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #endif
+   
+   char * res = (char *) malloc(XRIF_REORDER_CHUNK*handle->data_size);
+   
+   if(res == NULL)
+   {
+      #ifndef XRIF_NO_OMP
+      #pragma omp atomic write
+      #endif
+      nomem = 1;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp for
+   #endif
+   for(size_t c = 0; c < nchunks; ++c)
+   {
+      if(res == NULL) continue;
+      
+      size_t pix = c*XRIF_REORDER_CHUNK;
+      size_t n = (pix + XRIF_REORDER_CHUNK <= npix) ? XRIF_REORDER_CHUNK : npix - pix;
+      
+      if(handle->data_size == 2)
+      {
+         xrif_residual_sint16( (int16_t *) res, handle, method, off + pix, n);
+         
+         if(reorder == XRIF_REORDER_BYTEPACK_RENIBBLE)
+         {
+            char * nibbles = reordered_buffer + npix;
+            xrif_reorder_bytepack_renibble_sint16_kernel( reordered_buffer + pix, nibbles + pix/2, nibbles + halfoff + pix/2, res, n, simd);
+         }
+         else
+         {
+            xrif_reorder_bytepack_sint16_kernel( reordered_buffer + pix, reordered_buffer + npix + pix, res, n, simd);
+         }
+      }
+      else if(handle->data_size == 4)
+      {
+         xrif_residual_sint32( (int32_t *) res, handle, method, off + pix, n);
+         xrif_reorder_bytepack_sint32_kernel( reordered_buffer + pix, npix, res, n, simd);
+      }
+      else
+      {
+         xrif_residual_sint64( (int64_t *) res, handle, method, off + pix, n);
+         xrif_reorder_bytepack_sint64_kernel( reordered_buffer + pix, npix, res, n, simd);
+      }
+   }
+   
+   free(res);
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   if(nomem)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_reorder", "error allocating residual buffer");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   //The last frame is the reference for the next cube
+   if(handle->chain_cubes)
+   {
+      memcpy(handle->chain_buffer, handle->raw_buffer + (handle->frames-1)*one_frame, one_frame);
+   }
+   
+   return XRIF_NOERROR;
+}
@@ -0,0 +1,1248 @@
+/** \file xrif_difference_spatial.c
+  * \brief Implementation of xrif 2D spatial predictor differencing
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include "xrif.h"
+
+#if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+#include <omp.h>
+#endif
+
+/* Each pixel is predicted from its neighbours to the left (a), above (b), and above-left (c).  The first row of each image is 
+ * predicted from the left only, and the first pixel of every other row from above only.  The predictors are written without 
+ * branches so the encoding loops vectorize.
+ */
+
+//Median edge detector (LOCO-I): the smaller of a and b above an edge, the larger below it, and the plane a + b - c otherwise
+static inline int16_t xrif_predict_med_sint16( int16_t a,
+                                               int16_t b,
+                                               int16_t c
+                                             )
+{
+   //The median of a, b, and a + b - c, which is a + b - c clamped to the range of a and b
+   int32_t mx = (a > b) ? a : b;
+   int32_t mn = (a > b) ? b : a;
+   int32_t p = (int32_t) a + b - c;
+   
+   p = (p > mx) ? mx : p;
+   
+   return (p < mn) ? mn : p;
+}
+
+//Paeth: whichever of a, b, and c is closest to a + b - c
+static inline int16_t xrif_predict_paeth_sint16( int16_t a,
+                                                 int16_t b,
+                                                 int16_t c
+                                               )
+{
+   int32_t pa = (int32_t) b - c;
+   int32_t pb = (int32_t) a - c;
+   int32_t pc = pa + pb;
+   
+   pa = (pa < 0) ? -pa : pa;
+   pb = (pb < 0) ? -pb : pb;
+   pc = (pc < 0) ? -pc : pc;
+   
+   int usea = (pa <= pb) & (pa <= pc);
+   
+   return usea ? a : ((pb <= pc) ? b : c);
+}
+
+//Average of a and b, rounded down, without overflow
+static inline int16_t xrif_predict_average_sint16( int16_t a,
+                                                   int16_t b
+                                                 )
+{
+   return (a >> 1) + (b >> 1) + (a & b & 1);
+}
+
+//Median edge detector (LOCO-I): the smaller of a and b above an edge, the larger below it, and the plane a + b - c otherwise
+static inline int32_t xrif_predict_med_sint32( int32_t a,
+                                               int32_t b,
+                                               int32_t c
+                                             )
+{
+   //The median of a, b, and a + b - c, which is a + b - c clamped to the range of a and b
+   int64_t mx = (a > b) ? a : b;
+   int64_t mn = (a > b) ? b : a;
+   int64_t p = (int64_t) a + b - c;
+   
+   p = (p > mx) ? mx : p;
+   
+   return (p < mn) ? mn : p;
+}
+
+//Paeth: whichever of a, b, and c is closest to a + b - c
+static inline int32_t xrif_predict_paeth_sint32( int32_t a,
+                                                 int32_t b,
+                                                 int32_t c
+                                               )
+{
+   int64_t pa = (int64_t) b - c;
+   int64_t pb = (int64_t) a - c;
+   int64_t pc = pa + pb;
+   
+   pa = (pa < 0) ? -pa : pa;
+   pb = (pb < 0) ? -pb : pb;
+   pc = (pc < 0) ? -pc : pc;
+   
+   int usea = (pa <= pb) & (pa <= pc);
+   
+   return usea ? a : ((pb <= pc) ? b : c);
+}
+
+//Average of a and b, rounded down, without overflow
+static inline int32_t xrif_predict_average_sint32( int32_t a,
+                                                   int32_t b
+                                                 )
+{
+   return (a >> 1) + (b >> 1) + (a & b & 1);
+}
+
+//Median edge detector (LOCO-I): the smaller of a and b above an edge, the larger below it, and the plane a + b - c otherwise
+static inline int64_t xrif_predict_med_sint64( int64_t a,
+                                               int64_t b,
+                                               int64_t c
+                                             )
+{
+   int64_t mx = (a > b) ? a : b;
+   int64_t mn = (a > b) ? b : a;
+   
+   return (c >= mx) ? mn : ((c <= mn) ? mx : (int64_t) ((uint64_t) a + (uint64_t) b - (uint64_t) c));
+}
+
+//Paeth: whichever of a, b, and c is closest to a + b - c
+static inline int64_t xrif_predict_paeth_sint64( int64_t a,
+                                                 int64_t b,
+                                                 int64_t c
+                                               )
+{
+   //The distances are computed modulo 2^64, which is only approximate for very large values but the same when decoding
+   uint64_t pa = (uint64_t) b - (uint64_t) c;
+   uint64_t pb = (uint64_t) a - (uint64_t) c;
+   uint64_t pc = pa + pb;
+   
+   pa = ((int64_t) pa < 0) ? -pa : pa;
+   pb = ((int64_t) pb < 0) ? -pb : pb;
+   pc = ((int64_t) pc < 0) ? -pc : pc;
+   
+   int usea = (pa <= pb) & (pa <= pc);
+   
+   return usea ? a : ((pb <= pc) ? b : c);
+}
+
+//Average of a and b, rounded down, without overflow
+static inline int64_t xrif_predict_average_sint64( int64_t a,
+                                                   int64_t b
+                                                 )
+{
+   return (a >> 1) + (b >> 1) + (a & b & 1);
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// int16_t
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//Residuals of one row.  cur is the original row, and up is the original row above it or NULL for the first row of an image.
+static void xrif_difference_spatial_sint16_row( int16_t * restrict res,
+                                                const int16_t * restrict cur,
+                                                const int16_t * restrict up,
+                                                size_t w,
+                                                int method
+                                              )
+{
+   if(up == NULL)
+   {
+      res[0] = cur[0];
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - cur[x-1];
+      return;
+   }
+   
+   res[0] = cur[0] - up[0];
+   
+   if(method == XRIF_DIFFERENCE_MED)
+   {
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - xrif_predict_med_sint16(cur[x-1], up[x], up[x-1]);
+   }
+   else if(method == XRIF_DIFFERENCE_PAETH)
+   {
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - xrif_predict_paeth_sint16(cur[x-1], up[x], up[x-1]);
+   }
+   else //XRIF_DIFFERENCE_AVERAGE
+   {
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - xrif_predict_average_sint16(cur[x-1], up[x]);
+   }
+}
+
+//Restore one row in place from the restored row above it.  Each prediction needs the pixel just restored to its left.
+static void xrif_undifference_spatial_sint16_row( int16_t * restrict row,
+                                                  const int16_t * restrict up,
+                                                  size_t w,
+                                                  int method
+                                                )
+{
+   int16_t a = row[0] + up[0];
+   row[0] = a;
+   
+   if(method == XRIF_DIFFERENCE_MED)
+   {
+      for(size_t x = 1; x < w; ++x)
+      {
+         a = row[x] + xrif_predict_med_sint16(a, up[x], up[x-1]);
+         row[x] = a;
+      }
+   }
+   else if(method == XRIF_DIFFERENCE_PAETH)
+   {
+      for(size_t x = 1; x < w; ++x)
+      {
+         a = row[x] + xrif_predict_paeth_sint16(a, up[x], up[x-1]);
+         row[x] = a;
+      }
+   }
+   else //XRIF_DIFFERENCE_AVERAGE
+   {
+      for(size_t x = 1; x < w; ++x)
+      {
+         a = row[x] + xrif_predict_average_sint16(a, up[x]);
+         row[x] = a;
+      }
+   }
+}
+
+xrif_error_t xrif_difference_spatial_sint16( xrif_t handle )
+{
+   size_t w = handle->width;
+   size_t h = handle->height;
+   size_t nrows = h*handle->depth*handle->frames;
+   int method = handle->difference_method;
+   
+   int16_t * rb = (int16_t *) handle->raw_buffer;
+   
+   int nthreads = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   if(xrif_use_omp(handle, w*nrows)) nthreads = omp_get_max_threads();
+   #endif
+   
+   //Each thread keeps a copy of the original row above and of the row being differenced
+   int16_t * rows = (int16_t *) malloc(2*w*nthreads*sizeof(int16_t));
+   if(rows == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_spatial_sint16", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (nthreads > 1) num_threads(nthreads)
+   {
+   #endif
+   
+   size_t t = 0;
+   size_t nt = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   t = omp_get_thread_num();
+   nt = omp_get_num_threads();
+   #endif
+   
+   //The rows of the whole cube are split into one contiguous range per thread
+   size_t s = nrows*t/nt;
+   size_t e = nrows*(t+1)/nt;
+   
+   int16_t * up = rows + 2*w*t;
+   int16_t * cur = up + w;
+   
+   //The row above the first row of the range belongs to the range before, so it is copied before any thread changes it.
+   if(s < e && s % h != 0) memcpy(up, rb + (s-1)*w, w*sizeof(int16_t));
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   for(size_t r = s; r < e; ++r)
+   {
+      int16_t * row = rb + r*w;
+      
+      memcpy(cur, row, w*sizeof(int16_t));
+      
+      xrif_difference_spatial_sint16_row(row, cur, (r % h == 0) ? NULL : up, w, method);
+      
+      int16_t * tmp = up;
+      up = cur;
+      cur = tmp;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   free(rows);
+   
+   return XRIF_NOERROR;
+   
+} //xrif_difference_spatial_sint16
+
+xrif_error_t xrif_undifference_spatial_sint16( xrif_t handle )
+{
+   size_t w = handle->width;
+   size_t h = handle->height;
+   size_t nimages = handle->depth*handle->frames;
+   
+   //The spatial pass of the previous frame + MED method is the same as MED
+   int method = (handle->difference_method == XRIF_DIFFERENCE_PREVIOUS_MED) ? XRIF_DIFFERENCE_MED : handle->difference_method;
+   
+   int16_t * rb = (int16_t *) handle->raw_buffer;
+   
+   int simd = xrif_simd_level();
+   
+   //Restoring a row needs the restored pixel to its left, so the images are distributed over threads rather than the rows.
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, w*h*nimages))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t k = 0; k < nimages; ++k)
+   {
+      int16_t * img = rb + k*w*h;
+      
+      //The first row is a running sum
+      xrif_undifference_pixel_sint16_kernel(img, w, 0, simd);
+      
+      for(size_t y = 1; y < h; ++y)
+      {
+         xrif_undifference_spatial_sint16_row(img + y*w, img + (y-1)*w, w, method);
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+   
+} //xrif_undifference_spatial_sint16
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// int32_t
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//Residuals of one row.  cur is the original row, and up is the original row above it or NULL for the first row of an image.
+static void xrif_difference_spatial_sint32_row( int32_t * restrict res,
+                                                const int32_t * restrict cur,
+                                                const int32_t * restrict up,
+                                                size_t w,
+                                                int method
+                                              )
+{
+   if(up == NULL)
+   {
+      res[0] = cur[0];
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - cur[x-1];
+      return;
+   }
+   
+   res[0] = cur[0] - up[0];
+   
+   if(method == XRIF_DIFFERENCE_MED)
+   {
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - xrif_predict_med_sint32(cur[x-1], up[x], up[x-1]);
+   }
+   else if(method == XRIF_DIFFERENCE_PAETH)
+   {
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - xrif_predict_paeth_sint32(cur[x-1], up[x], up[x-1]);
+   }
+   else //XRIF_DIFFERENCE_AVERAGE
+   {
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - xrif_predict_average_sint32(cur[x-1], up[x]);
+   }
+}
+
+//Restore one row in place from the restored row above it.  Each prediction needs the pixel just restored to its left.
+static void xrif_undifference_spatial_sint32_row( int32_t * restrict row,
+                                                  const int32_t * restrict up,
+                                                  size_t w,
+                                                  int method
+                                                )
+{
+   int32_t a = row[0] + up[0];
+   row[0] = a;
+   
+   if(method == XRIF_DIFFERENCE_MED)
+   {
+      for(size_t x = 1; x < w; ++x)
+      {
+         a = row[x] + xrif_predict_med_sint32(a, up[x], up[x-1]);
+         row[x] = a;
+      }
+   }
+   else if(method == XRIF_DIFFERENCE_PAETH)
+   {
+      for(size_t x = 1; x < w; ++x)
+      {
+         a = row[x] + xrif_predict_paeth_sint32(a, up[x], up[x-1]);
+         row[x] = a;
+      }
+   }
+   else //XRIF_DIFFERENCE_AVERAGE
+   {
+      for(size_t x = 1; x < w; ++x)
+      {
+         a = row[x] + xrif_predict_average_sint32(a, up[x]);
+         row[x] = a;
+      }
+   }
+}
+
+xrif_error_t xrif_difference_spatial_sint32( xrif_t handle )
+{
+   size_t w = handle->width;
+   size_t h = handle->height;
+   size_t nrows = h*handle->depth*handle->frames;
+   int method = handle->difference_method;
+   
+   int32_t * rb = (int32_t *) handle->raw_buffer;
+   
+   int nthreads = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   if(xrif_use_omp(handle, w*nrows)) nthreads = omp_get_max_threads();
+   #endif
+   
+   //Each thread keeps a copy of the original row above and of the row being differenced
+   int32_t * rows = (int32_t *) malloc(2*w*nthreads*sizeof(int32_t));
+   if(rows == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_spatial_sint32", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (nthreads > 1) num_threads(nthreads)
+   {
+   #endif
+   
+   size_t t = 0;
+   size_t nt = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   t = omp_get_thread_num();
+   nt = omp_get_num_threads();
+   #endif
+   
+   //The rows of the whole cube are split into one contiguous range per thread
+   size_t s = nrows*t/nt;
+   size_t e = nrows*(t+1)/nt;
+   
+   int32_t * up = rows + 2*w*t;
+   int32_t * cur = up + w;
+   
+   //The row above the first row of the range belongs to the range before, so it is copied before any thread changes it.
+   if(s < e && s % h != 0) memcpy(up, rb + (s-1)*w, w*sizeof(int32_t));
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   for(size_t r = s; r < e; ++r)
+   {
+      int32_t * row = rb + r*w;
+      
+      memcpy(cur, row, w*sizeof(int32_t));
+      
+      xrif_difference_spatial_sint32_row(row, cur, (r % h == 0) ? NULL : up, w, method);
+      
+      int32_t * tmp = up;
+      up = cur;
+      cur = tmp;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   free(rows);
+   
+   return XRIF_NOERROR;
+   
+} //xrif_difference_spatial_sint32
+
+xrif_error_t xrif_undifference_spatial_sint32( xrif_t handle )
+{
+   size_t w = handle->width;
+   size_t h = handle->height;
+   size_t nimages = handle->depth*handle->frames;
+   
+   //The spatial pass of the previous frame + MED method is the same as MED
+   int method = (handle->difference_method == XRIF_DIFFERENCE_PREVIOUS_MED) ? XRIF_DIFFERENCE_MED : handle->difference_method;
+   
+   int32_t * rb = (int32_t *) handle->raw_buffer;
+   
+   int simd = xrif_simd_level();
+   
+   //Restoring a row needs the restored pixel to its left, so the images are distributed over threads rather than the rows.
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, w*h*nimages))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t k = 0; k < nimages; ++k)
+   {
+      int32_t * img = rb + k*w*h;
+      
+      //The first row is a running sum
+      xrif_undifference_pixel_sint32_kernel(img, w, 0, simd);
+      
+      for(size_t y = 1; y < h; ++y)
+      {
+         xrif_undifference_spatial_sint32_row(img + y*w, img + (y-1)*w, w, method);
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+   
+} //xrif_undifference_spatial_sint32
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// int64_t
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//Residuals of one row.  cur is the original row, and up is the original row above it or NULL for the first row of an image.
+static void xrif_difference_spatial_sint64_row( int64_t * restrict res,
+                                                const int64_t * restrict cur,
+                                                const int64_t * restrict up,
+                                                size_t w,
+                                                int method
+                                              )
+{
+   if(up == NULL)
+   {
+      res[0] = cur[0];
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - cur[x-1];
+      return;
+   }
+   
+   res[0] = cur[0] - up[0];
+   
+   if(method == XRIF_DIFFERENCE_MED)
+   {
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - xrif_predict_med_sint64(cur[x-1], up[x], up[x-1]);
+   }
+   else if(method == XRIF_DIFFERENCE_PAETH)
+   {
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - xrif_predict_paeth_sint64(cur[x-1], up[x], up[x-1]);
+   }
+   else //XRIF_DIFFERENCE_AVERAGE
+   {
+      for(size_t x = 1; x < w; ++x) res[x] = cur[x] - xrif_predict_average_sint64(cur[x-1], up[x]);
+   }
+}
+
+//Restore one row in place from the restored row above it.  Each prediction needs the pixel just restored to its left.
+static void xrif_undifference_spatial_sint64_row( int64_t * restrict row,
+                                                  const int64_t * restrict up,
+                                                  size_t w,
+                                                  int method
+                                                )
+{
+   int64_t a = row[0] + up[0];
+   row[0] = a;
+   
+   if(method == XRIF_DIFFERENCE_MED)
+   {
+      for(size_t x = 1; x < w; ++x)
+      {
+         a = row[x] + xrif_predict_med_sint64(a, up[x], up[x-1]);
+         row[x] = a;
+      }
+   }
+   else if(method == XRIF_DIFFERENCE_PAETH)
+   {
+      for(size_t x = 1; x < w; ++x)
+      {
+         a = row[x] + xrif_predict_paeth_sint64(a, up[x], up[x-1]);
+         row[x] = a;
+      }
+   }
+   else //XRIF_DIFFERENCE_AVERAGE
+   {
+      for(size_t x = 1; x < w; ++x)
+      {
+         a = row[x] + xrif_predict_average_sint64(a, up[x]);
+         row[x] = a;
+      }
+   }
+}
+
+xrif_error_t xrif_difference_spatial_sint64( xrif_t handle )
+{
+   size_t w = handle->width;
+   size_t h = handle->height;
+   size_t nrows = h*handle->depth*handle->frames;
+   int method = handle->difference_method;
+   
+   int64_t * rb = (int64_t *) handle->raw_buffer;
+   
+   int nthreads = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   if(xrif_use_omp(handle, w*nrows)) nthreads = omp_get_max_threads();
+   #endif
+   
+   //Each thread keeps a copy of the original row above and of the row being differenced
+   int64_t * rows = (int64_t *) malloc(2*w*nthreads*sizeof(int64_t));
+   if(rows == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_spatial_sint64", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (nthreads > 1) num_threads(nthreads)
+   {
+   #endif
+   
+   size_t t = 0;
+   size_t nt = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   t = omp_get_thread_num();
+   nt = omp_get_num_threads();
+   #endif
+   
+   //The rows of the whole cube are split into one contiguous range per thread
+   size_t s = nrows*t/nt;
+   size_t e = nrows*(t+1)/nt;
+   
+   int64_t * up = rows + 2*w*t;
+   int64_t * cur = up + w;
+   
+   //The row above the first row of the range belongs to the range before, so it is copied before any thread changes it.
+   if(s < e && s % h != 0) memcpy(up, rb + (s-1)*w, w*sizeof(int64_t));
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp barrier
+   #endif
+   
+   for(size_t r = s; r < e; ++r)
+   {
+      int64_t * row = rb + r*w;
+      
+      memcpy(cur, row, w*sizeof(int64_t));
+      
+      xrif_difference_spatial_sint64_row(row, cur, (r % h == 0) ? NULL : up, w, method);
+      
+      int64_t * tmp = up;
+      up = cur;
+      cur = tmp;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   free(rows);
+   
+   return XRIF_NOERROR;
+   
+} //xrif_difference_spatial_sint64
+
+xrif_error_t xrif_undifference_spatial_sint64( xrif_t handle )
+{
+   size_t w = handle->width;
+   size_t h = handle->height;
+   size_t nimages = handle->depth*handle->frames;
+   
+   //The spatial pass of the previous frame + MED method is the same as MED
+   int method = (handle->difference_method == XRIF_DIFFERENCE_PREVIOUS_MED) ? XRIF_DIFFERENCE_MED : handle->difference_method;
+   
+   int64_t * rb = (int64_t *) handle->raw_buffer;
+   
+   int simd = xrif_simd_level();
+   
+   //Restoring a row needs the restored pixel to its left, so the images are distributed over threads rather than the rows.
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (xrif_use_omp(handle, w*h*nimages))
+   {
+   #pragma omp for schedule(static)
+   #endif
+   for(size_t k = 0; k < nimages; ++k)
+   {
+      int64_t * img = rb + k*w*h;
+      
+      //The first row is a running sum
+      xrif_undifference_pixel_sint64_kernel(img, w, 0, simd);
+      
+      for(size_t y = 1; y < h; ++y)
+      {
+         xrif_undifference_spatial_sint64_row(img + y*w, img + (y-1)*w, w, method);
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   return XRIF_NOERROR;
+   
+} //xrif_undifference_spatial_sint64
+
+//Dispatch spatial differencing according to type
+xrif_error_t xrif_difference_spatial( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_difference_spatial", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_spatial", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+      
+   if(handle->raw_buffer_size < handle->width*handle->height*handle->depth*handle->frames*handle->data_size)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_spatial", "raw buffer size not sufficient");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( !xrif_difference_spatial_method(handle->difference_method) )
+   {
+      XRIF_ERROR_PRINT("xrif_difference_spatial", "difference method is not a spatial predictor");
+      return XRIF_ERROR_BADARG;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_difference_spatial_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   {
+      return xrif_difference_spatial_sint32(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_difference_spatial_sint64(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_difference_spatial", "spatial differencing not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+} //xrif_difference_spatial
+
+//Dispatch spatial undifferencing according to type
+xrif_error_t xrif_undifference_spatial( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_spatial", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_spatial", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+      
+   if(handle->raw_buffer_size < handle->width*handle->height*handle->depth*handle->frames*handle->data_size)
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_spatial", "raw buffer size not sufficient");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if( !xrif_difference_spatial_method(handle->difference_method) )
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_spatial", "difference method is not a spatial predictor");
+      return XRIF_ERROR_BADARG;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_undifference_spatial_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   {
+      return xrif_undifference_spatial_sint32(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_undifference_spatial_sint64(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_spatial", "spatial undifferencing not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+} //xrif_undifference_spatial
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// previous frame + MED
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//The temporal residual of one row.  prev is the same row of the previous frame, or NULL for the first frame.
+static void xrif_temporal_sint16_row( int16_t * restrict d,
+                                      const int16_t * restrict row,
+                                      const int16_t * restrict prev,
+                                      size_t w
+                                    )
+{
+   if(prev == NULL)
+   {
+      memcpy(d, row, w*sizeof(int16_t));
+      return;
+   }
+   
+   for(size_t x = 0; x < w; ++x) d[x] = row[x] - prev[x];
+}
+
+xrif_error_t xrif_difference_previous_med_sint16( xrif_t handle )
+{
+   size_t w = handle->width;
+   size_t h = handle->height;
+   size_t fpix = w*h*handle->depth;
+   size_t nrows = h*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   int16_t * rb = (int16_t *) handle->raw_buffer;
+   
+   int nthreads = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   if(xrif_use_omp(handle, fpix*nframes)) nthreads = omp_get_max_threads();
+   #endif
+   
+   //Each thread keeps the temporal residuals of the row above and of the row being differenced
+   int16_t * rows = (int16_t *) malloc(2*w*nthreads*sizeof(int16_t));
+   if(rows == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_previous_med_sint16", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (nthreads > 1) num_threads(nthreads)
+   {
+   #endif
+   
+   size_t t = 0;
+   size_t nt = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   t = omp_get_thread_num();
+   nt = omp_get_num_threads();
+   #endif
+   
+   //The rows of each frame are split into one contiguous range per thread
+   size_t s = nrows*t/nt;
+   size_t e = nrows*(t+1)/nt;
+   
+   int16_t * up = rows + 2*w*t;
+   int16_t * cur = up + w;
+   
+   //Going backwards, each frame is differenced while the frame before it is unchanged.
+   for(size_t n = nframes; n > 0; --n)
+   {
+      int16_t * frame = rb + (n-1)*fpix;
+      
+      //Key frames are only differenced spatially
+      const int16_t * prev = ((n-1) % sframes != 0) ? frame - fpix : NULL;
+      
+      //The row above the range belongs to the range before, so its residual is taken before any thread changes this frame.
+      //A thread can only reach this barrier once every thread is done reading this frame as the previous one.
+      if(s < e && s % h != 0) xrif_temporal_sint16_row(up, frame + (s-1)*w, prev ? prev + (s-1)*w : NULL, w);
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp barrier
+      #endif
+      
+      for(size_t r = s; r < e; ++r)
+      {
+         xrif_temporal_sint16_row(cur, frame + r*w, prev ? prev + r*w : NULL, w);
+         
+         xrif_difference_spatial_sint16_row(frame + r*w, cur, (r % h == 0) ? NULL : up, w, XRIF_DIFFERENCE_MED);
+         
+         int16_t * tmp = up;
+         up = cur;
+         cur = tmp;
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   free(rows);
+   
+   return XRIF_NOERROR;
+   
+} //xrif_difference_previous_med_sint16
+
+//The temporal residual of one row.  prev is the same row of the previous frame, or NULL for the first frame.
+static void xrif_temporal_sint32_row( int32_t * restrict d,
+                                      const int32_t * restrict row,
+                                      const int32_t * restrict prev,
+                                      size_t w
+                                    )
+{
+   if(prev == NULL)
+   {
+      memcpy(d, row, w*sizeof(int32_t));
+      return;
+   }
+   
+   for(size_t x = 0; x < w; ++x) d[x] = row[x] - prev[x];
+}
+
+xrif_error_t xrif_difference_previous_med_sint32( xrif_t handle )
+{
+   size_t w = handle->width;
+   size_t h = handle->height;
+   size_t fpix = w*h*handle->depth;
+   size_t nrows = h*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   int32_t * rb = (int32_t *) handle->raw_buffer;
+   
+   int nthreads = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   if(xrif_use_omp(handle, fpix*nframes)) nthreads = omp_get_max_threads();
+   #endif
+   
+   //Each thread keeps the temporal residuals of the row above and of the row being differenced
+   int32_t * rows = (int32_t *) malloc(2*w*nthreads*sizeof(int32_t));
+   if(rows == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_previous_med_sint32", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (nthreads > 1) num_threads(nthreads)
+   {
+   #endif
+   
+   size_t t = 0;
+   size_t nt = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   t = omp_get_thread_num();
+   nt = omp_get_num_threads();
+   #endif
+   
+   //The rows of each frame are split into one contiguous range per thread
+   size_t s = nrows*t/nt;
+   size_t e = nrows*(t+1)/nt;
+   
+   int32_t * up = rows + 2*w*t;
+   int32_t * cur = up + w;
+   
+   //Going backwards, each frame is differenced while the frame before it is unchanged.
+   for(size_t n = nframes; n > 0; --n)
+   {
+      int32_t * frame = rb + (n-1)*fpix;
+      
+      //Key frames are only differenced spatially
+      const int32_t * prev = ((n-1) % sframes != 0) ? frame - fpix : NULL;
+      
+      //The row above the range belongs to the range before, so its residual is taken before any thread changes this frame.
+      //A thread can only reach this barrier once every thread is done reading this frame as the previous one.
+      if(s < e && s % h != 0) xrif_temporal_sint32_row(up, frame + (s-1)*w, prev ? prev + (s-1)*w : NULL, w);
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp barrier
+      #endif
+      
+      for(size_t r = s; r < e; ++r)
+      {
+         xrif_temporal_sint32_row(cur, frame + r*w, prev ? prev + r*w : NULL, w);
+         
+         xrif_difference_spatial_sint32_row(frame + r*w, cur, (r % h == 0) ? NULL : up, w, XRIF_DIFFERENCE_MED);
+         
+         int32_t * tmp = up;
+         up = cur;
+         cur = tmp;
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   free(rows);
+   
+   return XRIF_NOERROR;
+   
+} //xrif_difference_previous_med_sint32
+
+//The temporal residual of one row.  prev is the same row of the previous frame, or NULL for the first frame.
+static void xrif_temporal_sint64_row( int64_t * restrict d,
+                                      const int64_t * restrict row,
+                                      const int64_t * restrict prev,
+                                      size_t w
+                                    )
+{
+   if(prev == NULL)
+   {
+      memcpy(d, row, w*sizeof(int64_t));
+      return;
+   }
+   
+   for(size_t x = 0; x < w; ++x) d[x] = row[x] - prev[x];
+}
+
+xrif_error_t xrif_difference_previous_med_sint64( xrif_t handle )
+{
+   size_t w = handle->width;
+   size_t h = handle->height;
+   size_t fpix = w*h*handle->depth;
+   size_t nrows = h*handle->depth;
+   size_t nframes = handle->frames;
+   size_t sframes = xrif_segment_frames(handle);
+   
+   int64_t * rb = (int64_t *) handle->raw_buffer;
+   
+   int nthreads = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   if(xrif_use_omp(handle, fpix*nframes)) nthreads = omp_get_max_threads();
+   #endif
+   
+   //Each thread keeps the temporal residuals of the row above and of the row being differenced
+   int64_t * rows = (int64_t *) malloc(2*w*nthreads*sizeof(int64_t));
+   if(rows == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_previous_med_sint64", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (nthreads > 1) num_threads(nthreads)
+   {
+   #endif
+   
+   size_t t = 0;
+   size_t nt = 1;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   t = omp_get_thread_num();
+   nt = omp_get_num_threads();
+   #endif
+   
+   //The rows of each frame are split into one contiguous range per thread
+   size_t s = nrows*t/nt;
+   size_t e = nrows*(t+1)/nt;
+   
+   int64_t * up = rows + 2*w*t;
+   int64_t * cur = up + w;
+   
+   //Going backwards, each frame is differenced while the frame before it is unchanged.
+   for(size_t n = nframes; n > 0; --n)
+   {
+      int64_t * frame = rb + (n-1)*fpix;
+      
+      //Key frames are only differenced spatially
+      const int64_t * prev = ((n-1) % sframes != 0) ? frame - fpix : NULL;
+      
+      //The row above the range belongs to the range before, so its residual is taken before any thread changes this frame.
+      //A thread can only reach this barrier once every thread is done reading this frame as the previous one.
+      if(s < e && s % h != 0) xrif_temporal_sint64_row(up, frame + (s-1)*w, prev ? prev + (s-1)*w : NULL, w);
+      
+      #ifndef XRIF_NO_OMP
+      #pragma omp barrier
+      #endif
+      
+      for(size_t r = s; r < e; ++r)
+      {
+         xrif_temporal_sint64_row(cur, frame + r*w, prev ? prev + r*w : NULL, w);
+         
+         xrif_difference_spatial_sint64_row(frame + r*w, cur, (r % h == 0) ? NULL : up, w, XRIF_DIFFERENCE_MED);
+         
+         int64_t * tmp = up;
+         up = cur;
+         cur = tmp;
+      }
+   }
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   free(rows);
+   
+   return XRIF_NOERROR;
+   
+} //xrif_difference_previous_med_sint64
+
+//Dispatch previous frame + MED differencing according to type
+xrif_error_t xrif_difference_previous_med( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_difference_previous_med", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_previous_med", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+      
+   if(handle->raw_buffer_size < handle->width*handle->height*handle->depth*handle->frames*handle->data_size)
+   {
+      XRIF_ERROR_PRINT("xrif_difference_previous_med", "raw buffer size not sufficient");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      return xrif_difference_previous_med_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   {
+      return xrif_difference_previous_med_sint32(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      return xrif_difference_previous_med_sint64(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_difference_previous_med", "previous frame + MED differencing not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+} //xrif_difference_previous_med
+
+//Dispatch previous frame + MED undifferencing according to type
+xrif_error_t xrif_undifference_previous_med( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_previous_med", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_previous_med", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+      
+   if(handle->raw_buffer_size < handle->width*handle->height*handle->depth*handle->frames*handle->data_size)
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_previous_med", "raw buffer size not sufficient");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   xrif_error_t rv;
+   
+   //First the temporal residuals of each image are restored, then the frames
+   if(handle->type_code == XRIF_TYPECODE_INT16 || handle->type_code == XRIF_TYPECODE_UINT16)
+   {
+      rv = xrif_undifference_spatial_sint16(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT32 || handle->type_code == XRIF_TYPECODE_UINT32)
+   {
+      rv = xrif_undifference_spatial_sint32(handle);
+   }
+   else if(handle->type_code == XRIF_TYPECODE_INT64 || handle->type_code == XRIF_TYPECODE_UINT64)
+   {
+      rv = xrif_undifference_spatial_sint64(handle);
+   }
+   else
+   {
+      XRIF_ERROR_PRINT("xrif_undifference_previous_med", "previous frame + MED undifferencing not implemented for type");
+      return XRIF_ERROR_NOTIMPL;
+   }
+   
+   if(rv != XRIF_NOERROR) return rv;
+   
+   return xrif_undifference_previous(handle);
+   
+} //xrif_undifference_previous_med
+
+int xrif_difference_spatial_method( int method )
+{
+   return (method == XRIF_DIFFERENCE_MED || method == XRIF_DIFFERENCE_PAETH || method == XRIF_DIFFERENCE_AVERAGE);
+}
@@ -1,6 +1,14 @@
+/** \file xrif_lz4_memory12.c
+  * \brief LZ4 compression with a 4 KB hash table
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
 /* This file is part of the xrif library.
 
-Copyright (c) 2019, 2020, The Arizona Board of Regents on behalf of The
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
 University of Arizona
 
 All rights reserved.
@@ -76,34 +84,6 @@ matter of this Agreement.
 
 */
 
-#include <stdio.h>
-
-
-int main()
-{
-   printf("static const unsigned short bit_to_position[] = \n");
-   printf("{\n");
-   
-   for(unsigned short c =0; c < 256; ++c)
-   {
-      printf("/*%d*/   ", c);
-      for(int p=0; p < 16; ++p)
-      {
-         for( int b=0; b<8; ++b)
-         {
-            if(!(b==0 && p==0)) printf(", ");
-            printf("0x%04x", (int) ( ((c >> b) & 1) << p ) );
-         }
-      }
-      
-      if(c < 255) printf(",\n");
-      else  printf("\n");
-      
-   }
-   
-   
-   
-   printf("};\n"); 
-
-}
+#define LZ4_MEMORY_USAGE 12
 
+#include "xrif_lz4_memory.inc"
@@ -1,6 +1,14 @@
+/** \file xrif_lz4_memory14.c
+  * \brief LZ4 compression with a 16 KB hash table
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
 /* This file is part of the xrif library.
 
-Copyright (c) 2019, 2020, The Arizona Board of Regents on behalf of The
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
 University of Arizona
 
 All rights reserved.
@@ -76,44 +84,6 @@ matter of this Agreement.
 
 */
 
-#include <stdio.h>
-
-
-int main()
-{
-   printf("static const unsigned char set_bits[] = \n");
-   printf("{\n");
-   
-   for(unsigned short c =0; c < 256; ++c)
-   {
-      int nbits = 0;
-      for(int b=0;b<8;++b) if( (c >> b) & 1) ++nbits;
-      
-      printf("/*%d*/   ", c);
-      printf("%d, ", nbits);
-      
-      for( int b=0; b<8; ++b)
-      {
-         if( (c >> b) & 1)
-         {
-            printf("%d", b);
-            if(b!=7 || nbits < 8) printf(", ");
-         }
-      }
-      for( int b=nbits; b<8; ++b)
-      {
-         printf("0");
-         if(b!=7) printf(", ");
-      }
-      
-      if(c < 255) printf(",\n");
-      else  printf("\n");
-      
-   }
-   
-   
-   
-   printf("};\n"); 
-
-}
+#define LZ4_MEMORY_USAGE 14
 
+#include "xrif_lz4_memory.inc"
@@ -1,6 +1,14 @@
+/** \file xrif_lz4_memory16.c
+  * \brief LZ4 compression with a 64 KB hash table
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
 /* This file is part of the xrif library.
 
-Copyright (c) 2019, 2020, The Arizona Board of Regents on behalf of The
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
 University of Arizona
 
 All rights reserved.
@@ -76,49 +84,6 @@ matter of this Agreement.
 
 */
 
-#include <stdio.h>
-
-int main()
-{
-   printf("static const unsigned char bitshift_and_nibbles[] = \n");
-   printf("{\n");
-   
-   for(unsigned int i =0; i < 65536; ++i)
-   {
-      for(int pix = 0; pix<2; ++pix)
-      {
-         unsigned short usi = i;
-         short s = (short) usi; //*((short*)&usi);
-         int sbit = (s < 0);
-
-         s *= (1-2*sbit);
-      
-         unsigned short us = ( (s) << 1) | sbit;
-       
-         //((unsigned char *)(&us))[0]; 
-
-         unsigned char nib1 = 0, nib2 = 0; 
-         
-         if(pix % 2 == 0)
-         {
-            nib1 |= ((unsigned char *)(&us))[1] << 4;
-            nib2 |= ((unsigned char *)(&us))[1] & 240;
-         }
-         else
-         {
-            nib1 |= (((unsigned char *)(&us))[1] & 15);
-            nib2 |= ((unsigned char *)(&us))[1] >> 4;
-         }  
-      
-         printf("  /*%d*/  %d, %d, %d", i, (unsigned char) ((char *)(&us))[0] , (unsigned char) nib1, (unsigned char) nib2);
-         
-         if(i == 65535 && pix==1) printf("\n");
-         else printf(",\n");
-      }
-   }
-   
-   
-   printf("};\n"); 
-
-}
+#define LZ4_MEMORY_USAGE 16
 
+#include "xrif_lz4_memory.inc"
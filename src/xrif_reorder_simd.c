@@ -0,0 +1,1239 @@
+/** \file xrif_reorder_simd.c
+  * \brief Vectorized kernels for xrif bytepack reordering
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include "xrif.h"
+
+#if !defined(XRIF_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define XRIF_SIMD_X86
+#include <immintrin.h>
+#endif
+
+int xrif_simd_level(void)
+{
+   #ifdef XRIF_SIMD_X86
+   __builtin_cpu_init();
+   
+   if(__builtin_cpu_supports("avx2")) return XRIF_SIMD_AVX2;
+   if(__builtin_cpu_supports("sse2")) return XRIF_SIMD_SSE2;
+   #endif
+   
+   return XRIF_SIMD_NONE;
+}
+
+//--------------------------------------------------------------------
+//  16 bit bytepack
+//--------------------------------------------------------------------
+
+/* The high byte is swapped between 0 and -1 when the low byte is negative, so that small negative values have a 0 high byte.
+ * This is its own inverse, so the same fixup is applied when unreordering.
+ */
+
+static void xrif_reorder_bytepack_sint16_scalar( char * lo,
+                                                 char * hi,
+                                                 const char * raw,
+                                                 size_t npix
+                                               )
+{
+   for(size_t pix = 0; pix < npix; ++pix)
+   {
+      //Note: a lookup table for this was found to be 2x slower than the following algorithm.
+      int_fast8_t x2 = raw[2*pix];
+      int_fast8_t x1 = raw[2*pix+1];
+
+      if(x2 < 0)
+      {
+         if(x1 == -1)  x1 = 0;
+         else if(x1 == 0) x1 = -1;
+      }
+         
+      lo[pix] = x2; 
+      hi[pix] = x1;
+   }
+}
+
+static void xrif_unreorder_bytepack_sint16_scalar( char * raw,
+                                                   const char * lo,
+                                                   const char * hi,
+                                                   size_t npix
+                                                 )
+{
+   for(size_t pix = 0; pix < npix; ++pix)
+   {
+      int_fast8_t x2 = lo[pix]; 
+      int_fast8_t x1 = hi[pix];
+         
+      if(x2 < 0)
+      {
+         if(x1 == -1) x1 = 0;
+         else if(x1 == 0) x1 = -1;
+      }
+         
+      raw[2*pix] = x2;
+      raw[2*pix+1] = x1;
+   }
+}
+
+#ifdef XRIF_SIMD_X86
+
+__attribute__((target("sse2")))
+static inline __m128i xrif_sign_fixup_sse2( __m128i lo,
+                                            __m128i hi
+                                          )
+{
+   __m128i neg = _mm_cmplt_epi8(lo, _mm_setzero_si128());
+   __m128i swap = _mm_or_si128( _mm_cmpeq_epi8(hi, _mm_setzero_si128()), _mm_cmpeq_epi8(hi, _mm_set1_epi8(-1)));
+   
+   return _mm_xor_si128(hi, _mm_and_si128(neg, swap));
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_reorder_bytepack_sint16_sse2( char * lo,
+                                                 char * hi,
+                                                 const char * raw,
+                                                 size_t npix
+                                               )
+{
+   const __m128i lomask = _mm_set1_epi16(0x00FF);
+   
+   size_t pix = 0;
+   for(; pix + 16 <= npix; pix += 16)
+   {
+      __m128i a = _mm_loadu_si128( (const __m128i *) (raw + 2*pix));
+      __m128i b = _mm_loadu_si128( (const __m128i *) (raw + 2*pix + 16));
+      
+      __m128i l = _mm_packus_epi16( _mm_and_si128(a, lomask), _mm_and_si128(b, lomask));
+      __m128i h = _mm_packus_epi16( _mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+      
+      _mm_storeu_si128( (__m128i *) (lo + pix), l);
+      _mm_storeu_si128( (__m128i *) (hi + pix), xrif_sign_fixup_sse2(l, h));
+   }
+   
+   return pix;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_unreorder_bytepack_sint16_sse2( char * raw,
+                                                   const char * lo,
+                                                   const char * hi,
+                                                   size_t npix
+                                                 )
+{
+   size_t pix = 0;
+   for(; pix + 16 <= npix; pix += 16)
+   {
+      __m128i l = _mm_loadu_si128( (const __m128i *) (lo + pix));
+      __m128i h = xrif_sign_fixup_sse2(l, _mm_loadu_si128( (const __m128i *) (hi + pix)));
+      
+      _mm_storeu_si128( (__m128i *) (raw + 2*pix), _mm_unpacklo_epi8(l, h));
+      _mm_storeu_si128( (__m128i *) (raw + 2*pix + 16), _mm_unpackhi_epi8(l, h));
+   }
+   
+   return pix;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i xrif_sign_fixup_avx2( __m256i lo,
+                                            __m256i hi
+                                          )
+{
+   __m256i neg = _mm256_cmpgt_epi8(_mm256_setzero_si256(), lo);
+   __m256i swap = _mm256_or_si256( _mm256_cmpeq_epi8(hi, _mm256_setzero_si256()), _mm256_cmpeq_epi8(hi, _mm256_set1_epi8(-1)));
+   
+   return _mm256_xor_si256(hi, _mm256_and_si256(neg, swap));
+}
+
+__attribute__((target("avx2")))
+static size_t xrif_reorder_bytepack_sint16_avx2( char * lo,
+                                                 char * hi,
+                                                 const char * raw,
+                                                 size_t npix
+                                               )
+{
+   const __m256i lomask = _mm256_set1_epi16(0x00FF);
+   
+   size_t pix = 0;
+   for(; pix + 32 <= npix; pix += 32)
+   {
+      __m256i a = _mm256_loadu_si256( (const __m256i *) (raw + 2*pix));
+      __m256i b = _mm256_loadu_si256( (const __m256i *) (raw + 2*pix + 32));
+      
+      //The packs work within 128 bit lanes, so the 64 bit quarters come out as 0-7, 16-23, 8-15, 24-31
+      __m256i l = _mm256_packus_epi16( _mm256_and_si256(a, lomask), _mm256_and_si256(b, lomask));
+      __m256i h = _mm256_packus_epi16( _mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+      
+      l = _mm256_permute4x64_epi64(l, 0xD8);
+      h = _mm256_permute4x64_epi64(h, 0xD8);
+      
+      _mm256_storeu_si256( (__m256i *) (lo + pix), l);
+      _mm256_storeu_si256( (__m256i *) (hi + pix), xrif_sign_fixup_avx2(l, h));
+   }
+   
+   return pix;
+}
+
+__attribute__((target("avx2")))
+static size_t xrif_unreorder_bytepack_sint16_avx2( char * raw,
+                                                   const char * lo,
+                                                   const char * hi,
+                                                   size_t npix
+                                                 )
+{
+   size_t pix = 0;
+   for(; pix + 32 <= npix; pix += 32)
+   {
+      __m256i l = _mm256_loadu_si256( (const __m256i *) (lo + pix));
+      __m256i h = xrif_sign_fixup_avx2(l, _mm256_loadu_si256( (const __m256i *) (hi + pix)));
+      
+      //The unpacks work within 128 bit lanes, giving pixels 0-7 and 16-23 from the low halves, and 8-15 and 24-31 from the high halves
+      __m256i u0 = _mm256_unpacklo_epi8(l, h);
+      __m256i u1 = _mm256_unpackhi_epi8(l, h);
+      
+      _mm256_storeu_si256( (__m256i *) (raw + 2*pix), _mm256_permute2x128_si256(u0, u1, 0x20));
+      _mm256_storeu_si256( (__m256i *) (raw + 2*pix + 32), _mm256_permute2x128_si256(u0, u1, 0x31));
+   }
+   
+   return pix;
+}
+
+#endif //XRIF_SIMD_X86
+
+void xrif_reorder_bytepack_sint16_kernel( char * lo,
+                                          char * hi,
+                                          const char * raw,
+                                          size_t npix,
+                                          int simd
+                                        )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_AVX2) done = xrif_reorder_bytepack_sint16_avx2(lo, hi, raw, npix);
+   else if(simd >= XRIF_SIMD_SSE2) done = xrif_reorder_bytepack_sint16_sse2(lo, hi, raw, npix);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_reorder_bytepack_sint16_scalar(lo + done, hi + done, raw + 2*done, npix - done);
+}
+
+void xrif_unreorder_bytepack_sint16_kernel( char * raw,
+                                            const char * lo,
+                                            const char * hi,
+                                            size_t npix,
+                                            int simd
+                                          )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_AVX2) done = xrif_unreorder_bytepack_sint16_avx2(raw, lo, hi, npix);
+   else if(simd >= XRIF_SIMD_SSE2) done = xrif_unreorder_bytepack_sint16_sse2(raw, lo, hi, npix);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_unreorder_bytepack_sint16_scalar(raw + 2*done, lo + done, hi + done, npix - done);
+}
+
+//--------------------------------------------------------------------
+//  32 and 64 bit bytepack
+//--------------------------------------------------------------------
+
+/* Wider pixels are sign-folded (zigzag encoded) so that small negative values have zero high bytes, and then split into one plane per byte.
+ * Plane b holds byte b of every pixel, and starts `stride` bytes after plane b-1.
+ */
+
+static void xrif_reorder_bytepack_sint32_scalar( char * planes,
+                                                 size_t stride,
+                                                 const char * raw,
+                                                 size_t npix
+                                               )
+{
+   const int32_t * rb = (const int32_t *) raw;
+   
+   for(size_t pix = 0; pix < npix; ++pix)
+   {
+      uint32_t x = rb[pix];
+      uint32_t z = (x << 1) ^ (uint32_t) -(x >> 31);
+      
+      for(int b = 0; b < 4; ++b) planes[b*stride + pix] = (char) (z >> (8*b));
+   }
+}
+
+static void xrif_unreorder_bytepack_sint32_scalar( char * raw,
+                                                   const char * planes,
+                                                   size_t stride,
+                                                   size_t npix
+                                                 )
+{
+   int32_t * rb = (int32_t *) raw;
+   
+   for(size_t pix = 0; pix < npix; ++pix)
+   {
+      uint32_t z = 0;
+      for(int b = 0; b < 4; ++b) z |= ((uint32_t) (unsigned char) planes[b*stride + pix]) << (8*b);
+      
+      rb[pix] = (int32_t) ((z >> 1) ^ (uint32_t) -(z & 1));
+   }
+}
+
+static void xrif_reorder_bytepack_sint64_scalar( char * planes,
+                                                 size_t stride,
+                                                 const char * raw,
+                                                 size_t npix
+                                               )
+{
+   const int64_t * rb = (const int64_t *) raw;
+   
+   for(size_t pix = 0; pix < npix; ++pix)
+   {
+      uint64_t x = rb[pix];
+      uint64_t z = (x << 1) ^ (uint64_t) -(x >> 63);
+      
+      for(int b = 0; b < 8; ++b) planes[b*stride + pix] = (char) (z >> (8*b));
+   }
+}
+
+static void xrif_unreorder_bytepack_sint64_scalar( char * raw,
+                                                   const char * planes,
+                                                   size_t stride,
+                                                   size_t npix
+                                                 )
+{
+   int64_t * rb = (int64_t *) raw;
+   
+   for(size_t pix = 0; pix < npix; ++pix)
+   {
+      uint64_t z = 0;
+      for(int b = 0; b < 8; ++b) z |= ((uint64_t) (unsigned char) planes[b*stride + pix]) << (8*b);
+      
+      rb[pix] = (int64_t) ((z >> 1) ^ (uint64_t) -(z & 1));
+   }
+}
+
+#ifdef XRIF_SIMD_X86
+
+/* Transposing bytes with unpacks: view n registers of 16 bytes as one array of 16n bytes.  One round of unpacking register i with register i+n/2
+ * into registers 2i and 2i+1 rotates the bits of each byte's index in that array left by one.  For 16 pixels of n bytes the index is 
+ * pixel*n + byte, and the transposed index is byte*16 + pixel, which is a rotation by 4.  So 4 rounds transpose the pixels into byte planes, 
+ * and log2(n) more rounds (a full rotation) bring them back, which is how unreordering is done.
+ */
+__attribute__((target("sse2")))
+static inline void xrif_unpack_round_sse2( __m128i * r,
+                                           int n
+                                         )
+{
+   __m128i t[8];
+   
+   for(int i = 0; i < n/2; ++i)
+   {
+      t[2*i] = _mm_unpacklo_epi8(r[i], r[i + n/2]);
+      t[2*i+1] = _mm_unpackhi_epi8(r[i], r[i + n/2]);
+   }
+   
+   for(int i = 0; i < n; ++i) r[i] = t[i];
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_reorder_bytepack_sint32_sse2( char * planes,
+                                                 size_t stride,
+                                                 const char * raw,
+                                                 size_t npix
+                                               )
+{
+   size_t pix = 0;
+   for(; pix + 16 <= npix; pix += 16)
+   {
+      __m128i r[4];
+      
+      for(int i = 0; i < 4; ++i)
+      {
+         __m128i x = _mm_loadu_si128( (const __m128i *) (raw + 4*pix + 16*i));
+         r[i] = _mm_xor_si128( _mm_slli_epi32(x, 1), _mm_srai_epi32(x, 31));
+      }
+      
+      for(int k = 0; k < 4; ++k) xrif_unpack_round_sse2(r, 4);
+      
+      for(int b = 0; b < 4; ++b) _mm_storeu_si128( (__m128i *) (planes + b*stride + pix), r[b]);
+   }
+   
+   return pix;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_unreorder_bytepack_sint32_sse2( char * raw,
+                                                   const char * planes,
+                                                   size_t stride,
+                                                   size_t npix
+                                                 )
+{
+   const __m128i one = _mm_set1_epi32(1);
+   
+   size_t pix = 0;
+   for(; pix + 16 <= npix; pix += 16)
+   {
+      __m128i r[4];
+      
+      for(int b = 0; b < 4; ++b) r[b] = _mm_loadu_si128( (const __m128i *) (planes + b*stride + pix));
+      
+      for(int k = 0; k < 2; ++k) xrif_unpack_round_sse2(r, 4);
+      
+      for(int i = 0; i < 4; ++i)
+      {
+         __m128i z = r[i];
+         __m128i x = _mm_xor_si128( _mm_srli_epi32(z, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z, one)));
+         _mm_storeu_si128( (__m128i *) (raw + 4*pix + 16*i), x);
+      }
+   }
+   
+   return pix;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_reorder_bytepack_sint64_sse2( char * planes,
+                                                 size_t stride,
+                                                 const char * raw,
+                                                 size_t npix
+                                               )
+{
+   size_t pix = 0;
+   for(; pix + 16 <= npix; pix += 16)
+   {
+      __m128i r[8];
+      
+      for(int i = 0; i < 8; ++i)
+      {
+         __m128i x = _mm_loadu_si128( (const __m128i *) (raw + 8*pix + 16*i));
+         
+         //SSE2 has no 64 bit arithmetic shift, so spread the sign of the high 32 bits over each 64 bit lane
+         __m128i sign = _mm_shuffle_epi32( _mm_srai_epi32(x, 31), _MM_SHUFFLE(3,3,1,1));
+         r[i] = _mm_xor_si128( _mm_slli_epi64(x, 1), sign);
+      }
+      
+      for(int k = 0; k < 4; ++k) xrif_unpack_round_sse2(r, 8);
+      
+      for(int b = 0; b < 8; ++b) _mm_storeu_si128( (__m128i *) (planes + b*stride + pix), r[b]);
+   }
+   
+   return pix;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_unreorder_bytepack_sint64_sse2( char * raw,
+                                                   const char * planes,
+                                                   size_t stride,
+                                                   size_t npix
+                                                 )
+{
+   const __m128i one = _mm_set1_epi64x(1);
+   
+   size_t pix = 0;
+   for(; pix + 16 <= npix; pix += 16)
+   {
+      __m128i r[8];
+      
+      for(int b = 0; b < 8; ++b) r[b] = _mm_loadu_si128( (const __m128i *) (planes + b*stride + pix));
+      
+      for(int k = 0; k < 3; ++k) xrif_unpack_round_sse2(r, 8);
+      
+      for(int i = 0; i < 8; ++i)
+      {
+         __m128i z = r[i];
+         __m128i x = _mm_xor_si128( _mm_srli_epi64(z, 1), _mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(z, one)));
+         _mm_storeu_si128( (__m128i *) (raw + 8*pix + 16*i), x);
+      }
+   }
+   
+   return pix;
+}
+
+#endif //XRIF_SIMD_X86
+
+void xrif_reorder_bytepack_sint32_kernel( char * planes,
+                                          size_t stride,
+                                          const char * raw,
+                                          size_t npix,
+                                          int simd
+                                        )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_reorder_bytepack_sint32_sse2(planes, stride, raw, npix);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_reorder_bytepack_sint32_scalar(planes + done, stride, raw + 4*done, npix - done);
+}
+
+void xrif_unreorder_bytepack_sint32_kernel( char * raw,
+                                            const char * planes,
+                                            size_t stride,
+                                            size_t npix,
+                                            int simd
+                                          )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_unreorder_bytepack_sint32_sse2(raw, planes, stride, npix);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_unreorder_bytepack_sint32_scalar(raw + 4*done, planes + done, stride, npix - done);
+}
+
+void xrif_reorder_bytepack_sint64_kernel( char * planes,
+                                          size_t stride,
+                                          const char * raw,
+                                          size_t npix,
+                                          int simd
+                                        )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_reorder_bytepack_sint64_sse2(planes, stride, raw, npix);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_reorder_bytepack_sint64_scalar(planes + done, stride, raw + 8*done, npix - done);
+}
+
+void xrif_unreorder_bytepack_sint64_kernel( char * raw,
+                                            const char * planes,
+                                            size_t stride,
+                                            size_t npix,
+                                            int simd
+                                          )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_unreorder_bytepack_sint64_sse2(raw, planes, stride, npix);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_unreorder_bytepack_sint64_scalar(raw + 8*done, planes + done, stride, npix - done);
+}
+
+//--------------------------------------------------------------------
+//  Byte shuffle
+//--------------------------------------------------------------------
+
+/* Floating point pixels are split into byte planes as they are, without sign folding, since after XOR differencing they are bit patterns
+ * rather than numbers.
+ */
+
+static void xrif_reorder_byteshuffle_scalar( char * planes,
+                                             size_t stride,
+                                             const char * raw,
+                                             size_t npix,
+                                             size_t nbytes
+                                           )
+{
+   for(size_t pix = 0; pix < npix; ++pix)
+   {
+      for(size_t b = 0; b < nbytes; ++b) planes[b*stride + pix] = raw[pix*nbytes + b];
+   }
+}
+
+static void xrif_unreorder_byteshuffle_scalar( char * raw,
+                                               const char * planes,
+                                               size_t stride,
+                                               size_t npix,
+                                               size_t nbytes
+                                             )
+{
+   for(size_t pix = 0; pix < npix; ++pix)
+   {
+      for(size_t b = 0; b < nbytes; ++b) raw[pix*nbytes + b] = planes[b*stride + pix];
+   }
+}
+
+#ifdef XRIF_SIMD_X86
+
+//See xrif_unpack_round_sse2 for how the transpose works.  n is 2, 4, or 8, and m = log2(n).
+__attribute__((target("sse2")))
+static size_t xrif_reorder_byteshuffle_sse2( char * planes,
+                                             size_t stride,
+                                             const char * raw,
+                                             size_t npix,
+                                             int n
+                                           )
+{
+   size_t pix = 0;
+   for(; pix + 16 <= npix; pix += 16)
+   {
+      __m128i r[8];
+      
+      for(int i = 0; i < n; ++i) r[i] = _mm_loadu_si128( (const __m128i *) (raw + n*pix + 16*i));
+      
+      for(int k = 0; k < 4; ++k) xrif_unpack_round_sse2(r, n);
+      
+      for(int b = 0; b < n; ++b) _mm_storeu_si128( (__m128i *) (planes + b*stride + pix), r[b]);
+   }
+   
+   return pix;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_unreorder_byteshuffle_sse2( char * raw,
+                                               const char * planes,
+                                               size_t stride,
+                                               size_t npix,
+                                               int n
+                                             )
+{
+   int m = (n == 2) ? 1 : ((n == 4) ? 2 : 3);
+   
+   size_t pix = 0;
+   for(; pix + 16 <= npix; pix += 16)
+   {
+      __m128i r[8];
+      
+      for(int b = 0; b < n; ++b) r[b] = _mm_loadu_si128( (const __m128i *) (planes + b*stride + pix));
+      
+      for(int k = 0; k < m; ++k) xrif_unpack_round_sse2(r, n);
+      
+      for(int i = 0; i < n; ++i) _mm_storeu_si128( (__m128i *) (raw + n*pix + 16*i), r[i]);
+   }
+   
+   return pix;
+}
+
+#endif //XRIF_SIMD_X86
+
+void xrif_reorder_byteshuffle_kernel( char * planes,
+                                      size_t stride,
+                                      const char * raw,
+                                      size_t npix,
+                                      size_t nbytes,
+                                      int simd
+                                    )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2 && (nbytes == 2 || nbytes == 4 || nbytes == 8))
+   {
+      done = xrif_reorder_byteshuffle_sse2(planes, stride, raw, npix, nbytes);
+   }
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_reorder_byteshuffle_scalar(planes + done, stride, raw + nbytes*done, npix - done, nbytes);
+}
+
+void xrif_unreorder_byteshuffle_kernel( char * raw,
+                                        const char * planes,
+                                        size_t stride,
+                                        size_t npix,
+                                        size_t nbytes,
+                                        int simd
+                                      )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2 && (nbytes == 2 || nbytes == 4 || nbytes == 8))
+   {
+      done = xrif_unreorder_byteshuffle_sse2(raw, planes, stride, npix, nbytes);
+   }
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_unreorder_byteshuffle_scalar(raw + nbytes*done, planes + done, stride, npix - done, nbytes);
+}
+
+//--------------------------------------------------------------------
+//  16 bit bitpack
+//--------------------------------------------------------------------
+
+/* Bitpack zigzag encodes each pixel and writes bit b of pixel i to bit i%8 of byte i/8 of plane b.  Each group of 8 pixels fills one byte
+ * in each of the 16 planes, so groups are independent.  The scalar kernel transposes the 8x8 bit matrices of the low and high bytes
+ * with shifts and masks.  The vector kernels take bit b of 16 or 32 pixels at once with a movemask.
+ */
+
+//Transpose an 8x8 bit matrix, where byte i is row i and bit j is column j.  This is its own inverse.
+static inline uint64_t xrif_transpose8x8( uint64_t x )
+{
+   uint64_t t;
+   
+   t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+   x = x ^ t ^ (t << 7);
+   t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+   x = x ^ t ^ (t << 14);
+   t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+   x = x ^ t ^ (t << 28);
+   
+   return x;
+}
+
+static void xrif_reorder_bitpack_sint16_scalar( char * planes,
+                                                size_t stride,
+                                                const char * raw,
+                                                size_t npix
+                                              )
+{
+   const int16_t * rb = (const int16_t *) raw;
+   
+   for(size_t pix = 0; pix < npix; pix += 8)
+   {
+      size_t n = (npix - pix < 8) ? npix - pix : 8;
+      
+      //Pack the low bytes of the 8 pixels into one word, and the high bytes into another
+      uint64_t lo = 0, hi = 0;
+      for(size_t j = 0; j < n; ++j)
+      {
+         uint16_t x = rb[pix + j];
+         uint16_t z = (x << 1) ^ (uint16_t) -(x >> 15);
+         
+         lo |= ((uint64_t) (z & 0xFF)) << (8*j);
+         hi |= ((uint64_t) (z >> 8)) << (8*j);
+      }
+      
+      lo = xrif_transpose8x8(lo);
+      hi = xrif_transpose8x8(hi);
+      
+      for(int b = 0; b < 8; ++b)
+      {
+         planes[b*stride + pix/8] = (char) (lo >> (8*b));
+         planes[(8+b)*stride + pix/8] = (char) (hi >> (8*b));
+      }
+   }
+}
+
+static void xrif_unreorder_bitpack_sint16_scalar( char * raw,
+                                                  const char * planes,
+                                                  size_t stride,
+                                                  size_t npix
+                                                )
+{
+   int16_t * rb = (int16_t *) raw;
+   
+   for(size_t pix = 0; pix < npix; pix += 8)
+   {
+      size_t n = (npix - pix < 8) ? npix - pix : 8;
+      
+      uint64_t lo = 0, hi = 0;
+      for(int b = 0; b < 8; ++b)
+      {
+         lo |= ((uint64_t) (unsigned char) planes[b*stride + pix/8]) << (8*b);
+         hi |= ((uint64_t) (unsigned char) planes[(8+b)*stride + pix/8]) << (8*b);
+      }
+      
+      lo = xrif_transpose8x8(lo);
+      hi = xrif_transpose8x8(hi);
+      
+      for(size_t j = 0; j < n; ++j)
+      {
+         uint16_t z = ((lo >> (8*j)) & 0xFF) | (((hi >> (8*j)) & 0xFF) << 8);
+         rb[pix + j] = (int16_t) ((z >> 1) ^ (uint16_t) -(z & 1));
+      }
+   }
+}
+
+#ifdef XRIF_SIMD_X86
+
+__attribute__((target("sse2")))
+static size_t xrif_reorder_bitpack_sint16_sse2( char * planes,
+                                                size_t stride,
+                                                const char * raw,
+                                                size_t npix
+                                              )
+{
+   const __m128i mask = _mm_set1_epi16(0x00FF);
+   
+   size_t pix = 0;
+   for(; pix + 16 <= npix; pix += 16)
+   {
+      __m128i a = _mm_loadu_si128( (const __m128i *) (raw + 2*pix));
+      __m128i b = _mm_loadu_si128( (const __m128i *) (raw + 2*pix + 16));
+      
+      a = _mm_xor_si128( _mm_slli_epi16(a, 1), _mm_srai_epi16(a, 15));
+      b = _mm_xor_si128( _mm_slli_epi16(b, 1), _mm_srai_epi16(b, 15));
+      
+      __m128i lo = _mm_packus_epi16( _mm_and_si128(a, mask), _mm_and_si128(b, mask));
+      __m128i hi = _mm_packus_epi16( _mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+      
+      //Shift bit k to the top of each byte.  Shifting 16 bit lanes is fine since only the top bit of each byte is used.
+      for(int k = 0; k < 8; ++k)
+      {
+         uint16_t mlo = _mm_movemask_epi8( _mm_slli_epi16(lo, 7-k));
+         uint16_t mhi = _mm_movemask_epi8( _mm_slli_epi16(hi, 7-k));
+         
+         memcpy(planes + k*stride + pix/8, &mlo, 2);
+         memcpy(planes + (8+k)*stride + pix/8, &mhi, 2);
+      }
+   }
+   
+   return pix;
+}
+
+__attribute__((target("avx2")))
+static size_t xrif_reorder_bitpack_sint16_avx2( char * planes,
+                                                size_t stride,
+                                                const char * raw,
+                                                size_t npix
+                                              )
+{
+   const __m256i mask = _mm256_set1_epi16(0x00FF);
+   
+   size_t pix = 0;
+   for(; pix + 32 <= npix; pix += 32)
+   {
+      __m256i a = _mm256_loadu_si256( (const __m256i *) (raw + 2*pix));
+      __m256i b = _mm256_loadu_si256( (const __m256i *) (raw + 2*pix + 32));
+      
+      a = _mm256_xor_si256( _mm256_slli_epi16(a, 1), _mm256_srai_epi16(a, 15));
+      b = _mm256_xor_si256( _mm256_slli_epi16(b, 1), _mm256_srai_epi16(b, 15));
+      
+      //packus works within 128 bit lanes, so restore the pixel order with a permute
+      __m256i lo = _mm256_permute4x64_epi64( _mm256_packus_epi16( _mm256_and_si256(a, mask), _mm256_and_si256(b, mask)), 0xD8);
+      __m256i hi = _mm256_permute4x64_epi64( _mm256_packus_epi16( _mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8)), 0xD8);
+      
+      for(int k = 0; k < 8; ++k)
+      {
+         uint32_t mlo = _mm256_movemask_epi8( _mm256_slli_epi16(lo, 7-k));
+         uint32_t mhi = _mm256_movemask_epi8( _mm256_slli_epi16(hi, 7-k));
+         
+         memcpy(planes + k*stride + pix/8, &mlo, 4);
+         memcpy(planes + (8+k)*stride + pix/8, &mhi, 4);
+      }
+   }
+   
+   return pix;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_unreorder_bitpack_sint16_sse2( char * raw,
+                                                  const char * planes,
+                                                  size_t stride,
+                                                  size_t npix
+                                                )
+{
+   //Byte i selects bit i%8 of the byte of the plane it is spread from
+   const __m128i sel = _mm_set_epi8( -128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+   const __m128i one = _mm_set1_epi16(1);
+   
+   size_t pix = 0;
+   for(; pix + 16 <= npix; pix += 16)
+   {
+      __m128i lo = _mm_setzero_si128();
+      __m128i hi = _mm_setzero_si128();
+      
+      for(int k = 0; k < 16; ++k)
+      {
+         unsigned char m[2];
+         memcpy(m, planes + k*stride + pix/8, 2);
+         
+         //Spread the first byte over bytes 0-7 and the second over bytes 8-15, then test each byte's bit
+         __m128i v = _mm_set_epi64x( 0x0101010101010101LL * m[1], 0x0101010101010101LL * m[0]);
+         __m128i bits = _mm_cmpeq_epi8( _mm_and_si128(v, sel), sel);
+         
+         if(k < 8) lo = _mm_or_si128(lo, _mm_and_si128(bits, _mm_set1_epi8( (char) (1 << k))));
+         else hi = _mm_or_si128(hi, _mm_and_si128(bits, _mm_set1_epi8( (char) (1 << (k-8)))));
+      }
+      
+      __m128i a = _mm_unpacklo_epi8(lo, hi);
+      __m128i b = _mm_unpackhi_epi8(lo, hi);
+      
+      a = _mm_xor_si128( _mm_srli_epi16(a, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(a, one)));
+      b = _mm_xor_si128( _mm_srli_epi16(b, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(b, one)));
+      
+      _mm_storeu_si128( (__m128i *) (raw + 2*pix), a);
+      _mm_storeu_si128( (__m128i *) (raw + 2*pix + 16), b);
+   }
+   
+   return pix;
+}
+
+#endif //XRIF_SIMD_X86
+
+void xrif_reorder_bitpack_sint16_kernel( char * planes,
+                                         size_t stride,
+                                         const char * raw,
+                                         size_t npix,
+                                         int simd
+                                       )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_AVX2) done = xrif_reorder_bitpack_sint16_avx2(planes, stride, raw, npix);
+   
+   if(simd >= XRIF_SIMD_SSE2) done += xrif_reorder_bitpack_sint16_sse2(planes + done/8, stride, raw + 2*done, npix - done);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_reorder_bitpack_sint16_scalar(planes + done/8, stride, raw + 2*done, npix - done);
+}
+
+void xrif_unreorder_bitpack_sint16_kernel( char * raw,
+                                           const char * planes,
+                                           size_t stride,
+                                           size_t npix,
+                                           int simd
+                                         )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_unreorder_bitpack_sint16_sse2(raw, planes, stride, npix);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_unreorder_bitpack_sint16_scalar(raw + 2*done, planes + done/8, stride, npix - done);
+}
+
+//--------------------------------------------------------------------
+//  16 bit renibble
+//--------------------------------------------------------------------
+
+/* Renibble sign-magnitude folds each pixel, with the sign in bit 0, and writes the low byte to the first plane.  The high bytes of a
+ * pair of pixels are split into one byte holding the low nibbles and one holding the high nibbles, the even pixel's nibble on top.
+ * Each pair fills one byte of each nibble plane, so runs starting on an even pixel can be reordered independently.  The vector 
+ * kernels do the nibble arithmetic in 16 bit lanes holding the two high bytes of a pair.
+ */
+
+static void xrif_reorder_renibble_sint16_scalar( unsigned char * lo,
+                                                 unsigned char * nib1,
+                                                 unsigned char * nib2,
+                                                 const char * raw,
+                                                 size_t npix
+                                               )
+{
+   for(size_t q = 0; 2*q < npix; ++q)
+   {
+      uint16_t us[2] = {0,0};
+      
+      for(int k = 0; k < 2 && 2*q + k < npix; ++k)
+      {
+         int16_t s;
+         memcpy(&s, raw + 2*(2*q+k), sizeof(s));
+         
+         uint16_t sbit = (s < 0);
+         uint16_t mag = sbit ? -((uint16_t) s) : (uint16_t) s;
+         
+         //The most negative value folds to 1
+         us[k] = (uint16_t) (mag << 1) | sbit;
+         
+         lo[2*q+k] = (unsigned char) us[k];
+      }
+      
+      unsigned char h0 = us[0] >> 8;
+      unsigned char h1 = us[1] >> 8;
+      
+      nib1[q] = (unsigned char) ((h0 << 4) | (h1 & 15));
+      nib2[q] = (unsigned char) ((h0 & 240) | (h1 >> 4));
+   }
+}
+
+static void xrif_unreorder_renibble_sint16_scalar( char * raw,
+                                                   const unsigned char * lo,
+                                                   const unsigned char * nib1,
+                                                   const unsigned char * nib2,
+                                                   size_t npix
+                                                 )
+{
+   for(size_t q = 0; 2*q < npix; ++q)
+   {
+      uint16_t us[2];
+      
+      us[0] = (uint16_t) ((nib1[q] >> 4) | (nib2[q] & 240)) << 8;
+      us[1] = (uint16_t) ((nib1[q] & 15) | ((nib2[q] << 4) & 240)) << 8;
+      
+      for(int k = 0; k < 2 && 2*q + k < npix; ++k)
+      {
+         us[k] |= lo[2*q+k];
+         
+         uint16_t sbit = us[k] & 1;
+         uint16_t mag = us[k] >> 1;
+         
+         //The most negative value was folded to 0 with the sign bit set
+         if(sbit && mag == 0) mag = 0x8000;
+         
+         uint16_t s = sbit ? -mag : mag;
+         memcpy(raw + 2*(2*q+k), &s, sizeof(s));
+      }
+   }
+}
+
+#ifdef XRIF_SIMD_X86
+
+__attribute__((target("sse2")))
+static inline __m128i xrif_renibble_fold_sse2( __m128i x )
+{
+   __m128i sign = _mm_srai_epi16(x, 15);
+   __m128i mag = _mm_sub_epi16( _mm_xor_si128(x, sign), sign);
+   
+   return _mm_or_si128( _mm_slli_epi16(mag, 1), _mm_srli_epi16(x, 15));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i xrif_renibble_unfold_sse2( __m128i us )
+{
+   const __m128i one = _mm_set1_epi16(1);
+   
+   __m128i sbit = _mm_and_si128(us, one);
+   __m128i neg = _mm_sub_epi16( _mm_setzero_si128(), sbit);
+   __m128i s = _mm_add_epi16( _mm_xor_si128( _mm_srli_epi16(us, 1), neg), sbit);
+   
+   //1 is the most negative value
+   return _mm_or_si128(s, _mm_and_si128( _mm_cmpeq_epi16(us, one), _mm_set1_epi16(-32768)));
+}
+
+//Splits the high bytes of 16 pixels, as pairs in 16 bit lanes, into 8 bytes of each nibble plane, still in 16 bit lanes.
+__attribute__((target("sse2")))
+static inline void xrif_renibble_split_sse2( __m128i * a,
+                                             __m128i * b,
+                                             __m128i h
+                                           )
+{
+   const __m128i lomask = _mm_set1_epi16(0x00FF);
+   const __m128i lonib = _mm_set1_epi16(0x000F);
+   const __m128i hinib = _mm_set1_epi16(0x00F0);
+   
+   __m128i e = _mm_and_si128(h, lomask);
+   __m128i o = _mm_srli_epi16(h, 8);
+   
+   *a = _mm_or_si128( _mm_and_si128( _mm_slli_epi16(e, 4), hinib), _mm_and_si128(o, lonib));
+   *b = _mm_or_si128( _mm_and_si128(e, hinib), _mm_srli_epi16(o, 4));
+}
+
+//The inverse of xrif_renibble_split_sse2, taking nibble plane bytes in 16 bit lanes and returning the pairs of high bytes.
+__attribute__((target("sse2")))
+static inline __m128i xrif_renibble_join_sse2( __m128i a,
+                                               __m128i b
+                                             )
+{
+   const __m128i lonib = _mm_set1_epi16(0x000F);
+   const __m128i hinib = _mm_set1_epi16(0x00F0);
+   
+   __m128i e = _mm_or_si128( _mm_srli_epi16(a, 4), _mm_and_si128(b, hinib));
+   __m128i o = _mm_or_si128( _mm_and_si128(a, lonib), _mm_and_si128( _mm_slli_epi16(b, 4), hinib));
+   
+   return _mm_or_si128(e, _mm_slli_epi16(o, 8));
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_reorder_renibble_sint16_sse2( unsigned char * lo,
+                                                 unsigned char * nib1,
+                                                 unsigned char * nib2,
+                                                 const char * raw,
+                                                 size_t npix
+                                               )
+{
+   const __m128i lomask = _mm_set1_epi16(0x00FF);
+   
+   size_t pix = 0;
+   for(; pix + 32 <= npix; pix += 32)
+   {
+      __m128i u[4];
+      for(int i = 0; i < 4; ++i) u[i] = xrif_renibble_fold_sse2( _mm_loadu_si128( (const __m128i *) (raw + 2*pix + 16*i)));
+      
+      __m128i l0 = _mm_packus_epi16( _mm_and_si128(u[0], lomask), _mm_and_si128(u[1], lomask));
+      __m128i l1 = _mm_packus_epi16( _mm_and_si128(u[2], lomask), _mm_and_si128(u[3], lomask));
+      __m128i h0 = _mm_packus_epi16( _mm_srli_epi16(u[0], 8), _mm_srli_epi16(u[1], 8));
+      __m128i h1 = _mm_packus_epi16( _mm_srli_epi16(u[2], 8), _mm_srli_epi16(u[3], 8));
+      
+      __m128i a0, b0, a1, b1;
+      xrif_renibble_split_sse2(&a0, &b0, h0);
+      xrif_renibble_split_sse2(&a1, &b1, h1);
+      
+      _mm_storeu_si128( (__m128i *) (lo + pix), l0);
+      _mm_storeu_si128( (__m128i *) (lo + pix + 16), l1);
+      _mm_storeu_si128( (__m128i *) (nib1 + pix/2), _mm_packus_epi16(a0, a1));
+      _mm_storeu_si128( (__m128i *) (nib2 + pix/2), _mm_packus_epi16(b0, b1));
+   }
+   
+   return pix;
+}
+
+__attribute__((target("sse2")))
+static size_t xrif_unreorder_renibble_sint16_sse2( char * raw,
+                                                   const unsigned char * lo,
+                                                   const unsigned char * nib1,
+                                                   const unsigned char * nib2,
+                                                   size_t npix
+                                                 )
+{
+   const __m128i zero = _mm_setzero_si128();
+   
+   size_t pix = 0;
+   for(; pix + 32 <= npix; pix += 32)
+   {
+      __m128i a = _mm_loadu_si128( (const __m128i *) (nib1 + pix/2));
+      __m128i b = _mm_loadu_si128( (const __m128i *) (nib2 + pix/2));
+      
+      __m128i h[2];
+      h[0] = xrif_renibble_join_sse2( _mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+      h[1] = xrif_renibble_join_sse2( _mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+      
+      for(int i = 0; i < 2; ++i)
+      {
+         __m128i l = _mm_loadu_si128( (const __m128i *) (lo + pix + 16*i));
+         
+         _mm_storeu_si128( (__m128i *) (raw + 2*pix + 32*i), xrif_renibble_unfold_sse2( _mm_unpacklo_epi8(l, h[i])));
+         _mm_storeu_si128( (__m128i *) (raw + 2*pix + 32*i + 16), xrif_renibble_unfold_sse2( _mm_unpackhi_epi8(l, h[i])));
+      }
+   }
+   
+   return pix;
+}
+
+#endif //XRIF_SIMD_X86
+
+void xrif_reorder_bytepack_renibble_sint16_kernel( char * lo,
+                                                   char * nib1,
+                                                   char * nib2,
+                                                   const char * raw,
+                                                   size_t npix,
+                                                   int simd
+                                                 )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_reorder_renibble_sint16_sse2( (unsigned char *) lo, (unsigned char *) nib1, (unsigned char *) nib2, raw, npix);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_reorder_renibble_sint16_scalar( (unsigned char *) lo + done, (unsigned char *) nib1 + done/2, (unsigned char *) nib2 + done/2, raw + 2*done, npix - done);
+}
+
+void xrif_unreorder_bytepack_renibble_sint16_kernel( char * raw,
+                                                     const char * lo,
+                                                     const char * nib1,
+                                                     const char * nib2,
+                                                     size_t npix,
+                                                     int simd
+                                                   )
+{
+   size_t done = 0;
+   
+   #ifdef XRIF_SIMD_X86
+   if(simd > XRIF_SIMD_NONE && simd > xrif_simd_level()) simd = xrif_simd_level();
+   
+   if(simd >= XRIF_SIMD_SSE2) done = xrif_unreorder_renibble_sint16_sse2(raw, (const unsigned char *) lo, (const unsigned char *) nib1, (const unsigned char *) nib2, npix);
+   #else
+   (void) simd;
+   #endif
+   
+   xrif_unreorder_renibble_sint16_scalar(raw + 2*done, (const unsigned char *) lo + done, (const unsigned char *) nib1 + done/2, (const unsigned char *) nib2 + done/2, npix - done);
+}
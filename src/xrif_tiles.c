@@ -0,0 +1,702 @@
+/** \file xrif_tiles.c
+  * \brief Implementation of tiled xrif encoding and decoding
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+
+
+
+#include "xrif.h"
+
+#if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+#include <omp.h>
+#endif
+
+/* A tile is a run of xrif_handle::tile_size bytes of the raw buffer, in pixel order from the start of the cube.  Each tile is differenced, 
+ * reordered, and compressed before moving on to the next, so its residuals and reordered bytes are still in cache when they are used.
+ * The planes of each tile are reordered on their own, so they do not span the cube, and each tile is an independent LZ4 block.
+ */
+
+int xrif_tiled( xrif_t handle )
+{
+   if(handle == NULL) return 0;
+   
+   if(handle->tile_size == 0) return 0;
+   
+   int method = handle->compress_method;
+   if(method == 0) method = XRIF_COMPRESS_DEFAULT;
+   
+   if(method != XRIF_COMPRESS_LZ4 && method != XRIF_COMPRESS_LZ4HC) return 0;
+   
+   return xrif_difference_reorder_supported(handle);
+}
+
+size_t xrif_ntiles( xrif_t handle )
+{
+   if(handle == NULL || handle->tile_size == 0) return 0;
+   
+   size_t nbytes = handle->width*handle->height*handle->depth*handle->frames*handle->data_size;
+   
+   return (nbytes + handle->tile_size - 1) / handle->tile_size;
+}
+
+//The number of bytes in a reordered tile of n pixels
+static size_t xrif_tile_bytes( xrif_t handle,
+                               int reorder,
+                               size_t n
+                             )
+{
+   if(reorder == XRIF_REORDER_BYTEPACK_RENIBBLE) return n + 2*((n+1)/2);
+   
+   return n*handle->data_size;
+}
+
+//Difference and reorder the n pixels starting at pixel r into tb
+static void xrif_tile_reorder( char * tb,
+                               char * res,
+                               xrif_t handle,
+                               int method,
+                               int reorder,
+                               size_t r,
+                               size_t n,
+                               int simd
+                             )
+{
+   if(handle->data_size == 2)
+   {
+      xrif_residual_sint16( (int16_t *) res, handle, method, r, n);
+      
+      if(reorder == XRIF_REORDER_BYTEPACK_RENIBBLE)
+      {
+         size_t half = (n+1)/2;
+         xrif_reorder_bytepack_renibble_sint16_kernel( tb, tb + n, tb + n + half, res, n, simd);
+      }
+      else
+      {
+         xrif_reorder_bytepack_sint16_kernel( tb, tb + n, res, n, simd);
+      }
+   }
+   else if(handle->data_size == 4)
+   {
+      xrif_residual_sint32( (int32_t *) res, handle, method, r, n);
+      xrif_reorder_bytepack_sint32_kernel( tb, n, res, n, simd);
+   }
+   else
+   {
+      xrif_residual_sint64( (int64_t *) res, handle, method, r, n);
+      xrif_reorder_bytepack_sint64_kernel( tb, n, res, n, simd);
+   }
+}
+
+/* The untile functions unreorder a tile into the raw buffer and undifference it in place.  Tiles are decoded in order, so the
+ * reference pixels in earlier tiles have already been restored.
+ */
+
+static void xrif_untile_sint16( xrif_t handle,
+                                int method,
+                                int reorder,
+                                const char * tb,
+                                size_t r,
+                                size_t n,
+                                int simd
+                              )
+{
+   int16_t * rb = (int16_t *) handle->raw_buffer;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t i = 0;
+   
+   if(reorder == XRIF_REORDER_BYTEPACK_RENIBBLE)
+   {
+      size_t half = (n+1)/2;
+      xrif_unreorder_bytepack_renibble_sint16_kernel( (char *) (rb + r), tb, tb + n, tb + n + half, n, simd);
+   }
+   else
+   {
+      xrif_unreorder_bytepack_sint16_kernel( (char *) (rb + r), tb, tb + n, n, simd);
+   }
+   
+   //The first frame is stored as is, or differenced against the last frame of the previous cube
+   if(method != XRIF_DIFFERENCE_PIXEL && r < fpix)
+   {
+      size_t e = (n < fpix - r) ? n : fpix - r;
+      
+      if(handle->chained)
+      {
+         const int16_t * ref = (const int16_t *) handle->chain_buffer + 2*fpix;
+         for(; i < e; ++i) rb[r+i] = rb[r+i] + ref[r+i];
+      }
+      
+      i = e;
+   }
+   
+   if(method == XRIF_DIFFERENCE_PREVIOUS)
+   {
+      for(; i < n; ++i) rb[r+i] = rb[r+i] + rb[r+i-fpix];
+   }
+   else if(method == XRIF_DIFFERENCE_FIRST)
+   {
+      while(i < n)
+      {
+         size_t j = (r+i) % fpix;
+         size_t e = (n - i < fpix - j) ? n : i + fpix - j;
+         
+         for(; i < e; ++i, ++j) rb[r+i] = rb[r+i] + rb[j];
+      }
+   }
+   else //XRIF_DIFFERENCE_PIXEL
+   {
+      size_t ppix = handle->width*handle->height;
+      
+      while(i < n)
+      {
+         size_t j = (r+i) % ppix;
+         size_t e = (n - i < ppix - j) ? n : i + ppix - j;
+         
+         //The first pixel of each image is its own reference
+         xrif_undifference_pixel_sint16_kernel(rb + r + i, e - i, (j == 0) ? 0 : rb[r+i-1], simd);
+         i = e;
+      }
+   }
+}
+
+static void xrif_untile_sint32( xrif_t handle,
+                                int method,
+                                const char * tb,
+                                size_t r,
+                                size_t n,
+                                int simd
+                              )
+{
+   int32_t * rb = (int32_t *) handle->raw_buffer;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t i = 0;
+   
+   xrif_unreorder_bytepack_sint32_kernel( (char *) (rb + r), tb, n, n, simd);
+   
+   //The first frame is stored as is, or differenced against the last frame of the previous cube
+   if(method != XRIF_DIFFERENCE_PIXEL && r < fpix)
+   {
+      size_t e = (n < fpix - r) ? n : fpix - r;
+      
+      if(handle->chained)
+      {
+         const int32_t * ref = (const int32_t *) handle->chain_buffer + 2*fpix;
+         for(; i < e; ++i) rb[r+i] = rb[r+i] + ref[r+i];
+      }
+      
+      i = e;
+   }
+   
+   if(method == XRIF_DIFFERENCE_PREVIOUS)
+   {
+      for(; i < n; ++i) rb[r+i] = rb[r+i] + rb[r+i-fpix];
+   }
+   else if(method == XRIF_DIFFERENCE_FIRST)
+   {
+      while(i < n)
+      {
+         size_t j = (r+i) % fpix;
+         size_t e = (n - i < fpix - j) ? n : i + fpix - j;
+         
+         for(; i < e; ++i, ++j) rb[r+i] = rb[r+i] + rb[j];
+      }
+   }
+   else //XRIF_DIFFERENCE_PIXEL
+   {
+      size_t ppix = handle->width*handle->height;
+      
+      while(i < n)
+      {
+         size_t j = (r+i) % ppix;
+         size_t e = (n - i < ppix - j) ? n : i + ppix - j;
+         
+         //The first pixel of each image is its own reference
+         xrif_undifference_pixel_sint32_kernel(rb + r + i, e - i, (j == 0) ? 0 : rb[r+i-1], simd);
+         i = e;
+      }
+   }
+}
+
+static void xrif_untile_sint64( xrif_t handle,
+                                int method,
+                                const char * tb,
+                                size_t r,
+                                size_t n,
+                                int simd
+                              )
+{
+   int64_t * rb = (int64_t *) handle->raw_buffer;
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t i = 0;
+   
+   xrif_unreorder_bytepack_sint64_kernel( (char *) (rb + r), tb, n, n, simd);
+   
+   //The first frame is stored as is, or differenced against the last frame of the previous cube
+   if(method != XRIF_DIFFERENCE_PIXEL && r < fpix)
+   {
+      size_t e = (n < fpix - r) ? n : fpix - r;
+      
+      if(handle->chained)
+      {
+         const int64_t * ref = (const int64_t *) handle->chain_buffer + 2*fpix;
+         for(; i < e; ++i) rb[r+i] = rb[r+i] + ref[r+i];
+      }
+      
+      i = e;
+   }
+   
+   if(method == XRIF_DIFFERENCE_PREVIOUS)
+   {
+      for(; i < n; ++i) rb[r+i] = rb[r+i] + rb[r+i-fpix];
+   }
+   else if(method == XRIF_DIFFERENCE_FIRST)
+   {
+      while(i < n)
+      {
+         size_t j = (r+i) % fpix;
+         size_t e = (n - i < fpix - j) ? n : i + fpix - j;
+         
+         for(; i < e; ++i, ++j) rb[r+i] = rb[r+i] + rb[j];
+      }
+   }
+   else //XRIF_DIFFERENCE_PIXEL
+   {
+      size_t ppix = handle->width*handle->height;
+      
+      while(i < n)
+      {
+         size_t j = (r+i) % ppix;
+         size_t e = (n - i < ppix - j) ? n : i + ppix - j;
+         
+         //The first pixel of each image is its own reference
+         xrif_undifference_pixel_sint64_kernel(rb + r + i, e - i, (j == 0) ? 0 : rb[r+i-1], simd);
+         i = e;
+      }
+   }
+}
+
+xrif_error_t xrif_encode_tiles( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_encode_tiles", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(!xrif_tiled(handle))
+   {
+      XRIF_ERROR_PRINT("xrif_encode_tiles", "tiled encoding not implemented for this configuration");
+      return XRIF_ERROR_NOTIMPL;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->reordered_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_encode_tiles", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+   
+   int method = handle->difference_method;
+   if(method == 0) method = XRIF_DIFFERENCE_DEFAULT;
+   
+   int reorder = handle->reorder_method;
+   if(reorder == 0) reorder = XRIF_REORDER_DEFAULT;
+   
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t one_frame = fpix*handle->data_size; //bytes
+   size_t npix = fpix*handle->frames;
+   
+   size_t tile_size = handle->tile_size;
+   size_t tpix = tile_size / handle->data_size;
+   size_t ntiles = xrif_ntiles(handle);
+   size_t table_size = XRIF_BLOCK_TABLE_SIZE(ntiles);
+   
+   if( handle->raw_buffer_size < one_frame*handle->frames )
+   {
+      XRIF_ERROR_PRINT("xrif_encode_tiles", "raw buffer is too small");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   //The compressed tiles are staged in the reordered buffer, one tile-sized slot each
+   if( handle->reordered_buffer_size < ntiles*tile_size )
+   {
+      XRIF_ERROR_PRINT("xrif_encode_tiles", "reordered buffer is too small");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   char *compressed_buffer;
+   size_t compressed_size;
+   
+   if(handle->compress_on_raw) 
+   {
+      compressed_buffer = handle->raw_buffer;
+      compressed_size = handle->raw_buffer_size;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+      compressed_size = handle->compressed_buffer_size;
+   }
+   
+   if(compressed_buffer == NULL || compressed_size < xrif_min_compressed_size(handle))
+   {
+      XRIF_ERROR_PRINT("xrif_encode_tiles", "compressed buffer is too small");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   //Set up chaining as xrif_difference does.  The raw buffer is read until the last tile is done, so the last frame is saved afterwards.
+   if(handle->chain_cubes)
+   {
+      xrif_error_t rv = xrif_allocate_chain(handle);
+      if(rv != XRIF_NOERROR)
+      {
+         XRIF_ERROR_PRINT("xrif_encode_tiles", "error from xrif_allocate_chain");
+         return rv;
+      }
+   }
+   
+   handle->chained = (handle->chain_cubes && handle->chain_encode_valid && (method == XRIF_DIFFERENCE_PREVIOUS || method == XRIF_DIFFERENCE_FIRST));
+   
+   xrif_error_t rv = xrif_allocate_lz4_state(handle);
+   if(rv != XRIF_NOERROR)
+   {
+      XRIF_ERROR_PRINT("xrif_encode_tiles", "error from xrif_allocate_lz4_state");
+      return rv;
+   }
+   
+   //The tile table can't be written until the raw buffer has been read, since they may be the same memory
+   uint32_t * sizes = (uint32_t *) malloc(ntiles*sizeof(uint32_t));
+   if(sizes == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_encode_tiles", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   int simd = xrif_simd_level();
+   int nomem = 0;
+   int nskipped = 0;
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp parallel if (handle->omp_parallel > 0) 
+   {
+   #endif
+   
+   char * res = (char *) malloc(tile_size);
+   char * tb = (char *) malloc(tile_size);
+   
+   if(res == NULL || tb == NULL)
+   {
+      #ifndef XRIF_NO_OMP
+      #pragma omp atomic write
+      #endif
+      nomem = 1;
+   }
+   
+   int thread = 0;
+   #if !defined(XRIF_NO_OMP) && defined(_OPENMP)
+   thread = omp_get_thread_num();
+   #endif
+   
+   #ifndef XRIF_NO_OMP
+   #pragma omp for schedule(dynamic) reduction(+:nskipped)
+   #endif
+   for(size_t k = 0; k < ntiles; ++k)
+   {
+      if(res == NULL || tb == NULL) continue;
+      
+      size_t r = k*tpix;
+      size_t n = (r + tpix <= npix) ? tpix : npix - r;
+      int len = xrif_tile_bytes(handle, reorder, n);
+      
+      xrif_tile_reorder( tb, res, handle, method, reorder, r, n, simd);
+      
+      char * slot = handle->reordered_buffer + k*tile_size;
+      int csize = 0;
+      
+      if(handle->skip_entropy > 0 && xrif_sample_entropy(tb, len) >= handle->skip_entropy) ++nskipped;
+      else
+      {
+         //Limiting the output to less than the tile lets LZ4 give up as soon as the tile can't shrink
+         csize = xrif_lz4_compress_state( handle, thread, tb, slot, len, len - 1);
+      }
+      
+      if(csize > 0)
+      {
+         sizes[k] = csize;
+      }
+      else
+      {
+         //Store the tile as is
+         memcpy(slot, tb, len);
+         sizes[k] = len | XRIF_BLOCK_RAW;
+      }
+   }
+   
+   free(res);
+   free(tb);
+   
+   #ifndef XRIF_NO_OMP
+   }
+   #endif
+   
+   if(nomem)
+   {
+      free(sizes);
+      XRIF_ERROR_PRINT("xrif_encode_tiles", "error allocating tile buffers");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   //The last frame is the reference for the next cube.  It has to be saved before the compressed data overwrites the raw buffer.
+   if(handle->chain_cubes)
+   {
+      memcpy(handle->chain_buffer, handle->raw_buffer + (handle->frames-1)*one_frame, one_frame);
+   }
+   
+   //Now write the table and pack the tiles after it
+   uint32_t * table = (uint32_t *) compressed_buffer;
+   table[0] = ntiles;
+   
+   size_t pos = table_size;
+   for(size_t k = 0; k < ntiles; ++k)
+   {
+      size_t csize = sizes[k] & ~XRIF_BLOCK_RAW;
+      
+      table[1+k] = sizes[k];
+      memcpy(compressed_buffer + pos, handle->reordered_buffer + k*tile_size, csize);
+      pos += csize;
+   }
+   
+   free(sizes);
+   
+   handle->compressed_size = pos;
+   handle->compress_skipped = nskipped;
+   
+   //Tiles are independent, so a streamed cube after this one can not use it as a dictionary
+   handle->lz4_chained = 0;
+   handle->lz4_dict_encode_size = 0;
+   
+   return XRIF_NOERROR;
+}
+
+xrif_error_t xrif_decode_tiles( xrif_t handle )
+{
+   if( handle == NULL) 
+   {
+      XRIF_ERROR_PRINT("xrif_decode_tiles", "can not use a null pointer");
+      return XRIF_ERROR_NULLPTR;
+   }
+   
+   if(!xrif_tiled(handle))
+   {
+      XRIF_ERROR_PRINT("xrif_decode_tiles", "tiled decoding not implemented for this configuration");
+      return XRIF_ERROR_NOTIMPL;
+   }
+   
+   if( handle->raw_buffer == NULL || handle->width*handle->height*handle->depth*handle->frames == 0 || handle->type_code == 0)
+   {
+      XRIF_ERROR_PRINT("xrif_decode_tiles", "handle not set up");
+      return XRIF_ERROR_NOT_SETUP;
+   }
+   
+   int method = handle->difference_method;
+   if(method == 0) method = XRIF_DIFFERENCE_DEFAULT;
+   
+   int reorder = handle->reorder_method;
+   if(reorder == 0) reorder = XRIF_REORDER_DEFAULT;
+   
+   size_t fpix = handle->width*handle->height*handle->depth;
+   size_t one_frame = fpix*handle->data_size; //bytes
+   size_t npix = fpix*handle->frames;
+   
+   size_t tile_size = handle->tile_size;
+   size_t tpix = tile_size / handle->data_size;
+   size_t ntiles = xrif_ntiles(handle);
+   size_t table_size = XRIF_BLOCK_TABLE_SIZE(ntiles);
+   
+   if( handle->raw_buffer_size < one_frame*handle->frames )
+   {
+      XRIF_ERROR_PRINT("xrif_decode_tiles", "raw buffer is too small");
+      return XRIF_ERROR_INSUFFICIENT_SIZE;
+   }
+   
+   const char * compressed_buffer;
+   
+   if(handle->compress_on_raw) 
+   {
+      //The tiles are decoded into the raw buffer, so the compressed data is moved out of the way first
+      if(handle->reordered_buffer == NULL || handle->reordered_buffer_size < handle->compressed_size)
+      {
+         XRIF_ERROR_PRINT("xrif_decode_tiles", "reordered buffer is too small");
+         return XRIF_ERROR_INSUFFICIENT_SIZE;
+      }
+      
+      memcpy(handle->reordered_buffer, handle->raw_buffer, handle->compressed_size);
+      compressed_buffer = handle->reordered_buffer;
+   }
+   else 
+   {
+      compressed_buffer = handle->compressed_buffer;
+   }
+   
+   const uint32_t * table = (const uint32_t *) compressed_buffer;
+   
+   if(compressed_buffer == NULL || ntiles == 0 || handle->compressed_size < table_size || table[0] != ntiles)
+   {
+      XRIF_ERROR_PRINT("xrif_decode_tiles", "tile table does not match configuration");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   //The reference must be the right size.  xrif_decode has already checked that it comes from the previous cube in the chain.
+   if( handle->chained && (handle->chain_buffer == NULL || handle->chain_buffer_size != 3*one_frame) )
+   {
+      XRIF_ERROR_PRINT("xrif_decode_tiles", "reference for chained cube not available");
+      return XRIF_ERROR_NOREFERENCE;
+   }
+   
+   char * tb = (char *) malloc(tile_size);
+   if(tb == NULL)
+   {
+      XRIF_ERROR_PRINT("xrif_decode_tiles", "error from malloc");
+      return XRIF_ERROR_MALLOC;
+   }
+   
+   int simd = xrif_simd_level();
+   int nfail = 0;
+   
+   size_t pos = table_size;
+   for(size_t k = 0; k < ntiles; ++k)
+   {
+      size_t r = k*tpix;
+      size_t n = (r + tpix <= npix) ? tpix : npix - r;
+      int len = xrif_tile_bytes(handle, reorder, n);
+      
+      size_t csize = table[1+k] & ~XRIF_BLOCK_RAW;
+      
+      if(pos + csize > handle->compressed_size)
+      {
+         nfail = 1;
+         break;
+      }
+      
+      if(table[1+k] & XRIF_BLOCK_RAW)
+      {
+         if(csize != (size_t) len) nfail = 1;
+         else memcpy(tb, compressed_buffer + pos, len);
+      }
+      else if(LZ4_decompress_safe( compressed_buffer + pos, tb, csize, len) != len)
+      {
+         nfail = 1;
+      }
+      
+      if(nfail) break;
+      
+      pos += csize;
+      
+      if(handle->data_size == 2) xrif_untile_sint16( handle, method, reorder, tb, r, n, simd);
+      else if(handle->data_size == 4) xrif_untile_sint32( handle, method, tb, r, n, simd);
+      else xrif_untile_sint64( handle, method, tb, r, n, simd);
+   }
+   
+   free(tb);
+   
+   if(nfail || pos != handle->compressed_size)
+   {
+      XRIF_ERROR_PRINT("xrif_decode_tiles", "tile table does not match compressed data");
+      return XRIF_ERROR_INVALID_SIZE;
+   }
+   
+   //Keep the last frame as the reference for the next cube.
+   if(handle->chain_cubes)
+   {
+      xrif_error_t rv = xrif_allocate_chain(handle);
+      if(rv != XRIF_NOERROR)
+      {
+         XRIF_ERROR_PRINT("xrif_decode_tiles", "error from xrif_allocate_chain");
+         return rv;
+      }
+      
+      memcpy(handle->chain_buffer + 2*one_frame, handle->raw_buffer + (handle->frames-1)*one_frame, one_frame);
+   }
+   
+   return XRIF_NOERROR;
+}
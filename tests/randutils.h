@@ -260,3 +260,60 @@ int fill_uint64_white( uint64_t * buffer,
    
    return 0;
 }
+
+//Fill a half precision buffer with random bit patterns
+int fill_half_white( uint16_t * buffer,
+                     size_t size,
+                     uint16_t start
+                   )
+{
+   (void) start;
+   
+   if(buffer == NULL) return -1;
+   if(size < 1) return -1;
+   
+   for( size_t i = 0; i < size; ++i ) 
+   {
+      buffer[i] = rand32bits() & 0xFFFF;
+   }
+   
+   return 0;
+}
+
+//Fill a float buffer with white noise of both signs
+int fill_float_white( float * buffer,
+                      size_t size,
+                      float start
+                    )
+{
+   (void) start;
+   
+   if(buffer == NULL) return -1;
+   if(size < 1) return -1;
+   
+   for( size_t i = 0; i < size; ++i ) 
+   {
+      buffer[i] = (((double) rand())/RAND_MAX - 0.5)*2000;
+   }
+   
+   return 0;
+}
+
+//Fill a double buffer with white noise of both signs
+int fill_double_white( double * buffer,
+                       size_t size,
+                       double start
+                     )
+{
+   (void) start;
+   
+   if(buffer == NULL) return -1;
+   if(size < 1) return -1;
+   
+   for( size_t i = 0; i < size; ++i ) 
+   {
+      buffer[i] = (((double) rand())/RAND_MAX - 0.5)*2000 + ((double) rand())/RAND_MAX*1e-6;
+   }
+   
+   return 0;
+}
@@ -10,6 +10,12 @@
    #define XRIF_TESTLOOP_TYPE int64_t
 #elif XRIF_TESTLOOP_TYPECODE == XRIF_TYPECODE_UINT64
    #define XRIF_TESTLOOP_TYPE uint64_t
+#elif XRIF_TESTLOOP_TYPECODE == XRIF_TYPECODE_HALF
+   #define XRIF_TESTLOOP_TYPE uint16_t
+#elif XRIF_TESTLOOP_TYPECODE == XRIF_TYPECODE_FLOAT
+   #define XRIF_TESTLOOP_TYPE float
+#elif XRIF_TESTLOOP_TYPECODE == XRIF_TYPECODE_DOUBLE
+   #define XRIF_TESTLOOP_TYPE double
 #endif
 
 #if XRIF_TESTLOOP_FILL == 0
@@ -42,6 +48,12 @@
    #define XRIF_TESTLOOP_FILL_FUNC fill_int64_white
 #elif XRIF_TESTLOOP_TYPECODE == XRIF_TYPECODE_UINT64
    #define XRIF_TESTLOOP_FILL_FUNC fill_uint64_white
+#elif XRIF_TESTLOOP_TYPECODE == XRIF_TYPECODE_HALF
+   #define XRIF_TESTLOOP_FILL_FUNC fill_half_white
+#elif XRIF_TESTLOOP_TYPECODE == XRIF_TYPECODE_FLOAT
+   #define XRIF_TESTLOOP_FILL_FUNC fill_float_white
+#elif XRIF_TESTLOOP_TYPECODE == XRIF_TYPECODE_DOUBLE
+   #define XRIF_TESTLOOP_FILL_FUNC fill_double_white
 #endif
 
 #endif
@@ -54,6 +66,16 @@
    #define XRIF_TESTLOOP_DIFF_STR "first"
 #elif XRIF_TESTLOOP_DIFFERENCE == XRIF_DIFFERENCE_PIXEL
    #define XRIF_TESTLOOP_DIFF_STR "pixel"
+#elif XRIF_TESTLOOP_DIFFERENCE == XRIF_DIFFERENCE_MED || XRIF_TESTLOOP_DIFFERENCE == XRIF_DIFFERENCE_PAETH || XRIF_TESTLOOP_DIFFERENCE == XRIF_DIFFERENCE_AVERAGE
+   #define XRIF_TESTLOOP_DIFF_STR "spatial"
+#elif XRIF_TESTLOOP_DIFFERENCE == XRIF_DIFFERENCE_PREVIOUS_MED
+   #define XRIF_TESTLOOP_DIFF_STR "previous_med"
+#elif XRIF_TESTLOOP_DIFFERENCE == XRIF_DIFFERENCE_LINEAR
+   #define XRIF_TESTLOOP_DIFF_STR "linear"
+#elif XRIF_TESTLOOP_DIFFERENCE == XRIF_DIFFERENCE_REFERENCE
+   #define XRIF_TESTLOOP_DIFF_STR "reference"
+#elif XRIF_TESTLOOP_DIFFERENCE == XRIF_DIFFERENCE_ADAPTIVE
+   #define XRIF_TESTLOOP_DIFF_STR "adaptive"
 #endif
 
 #if XRIF_TESTLOOP_REORDER == XRIF_REORDER_NONE
@@ -70,6 +92,12 @@
    #define XRIF_TESTLOOP_COMP_STR "none"
 #elif XRIF_TESTLOOP_COMPRESS == XRIF_COMPRESS_LZ4
    #define XRIF_TESTLOOP_COMP_STR "lz4"
+#elif XRIF_TESTLOOP_COMPRESS == XRIF_COMPRESS_LZ4HC
+   #define XRIF_TESTLOOP_COMP_STR "lz4hc"
+#elif XRIF_TESTLOOP_COMPRESS == XRIF_COMPRESS_ZSTD
+   #define XRIF_TESTLOOP_COMP_STR "zstd"
+#elif XRIF_TESTLOOP_COMPRESS == XRIF_COMPRESS_RANS
+   #define XRIF_TESTLOOP_COMP_STR "rans"
 #endif
 
    xrif_t hand = NULL;
@@ -109,6 +137,11 @@
                
                hand->omp_parallel = 0;
                
+               //Optional extra configuration of the handle, e.g. method parameters
+               #ifdef XRIF_TESTLOOP_SETUP
+               XRIF_TESTLOOP_SETUP
+               #endif
+               
                rv = xrif_allocate_raw(hand);
                ck_assert( rv == XRIF_NOERROR );
       
@@ -196,3 +229,4 @@
 #undef XRIF_TESTLOOP_ENCODE
 #undef XRIF_TESTLOOP_DECODE
 #undef XRIF_TESTLOOP_NOPERF
+#undef XRIF_TESTLOOP_SETUP
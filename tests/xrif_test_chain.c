@@ -0,0 +1,697 @@
+/** \file xrif_test_chain.c
+  * \brief Test the xrif cube chaining 
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <limits.h>
+
+#include "../src/xrif.h"
+
+#ifndef XRIF_TEST_TRIALS
+   #define XRIF_TEST_TRIALS (2)
+#endif
+
+int test_trials;
+
+/************************************************************/
+/* Encoding and decoding sequences of chained cubes
+/************************************************************/
+
+int ws[] = {2,4,21,64}; //widths of images
+int hs[] = {2,4,33,64}; //heights of images
+int ps[] = {1,2,5,32}; //planes of the cube
+
+#define NCUBES (6)
+#define KEYFRAME (3)
+
+//Fill a buffer with white noise bytes
+void fill_bytes_white( char * buffer,
+                       size_t size
+                     )
+{
+   for(size_t i = 0; i < size; ++i)
+   {
+      buffer[i] = rand();
+   }
+}
+
+/* Encode a sequence of NCUBES cubes with one handle, and decode them with another, passing the data
+ * through the header and the compressed buffer as an archive file would.  The cube KEYFRAME is made a keyframe.
+ * Returns the number of cubes which did not match.
+ */
+int chain_sequence( xrif_typecode_t type_code,
+                    int difference_method,
+                    int reorder_method,
+                    int compress_method,
+                    int chain_cubes,
+                    int lz4_stream,
+                    int omp
+                  )
+{
+   int can_chain = (chain_cubes && (difference_method == XRIF_DIFFERENCE_PREVIOUS || difference_method == XRIF_DIFFERENCE_FIRST));
+   int can_stream = (lz4_stream && (compress_method == XRIF_COMPRESS_LZ4 || compress_method == XRIF_COMPRESS_LZ4HC));
+   
+
+   int fail = 0;
+   
+   for(int w =0; w < sizeof(ws)/sizeof(ws[0]); ++w)
+   {
+      for(int h=0; h < sizeof(hs)/sizeof(hs[0]); ++h)
+      {
+         for(int p=0; p< sizeof(ps)/sizeof(ps[0]); ++p)
+         {
+            xrif_t enc = NULL;
+            xrif_t dec = NULL;
+            
+            xrif_error_t rv = xrif_new(&enc);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_new(&dec);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_set_size(enc, ws[w], hs[h], 1, ps[p], type_code);
+            ck_assert( rv == XRIF_NOERROR );
+      
+            rv = xrif_configure(enc, difference_method, reorder_method, compress_method);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_set_chain_cubes(enc, chain_cubes);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_set_chain_cubes(dec, chain_cubes);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_set_lz4_stream(enc, lz4_stream);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_set_lz4_stream(dec, lz4_stream);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            enc->omp_parallel = omp;
+            dec->omp_parallel = omp;
+            
+            rv = xrif_allocate(enc);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            size_t cube_size = enc->width*enc->height*enc->frames*enc->data_size;
+            
+            char * orig = (char *) malloc(cube_size);
+            ck_assert( orig != NULL );
+            
+            for(int c = 0; c < NCUBES; ++c)
+            {
+               fill_bytes_white(enc->raw_buffer, cube_size);
+               memcpy(orig, enc->raw_buffer, cube_size);
+               
+               if(c == KEYFRAME) 
+               {
+                  rv = xrif_keyframe(enc);
+                  ck_assert( rv == XRIF_NOERROR );
+               }
+               
+               rv = xrif_encode(enc);
+               ck_assert( rv == XRIF_NOERROR );
+               
+               ck_assert_int_eq( enc->chained, (can_chain && c != 0 && c != KEYFRAME) );
+               ck_assert_int_eq( enc->lz4_chained, (can_stream && c != 0 && c != KEYFRAME) );
+               ck_assert_int_eq( enc->chain_index, (chain_cubes || lz4_stream) ? c % KEYFRAME : 0 );
+               
+               char header[XRIF_HEADER_SIZE];
+               rv = xrif_write_header(header, enc);
+               ck_assert( rv == XRIF_NOERROR );
+               
+               uint32_t header_size;
+               rv = xrif_read_header(dec, &header_size, header);
+               ck_assert( rv == XRIF_NOERROR );
+               
+               if(c == 0)
+               {
+                  rv = xrif_allocate(dec);
+                  ck_assert( rv == XRIF_NOERROR );
+               }
+               
+               memcpy(dec->raw_buffer, enc->raw_buffer, enc->compressed_size);
+               
+               rv = xrif_decode(dec);
+               ck_assert( rv == XRIF_NOERROR );
+               
+               if(memcmp(dec->raw_buffer, orig, cube_size) != 0)
+               {
+                  ++fail;
+                  fprintf(stderr, "failure: %s/%s/%s %d %d %d cube %d\n", xrif_difference_method_string(difference_method), 
+                                                                        xrif_reorder_method_string(reorder_method), 
+                                                                           xrif_compress_method_string(compress_method), ws[w], hs[h], ps[p], c);
+               }
+            }
+            
+            free(orig);
+            
+            rv = xrif_delete(enc);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_delete(dec);
+            ck_assert( rv == XRIF_NOERROR );
+         }//p
+      }//h
+   }//w
+   
+   return fail;
+}
+
+/** Verify chained encoding and decoding with previous differencing
+  * Verify that a sequence of chained cubes, with a keyframe in the middle, can be decoded for 16 bit types, and for float.
+  * This includes bitpack with pixel counts which are not a multiple of 8, where a chained cube needs more reordered space.
+  * \anchor chain_previous_int16_white
+  */
+START_TEST (chain_previous_int16_white)
+{
+   fprintf(stderr, "Testing cube chaining with previous differencing for 16-bit white noise.\n");
+   
+   int fail = 0;
+   for(int q = 0; q < test_trials; ++q)
+   {
+      fail += chain_sequence(XRIF_TYPECODE_INT16, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4, 1, 0, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_UINT16, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK_RENIBBLE, XRIF_COMPRESS_LZ4, 1, 0, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_INT16, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_NONE, XRIF_COMPRESS_NONE, 1, 0, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_INT16, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BITPACK, XRIF_COMPRESS_LZ4, 1, 0, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_FLOAT, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4, 1, 0, q % 2);
+   }
+   
+   ck_assert( fail == 0 );
+}
+END_TEST;
+
+/** Verify chained encoding and decoding with first differencing
+  * Verify that a sequence of chained cubes, with a keyframe in the middle, can be decoded for 32 and 64 bit types, including floating point,
+  * and for 16 bit bitpack together with the LZ4 stream.
+  * \anchor chain_first_white
+  */
+START_TEST (chain_first_white)
+{
+   fprintf(stderr, "Testing cube chaining with first differencing for 32 and 64-bit white noise.\n");
+   
+   int fail = 0;
+   for(int q = 0; q < test_trials; ++q)
+   {
+      fail += chain_sequence(XRIF_TYPECODE_INT32, XRIF_DIFFERENCE_FIRST, XRIF_REORDER_NONE, XRIF_COMPRESS_LZ4, 1, 0, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_UINT64, XRIF_DIFFERENCE_FIRST, XRIF_REORDER_NONE, XRIF_COMPRESS_LZ4, 1, 0, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_UINT16, XRIF_DIFFERENCE_FIRST, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4, 1, 0, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_DOUBLE, XRIF_DIFFERENCE_FIRST, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4, 1, 0, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_UINT16, XRIF_DIFFERENCE_FIRST, XRIF_REORDER_BITPACK, XRIF_COMPRESS_LZ4, 1, 1, q % 2);
+   }
+   
+   ck_assert( fail == 0 );
+}
+END_TEST;
+
+/** Verify a chained cube can not be decoded without its reference
+  * Verify that decoding a chained cube fails on a new handle, and after skipping a cube, and that decoding 
+  * resumes at the next keyframe.
+  * \anchor chain_noreference
+  */
+START_TEST (chain_noreference)
+{
+   xrif_t enc = NULL;
+   xrif_t dec = NULL;
+   
+   xrif_error_t rv = xrif_new(&enc);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_new(&dec);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(enc, 32, 32, 1, 8, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_chain_cubes(enc, 1);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_allocate(enc);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_chain_cubes(dec, 1);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   size_t cube_size = enc->width*enc->height*enc->frames*enc->data_size;
+   
+   char * orig = (char *) malloc(cube_size);
+   ck_assert( orig != NULL );
+   
+   //Cube 0 is a keyframe, cubes 1 and 2 are chained, cube 3 is a keyframe
+   for(int c = 0; c < 4; ++c)
+   {
+      fill_bytes_white(enc->raw_buffer, cube_size);
+      memcpy(orig, enc->raw_buffer, cube_size);
+      
+      if(c == 3) xrif_keyframe(enc);
+      
+      rv = xrif_encode(enc);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      if(c == 0) continue; //the decoder never sees the first keyframe
+      
+      char header[XRIF_HEADER_SIZE];
+      rv = xrif_write_header(header, enc);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      uint32_t header_size;
+      rv = xrif_read_header(dec, &header_size, header);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      if(c == 1)
+      {
+         rv = xrif_allocate(dec);
+         ck_assert( rv == XRIF_NOERROR );
+      }
+      
+      memcpy(dec->raw_buffer, enc->raw_buffer, enc->compressed_size);
+      
+      rv = xrif_decode(dec);
+      
+      if(c < 3)
+      {
+         //Cube 1 has no reference at all, and cube 2 references cube 1 which was not decoded
+         ck_assert_int_eq( rv, XRIF_ERROR_NOREFERENCE );
+      }
+      else
+      {
+         ck_assert_int_eq( rv, XRIF_NOERROR );
+         ck_assert( memcmp(dec->raw_buffer, orig, cube_size) == 0 );
+      }
+   }
+   
+   free(orig);
+   
+   rv = xrif_delete(enc);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_delete(dec);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
+/** Verify that chaining improves compression of a static scene
+  * Verify that a chained cube compresses better than a keyframe when successive frames are nearly identical.
+  * \anchor chain_ratio
+  */
+START_TEST (chain_ratio)
+{
+   xrif_t enc = NULL;
+   
+   xrif_error_t rv = xrif_new(&enc);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(enc, 64, 64, 1, 8, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_chain_cubes(enc, 1);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_allocate(enc);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   size_t npix = enc->width*enc->height;
+   
+   int16_t * scene = (int16_t *) malloc(npix*sizeof(int16_t));
+   ck_assert( scene != NULL );
+   
+   for(size_t i = 0; i < npix; ++i) scene[i] = rand();
+   
+   size_t sizes[2];
+   
+   for(int c = 0; c < 2; ++c)
+   {
+      int16_t * rb = (int16_t *) enc->raw_buffer;
+      
+      for(size_t n = 0; n < enc->frames; ++n)
+      {
+         for(size_t i = 0; i < npix; ++i) rb[n*npix + i] = scene[i] + rand() % 4;
+      }
+      
+      rv = xrif_encode(enc);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      sizes[c] = enc->compressed_size;
+   }
+   
+   //The keyframe has to store the scene, the chained cube does not
+   ck_assert( sizes[1] < sizes[0] );
+   
+   free(scene);
+   
+   rv = xrif_delete(enc);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
+/** Verify LZ4 streaming across cubes
+  * Verify that a sequence of cubes compressed with LZ4 streaming, with a keyframe in the middle, can be decoded, 
+  * alone and together with cube chaining, and that a repeated cube compresses better against the previous one.
+  * \anchor chain_lz4_stream
+  */
+START_TEST (chain_lz4_stream)
+{
+   fprintf(stderr, "Testing LZ4 streaming across cubes for white noise.\n");
+   
+   int fail = 0;
+   for(int q = 0; q < test_trials; ++q)
+   {
+      fail += chain_sequence(XRIF_TYPECODE_INT16, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4, 0, 1, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_INT16, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4HC, 0, 1, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_UINT16, XRIF_DIFFERENCE_FIRST, XRIF_REORDER_BYTEPACK_RENIBBLE, XRIF_COMPRESS_LZ4, 1, 1, q % 2);
+      fail += chain_sequence(XRIF_TYPECODE_INT32, XRIF_DIFFERENCE_PIXEL, XRIF_REORDER_NONE, XRIF_COMPRESS_LZ4HC, 1, 1, q % 2);
+   }
+   
+   ck_assert( fail == 0 );
+   
+   //A small cube repeated exactly should be found in the dictionary
+   xrif_t enc = NULL;
+   
+   xrif_error_t rv = xrif_new(&enc);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(enc, 16, 16, 1, 4, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_lz4_stream(enc, 1);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_allocate(enc);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   size_t cube_size = enc->width*enc->height*enc->frames*enc->data_size;
+   
+   char * orig = (char *) malloc(cube_size);
+   ck_assert( orig != NULL );
+   
+   fill_bytes_white(orig, cube_size);
+   
+   size_t sizes[2];
+   
+   for(int c = 0; c < 2; ++c)
+   {
+      memcpy(enc->raw_buffer, orig, cube_size);
+      
+      rv = xrif_encode(enc);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      sizes[c] = enc->compressed_size;
+   }
+   
+   ck_assert( enc->lz4_chained == 1 );
+   ck_assert( 4*sizes[1] < sizes[0] );
+   
+   free(orig);
+   
+   rv = xrif_delete(enc);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
+/** Verify the key frame interval between chained cubes
+  * Verify that a sequence of cubes alternating between a key frame interval and none can be encoded and decoded through the header
+  * with each temporal difference method.  Chaining and LZ4 streaming are turned off for the cubes with a key frame interval, which can not use them,
+  * and back on for the others.
+  * \anchor encode_keyframes
+  */
+START_TEST (encode_keyframes)
+{
+   fprintf(stderr, "Testing the key frame interval between chained cubes for white noise.\n");
+   
+   int methods[] = {XRIF_DIFFERENCE_PREVIOUS, XRIF_DIFFERENCE_FIRST, XRIF_DIFFERENCE_PREVIOUS_MED, XRIF_DIFFERENCE_LINEAR};
+   int intervals[] = {1, 2, 3, 7};
+   
+   int fail = 0;
+   for(int q = 0; q < test_trials; ++q)
+   {
+      for(int m = 0; m < sizeof(methods)/sizeof(methods[0]); ++m)
+      {
+         for(int k = 0; k < sizeof(intervals)/sizeof(intervals[0]); ++k)
+         {
+            xrif_t enc = NULL;
+            xrif_t dec = NULL;
+            
+            xrif_error_t rv = xrif_new(&enc);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_new(&dec);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_set_size(enc, 33, 21, 1, 16, (q % 2 == 0) ? XRIF_TYPECODE_INT16 : XRIF_TYPECODE_UINT32);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_configure(enc, methods[m], XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_set_chain_cubes(enc, 1);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_set_chain_cubes(dec, 1);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_set_lz4_stream(enc, 1);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_set_lz4_stream(dec, 1);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            enc->omp_parallel = 1;
+            enc->omp_min_pixels = 0;
+            dec->omp_parallel = 1;
+            
+            rv = xrif_allocate(enc);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            size_t cube_size = enc->width*enc->height*enc->frames*enc->data_size;
+            
+            char * orig = (char *) malloc(cube_size);
+            ck_assert( orig != NULL );
+            
+            for(int c = 0; c < NCUBES; ++c)
+            {
+               xrif_dimension_t interval = (c % 2 == 0) ? intervals[k] : 0;
+               
+               //Key frames need chaining and streaming to be off, since the interval takes the place of the chain index
+               if(interval > 0)
+               {
+                  rv = xrif_set_keyframe_interval(enc, interval);
+                  ck_assert( rv == XRIF_ERROR_BADARG );
+                  
+                  rv = xrif_set_chain_cubes(enc, 0);
+                  ck_assert( rv == XRIF_NOERROR );
+                  
+                  rv = xrif_set_lz4_stream(enc, 0);
+                  ck_assert( rv == XRIF_NOERROR );
+                  
+                  rv = xrif_set_keyframe_interval(enc, interval);
+                  ck_assert( rv == XRIF_NOERROR );
+               }
+               else
+               {
+                  rv = xrif_set_keyframe_interval(enc, 0);
+                  ck_assert( rv == XRIF_NOERROR );
+                  
+                  rv = xrif_set_chain_cubes(enc, 1);
+                  ck_assert( rv == XRIF_NOERROR );
+                  
+                  rv = xrif_set_lz4_stream(enc, 1);
+                  ck_assert( rv == XRIF_NOERROR );
+               }
+               
+               fill_bytes_white(enc->raw_buffer, cube_size);
+               memcpy(orig, enc->raw_buffer, cube_size);
+               
+               rv = xrif_encode(enc);
+               ck_assert( rv == XRIF_NOERROR );
+               
+               if(interval > 0)
+               {
+                  ck_assert_int_eq( enc->chained, 0 );
+                  ck_assert_int_eq( enc->lz4_chained, 0 );
+                  ck_assert_int_eq( enc->chain_index, 0 );
+               }
+               
+               char header[XRIF_HEADER_SIZE];
+               rv = xrif_write_header(header, enc);
+               ck_assert( rv == XRIF_NOERROR );
+               
+               uint32_t header_size;
+               rv = xrif_read_header(dec, &header_size, header);
+               ck_assert( rv == XRIF_NOERROR );
+               ck_assert_int_eq( dec->keyframe_interval, interval );
+               
+               if(c == 0)
+               {
+                  rv = xrif_allocate(dec);
+                  ck_assert( rv == XRIF_NOERROR );
+               }
+               
+               memcpy(dec->raw_buffer, enc->raw_buffer, enc->compressed_size);
+               
+               rv = xrif_decode(dec);
+               ck_assert( rv == XRIF_NOERROR );
+               
+               if(memcmp(dec->raw_buffer, orig, cube_size) != 0)
+               {
+                  ++fail;
+                  fprintf(stderr, "failure: %s key frame interval %d cube %d\n", xrif_difference_method_string(methods[m]), (int) interval, c);
+               }
+            }
+            
+            free(orig);
+            
+            rv = xrif_delete(enc);
+            ck_assert( rv == XRIF_NOERROR );
+            
+            rv = xrif_delete(dec);
+            ck_assert( rv == XRIF_NOERROR );
+         }//k
+      }//m
+   }//q
+   
+   ck_assert( fail == 0 );
+}
+END_TEST;
+
+Suite * chain_suite(void)
+{
+    Suite *s;
+    TCase *tc_chain;
+
+    s = suite_create("Cube Chaining");
+
+    /* Chaining test case */
+    tc_chain = tcase_create("Chained white noise");
+
+    tcase_set_timeout(tc_chain, 1e9);
+    
+    tcase_add_test(tc_chain, chain_previous_int16_white);
+    tcase_add_test(tc_chain, chain_first_white);
+    tcase_add_test(tc_chain, chain_noreference);
+    tcase_add_test(tc_chain, chain_ratio);
+    tcase_add_test(tc_chain, chain_lz4_stream);
+    tcase_add_test(tc_chain, encode_keyframes);
+    
+    suite_add_tcase(s, tc_chain);
+    
+    return s;
+}
+
+int main( int argc,
+          char ** argv
+        )
+{
+   
+   extern int test_trials;
+   
+   test_trials = XRIF_TEST_TRIALS;
+   
+   if(argc == 2)
+   {
+      test_trials = atoi(argv[1]);
+   }
+   
+   fprintf(stderr, "running %d trials per format\n", test_trials);
+   
+   int number_failed;
+   Suite *s;
+   SRunner *sr;
+
+   // Intialize the random number sequence
+   srand((unsigned) time(NULL));
+
+   s = chain_suite();
+   sr = srunner_create(s);
+
+   srunner_run_all(sr, CK_NORMAL);
+   number_failed = srunner_ntests_failed(sr);
+   srunner_free(sr);
+   
+   return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+   
+}
@@ -0,0 +1,987 @@
+/** \file xrif_test_compress_whitenoise.c
+  * \brief Test the compression methods with white noise.
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_test_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2019, 2020, 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <limits.h>
+#include <math.h>
+
+#include "../src/xrif.h"
+
+#include "randutils.h"
+
+#ifndef XRIF_TEST_TRIALS
+   #define XRIF_TEST_TRIALS (2)
+#endif
+
+int test_trials;
+
+/************************************************************/
+/* Fuzz testing the full encode/decode cycle with each compression method
+/************************************************************/
+
+int ws[] = {2,4,8,21, 33, 47, 64}; //widths of images
+int hs[] = {2,4,8,21, 33, 47, 64}; //heights of images
+int ps[] = {1,2,4,5,27,63,64}; //planes of the cube
+
+/** Verify LZ4HC compression for int16_t
+  * Verify that the xrif encode/decode cycle using LZ4HC works with white noise for int16_t.
+  * \anchor compress_lz4hc_int16_white
+  */
+START_TEST (compress_lz4hc_int16_white)
+{
+   fprintf(stderr, "Testing LZ4HC compression for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4HC)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify LZ4HC compression for uint16_t at the minimum and maximum levels
+  * Verify that the xrif encode/decode cycle using LZ4HC works with white noise for uint16_t, at the level limits.
+  * \anchor compress_lz4hc_uint16_white
+  */
+START_TEST (compress_lz4hc_uint16_white)
+{
+   fprintf(stderr, "Testing LZ4HC compression for unsigned 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4HC)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP rv = xrif_set_lz4hc_level(hand, (q % 2 == 0) ? XRIF_LZ4HC_LEVEL_MIN : XRIF_LZ4HC_LEVEL_MAX); ck_assert( rv == XRIF_NOERROR );
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify block LZ4 compression for int16_t
+  * Verify that the xrif encode/decode cycle using LZ4 with independent blocks works with white noise for int16_t, serial and in parallel.
+  * \anchor compress_lz4_blocks_int16_white
+  */
+START_TEST (compress_lz4_blocks_int16_white)
+{
+   fprintf(stderr, "Testing block LZ4 compression for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP rv = xrif_set_compress_block_size(hand, XRIF_COMPRESS_BLOCK_UNIT); ck_assert( rv == XRIF_NOERROR ); hand->omp_parallel = q % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify block LZ4HC compression for uint16_t
+  * Verify that the xrif encode/decode cycle using LZ4HC with independent blocks works with white noise for uint16_t, serial and in parallel.
+  * \anchor compress_lz4hc_blocks_uint16_white
+  */
+START_TEST (compress_lz4hc_blocks_uint16_white)
+{
+   fprintf(stderr, "Testing block LZ4HC compression for unsigned 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4HC)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP rv = xrif_set_compress_block_size(hand, 3*XRIF_COMPRESS_BLOCK_UNIT); ck_assert( rv == XRIF_NOERROR ); hand->omp_parallel = 1 - q % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify LZ4 compression with each hash table size for int16_t
+  * Verify that the xrif encode/decode cycle using LZ4 works with white noise for int16_t for each supported hash table size, with and without blocks.
+  * \anchor compress_lz4_memory_int16_white
+  */
+START_TEST (compress_lz4_memory_int16_white)
+{
+   fprintf(stderr, "Testing LZ4 compression hash table sizes for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP rv = xrif_set_lz4_memory_usage(hand, XRIF_LZ4_MEMORY_USAGE_MIN + 2*((w+h+p) % 5)); ck_assert( rv == XRIF_NOERROR ); \
+                               if(q % 2) { rv = xrif_set_compress_block_size(hand, XRIF_COMPRESS_BLOCK_UNIT); ck_assert( rv == XRIF_NOERROR ); hand->omp_parallel = 1; }
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify Zstandard compression for int16_t
+  * Verify that the xrif encode/decode cycle using Zstandard works with white noise for int16_t, at several levels and with worker threads.
+  * Only run if xrif was built with Zstandard.
+  * \anchor compress_zstd_int16_white
+  */
+START_TEST (compress_zstd_int16_white)
+{
+   #ifdef XRIF_USE_ZSTD
+   fprintf(stderr, "Testing zstd compression for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_ZSTD)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP rv = xrif_set_zstd_level(hand, -1 + 10*(q % 3)); ck_assert( rv == XRIF_NOERROR ); \
+                               rv = xrif_set_zstd_workers(hand, 2*(q % 2)); ck_assert( rv == XRIF_NOERROR );
+   
+   #include "testloop.c"
+   #else
+   fprintf(stderr, "Skipping zstd compression test, xrif was built without zstd.\n");
+   #endif
+}
+END_TEST;
+
+/** Verify rANS compression for int16_t
+  * Verify that the xrif encode/decode cycle using rANS works with white noise for int16_t, with the bytepack planes, serial and in parallel.
+  * \anchor compress_rans_int16_white
+  */
+START_TEST (compress_rans_int16_white)
+{
+   fprintf(stderr, "Testing rANS compression for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_RANS)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP hand->omp_parallel = q % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify rANS compression for uint16_t
+  * Verify that the xrif encode/decode cycle using rANS works with white noise for uint16_t, with pixel differencing and with a single plane.
+  * \anchor compress_rans_uint16_white
+  */
+START_TEST (compress_rans_uint16_white)
+{
+   fprintf(stderr, "Testing rANS compression for unsigned 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PIXEL)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_RANS)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP if(q % 2) { rv = xrif_set_reorder_method(hand, XRIF_REORDER_BYTEPACK_RENIBBLE); ck_assert( rv == XRIF_NOERROR ); }
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify that rANS compresses read noise better than LZ4
+  * Verify that for a constant scene with small random noise, rANS gives a smaller compressed size than LZ4.
+  * \anchor compress_rans_ratio
+  */
+START_TEST (compress_rans_ratio)
+{
+   size_t sizes[2];
+   int methods[2] = {XRIF_COMPRESS_LZ4, XRIF_COMPRESS_RANS};
+   
+   for(int m = 0; m < 2; ++m)
+   {
+      xrif_t hand = NULL;
+      
+      xrif_error_t rv = xrif_new(&hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_set_size(hand, 64, 64, 1, 16, XRIF_TYPECODE_INT16);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_configure(hand, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK, methods[m]);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_allocate(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      srand(1);
+      
+      int16_t * rb = (int16_t *) hand->raw_buffer;
+      for(size_t i = 0; i < hand->width*hand->height*hand->frames; ++i) rb[i] = 1000 + (rand() % 24) - 12;
+      
+      rv = xrif_encode(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      sizes[m] = hand->compressed_size;
+      
+      rv = xrif_delete(hand);
+      ck_assert( rv == XRIF_NOERROR );
+   }
+   
+   ck_assert( sizes[1] < sizes[0] );
+}
+END_TEST;
+
+/** Verify per-plane compression for int16_t
+  * Verify that the xrif encode/decode cycle with each plane compressed separately works with white noise for int16_t, with LZ4 and LZ4HC, serial and in parallel.
+  * \anchor compress_planes_int16_white
+  */
+START_TEST (compress_planes_int16_white)
+{
+   fprintf(stderr, "Testing per-plane compression for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP rv = xrif_set_compress_planes(hand, 1); ck_assert( rv == XRIF_NOERROR ); \
+                               if(q % 2) { rv = xrif_set_compress_method(hand, XRIF_COMPRESS_LZ4HC); ck_assert( rv == XRIF_NOERROR ); } \
+                               hand->omp_parallel = (q/2) % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify per-plane compression for uint16_t
+  * Verify that the xrif encode/decode cycle with each plane compressed separately works with white noise for uint16_t, with pixel differencing and with a single plane.
+  * \anchor compress_planes_uint16_white
+  */
+START_TEST (compress_planes_uint16_white)
+{
+   fprintf(stderr, "Testing per-plane compression for unsigned 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PIXEL)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP rv = xrif_set_compress_planes(hand, 1); ck_assert( rv == XRIF_NOERROR ); \
+                               if(q % 2) { rv = xrif_set_reorder_method(hand, XRIF_REORDER_BYTEPACK_RENIBBLE); ck_assert( rv == XRIF_NOERROR ); }
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify that incompressible planes are stored raw
+  * Verify that for a constant scene with noise, the noisy low byte plane is stored as is while the high byte plane is compressed,
+  * so that the compressed data is never larger than the plane table plus the reordered data.
+  * \anchor compress_planes_raw
+  */
+START_TEST (compress_planes_raw)
+{
+   xrif_t hand = NULL;
+   
+   xrif_error_t rv = xrif_new(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(hand, 64, 64, 1, 16, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_configure(hand, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_compress_planes(hand, 1);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_allocate(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   srand(1);
+   
+   int16_t * rb = (int16_t *) hand->raw_buffer;
+   for(size_t i = 0; i < hand->width*hand->height*hand->frames; ++i) rb[i] = 1000 + (rand() % 256) - 128;
+   
+   rv = xrif_encode(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( hand->compressed_size < XRIF_BLOCK_TABLE_SIZE(3*3) + xrif_min_reordered_size(hand) );
+   
+   //The first frame, then the low and high byte planes.  The data was compressed in place in the raw buffer.
+   uint32_t * table = (uint32_t *) hand->raw_buffer;
+   ck_assert_int_eq( table[0], 3);
+   ck_assert_int_eq( (int32_t) table[3 + 3*1], XRIF_COMPRESS_NONE);
+   ck_assert_int_eq( table[2 + 3*1], table[1 + 3*1]);
+   ck_assert_int_eq( (int32_t) table[3 + 3*2], XRIF_COMPRESS_LZ4);
+   ck_assert( table[2 + 3*2] < table[1 + 3*2] );
+   
+   rv = xrif_decode(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   srand(1);
+   for(size_t i = 0; i < hand->width*hand->height*hand->frames; ++i) ck_assert( rb[i] == 1000 + (rand() % 256) - 128 );
+   
+   rv = xrif_delete(hand);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
+/** Verify skipping incompressible blocks for int16_t
+  * Verify that the xrif encode/decode cycle works with white noise for int16_t when blocks and planes are skipped based on their entropy, serial and in parallel.
+  * \anchor compress_skip_int16_white
+  */
+START_TEST (compress_skip_int16_white)
+{
+   fprintf(stderr, "Testing entropy skipping for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP rv = xrif_set_skip_entropy(hand, 2 + 2*(q % 3)); ck_assert( rv == XRIF_NOERROR ); \
+                               if(q % 2) { rv = xrif_set_compress_planes(hand, 1); ck_assert( rv == XRIF_NOERROR ); } \
+                               else { rv = xrif_set_compress_block_size(hand, XRIF_COMPRESS_BLOCK_UNIT); ck_assert( rv == XRIF_NOERROR ); } \
+                               hand->omp_parallel = (q/2) % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify that high entropy blocks are skipped
+  * Verify that the entropy estimate separates noise from constant data, and that noisy blocks and planes are stored as is and counted 
+  * while the rest are compressed.
+  * \anchor compress_skip_entropy
+  */
+START_TEST (compress_skip_entropy)
+{
+   char buf[8192];
+   
+   memset(buf, 7, sizeof(buf));
+   ck_assert( xrif_sample_entropy(buf, sizeof(buf)) == 0 );
+   
+   for(size_t i = 0; i < sizeof(buf); ++i) buf[i] = i % 16;
+   ck_assert( fabs(xrif_sample_entropy(buf, sizeof(buf)) - 4) < 1e-9 );
+   
+   srand(1);
+   for(size_t i = 0; i < sizeof(buf); ++i) buf[i] = rand() % 256;
+   ck_assert( xrif_sample_entropy(buf, sizeof(buf)) > 7.9 );
+   
+   for(int planes = 0; planes < 2; ++planes)
+   {
+      xrif_t hand = NULL;
+      
+      xrif_error_t rv = xrif_new(&hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_set_size(hand, 64, 64, 1, 16, XRIF_TYPECODE_INT16);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_configure(hand, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      //With 4 KiB blocks, the first frame is blocks 0 and 1, the low plane is blocks 2 to 16, and the high plane is blocks 17 to 31
+      if(planes) rv = xrif_set_compress_planes(hand, 1);
+      else rv = xrif_set_compress_block_size(hand, 4*XRIF_COMPRESS_BLOCK_UNIT);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_set_skip_entropy(hand, 7.5);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_allocate(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      srand(1);
+      
+      int16_t * rb = (int16_t *) hand->raw_buffer;
+      for(size_t i = 0; i < hand->width*hand->height*hand->frames; ++i) rb[i] = 1000 + (rand() % 256) - 128;
+      
+      rv = xrif_encode(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      uint32_t * table = (uint32_t *) hand->raw_buffer;
+      
+      if(planes)
+      {
+         //Only the low plane is noise
+         ck_assert_int_eq( hand->compress_skipped, 1);
+         ck_assert_int_eq( (int32_t) table[3 + 3*1], XRIF_COMPRESS_NONE);
+         ck_assert_int_eq( (int32_t) table[3 + 3*2], XRIF_COMPRESS_LZ4);
+      }
+      else
+      {
+         ck_assert_int_eq( hand->compress_skipped, 15);
+         for(int k = 2; k < 17; ++k) ck_assert( table[1 + k] == (4*XRIF_COMPRESS_BLOCK_UNIT | XRIF_BLOCK_RAW) );
+         for(int k = 17; k < 32; ++k) ck_assert( (table[1 + k] & XRIF_BLOCK_RAW) == 0 );
+      }
+      
+      rv = xrif_decode(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      srand(1);
+      for(size_t i = 0; i < hand->width*hand->height*hand->frames; ++i) ck_assert( rb[i] == 1000 + (rand() % 256) - 128 );
+      
+      rv = xrif_delete(hand);
+      ck_assert( rv == XRIF_NOERROR );
+   }
+}
+END_TEST;
+
+/** Verify bytepack reordering for signed 32-bit
+  * Verify that the xrif encode/decode cycle using bytepack reordering for signed 32-bit works with white noise.
+  * \anchor reorder_bytepack_int32_white
+  */
+START_TEST (reorder_bytepack_int32_white)
+{
+   fprintf(stderr, "Testing bytepack reordering for signed 32-bit.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT32)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP if(q % 2) { rv = xrif_set_compress_planes(hand, 1); ck_assert( rv == XRIF_NOERROR ); } hand->omp_parallel = (q/2) % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify bytepack reordering for unsigned 64-bit
+  * Verify that the xrif encode/decode cycle using bytepack reordering for unsigned 64-bit works with white noise.
+  * \anchor reorder_bytepack_uint64_white
+  */
+START_TEST (reorder_bytepack_uint64_white)
+{
+   fprintf(stderr, "Testing bytepack reordering for unsigned 64-bit.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT64)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PIXEL)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP if(q % 2) { rv = xrif_set_compress_planes(hand, 1); ck_assert( rv == XRIF_NOERROR ); } hand->omp_parallel = (q/2) % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify renibble reordering for unsigned 32-bit
+  * Verify that the xrif encode/decode cycle using renibble reordering for unsigned 32-bit works with white noise.
+  * \anchor reorder_renibble_uint32_white
+  */
+START_TEST (reorder_renibble_uint32_white)
+{
+   fprintf(stderr, "Testing renibble reordering for unsigned 32-bit.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT32)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP hand->omp_parallel = q % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify renibble reordering for signed 64-bit
+  * Verify that the xrif encode/decode cycle using renibble reordering for signed 64-bit works with white noise.
+  * \anchor reorder_renibble_int64_white
+  */
+START_TEST (reorder_renibble_int64_white)
+{
+   fprintf(stderr, "Testing renibble reordering for signed 64-bit.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT64)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_FIRST)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP hand->omp_parallel = q % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify XOR differencing with the previous frame for float
+  * Verify that the xrif encode/decode cycle using XOR differencing with the previous frame for float works with white noise.
+  * \anchor float_previous_white
+  */
+START_TEST (float_previous_white)
+{
+   fprintf(stderr, "Testing XOR differencing with the previous frame for float.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_FLOAT)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP if(q % 2) { rv = xrif_set_compress_planes(hand, 1); ck_assert( rv == XRIF_NOERROR ); } hand->omp_parallel = (q/2) % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify XOR differencing with the first frame for double
+  * Verify that the xrif encode/decode cycle using XOR differencing with the first frame for double works with white noise.
+  * \anchor double_first_white
+  */
+START_TEST (double_first_white)
+{
+   fprintf(stderr, "Testing XOR differencing with the first frame for double.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_DOUBLE)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_FIRST)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP if(q % 2) { rv = xrif_set_compress_planes(hand, 1); ck_assert( rv == XRIF_NOERROR ); } hand->omp_parallel = (q/2) % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify XOR differencing with the previous frame for half
+  * Verify that the xrif encode/decode cycle using XOR differencing with the previous frame for half works with white noise.
+  * \anchor half_previous_white
+  */
+START_TEST (half_previous_white)
+{
+   fprintf(stderr, "Testing XOR differencing with the previous frame for half.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_HALF)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_RANS)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP hand->omp_parallel = q % 2;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify that XOR differencing and the byte shuffle compress slowly varying floats
+  * Verify that a cube of float frames differing by small steps compresses, and decodes exactly.
+  * \anchor float_ratio
+  */
+START_TEST (float_ratio)
+{
+   xrif_t hand = NULL;
+   
+   xrif_error_t rv = xrif_new(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(hand, 64, 64, 1, 32, XRIF_TYPECODE_FLOAT);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_configure(hand, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_allocate(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   size_t npix = hand->width*hand->height;
+   
+   float * fb = (float *) hand->raw_buffer;
+   for(size_t n = 0; n < hand->frames; ++n)
+   {
+      for(size_t i = 0; i < npix; ++i) fb[n*npix + i] = 100.0f + 0.25f*((i + n) % 8);
+   }
+   
+   float * orig = (float *) malloc(hand->raw_size);
+   ck_assert( orig != NULL );
+   memcpy(orig, fb, hand->raw_size);
+   
+   rv = xrif_encode(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( hand->compressed_size < hand->raw_size/4 );
+   
+   rv = xrif_decode(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( memcmp(orig, fb, hand->raw_size) == 0 );
+   
+   //Pixel differencing is not implemented for floating point types
+   rv = xrif_configure(hand, XRIF_DIFFERENCE_PIXEL, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_encode(hand);
+   ck_assert( rv == XRIF_ERROR_NOTIMPL );
+   
+   free(orig);
+   
+   rv = xrif_delete(hand);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
+/** Verify bitpack reordering for int16_t
+  * Verify that the xrif encode/decode cycle using bitpack reordering works with white noise for int16_t, in parallel and with per-plane compression.
+  * \anchor reorder_bitpack_int16_white_omp
+  */
+START_TEST (reorder_bitpack_int16_white_omp)
+{
+   fprintf(stderr, "Testing bitpack reordering for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BITPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP if(q % 2) { rv = xrif_set_compress_planes(hand, 1); ck_assert( rv == XRIF_NOERROR ); } hand->omp_parallel = 1;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify bitpack reordering without compression
+  * Verify that the xrif encode/decode cycle with no compression works with bitpack reordering for int16_t, where the padded bit planes
+  * are larger than the raw data when the frame size is not a multiple of 8, alternating with renibble reordering which also pads.
+  * \anchor reorder_bitpack_none_white
+  */
+START_TEST (reorder_bitpack_none_white)
+{
+   fprintf(stderr, "Testing bitpack reordering without compression for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BITPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_NONE)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP if(q % 2) { rv = xrif_set_reorder_method(hand, XRIF_REORDER_BYTEPACK_RENIBBLE); ck_assert( rv == XRIF_NOERROR ); }
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify that bitpack reordering compresses small residuals
+  * Verify that a cube of 16 bit pixels with small frame to frame changes compresses better with bitpack than with bytepack reordering.
+  * \anchor reorder_bitpack_ratio
+  */
+START_TEST (reorder_bitpack_ratio)
+{
+   size_t csize[2];
+   
+   for(int k = 0; k < 2; ++k)
+   {
+      xrif_t hand = NULL;
+      
+      xrif_error_t rv = xrif_new(&hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_set_size(hand, 128, 128, 1, 32, XRIF_TYPECODE_INT16);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_configure(hand, XRIF_DIFFERENCE_PREVIOUS, (k == 0) ? XRIF_REORDER_BYTEPACK : XRIF_REORDER_BITPACK, XRIF_COMPRESS_LZ4);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_allocate(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      srand(2);
+      
+      int16_t * rb = (int16_t *) hand->raw_buffer;
+      for(size_t i = 0; i < hand->width*hand->height*hand->frames; ++i) rb[i] = 1000 + (rand() % 5);
+      
+      rv = xrif_encode(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      csize[k] = hand->compressed_size;
+      
+      rv = xrif_decode(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      srand(2);
+      for(size_t i = 0; i < hand->width*hand->height*hand->frames; ++i) ck_assert( rb[i] == 1000 + (rand() % 5) );
+      
+      rv = xrif_delete(hand);
+      ck_assert( rv == XRIF_NOERROR );
+   }
+   
+   fprintf(stderr, "bytepack: %zu bytes, bitpack: %zu bytes\n", csize[0], csize[1]);
+   ck_assert( csize[1] < csize[0] );
+}
+END_TEST;
+
+/** Verify renibble reordering for int16_t in parallel
+  * Verify that the xrif encode/decode cycle using renibble reordering works with white noise for int16_t with threads enabled,
+  * alternating previous and pixel differencing so that both the first frame and odd pixel counts are covered.
+  * \anchor reorder_renibble_int16_white_omp
+  */
+START_TEST (reorder_renibble_int16_white_omp)
+{
+   fprintf(stderr, "Testing renibble reordering for signed 16-bit white noise in parallel.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP if(q % 2) { rv = xrif_set_difference_method(hand, XRIF_DIFFERENCE_PIXEL); ck_assert( rv == XRIF_NOERROR ); } hand->omp_parallel = 1;
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+Suite * compress_suite(void)
+{
+    Suite *s;
+    TCase *tc_lz4hc, *tc_blocks, *tc_zstd, *tc_rans, *tc_planes, *tc_wide, *tc_float, *tc_bitpack, *tc_renibble;
+
+    s = suite_create("White Noise - Compression");
+
+    /* LZ4HC test case */
+    tc_lz4hc = tcase_create("LZ4HC white noise");
+
+    tcase_set_timeout(tc_lz4hc, 1e9);
+    
+    tcase_add_test(tc_lz4hc, compress_lz4hc_int16_white);
+    tcase_add_test(tc_lz4hc, compress_lz4hc_uint16_white);
+    
+    suite_add_tcase(s, tc_lz4hc);
+    
+    /* Block compression test case */
+    tc_blocks = tcase_create("Block compression white noise");
+
+    tcase_set_timeout(tc_blocks, 1e9);
+    
+    tcase_add_test(tc_blocks, compress_lz4_blocks_int16_white);
+    tcase_add_test(tc_blocks, compress_lz4hc_blocks_uint16_white);
+    tcase_add_test(tc_blocks, compress_lz4_memory_int16_white);
+    
+    suite_add_tcase(s, tc_blocks);
+    
+    /* Zstandard test case */
+    tc_zstd = tcase_create("Zstandard white noise");
+
+    tcase_set_timeout(tc_zstd, 1e9);
+    
+    tcase_add_test(tc_zstd, compress_zstd_int16_white);
+    
+    suite_add_tcase(s, tc_zstd);
+    
+    /* rANS test case */
+    tc_rans = tcase_create("rANS white noise");
+
+    tcase_set_timeout(tc_rans, 1e9);
+    
+    tcase_add_test(tc_rans, compress_rans_int16_white);
+    tcase_add_test(tc_rans, compress_rans_uint16_white);
+    tcase_add_test(tc_rans, compress_rans_ratio);
+    
+    suite_add_tcase(s, tc_rans);
+    
+    /* Per-plane compression test case */
+    tc_planes = tcase_create("Per-plane compression white noise");
+
+    tcase_set_timeout(tc_planes, 1e9);
+    
+    tcase_add_test(tc_planes, compress_planes_int16_white);
+    tcase_add_test(tc_planes, compress_planes_uint16_white);
+    tcase_add_test(tc_planes, compress_planes_raw);
+    tcase_add_test(tc_planes, compress_skip_int16_white);
+    tcase_add_test(tc_planes, compress_skip_entropy);
+    
+    suite_add_tcase(s, tc_planes);
+    
+    /* 32 and 64 bit reordering test case */
+    tc_wide = tcase_create("32 and 64 bit reordering white noise");
+
+    tcase_set_timeout(tc_wide, 1e9);
+    
+    tcase_add_test(tc_wide, reorder_bytepack_int32_white);
+    tcase_add_test(tc_wide, reorder_bytepack_uint64_white);
+    tcase_add_test(tc_wide, reorder_renibble_uint32_white);
+    tcase_add_test(tc_wide, reorder_renibble_int64_white);
+    
+    suite_add_tcase(s, tc_wide);
+    
+    /* Floating point test case */
+    tc_float = tcase_create("Floating point white noise");
+
+    tcase_set_timeout(tc_float, 1e9);
+    
+    tcase_add_test(tc_float, float_previous_white);
+    tcase_add_test(tc_float, double_first_white);
+    tcase_add_test(tc_float, half_previous_white);
+    tcase_add_test(tc_float, float_ratio);
+    
+    suite_add_tcase(s, tc_float);
+    
+    /* Bitpack test case */
+    tc_bitpack = tcase_create("Bitpack white noise");
+
+    tcase_set_timeout(tc_bitpack, 1e9);
+    
+    tcase_add_test(tc_bitpack, reorder_bitpack_int16_white_omp);
+    tcase_add_test(tc_bitpack, reorder_bitpack_none_white);
+    tcase_add_test(tc_bitpack, reorder_bitpack_ratio);
+    
+    suite_add_tcase(s, tc_bitpack);
+    
+    /* Renibble test case */
+    tc_renibble = tcase_create("Renibble white noise");
+
+    tcase_set_timeout(tc_renibble, 1e9);
+    
+    tcase_add_test(tc_renibble, reorder_renibble_int16_white_omp);
+    
+    suite_add_tcase(s, tc_renibble);
+    
+    return s;
+}
+
+int main( int argc,
+          char ** argv
+        )
+{
+   
+   extern int test_trials;
+   
+   test_trials = XRIF_TEST_TRIALS;
+   
+   if(argc == 2)
+   {
+      test_trials = atoi(argv[1]);
+   }
+   
+   fprintf(stderr, "running %d trials per format\n", test_trials);
+   
+   int number_failed;
+   Suite *s;
+   SRunner *sr;
+
+   // Intialize the random number sequence
+   srand((unsigned) time(NULL));
+
+   s = compress_suite();
+   sr = srunner_create(s);
+
+   srunner_run_all(sr, CK_NORMAL);
+   number_failed = srunner_ntests_failed(sr);
+   srunner_free(sr);
+   
+   return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+   
+}
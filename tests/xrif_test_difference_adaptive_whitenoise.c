@@ -0,0 +1,591 @@
+/** \file xrif_test_difference_adaptive_whitenoise.c
+  * \brief Test the adaptive differencing method with white noise.
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_test_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2019, 2020, 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../src/xrif.h"
+
+#include "randutils.h"
+
+#ifndef XRIF_TEST_TRIALS
+   #define XRIF_TEST_TRIALS (2)
+#endif
+
+int test_trials;
+
+/************************************************************/
+/* Fuzz testing differencing with the adaptive method
+/************************************************************/
+
+
+int ws[] = {2,4,8,21, 33, 47, 64}; //widths of images
+int hs[] = {2,4,8,21, 33, 47, 64}; //heights of images
+int ps[] = {1,2,4,5,27,63,64}; //planes of the cube
+
+ 
+/** Verify adaptive differencing for int16_t
+  * Verify that xrif difference/un-difference cycle works with white noise for int16_t.
+  * \anchor diff_adaptive_int16_white
+  */
+START_TEST (diff_adaptive_int16_white)
+{
+   fprintf(stderr, "Testing adaptive differencing for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_ADAPTIVE)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_adaptive
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_adaptive
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify adaptive differencing for uint16_t
+  * Verify that xrif difference/un-difference cycle works with white noise for uint16_t.
+  * \anchor diff_adaptive_uint16_white
+  */
+START_TEST (diff_adaptive_uint16_white)
+{
+   fprintf(stderr, "Testing adaptive differencing for unsigned 16-bit white noise.\n");
+   
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_ADAPTIVE)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_adaptive
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_adaptive
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify adaptive differencing for int32_t
+  * Verify that xrif difference/un-difference cycle works with white noise for int32_t.
+  * \anchor diff_adaptive_int32_white
+  */
+START_TEST (diff_adaptive_int32_white)
+{
+   fprintf(stderr, "Testing adaptive differencing for signed 32-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT32)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_ADAPTIVE)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_adaptive
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_adaptive
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify adaptive differencing for uint32_t
+  * Verify that xrif difference/un-difference cycle works with white noise for uint32_t.
+  * \anchor diff_adaptive_uint32_white
+  */
+START_TEST (diff_adaptive_uint32_white)
+{
+   fprintf(stderr, "Testing adaptive differencing for unsigned 32-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT32)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_ADAPTIVE)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_adaptive
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_adaptive
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify adaptive differencing for int64_t
+  * Verify that xrif difference/un-difference cycle works with white noise for int64_t.
+  * \anchor diff_adaptive_int64_white
+  */
+START_TEST (diff_adaptive_int64_white)
+{
+   fprintf(stderr, "Testing adaptive differencing for signed 64-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT64)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_ADAPTIVE)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_adaptive
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_adaptive
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify adaptive differencing for uint64_t
+  * Verify that xrif difference/un-difference cycle works with white noise for uint64_t.
+  * \anchor diff_adaptive_uint64_white
+  */
+START_TEST (diff_adaptive_uint64_white)
+{
+   fprintf(stderr, "Testing adaptive differencing for unsigned 64-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT64)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_ADAPTIVE)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_adaptive
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_adaptive
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify threaded adaptive differencing for int16_t
+  * Verify that the xrif difference/un-difference cycle works with threads and small blocks, both above and below the pixel cutoff.
+  * \anchor diff_adaptive_int16_omp
+  */
+START_TEST (diff_adaptive_int16_omp)
+{
+   fprintf(stderr, "Testing threaded adaptive differencing for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_ADAPTIVE)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_adaptive
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_adaptive
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP hand->omp_parallel = 1; rv = xrif_set_omp_min_pixels(hand, (q % 2 == 0) ? 0 : XRIF_OMP_MIN_PIXELS_DEFAULT); ck_assert( rv == XRIF_NOERROR ); \
+                               rv = xrif_set_adaptive_block_size(hand, 1 + q % 9); ck_assert( rv == XRIF_NOERROR );
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify that adaptive differencing chooses the method of each block
+  * Verify that each block of a frame made of four kinds of regions is differenced with the method suited to it, that the cube is restored,
+  * and that the block size is checked.
+  * \anchor diff_adaptive_choice
+  */
+START_TEST (diff_adaptive_choice)
+{
+   fprintf(stderr, "Testing adaptive differencing method choice.\n");
+   
+   xrif_t hand = NULL;
+   
+   xrif_error_t rv = xrif_new(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_adaptive_block_size(hand, 0);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert( hand->adaptive_block_size == XRIF_ADAPTIVE_BLOCK_SIZE_DEFAULT );
+   
+   rv = xrif_set_adaptive_block_size(hand, 65536);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert( hand->adaptive_block_size == 65535 );
+   
+   rv = xrif_set_adaptive_block_size(hand, 16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(hand, 32, 32, 1, 16, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( xrif_adaptive_blocks(hand) == 4 );
+   
+   rv = xrif_configure(hand, XRIF_DIFFERENCE_ADAPTIVE, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_NONE);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_allocate_raw(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   int16_t * rb = (int16_t *) hand->raw_buffer;
+   
+   int16_t base[32*32];
+   for(size_t i = 0; i < 32*32; ++i) base[i] = rand() % 20000;
+   
+   int16_t walk[32*32];
+   memcpy(walk, base, sizeof(walk));
+   
+   for(size_t n = 0; n < 16; ++n)
+   {
+      int16_t offset = rand() % 20000;
+      
+      for(size_t y = 0; y < 32; ++y)
+      {
+         for(size_t x = 0; x < 32; ++x)
+         {
+            size_t i = y*32 + x;
+            
+            walk[i] += (rand() % 3) - 1;
+            
+            int16_t v;
+            if(y < 16 && x < 16) v = (rand() % 5) - 2;                       //small white noise: none
+            else if(y < 16) v = walk[i];                                     //random walk on a static scene: previous
+            else if(x < 16) v = base[i] + ((n > 0) ? (rand() % 17) - 8 : 0); //white noise on the static scene of the first frame: first
+            else v = offset + x + y;                                         //changing smooth scene: pixel
+            
+            rb[n*32*32 + i] = v;
+         }
+      }
+   }
+   
+   int16_t * orig = (int16_t *) malloc(hand->raw_buffer_size);
+   ck_assert( orig != NULL );
+   memcpy(orig, rb, hand->raw_buffer_size);
+   
+   rv = xrif_difference_adaptive(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( hand->adaptive_methods_size == 4 );
+   ck_assert_int_eq( hand->adaptive_methods[0], XRIF_ADAPTIVE_NONE );
+   ck_assert_int_eq( hand->adaptive_methods[1], XRIF_ADAPTIVE_PREVIOUS );
+   ck_assert_int_eq( hand->adaptive_methods[2], XRIF_ADAPTIVE_FIRST );
+   ck_assert_int_eq( hand->adaptive_methods[3], XRIF_ADAPTIVE_PIXEL );
+   
+   //The pixel block is all 1s after its first pixel
+   for(size_t n = 0; n < 16; ++n)
+   {
+      for(size_t y = 16; y < 32; ++y)
+      {
+         for(size_t x = 16; x < 32; ++x)
+         {
+            if(y == 16 && x == 16) continue;
+            ck_assert( rb[n*32*32 + y*32 + x] == 1 );
+         }
+      }
+   }
+   
+   rv = xrif_undifference_adaptive(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( memcmp(rb, orig, hand->raw_buffer_size) == 0 );
+   
+   free(orig);
+   
+   rv = xrif_delete(hand);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
+/** Verify encoding and decoding with adaptive differencing
+  * Verify that the method table is passed through the header, that a bad table is rejected, and that floating point types 
+  * are not supported.
+  * \anchor encode_adaptive
+  */
+START_TEST (encode_adaptive)
+{
+   fprintf(stderr, "Testing encoding and decoding with adaptive differencing.\n");
+   
+   int types[] = {XRIF_TYPECODE_INT16, XRIF_TYPECODE_UINT32, XRIF_TYPECODE_INT64};
+   
+   for(int t = 0; t < sizeof(types)/sizeof(types[0]); ++t)
+   {
+      xrif_t enc = NULL;
+      xrif_t dec = NULL;
+      
+      xrif_error_t rv = xrif_new(&enc);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_new(&dec);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_set_adaptive_block_size(enc, 5);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_set_size(enc, 33, 21, 2, 8, types[t]);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      //7 x 9 blocks, since the planes are more rows
+      size_t nblocks = 63;
+      ck_assert( xrif_adaptive_blocks(enc) == nblocks );
+      
+      rv = xrif_configure(enc, XRIF_DIFFERENCE_ADAPTIVE, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_allocate(enc);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      size_t cube_size = enc->width*enc->height*enc->depth*enc->frames*enc->data_size;
+      
+      //Half static and half white noise
+      for(size_t i = 0; i < cube_size; ++i) enc->raw_buffer[i] = rand();
+      for(size_t n = 1; n < enc->frames; ++n) memcpy(enc->raw_buffer + n*cube_size/enc->frames, enc->raw_buffer, cube_size/enc->frames/2);
+      
+      char * orig = (char *) malloc(cube_size);
+      ck_assert( orig != NULL );
+      memcpy(orig, enc->raw_buffer, cube_size);
+      
+      rv = xrif_encode(enc);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      uint32_t hsz = XRIF_HEADER_SIZE_EXT + 64;
+      ck_assert_int_eq( xrif_header_size(enc), hsz );
+      
+      char header[XRIF_HEADER_SIZE_EXT + 64];
+      rv = xrif_write_header(header, enc);
+      ck_assert( rv == XRIF_NOERROR );
+      ck_assert( *((uint32_t *) &header[8]) == hsz );
+      ck_assert( *((uint16_t *) &header[48]) == 5 );
+      ck_assert( *((uint32_t *) &header[52]) == nblocks );
+      ck_assert( memcmp(&header[XRIF_HEADER_SIZE_EXT], enc->adaptive_methods, nblocks) == 0 );
+      
+      //Decoding needs the method table
+      rv = xrif_set_size(dec, 33, 21, 2, 8, types[t]);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_configure(dec, XRIF_DIFFERENCE_ADAPTIVE, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_undifference_adaptive(dec);
+      ck_assert( rv == XRIF_ERROR_NOT_SETUP );
+      
+      uint32_t header_size;
+      rv = xrif_read_header(dec, &header_size, header);
+      ck_assert( rv == XRIF_NOERROR );
+      ck_assert_int_eq( header_size, hsz );
+      
+      //The fixed part of the header does not hold the method table
+      rv = xrif_undifference_adaptive(dec);
+      ck_assert( rv == XRIF_ERROR_NOT_SETUP );
+      
+      rv = xrif_read_header_ext(dec, header, XRIF_HEADER_SIZE_EXT);
+      ck_assert( rv == XRIF_ERROR_BADHEADER );
+      
+      rv = xrif_read_header_ext(dec, header, sizeof(header));
+      ck_assert( rv == XRIF_NOERROR );
+      ck_assert( dec->adaptive_block_size == 5 );
+      ck_assert( dec->adaptive_methods_size == nblocks );
+      ck_assert( memcmp(dec->adaptive_methods, enc->adaptive_methods, nblocks) == 0 );
+      
+      rv = xrif_allocate(dec);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      memcpy(dec->raw_buffer, enc->raw_buffer, enc->compressed_size);
+      rv = xrif_decode(dec);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      ck_assert( memcmp(dec->raw_buffer, orig, cube_size) == 0 );
+      
+      //A bad method table is rejected
+      header[XRIF_HEADER_SIZE_EXT + 3] = XRIF_ADAPTIVE_PIXEL + 1;
+      rv = xrif_read_header(dec, &header_size, header);
+      ck_assert( rv == XRIF_NOERROR );
+      rv = xrif_read_header_ext(dec, header, sizeof(header));
+      ck_assert( rv == XRIF_ERROR_BADHEADER );
+      ck_assert( dec->adaptive_methods == NULL );
+      
+      header[XRIF_HEADER_SIZE_EXT + 3] = XRIF_ADAPTIVE_NONE;
+      *((uint32_t *) &header[52]) = nblocks + 1;
+      rv = xrif_read_header(dec, &header_size, header);
+      ck_assert( rv == XRIF_NOERROR );
+      rv = xrif_read_header_ext(dec, header, sizeof(header));
+      ck_assert( rv == XRIF_ERROR_BADHEADER );
+      
+      *((uint32_t *) &header[52]) = nblocks;
+      *((uint32_t *) &header[8]) = XRIF_HEADER_SIZE_EXT;
+      rv = xrif_read_header(dec, &header_size, header);
+      ck_assert( rv == XRIF_NOERROR );
+      rv = xrif_read_header_ext(dec, header, sizeof(header));
+      ck_assert( rv == XRIF_ERROR_BADHEADER );
+      
+      free(orig);
+      
+      rv = xrif_delete(enc);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_delete(dec);
+      ck_assert( rv == XRIF_NOERROR );
+   }
+   
+   //Floating point is not supported
+   xrif_t hand = NULL;
+   
+   xrif_error_t rv = xrif_new(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(hand, 8, 8, 1, 4, XRIF_TYPECODE_FLOAT);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_configure(hand, XRIF_DIFFERENCE_ADAPTIVE, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_NONE);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_allocate_raw(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_difference_adaptive(hand);
+   ck_assert( rv == XRIF_ERROR_NOTIMPL );
+   
+   rv = xrif_delete(hand);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
+Suite * whitenoise_suite(void)
+{
+    Suite *s;
+    TCase *tc_core16, *tc_core32, *tc_core64;
+
+    s = suite_create("White Noise - Difference Adaptive");
+
+    /* 16-bit Core test case */
+    tc_core16 = tcase_create("16 bit white noise");
+
+    tcase_set_timeout(tc_core16, 1e9);
+    
+    tcase_add_test(tc_core16, diff_adaptive_int16_white);
+    tcase_add_test(tc_core16, diff_adaptive_uint16_white);
+    tcase_add_test(tc_core16, diff_adaptive_int16_omp);
+    tcase_add_test(tc_core16, diff_adaptive_choice);
+    tcase_add_test(tc_core16, encode_adaptive);
+    
+    suite_add_tcase(s, tc_core16);
+    
+    /* 32-bit Core test case */
+    tc_core32 = tcase_create("32 bit white noise");
+
+    tcase_set_timeout(tc_core32, 1e9);
+    
+    tcase_add_test(tc_core32, diff_adaptive_int32_white);
+    tcase_add_test(tc_core32, diff_adaptive_uint32_white);
+    
+    suite_add_tcase(s, tc_core32);
+
+    /* 64-bit Core test case */
+    tc_core64 = tcase_create("64 bit white noise");
+
+    tcase_set_timeout(tc_core64, 1e9);
+    
+    tcase_add_test(tc_core64, diff_adaptive_int64_white);
+    tcase_add_test(tc_core64, diff_adaptive_uint64_white);
+    
+    suite_add_tcase(s, tc_core64);
+    
+    return s;
+}
+
+int main( int argc,
+          char ** argv
+        )
+{
+   
+   extern int test_trials;
+   
+   test_trials = XRIF_TEST_TRIALS;
+   
+   if(argc == 2)
+   {
+      test_trials = atoi(argv[1]);
+   }
+   
+   fprintf(stderr, "running %d trials per format\n", test_trials);
+   
+   int number_failed;
+   Suite *s;
+   SRunner *sr;
+
+   // Intialize the random number sequence
+   srand((unsigned) time(NULL));
+
+   s = whitenoise_suite();
+   sr = srunner_create(s);
+
+   srunner_run_all(sr, CK_NORMAL);
+   number_failed = srunner_ntests_failed(sr);
+   srunner_free(sr);
+   
+   return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+   
+}
@@ -500,6 +500,27 @@ START_TEST (diff_first_uint64_white)
 }
 END_TEST;
 
+/** Verify threaded first differencing for int16_t
+  * Verify that the xrif difference/un-difference cycle using the first image works with threads, both above and below the pixel cutoff.
+  * \anchor diff_first_int16_omp
+  */
+START_TEST (diff_first_int16_omp)
+{
+   fprintf(stderr, "Testing threaded first differencing for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_FIRST)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_first
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_first
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP hand->omp_parallel = 1; rv = xrif_set_omp_min_pixels(hand, (q % 2 == 0) ? 0 : XRIF_OMP_MIN_PIXELS_DEFAULT); ck_assert( rv == XRIF_NOERROR );
+   
+   #include "testloop.c"
+}
+END_TEST;
+
 Suite * whitenoise_suite(void)
 {
     Suite *s;
@@ -514,6 +535,7 @@ Suite * whitenoise_suite(void)
     
     tcase_add_test(tc_core16, diff_first_int16_white);
     tcase_add_test(tc_core16, diff_first_uint16_white);
+    tcase_add_test(tc_core16, diff_first_int16_omp);
     
     suite_add_tcase(s, tc_core16);
     
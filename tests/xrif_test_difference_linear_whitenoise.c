@@ -0,0 +1,410 @@
+/** \file xrif_test_difference_linear_whitenoise.c
+  * \brief Test the linear differencing method with white noise and ramps.
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_test_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2019, 2020, 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../src/xrif.h"
+
+#include "randutils.h"
+
+#ifndef XRIF_TEST_TRIALS
+   #define XRIF_TEST_TRIALS (2)
+#endif
+
+int test_trials;
+
+/************************************************************/
+/* Fuzz testing differencing with the linear method
+/************************************************************/
+
+
+int ws[] = {2,4,8,21, 33, 47, 64}; //widths of images
+int hs[] = {2,4,8,21, 33, 47, 64}; //heights of images
+int ps[] = {1,2,4,5,27,63,64}; //planes of the cube
+ 
+/** Verify linear differencing for int16_t
+  * Verify that xrif difference/un-difference cycle using the linear prediction from the two images before works with white noise for int16_t.
+  * \anchor diff_linear_int16_white
+  */
+START_TEST (diff_linear_int16_white)
+{
+   fprintf(stderr, "Testing linear differencing for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_LINEAR)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_linear
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_linear
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify linear differencing for uint16_t
+  * Verify that xrif difference/un-difference cycle using the linear prediction from the two images before works with white noise for uint16_t.
+  * \anchor diff_linear_uint16_white
+  */
+START_TEST (diff_linear_uint16_white)
+{
+   fprintf(stderr, "Testing linear differencing for unsigned 16-bit white noise.\n");
+   
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_LINEAR)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_linear
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_linear
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify linear differencing for int32_t
+  * Verify that xrif difference/un-difference cycle using the linear prediction from the two images before works with white noise for int32_t.
+  * \anchor diff_linear_int32_white
+  */
+START_TEST (diff_linear_int32_white)
+{
+   fprintf(stderr, "Testing linear differencing for signed 32-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT32)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_LINEAR)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_linear
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_linear
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify linear differencing for uint32_t
+  * Verify that xrif difference/un-difference cycle using the linear prediction from the two images before works with white noise for uint32_t.
+  * \anchor diff_linear_uint32_white
+  */
+START_TEST (diff_linear_uint32_white)
+{
+   fprintf(stderr, "Testing linear differencing for unsigned 32-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT32)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_LINEAR)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_linear
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_linear
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify linear differencing for int64_t
+  * Verify that xrif difference/un-difference cycle using the linear prediction from the two images before works with white noise for int64_t.
+  * \anchor diff_linear_int64_white
+  */
+START_TEST (diff_linear_int64_white)
+{
+   fprintf(stderr, "Testing linear differencing for signed 64-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT64)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_LINEAR)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_linear
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_linear
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify linear differencing for uint64_t
+  * Verify that xrif difference/un-difference cycle using the linear prediction from the two images before works with white noise for uint64_t.
+  * \anchor diff_linear_uint64_white
+  */
+START_TEST (diff_linear_uint64_white)
+{
+   fprintf(stderr, "Testing linear differencing for unsigned 64-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT64)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_LINEAR)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_linear
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_linear
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify threaded linear differencing for int16_t
+  * Verify that the xrif difference/un-difference cycle using the linear prediction from the two images before works with threads, both above and below the pixel cutoff.
+  * \anchor diff_linear_int16_omp
+  */
+START_TEST (diff_linear_int16_omp)
+{
+   fprintf(stderr, "Testing threaded linear differencing for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_LINEAR)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_linear
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_linear
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP hand->omp_parallel = 1; rv = xrif_set_omp_min_pixels(hand, (q % 2 == 0) ? 0 : XRIF_OMP_MIN_PIXELS_DEFAULT); ck_assert( rv == XRIF_NOERROR );
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+//Difference ramps which saturate at the end of the range of the type, and check that every residual after the second frame is 0.
+#define XRIF_CHECK_LINEAR_RAMP( type, typecode, lo, hi ) \
+   { \
+      rv = xrif_set_size(hand, w, h, 1, frames, typecode); \
+      ck_assert( rv == XRIF_NOERROR ); \
+      \
+      rv = xrif_configure(hand, XRIF_DIFFERENCE_LINEAR, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4); \
+      ck_assert( rv == XRIF_NOERROR ); \
+      \
+      rv = xrif_allocate_raw(hand); \
+      ck_assert( rv == XRIF_NOERROR ); \
+      \
+      type * buffer = (type *) hand->raw_buffer; \
+      type * orig = (type *) malloc(w*h*frames*sizeof(type)); \
+      ck_assert( orig != NULL ); \
+      \
+      for(size_t i = 0; i < w*h; ++i) \
+      { \
+         /* Half the pixels ramp up to hi and half down to lo, at different rates */ \
+         type rate = (type) (((hi)/16)/(1 + i % 7)); \
+         int up = (i % 2 == 0); \
+         type v = (up) ? (type) ((hi) - 3*rate) : (type) ((lo) + 3*rate); \
+         \
+         for(size_t n = 0; n < frames; ++n) \
+         { \
+            buffer[n*w*h + i] = v; \
+            if(up) v = ((hi) - v < rate) ? (hi) : (type) (v + rate); \
+            else v = (v - (lo) < rate) ? (lo) : (type) (v - rate); \
+         } \
+      } \
+      \
+      memcpy(orig, buffer, w*h*frames*sizeof(type)); \
+      \
+      rv = xrif_difference_linear(hand); \
+      ck_assert( rv == XRIF_NOERROR ); \
+      \
+      for(size_t i = 2*w*h; i < w*h*frames; ++i) ck_assert( buffer[i] == 0 ); \
+      \
+      rv = xrif_undifference_linear(hand); \
+      ck_assert( rv == XRIF_NOERROR ); \
+      \
+      ck_assert( memcmp(buffer, orig, w*h*frames*sizeof(type)) == 0 ); \
+      \
+      free(orig); \
+      xrif_reset(hand); \
+   }
+
+/** Verify linear differencing of ramps
+  * Verify that pixels which ramp up or down at a steady rate, and then stay at the end of the range of the type, have 
+  * residuals of 0 after the second frame because the prediction is clamped.  Verify that the undifferenced cubes match the originals.
+  * \anchor diff_linear_ramp
+  */
+START_TEST (diff_linear_ramp)
+{
+   fprintf(stderr, "Testing linear differencing of ramps.\n");
+   
+   size_t w = 29;
+   size_t h = 31;
+   size_t frames = 16;
+   
+   xrif_t hand = NULL;
+   
+   xrif_error_t rv = xrif_new(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   XRIF_CHECK_LINEAR_RAMP( int16_t, XRIF_TYPECODE_INT16, INT16_MIN, INT16_MAX );
+   XRIF_CHECK_LINEAR_RAMP( uint16_t, XRIF_TYPECODE_UINT16, 0, UINT16_MAX );
+   XRIF_CHECK_LINEAR_RAMP( int32_t, XRIF_TYPECODE_INT32, INT32_MIN, INT32_MAX );
+   XRIF_CHECK_LINEAR_RAMP( uint32_t, XRIF_TYPECODE_UINT32, 0, UINT32_MAX );
+   XRIF_CHECK_LINEAR_RAMP( int64_t, XRIF_TYPECODE_INT64, INT64_MIN, INT64_MAX );
+   XRIF_CHECK_LINEAR_RAMP( uint64_t, XRIF_TYPECODE_UINT64, 0, UINT64_MAX );
+   
+   rv = xrif_delete(hand);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
+#undef XRIF_CHECK_LINEAR_RAMP
+
+Suite * whitenoise_suite(void)
+{
+    Suite *s;
+    TCase *tc_core16, *tc_core32, *tc_core64;
+
+    s = suite_create("White Noise - Difference Linear");
+
+    /* 16-bit Core test case */
+    tc_core16 = tcase_create("16 bit white noise");
+
+    tcase_set_timeout(tc_core16, 1e9);
+    
+    tcase_add_test(tc_core16, diff_linear_int16_white);
+    tcase_add_test(tc_core16, diff_linear_uint16_white);
+    tcase_add_test(tc_core16, diff_linear_int16_omp);
+    tcase_add_test(tc_core16, diff_linear_ramp);
+    
+    suite_add_tcase(s, tc_core16);
+    
+    /* 32-bit Core test case */
+    tc_core32 = tcase_create("32 bit white noise");
+
+    tcase_set_timeout(tc_core32, 1e9);
+    
+    tcase_add_test(tc_core32, diff_linear_int32_white);
+    tcase_add_test(tc_core32, diff_linear_uint32_white);
+    
+    suite_add_tcase(s, tc_core32);
+
+    /* 64-bit Core test case */
+    tc_core64 = tcase_create("64 bit white noise");
+
+    tcase_set_timeout(tc_core64, 1e9);
+    
+    tcase_add_test(tc_core64, diff_linear_int64_white);
+    tcase_add_test(tc_core64, diff_linear_uint64_white);
+    
+    suite_add_tcase(s, tc_core64);
+    
+    return s;
+}
+
+int main( int argc,
+          char ** argv
+        )
+{
+   
+   extern int test_trials;
+   
+   test_trials = XRIF_TEST_TRIALS;
+   
+   if(argc == 2)
+   {
+      test_trials = atoi(argv[1]);
+   }
+   
+   fprintf(stderr, "running %d trials per format\n", test_trials);
+   
+   int number_failed;
+   Suite *s;
+   SRunner *sr;
+
+   // Intialize the random number sequence
+   srand((unsigned) time(NULL));
+
+   s = whitenoise_suite();
+   sr = srunner_create(s);
+
+   srunner_run_all(sr, CK_NORMAL);
+   number_failed = srunner_ntests_failed(sr);
+   srunner_free(sr);
+   
+   return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+   
+}
+
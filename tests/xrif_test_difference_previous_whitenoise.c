@@ -230,6 +230,87 @@ START_TEST (diff_previous_uint64_white)
 }
 END_TEST;
 
+/** Verify threaded previous differencing for int16_t
+  * Verify that the xrif difference/un-difference cycle using the previous image works with threads, both above and below the pixel cutoff.
+  * \anchor diff_previous_int16_omp
+  */
+START_TEST (diff_previous_int16_omp)
+{
+   fprintf(stderr, "Testing threaded previous differencing for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_previous
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_previous
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP hand->omp_parallel = 1; rv = xrif_set_omp_min_pixels(hand, (q % 2 == 0) ? 0 : XRIF_OMP_MIN_PIXELS_DEFAULT); ck_assert( rv == XRIF_NOERROR );
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify previous differencing with a key frame interval
+  * Verify that the xrif difference/un-difference cycle using the previous image works with a key frame interval, threaded and not, 
+  * and that the frames at the interval are left as is while the frame after each one is differenced against it.
+  * \anchor diff_previous_keyframes
+  */
+START_TEST (diff_previous_keyframes)
+{
+   fprintf(stderr, "Testing previous differencing with a key frame interval for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_previous
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_previous
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP hand->omp_parallel = q % 2; hand->omp_min_pixels = 0; rv = xrif_set_keyframe_interval(hand, 1 + q % 5); ck_assert( rv == XRIF_NOERROR );
+   
+   #include "testloop.c"
+   
+   //Check which frames are differenced
+   rv = xrif_new(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(hand, 8, 8, 1, 10, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_configure(hand, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_keyframe_interval(hand, 4);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( xrif_segment_frames(hand), 4 );
+   
+   rv = xrif_allocate_raw(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   int16_t * buffer = (int16_t *) hand->raw_buffer;
+   for(int n = 0; n < 10; ++n)
+   {
+      for(int i = 0; i < 64; ++i) buffer[n*64 + i] = n*n + i;
+   }
+   
+   rv = xrif_difference_previous(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   for(int n = 0; n < 10; ++n)
+   {
+      for(int i = 0; i < 64; ++i)
+      {
+         if(n % 4 == 0) ck_assert_int_eq( buffer[n*64 + i], n*n + i );
+         else ck_assert_int_eq( buffer[n*64 + i], 2*n - 1 );
+      }
+   }
+   
+   rv = xrif_delete(hand);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
 Suite * whitenoise_suite(void)
 {
     Suite *s;
@@ -244,6 +325,8 @@ Suite * whitenoise_suite(void)
     
     tcase_add_test(tc_core16, diff_previous_int16_white);
     tcase_add_test(tc_core16, diff_previous_uint16_white);
+    tcase_add_test(tc_core16, diff_previous_int16_omp);
+    tcase_add_test(tc_core16, diff_previous_keyframes);
     
     suite_add_tcase(s, tc_core16);
     
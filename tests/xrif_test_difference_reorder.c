@@ -0,0 +1,467 @@
+/** \file xrif_test_difference_reorder.c
+  * \brief Test the fused differencing and reordering stage
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../src/xrif.h"
+
+//Cube sizes {width, height, depth, frames}, chosen to have chunks crossing frames and images, and odd numbers of pixels
+size_t sizes[][4] = { {1,1,1,3}, {3,5,2,4}, {7,3,1,1}, {64,64,3,7}, {130,129,1,5} };
+
+#define NSIZES (sizeof(sizes)/sizeof(sizes[0]))
+
+xrif_typecode_t types[] = {XRIF_TYPECODE_INT16, XRIF_TYPECODE_UINT16, XRIF_TYPECODE_INT32, XRIF_TYPECODE_UINT64};
+
+#define NTYPES (sizeof(types)/sizeof(types[0]))
+
+int diffs[] = {XRIF_DIFFERENCE_PREVIOUS, XRIF_DIFFERENCE_FIRST, XRIF_DIFFERENCE_PIXEL};
+
+#define NDIFFS (sizeof(diffs)/sizeof(diffs[0]))
+
+//Fill with values that are small or near the limits, so that the differences wrap around
+void fill_bytes( char * buf,
+                 size_t nbytes
+               )
+{
+   for(size_t i = 0; i < nbytes; ++i)
+   {
+      int r = rand();
+      buf[i] = (r & 0x100) ? (char) (r & 0xFF) : ((r & 0x200) ? 0 : -1);
+   }
+}
+
+/** Verify the fused stage matches differencing then reordering
+  * Verify that for each supported combination of type, difference method, and reorder method, with and without chaining and threads,
+  * xrif_difference_reorder produces the same reordered buffer and chain reference as xrif_difference followed by xrif_reorder, and
+  * leaves the raw buffer unchanged.
+  * \anchor difference_reorder_match
+  */
+START_TEST (difference_reorder_match)
+{
+   for(size_t z = 0; z < NSIZES; ++z)
+   {
+      for(size_t t = 0; t < NTYPES; ++t)
+      {
+         for(size_t d = 0; d < NDIFFS; ++d)
+         {
+            for(int reorder = XRIF_REORDER_BYTEPACK; reorder <= XRIF_REORDER_BYTEPACK_RENIBBLE; reorder += 100)
+            {
+               for(int chain = 0; chain < 2; ++chain)
+               {
+                  if(chain && diffs[d] == XRIF_DIFFERENCE_PIXEL) continue;
+                  
+                  xrif_t hand = NULL;
+                  
+                  xrif_error_t rv = xrif_new(&hand);
+                  ck_assert( rv == XRIF_NOERROR );
+                  
+                  rv = xrif_set_size(hand, sizes[z][0], sizes[z][1], sizes[z][2], sizes[z][3], types[t]);
+                  ck_assert( rv == XRIF_NOERROR );
+                  
+                  rv = xrif_configure(hand, diffs[d], reorder, XRIF_COMPRESS_NONE);
+                  ck_assert( rv == XRIF_NOERROR );
+                  
+                  if(!xrif_difference_reorder_supported(hand))
+                  {
+                     //Only 32 and 64 bit renibble is not fused
+                     ck_assert( reorder == XRIF_REORDER_BYTEPACK_RENIBBLE && hand->data_size > 2 );
+                     
+                     rv = xrif_difference_reorder(hand);
+                     ck_assert( rv == XRIF_ERROR_NOTIMPL );
+                     
+                     xrif_delete(hand);
+                     continue;
+                  }
+                  
+                  rv = xrif_allocate(hand);
+                  ck_assert( rv == XRIF_NOERROR );
+                  
+                  hand->omp_parallel = (z + t + d) % 2;
+                  
+                  size_t one_frame = sizes[z][0]*sizes[z][1]*sizes[z][2]*hand->data_size;
+                  size_t nbytes = one_frame*sizes[z][3];
+                  size_t rsize = hand->reordered_buffer_size;
+                  
+                  char * orig = (char *) malloc(nbytes);
+                  char * ref = (char *) malloc(one_frame);
+                  char * fused = (char *) malloc(rsize);
+                  
+                  ck_assert( orig && ref && fused );
+                  
+                  fill_bytes(hand->raw_buffer, nbytes);
+                  memcpy(orig, hand->raw_buffer, nbytes);
+                  
+                  if(chain)
+                  {
+                     hand->chain_cubes = 1;
+                     
+                     rv = xrif_allocate_chain(hand);
+                     ck_assert( rv == XRIF_NOERROR );
+                     
+                     fill_bytes(ref, one_frame);
+                  }
+                  
+                  //Fused
+                  if(chain) 
+                  {
+                     memcpy(hand->chain_buffer, ref, one_frame);
+                     hand->chain_encode_valid = 1;
+                  }
+                  
+                  memset(hand->reordered_buffer, 0x5A, rsize);
+                  
+                  rv = xrif_difference_reorder(hand);
+                  ck_assert( rv == XRIF_NOERROR );
+                  ck_assert( hand->chained == chain );
+                  ck_assert( memcmp(hand->raw_buffer, orig, nbytes) == 0 );
+                  
+                  memcpy(fused, hand->reordered_buffer, rsize);
+                  
+                  if(chain) ck_assert( memcmp(hand->chain_buffer, orig + nbytes - one_frame, one_frame) == 0 );
+                  
+                  //Two pass
+                  if(chain) 
+                  {
+                     memcpy(hand->chain_buffer, ref, one_frame);
+                     hand->chain_encode_valid = 1;
+                  }
+                  
+                  memset(hand->reordered_buffer, 0x5A, rsize);
+                  
+                  rv = xrif_difference(hand);
+                  ck_assert( rv == XRIF_NOERROR );
+                  ck_assert( hand->chained == chain );
+                  
+                  rv = xrif_reorder(hand);
+                  ck_assert( rv == XRIF_NOERROR );
+                  
+                  //Bytepack fills exactly the cube, renibble zeroes the rest of its minimum size
+                  size_t cmpsize = (reorder == XRIF_REORDER_BYTEPACK) ? nbytes : xrif_min_reordered_size(hand);
+                  
+                  ck_assert( memcmp(hand->reordered_buffer, fused, cmpsize) == 0 );
+                  
+                  if(chain) ck_assert( memcmp(hand->chain_buffer, orig + nbytes - one_frame, one_frame) == 0 );
+                  
+                  free(orig);
+                  free(ref);
+                  free(fused);
+                  
+                  rv = xrif_delete(hand);
+                  ck_assert( rv == XRIF_NOERROR );
+               }
+            }
+         }
+      }
+   }
+}
+END_TEST;
+
+/** Verify the encode/decode cycle through the fused stage
+  * Verify that xrif_encode uses the fused stage and that xrif_decode restores the cube, for each difference method with threads enabled.
+  * \anchor difference_reorder_encode
+  */
+START_TEST (difference_reorder_encode)
+{
+   for(size_t d = 0; d < NDIFFS; ++d)
+   {
+      xrif_t hand = NULL;
+      
+      xrif_error_t rv = xrif_new(&hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_set_size(hand, 130, 129, 1, 5, XRIF_TYPECODE_INT16);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_configure(hand, diffs[d], XRIF_REORDER_BYTEPACK_RENIBBLE, XRIF_COMPRESS_LZ4);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_allocate(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      hand->omp_parallel = 1;
+      
+      ck_assert( xrif_difference_reorder_supported(hand) );
+      
+      size_t nbytes = 130*129*5*sizeof(int16_t);
+      char * orig = (char *) malloc(nbytes);
+      ck_assert( orig != NULL );
+      
+      fill_bytes(hand->raw_buffer, nbytes);
+      memcpy(orig, hand->raw_buffer, nbytes);
+      
+      rv = xrif_encode(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_decode(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      ck_assert( memcmp(hand->raw_buffer, orig, nbytes) == 0 );
+      
+      free(orig);
+      
+      rv = xrif_delete(hand);
+      ck_assert( rv == XRIF_NOERROR );
+   }
+}
+END_TEST;
+
+/** Verify tiled encoding and decoding
+  * Verify that for each tiled combination of type, difference method, reorder method, and tile size, with and without chaining, threads, 
+  * and compression on the raw buffer, a pair of cubes encoded with xrif_encode is restored by xrif_decode on a handle configured from the header.
+  * The second cube is a small change to the first, so that its tiles compress.
+  * \anchor tiles_encode_decode
+  */
+START_TEST (tiles_encode_decode)
+{
+   size_t tile_sizes[] = {1024, 3*1024, 65536};
+   
+   for(size_t z = 2; z < NSIZES; ++z)
+   {
+      for(size_t t = 0; t < NTYPES; ++t)
+      {
+         for(size_t d = 0; d < NDIFFS; ++d)
+         {
+            for(int reorder = XRIF_REORDER_BYTEPACK; reorder <= XRIF_REORDER_BYTEPACK_RENIBBLE; reorder += 100)
+            {
+               for(size_t k = 0; k < sizeof(tile_sizes)/sizeof(tile_sizes[0]); ++k)
+               {
+                  for(int on_raw = 0; on_raw < 2; ++on_raw)
+                  {
+                     int chain = (diffs[d] != XRIF_DIFFERENCE_PIXEL) && ((z + k) % 2);
+                     
+                     xrif_t enc = NULL;
+                     xrif_t dec = NULL;
+                     
+                     xrif_error_t rv = xrif_new(&enc);
+                     ck_assert( rv == XRIF_NOERROR );
+                     
+                     rv = xrif_new(&dec);
+                     ck_assert( rv == XRIF_NOERROR );
+                     
+                     rv = xrif_set_size(enc, sizes[z][0], sizes[z][1], sizes[z][2], sizes[z][3], types[t]);
+                     ck_assert( rv == XRIF_NOERROR );
+                     
+                     rv = xrif_configure(enc, diffs[d], reorder, XRIF_COMPRESS_LZ4);
+                     ck_assert( rv == XRIF_NOERROR );
+                     
+                     rv = xrif_set_tile_size(enc, tile_sizes[k]);
+                     ck_assert( rv == XRIF_NOERROR );
+                     
+                     if(!xrif_tiled(enc))
+                     {
+                        //Only 32 and 64 bit renibble is not tiled
+                        ck_assert( reorder == XRIF_REORDER_BYTEPACK_RENIBBLE && enc->data_size > 2 );
+                        
+                        xrif_delete(enc);
+                        xrif_delete(dec);
+                        continue;
+                     }
+                     
+                     rv = xrif_set_chain_cubes(enc, chain);
+                     ck_assert( rv == XRIF_NOERROR );
+                     
+                     rv = xrif_set_chain_cubes(dec, chain);
+                     ck_assert( rv == XRIF_NOERROR );
+                     
+                     enc->compress_on_raw = on_raw;
+                     dec->compress_on_raw = on_raw;
+                     enc->omp_parallel = (t + d + k) % 2;
+                     dec->omp_parallel = enc->omp_parallel;
+                     
+                     rv = xrif_allocate(enc);
+                     ck_assert( rv == XRIF_NOERROR );
+                     
+                     size_t nbytes = sizes[z][0]*sizes[z][1]*sizes[z][2]*sizes[z][3]*enc->data_size;
+                     
+                     char * orig = (char *) malloc(nbytes);
+                     ck_assert( orig != NULL );
+                     
+                     fill_bytes(orig, nbytes);
+                     
+                     for(int c = 0; c < 2; ++c)
+                     {
+                        if(c == 1) orig[rand() % nbytes] ^= 1;
+                        
+                        memcpy(enc->raw_buffer, orig, nbytes);
+                        
+                        rv = xrif_encode(enc);
+                        ck_assert( rv == XRIF_NOERROR );
+                        ck_assert( enc->chained == (chain && c == 1) );
+                        ck_assert( enc->compressed_size <= xrif_min_compressed_size(enc) );
+                        
+                        char header[XRIF_HEADER_SIZE];
+                        rv = xrif_write_header(header, enc);
+                        ck_assert( rv == XRIF_NOERROR );
+                        ck_assert( *((uint16_t *) &header[44]) & XRIF_HEADER_FLAG_TILED );
+                        
+                        uint32_t header_size;
+                        rv = xrif_read_header(dec, &header_size, header);
+                        ck_assert( rv == XRIF_NOERROR );
+                        ck_assert( dec->tile_size == tile_sizes[k] );
+                        ck_assert( xrif_tiled(dec) );
+                        
+                        if(c == 0)
+                        {
+                           rv = xrif_allocate(dec);
+                           ck_assert( rv == XRIF_NOERROR );
+                        }
+                        
+                        if(on_raw) memcpy(dec->raw_buffer, enc->raw_buffer, enc->compressed_size);
+                        else memcpy(dec->compressed_buffer, enc->compressed_buffer, enc->compressed_size);
+                        
+                        rv = xrif_decode(dec);
+                        ck_assert( rv == XRIF_NOERROR );
+                        
+                        ck_assert( memcmp(dec->raw_buffer, orig, nbytes) == 0 );
+                     }
+                     
+                     free(orig);
+                     
+                     rv = xrif_delete(enc);
+                     ck_assert( rv == XRIF_NOERROR );
+                     
+                     rv = xrif_delete(dec);
+                     ck_assert( rv == XRIF_NOERROR );
+                  }
+               }
+            }
+         }
+      }
+   }
+}
+END_TEST;
+
+Suite * difference_reorder_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+    TCase *tc_tiles;
+
+    s = suite_create("Fused differencing and reordering");
+
+    tc_core = tcase_create("Fused stage matches two passes");
+
+    tcase_set_timeout(tc_core, 1e9);
+    
+    tcase_add_test(tc_core, difference_reorder_match);
+    tcase_add_test(tc_core, difference_reorder_encode);
+    
+    suite_add_tcase(s, tc_core);
+    
+    tc_tiles = tcase_create("Tiled encoding");
+
+    tcase_set_timeout(tc_tiles, 1e9);
+    
+    tcase_add_test(tc_tiles, tiles_encode_decode);
+    
+    suite_add_tcase(s, tc_tiles);
+    
+    return s;
+}
+
+int main()
+{
+   int number_failed;
+   Suite *s;
+   SRunner *sr;
+
+   srand((unsigned) time(NULL));
+
+   s = difference_reorder_suite();
+   sr = srunner_create(s);
+
+   srunner_run_all(sr, CK_NORMAL);
+   number_failed = srunner_ntests_failed(sr);
+   srunner_free(sr);
+   
+   return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,600 @@
+/** \file xrif_test_difference_spatial_whitenoise.c
+  * \brief Test the spatial predictor differencing methods with white noise.
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_test_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2019, 2020, 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <limits.h>
+
+#include "../src/xrif.h"
+
+#include "randutils.h"
+
+#ifndef XRIF_TEST_TRIALS
+   #define XRIF_TEST_TRIALS (2)
+#endif
+
+int test_trials;
+
+/************************************************************/
+/* Fuzz testing differencing with the spatial predictors
+/************************************************************/
+
+
+int ws[] = {1,2,4,8,21, 33, 47, 64}; //widths of images
+int hs[] = {1,2,4,8,21, 33, 47, 64}; //heights of images
+int ps[] = {1,2,4,5,27,63,64}; //planes of the cube
+
+//Each configuration in the loop uses one of the three predictors
+#define XRIF_SPATIAL_SETUP rv = xrif_set_difference_method(hand, XRIF_DIFFERENCE_MED + 100*((w + h + p + q) % 3)); ck_assert( rv == XRIF_NOERROR );
+
+/** Verify spatial differencing for int16_t
+  * Verify that the xrif encode/decode cycle using the spatial predictors works with white noise for int16_t.
+  * \anchor diff_spatial_int16_white
+  */
+START_TEST (diff_spatial_int16_white)
+{
+   fprintf(stderr, "Testing spatial differencing for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_MED)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP XRIF_SPATIAL_SETUP
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify spatial differencing for uint16_t
+  * Verify that the xrif encode/decode cycle using the spatial predictors works with white noise for uint16_t.
+  * \anchor diff_spatial_uint16_white
+  */
+START_TEST (diff_spatial_uint16_white)
+{
+   fprintf(stderr, "Testing spatial differencing for unsigned 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_UINT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_MED)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP XRIF_SPATIAL_SETUP
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify spatial differencing for int32_t
+  * Verify that the xrif encode/decode cycle using the spatial predictors works with white noise for int32_t.
+  * \anchor diff_spatial_int32_white
+  */
+START_TEST (diff_spatial_int32_white)
+{
+   fprintf(stderr, "Testing spatial differencing for signed 32-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT32)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_MED)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP XRIF_SPATIAL_SETUP
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify spatial differencing for int64_t
+  * Verify that the xrif encode/decode cycle using the spatial predictors works with white noise for int64_t.
+  * \anchor diff_spatial_int64_white
+  */
+START_TEST (diff_spatial_int64_white)
+{
+   fprintf(stderr, "Testing spatial differencing for signed 64-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT64)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_MED)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP XRIF_SPATIAL_SETUP
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify threaded spatial differencing for int16_t
+  * Verify that the xrif difference/un-difference cycle using the spatial predictors works with threads, both above and below the pixel cutoff.
+  * \anchor diff_spatial_int16_omp
+  */
+START_TEST (diff_spatial_int16_omp)
+{
+   fprintf(stderr, "Testing threaded spatial differencing for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_MED)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_spatial
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_spatial
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP XRIF_SPATIAL_SETUP hand->omp_parallel = 1; rv = xrif_set_omp_min_pixels(hand, (q % 2 == 0) ? 0 : XRIF_OMP_MIN_PIXELS_DEFAULT); ck_assert( rv == XRIF_NOERROR );
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+//The prediction for pixel x of row y of an image, from the definitions of the predictors
+int64_t spatial_prediction( const int32_t * img,
+                            size_t w,
+                            size_t x,
+                            size_t y,
+                            int method
+                          )
+{
+   if(y == 0) return (x == 0) ? 0 : img[x-1];
+   if(x == 0) return img[(y-1)*w];
+   
+   int64_t a = img[y*w + x-1];
+   int64_t b = img[(y-1)*w + x];
+   int64_t c = img[(y-1)*w + x-1];
+   
+   if(method == XRIF_DIFFERENCE_MED)
+   {
+      int64_t mx = (a > b) ? a : b;
+      int64_t mn = (a > b) ? b : a;
+      
+      if(c >= mx) return mn;
+      if(c <= mn) return mx;
+      return a + b - c;
+   }
+   else if(method == XRIF_DIFFERENCE_PAETH)
+   {
+      int64_t p = a + b - c;
+      int64_t pa = llabs(p - a);
+      int64_t pb = llabs(p - b);
+      int64_t pc = llabs(p - c);
+      
+      if(pa <= pb && pa <= pc) return a;
+      if(pb <= pc) return b;
+      return c;
+   }
+   else
+   {
+      int64_t s = a + b;
+      return (s >= 0) ? s/2 : -((-s+1)/2);
+   }
+}
+
+/** Verify the spatial predictors
+  * For each predictor, verify that the residuals of 32 bit images with edges, ramps, and noise match the definition of the predictor
+  * computed independently, including the first row and column, and that the undifferenced images match the originals.
+  * \anchor diff_spatial_predictors
+  */
+START_TEST (diff_spatial_predictors)
+{
+   fprintf(stderr, "Testing the spatial predictors.\n");
+   
+   int methods[] = {XRIF_DIFFERENCE_MED, XRIF_DIFFERENCE_PAETH, XRIF_DIFFERENCE_AVERAGE};
+   
+   size_t w = 23;
+   size_t h = 17;
+   size_t frames = 3;
+   
+   xrif_t hand = NULL;
+   
+   xrif_error_t rv = xrif_new(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   for(int m = 0; m < 3; ++m)
+   {
+      for(int q = 0; q < test_trials; ++q)
+      {
+         rv = xrif_set_size(hand, w, h, 1, frames, XRIF_TYPECODE_INT32);
+         ck_assert( rv == XRIF_NOERROR );
+         
+         rv = xrif_configure(hand, methods[m], XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+         ck_assert( rv == XRIF_NOERROR );
+         
+         rv = xrif_allocate_raw(hand);
+         ck_assert( rv == XRIF_NOERROR );
+         
+         int32_t * buffer = (int32_t *) hand->raw_buffer;
+         
+         //A vertical edge, a diagonal ramp, and noise, with large values so the sums overflow 32 bits
+         for(size_t n = 0; n < frames; ++n)
+         {
+            for(size_t y = 0; y < h; ++y)
+            {
+               for(size_t x = 0; x < w; ++x)
+               {
+                  int32_t v;
+                  if(n == 0) v = (x < w/2) ? -2000000000 : 2000000000;
+                  else if(n == 1) v = 1000*(x + y) - 7*x*y;
+                  else v = rand() - RAND_MAX/2;
+                  
+                  buffer[n*w*h + y*w + x] = v;
+               }
+            }
+         }
+         
+         int32_t * orig = (int32_t *) malloc(w*h*frames*sizeof(int32_t));
+         ck_assert( orig != NULL );
+         memcpy(orig, buffer, w*h*frames*sizeof(int32_t));
+         
+         rv = xrif_difference_spatial(hand);
+         ck_assert( rv == XRIF_NOERROR );
+         
+         for(size_t n = 0; n < frames; ++n)
+         {
+            for(size_t y = 0; y < h; ++y)
+            {
+               for(size_t x = 0; x < w; ++x)
+               {
+                  int64_t pred = spatial_prediction(orig + n*w*h, w, x, y, methods[m]);
+                  int32_t res = (uint32_t) orig[n*w*h + y*w + x] - (uint32_t) pred;
+                  
+                  ck_assert_int_eq( buffer[n*w*h + y*w + x], res );
+               }
+            }
+         }
+         
+         rv = xrif_undifference_spatial(hand);
+         ck_assert( rv == XRIF_NOERROR );
+         
+         ck_assert( memcmp(buffer, orig, w*h*frames*sizeof(int32_t)) == 0 );
+         
+         free(orig);
+         
+         xrif_reset(hand);
+      }
+   }
+   
+   //The spatial functions only accept the spatial methods
+   rv = xrif_set_size(hand, w, h, 1, frames, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   rv = xrif_configure(hand, XRIF_DIFFERENCE_PIXEL, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+   ck_assert( rv == XRIF_NOERROR );
+   rv = xrif_allocate_raw(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_difference_spatial(hand);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   
+   rv = xrif_delete(hand);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
+/** Verify previous frame + MED differencing for int16_t
+  * Verify that the xrif encode/decode cycle using the previous frame and the median edge detector works with white noise for int16_t.
+  * \anchor diff_previous_med_int16_white
+  */
+START_TEST (diff_previous_med_int16_white)
+{
+   fprintf(stderr, "Testing previous frame + MED differencing for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS_MED)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify previous frame + MED differencing for int32_t
+  * Verify that the xrif encode/decode cycle using the previous frame and the median edge detector works with white noise for int32_t.
+  * \anchor diff_previous_med_int32_white
+  */
+START_TEST (diff_previous_med_int32_white)
+{
+   fprintf(stderr, "Testing previous frame + MED differencing for signed 32-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT32)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS_MED)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_encode
+   #define XRIF_TESTLOOP_DECODE xrif_decode
+   #define XRIF_TESTLOOP_NOPERF
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify threaded previous frame + MED differencing for int16_t
+  * Verify that the xrif difference/un-difference cycle using the previous frame and the median edge detector works with threads, 
+  * both above and below the pixel cutoff.
+  * \anchor diff_previous_med_int16_omp
+  */
+START_TEST (diff_previous_med_int16_omp)
+{
+   fprintf(stderr, "Testing threaded previous frame + MED differencing for signed 16-bit white noise.\n");
+   #define XRIF_TESTLOOP_TYPECODE (XRIF_TYPECODE_INT16)
+   #define XRIF_TESTLOOP_DIFFERENCE (XRIF_DIFFERENCE_PREVIOUS_MED)
+   #define XRIF_TESTLOOP_REORDER (XRIF_REORDER_BYTEPACK_RENIBBLE)
+   #define XRIF_TESTLOOP_COMPRESS (XRIF_COMPRESS_LZ4)
+   #define XRIF_TESTLOOP_FILL 1
+   #define XRIF_TESTLOOP_ENCODE xrif_difference_previous_med
+   #define XRIF_TESTLOOP_DECODE xrif_undifference_previous_med
+   #define XRIF_TESTLOOP_NOPERF
+   #define XRIF_TESTLOOP_SETUP hand->omp_parallel = 1; rv = xrif_set_omp_min_pixels(hand, (q % 2 == 0) ? 0 : XRIF_OMP_MIN_PIXELS_DEFAULT); ck_assert( rv == XRIF_NOERROR );
+   
+   #include "testloop.c"
+}
+END_TEST;
+
+/** Verify the previous frame + MED residuals
+  * Verify that the residuals of 32 bit cubes are the median edge detector residuals of the differences from the previous frame, 
+  * with the first frame only differenced spatially, and that the undifferenced cubes match the originals.  Both the threaded 
+  * and serial paths are checked.
+  * \anchor diff_previous_med_residuals
+  */
+START_TEST (diff_previous_med_residuals)
+{
+   fprintf(stderr, "Testing the previous frame + MED residuals.\n");
+   
+   size_t w = 37;
+   size_t h = 19;
+   size_t frames = 5;
+   
+   xrif_t hand = NULL;
+   
+   xrif_error_t rv = xrif_new(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   int32_t * orig = (int32_t *) malloc(w*h*frames*sizeof(int32_t));
+   ck_assert( orig != NULL );
+   
+   int32_t * temporal = (int32_t *) malloc(w*h*sizeof(int32_t));
+   ck_assert( temporal != NULL );
+   
+   for(int q = 0; q < 2*test_trials; ++q)
+   {
+      rv = xrif_set_size(hand, w, h, 1, frames, XRIF_TYPECODE_INT32);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_configure(hand, XRIF_DIFFERENCE_PREVIOUS_MED, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      rv = xrif_allocate_raw(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      hand->omp_parallel = q % 2;
+      rv = xrif_set_omp_min_pixels(hand, 0);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      int32_t * buffer = (int32_t *) hand->raw_buffer;
+      
+      //A fixed ramp with an edge, plus a moving spot and noise which change from frame to frame
+      for(size_t n = 0; n < frames; ++n)
+      {
+         for(size_t y = 0; y < h; ++y)
+         {
+            for(size_t x = 0; x < w; ++x)
+            {
+               int32_t v = 1000*(x + y) + ((x > w/2) ? 50000 : 0);
+               if(x/4 == n && y/4 == n) v += 20000;
+               v += rand() % 64;
+               
+               buffer[n*w*h + y*w + x] = v;
+            }
+         }
+      }
+      
+      memcpy(orig, buffer, w*h*frames*sizeof(int32_t));
+      
+      rv = xrif_difference_previous_med(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      for(size_t n = 0; n < frames; ++n)
+      {
+         for(size_t i = 0; i < w*h; ++i)
+         {
+            temporal[i] = orig[n*w*h + i] - ((n > 0) ? orig[(n-1)*w*h + i] : 0);
+         }
+         
+         for(size_t y = 0; y < h; ++y)
+         {
+            for(size_t x = 0; x < w; ++x)
+            {
+               int64_t pred = spatial_prediction(temporal, w, x, y, XRIF_DIFFERENCE_MED);
+               
+               ck_assert_int_eq( buffer[n*w*h + y*w + x], temporal[y*w + x] - pred );
+            }
+         }
+      }
+      
+      rv = xrif_undifference_previous_med(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      
+      ck_assert( memcmp(buffer, orig, w*h*frames*sizeof(int32_t)) == 0 );
+      
+      xrif_reset(hand);
+   }
+   
+   free(temporal);
+   free(orig);
+   
+   rv = xrif_delete(hand);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST;
+
+Suite * whitenoise_suite(void)
+{
+    Suite *s;
+    TCase *tc_core16, *tc_core32, *tc_core64;
+
+    s = suite_create("White Noise - Difference Spatial");
+
+    /* 16-bit Core test case */
+    tc_core16 = tcase_create("16 bit white noise");
+
+    tcase_set_timeout(tc_core16, 1e9);
+    
+    tcase_add_test(tc_core16, diff_spatial_int16_white);
+    tcase_add_test(tc_core16, diff_spatial_uint16_white);
+    tcase_add_test(tc_core16, diff_spatial_int16_omp);
+    tcase_add_test(tc_core16, diff_previous_med_int16_white);
+    tcase_add_test(tc_core16, diff_previous_med_int16_omp);
+    
+    suite_add_tcase(s, tc_core16);
+    
+    /* 32-bit Core test case */
+    tc_core32 = tcase_create("32 bit white noise");
+
+    tcase_set_timeout(tc_core32, 1e9);
+    
+    tcase_add_test(tc_core32, diff_spatial_int32_white);
+    tcase_add_test(tc_core32, diff_spatial_predictors);
+    tcase_add_test(tc_core32, diff_previous_med_int32_white);
+    tcase_add_test(tc_core32, diff_previous_med_residuals);
+    
+    suite_add_tcase(s, tc_core32);
+
+    /* 64-bit Core test case */
+    tc_core64 = tcase_create("64 bit white noise");
+
+    tcase_set_timeout(tc_core64, 1e9);
+    
+    tcase_add_test(tc_core64, diff_spatial_int64_white);
+    
+    suite_add_tcase(s, tc_core64);
+    
+    return s;
+}
+
+int main( int argc,
+          char ** argv
+        )
+{
+   
+   extern int test_trials;
+   
+   test_trials = XRIF_TEST_TRIALS;
+   
+   if(argc == 2)
+   {
+      test_trials = atoi(argv[1]);
+   }
+   
+   fprintf(stderr, "running %d trials per format\n", test_trials);
+   
+   int number_failed;
+   Suite *s;
+   SRunner *sr;
+
+   // Intialize the random number sequence
+   srand((unsigned) time(NULL));
+   
+
+   
+   s = whitenoise_suite();
+   sr = srunner_create(s);
+
+   srunner_run_all(sr, CK_NORMAL);
+   number_failed = srunner_ntests_failed(sr);
+   srunner_free(sr);
+   
+   return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+   
+}
+
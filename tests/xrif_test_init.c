@@ -112,12 +112,27 @@ START_TEST (initialize_handle_noerror)
    ck_assert_int_eq( hand.data_size, 0);
    ck_assert_int_eq( hand.compressed_size, 0);
    ck_assert_int_eq( hand.difference_method, XRIF_DIFFERENCE_DEFAULT);
+   ck_assert_int_eq( hand.chain_cubes, 0);
+   ck_assert_int_eq( hand.chained, 0);
+   ck_assert_int_eq( hand.chain_index, 0);
    ck_assert_int_eq( hand.reorder_method, XRIF_REORDER_DEFAULT);
    ck_assert_int_eq( hand.compress_method, XRIF_COMPRESS_DEFAULT);
    ck_assert_int_eq( hand.lz4_acceleration, 1);
+   ck_assert_int_eq( hand.lz4hc_level, XRIF_LZ4HC_LEVEL_DEFAULT);
+   ck_assert_int_eq( hand.lz4_memory_usage, XRIF_LZ4_MEMORY_USAGE_DEFAULT);
+   ck_assert_int_eq( hand.zstd_level, XRIF_ZSTD_LEVEL_DEFAULT);
+   ck_assert_int_eq( hand.zstd_workers, 0);
+   ck_assert_int_eq( hand.compress_block_size, 0);
+   ck_assert_int_eq( hand.tile_size, 0);
+   ck_assert_int_eq( hand.lz4_stream, 0);
+   ck_assert_int_eq( hand.lz4_chained, 0);
+   ck_assert_int_eq( hand.compress_planes, 0);
+   ck_assert( hand.skip_entropy == 0 );
    ck_assert_int_eq( hand.omp_parallel, 0);
    ck_assert_int_eq( hand.omp_numthreads, 1);
+   ck_assert_int_eq( hand.omp_min_pixels, XRIF_OMP_MIN_PIXELS_DEFAULT);
    ck_assert_int_eq( hand.compress_on_raw, 1);
+   ck_assert_int_eq( hand.compress_skipped, 0);
    ck_assert_int_eq( hand.own_raw, 0);
    ck_assert( hand.raw_buffer == NULL );
    ck_assert_int_eq( hand.raw_buffer_size, 0);
@@ -127,6 +142,21 @@ START_TEST (initialize_handle_noerror)
    ck_assert_int_eq( hand.own_compressed, 0);
    ck_assert( hand.compressed_buffer == NULL );
    ck_assert_int_eq( hand.compressed_buffer_size, 0);
+   ck_assert( hand.chain_buffer == NULL );
+   ck_assert_int_eq( hand.chain_buffer_size, 0);
+   ck_assert_int_eq( hand.chain_encode_valid, 0);
+   ck_assert_int_eq( hand.chain_decode_valid, 0);
+   ck_assert( hand.lz4_stream_encode == NULL );
+   ck_assert( hand.lz4hc_stream_encode == NULL );
+   ck_assert( hand.lz4_stream_decode == NULL );
+   ck_assert( hand.lz4_dict_buffer == NULL );
+   ck_assert_int_eq( hand.lz4_dict_encode_size, 0);
+   ck_assert_int_eq( hand.lz4_dict_decode_size, 0);
+   ck_assert( hand.lz4_state == NULL );
+   ck_assert_int_eq( hand.lz4_state_size, 0);
+   ck_assert_int_eq( hand.lz4_nstates, 0);
+   ck_assert( hand.zstd_cctx == NULL );
+   ck_assert( hand.zstd_dctx == NULL );
    
    ck_assert( rv == XRIF_NOERROR );
 }
@@ -165,11 +195,23 @@ START_TEST (new_delete_noerror)
    ck_assert_int_eq( hand->data_size, 0);
    ck_assert_int_eq( hand->compressed_size, 0);
    ck_assert_int_eq( hand->difference_method, XRIF_DIFFERENCE_DEFAULT);
+   ck_assert_int_eq( hand->chain_cubes, 0);
+   ck_assert_int_eq( hand->chained, 0);
+   ck_assert_int_eq( hand->chain_index, 0);
    ck_assert_int_eq( hand->reorder_method, XRIF_REORDER_DEFAULT);
    ck_assert_int_eq( hand->compress_method, XRIF_COMPRESS_DEFAULT);
    ck_assert_int_eq( hand->lz4_acceleration, 1);
+   ck_assert_int_eq( hand->lz4hc_level, XRIF_LZ4HC_LEVEL_DEFAULT);
+   ck_assert_int_eq( hand->lz4_memory_usage, XRIF_LZ4_MEMORY_USAGE_DEFAULT);
+   ck_assert_int_eq( hand->zstd_level, XRIF_ZSTD_LEVEL_DEFAULT);
+   ck_assert_int_eq( hand->zstd_workers, 0);
+   ck_assert_int_eq( hand->compress_block_size, 0);
+   ck_assert_int_eq( hand->tile_size, 0);
+   ck_assert_int_eq( hand->lz4_stream, 0);
+   ck_assert_int_eq( hand->lz4_chained, 0);
    ck_assert_int_eq( hand->omp_parallel, 0);
    ck_assert_int_eq( hand->omp_numthreads, 1);
+   ck_assert_int_eq( hand->omp_min_pixels, XRIF_OMP_MIN_PIXELS_DEFAULT);
    ck_assert_int_eq( hand->compress_on_raw, 1);
    ck_assert_int_eq( hand->own_raw, 0);
    ck_assert( hand->raw_buffer == NULL );
@@ -180,6 +222,21 @@ START_TEST (new_delete_noerror)
    ck_assert_int_eq( hand->own_compressed, 0);
    ck_assert( hand->compressed_buffer == NULL );
    ck_assert_int_eq( hand->compressed_buffer_size, 0);
+   ck_assert( hand->chain_buffer == NULL );
+   ck_assert_int_eq( hand->chain_buffer_size, 0);
+   ck_assert_int_eq( hand->chain_encode_valid, 0);
+   ck_assert_int_eq( hand->chain_decode_valid, 0);
+   ck_assert( hand->lz4_stream_encode == NULL );
+   ck_assert( hand->lz4hc_stream_encode == NULL );
+   ck_assert( hand->lz4_stream_decode == NULL );
+   ck_assert( hand->lz4_dict_buffer == NULL );
+   ck_assert_int_eq( hand->lz4_dict_encode_size, 0);
+   ck_assert_int_eq( hand->lz4_dict_decode_size, 0);
+   ck_assert( hand->lz4_state == NULL );
+   ck_assert_int_eq( hand->lz4_state_size, 0);
+   ck_assert_int_eq( hand->lz4_nstates, 0);
+   ck_assert( hand->zstd_cctx == NULL );
+   ck_assert( hand->zstd_dctx == NULL );
    
    ck_assert( rv == XRIF_NOERROR );
    
@@ -212,12 +269,27 @@ START_TEST (setup_noerror)
    //And we check that everything else is unaltered
    ck_assert_int_eq( hand.compressed_size, 0);
    ck_assert_int_eq( hand.difference_method, XRIF_DIFFERENCE_DEFAULT);
+   ck_assert_int_eq( hand.chain_cubes, 0);
+   ck_assert_int_eq( hand.chained, 0);
+   ck_assert_int_eq( hand.chain_index, 0);
    ck_assert_int_eq( hand.reorder_method, XRIF_REORDER_DEFAULT);
    ck_assert_int_eq( hand.compress_method, XRIF_COMPRESS_DEFAULT);
    ck_assert_int_eq( hand.lz4_acceleration, 1);
+   ck_assert_int_eq( hand.lz4hc_level, XRIF_LZ4HC_LEVEL_DEFAULT);
+   ck_assert_int_eq( hand.lz4_memory_usage, XRIF_LZ4_MEMORY_USAGE_DEFAULT);
+   ck_assert_int_eq( hand.zstd_level, XRIF_ZSTD_LEVEL_DEFAULT);
+   ck_assert_int_eq( hand.zstd_workers, 0);
+   ck_assert_int_eq( hand.compress_block_size, 0);
+   ck_assert_int_eq( hand.tile_size, 0);
+   ck_assert_int_eq( hand.lz4_stream, 0);
+   ck_assert_int_eq( hand.lz4_chained, 0);
+   ck_assert_int_eq( hand.compress_planes, 0);
+   ck_assert( hand.skip_entropy == 0 );
    ck_assert_int_eq( hand.omp_parallel, 0);
    ck_assert_int_eq( hand.omp_numthreads, 1);
+   ck_assert_int_eq( hand.omp_min_pixels, XRIF_OMP_MIN_PIXELS_DEFAULT);
    ck_assert_int_eq( hand.compress_on_raw, 1);
+   ck_assert_int_eq( hand.compress_skipped, 0);
    ck_assert_int_eq( hand.own_raw, 0);
    ck_assert( hand.raw_buffer == NULL );
    ck_assert_int_eq( hand.raw_buffer_size, 0);
@@ -227,6 +299,21 @@ START_TEST (setup_noerror)
    ck_assert_int_eq( hand.own_compressed, 0);
    ck_assert( hand.compressed_buffer == NULL );
    ck_assert_int_eq( hand.compressed_buffer_size, 0);
+   ck_assert( hand.chain_buffer == NULL );
+   ck_assert_int_eq( hand.chain_buffer_size, 0);
+   ck_assert_int_eq( hand.chain_encode_valid, 0);
+   ck_assert_int_eq( hand.chain_decode_valid, 0);
+   ck_assert( hand.lz4_stream_encode == NULL );
+   ck_assert( hand.lz4hc_stream_encode == NULL );
+   ck_assert( hand.lz4_stream_decode == NULL );
+   ck_assert( hand.lz4_dict_buffer == NULL );
+   ck_assert_int_eq( hand.lz4_dict_encode_size, 0);
+   ck_assert_int_eq( hand.lz4_dict_decode_size, 0);
+   ck_assert( hand.lz4_state == NULL );
+   ck_assert_int_eq( hand.lz4_state_size, 0);
+   ck_assert_int_eq( hand.lz4_nstates, 0);
+   ck_assert( hand.zstd_cctx == NULL );
+   ck_assert( hand.zstd_dctx == NULL );
    
    ck_assert( rv == XRIF_NOERROR );
 }
@@ -599,6 +686,614 @@ START_TEST (header_read)
 
 END_TEST
 
+START_TEST (header_read_lz4hc)
+{
+   //This test verifies that the LZ4HC level is written to and read from the header
+   
+   xrif_handle hand;
+   
+   xrif_error_t rv = xrif_initialize_handle(&hand);
+   
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(&hand, 120,240,2,1000, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_compress_method(&hand, XRIF_COMPRESS_LZ4HC);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_lz4hc_level(&hand, 12);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   char header[XRIF_HEADER_SIZE];
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( *((uint16_t *) &header[34]) == XRIF_COMPRESS_LZ4HC);
+   ck_assert( *((uint16_t *) &header[40]) == 12);
+   
+   xrif_handle hand2;
+   
+   rv = xrif_initialize_handle(&hand2);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   uint32_t header_size;
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( hand2.compress_method, XRIF_COMPRESS_LZ4HC);
+   ck_assert_int_eq( hand2.lz4hc_level, 12);
+   ck_assert_int_eq( hand2.lz4_acceleration, 1);
+   
+   //Out of range levels are clamped
+   rv = xrif_set_lz4hc_level(&hand, 0);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.lz4hc_level, XRIF_LZ4HC_LEVEL_MIN);
+   
+   rv = xrif_set_lz4hc_level(&hand, 100);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.lz4hc_level, XRIF_LZ4HC_LEVEL_MAX);
+}
+END_TEST
+
+START_TEST (lz4_state_allocate)
+{
+   //This test verifies the LZ4 hash table size setting, and that the LZ4 compression state is allocated by xrif_allocate and reused
+   
+   xrif_t hand = NULL;
+   
+   xrif_error_t rv = xrif_new(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   //Out of range and odd sizes are adjusted
+   rv = xrif_set_lz4_memory_usage(hand, 10);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand->lz4_memory_usage, XRIF_LZ4_MEMORY_USAGE_MIN);
+   
+   rv = xrif_set_lz4_memory_usage(hand, 22);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand->lz4_memory_usage, XRIF_LZ4_MEMORY_USAGE_MAX);
+   
+   rv = xrif_set_lz4_memory_usage(hand, 15);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand->lz4_memory_usage, 16);
+   
+   rv = xrif_set_lz4_memory_usage(hand, 12);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand->lz4_memory_usage, 12);
+   
+   rv = xrif_set_size(hand, 64, 64, 1, 4, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_configure(hand, XRIF_DIFFERENCE_PREVIOUS, XRIF_REORDER_BYTEPACK, XRIF_COMPRESS_LZ4);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_allocate(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( hand->lz4_state != NULL );
+   ck_assert_int_eq( hand->lz4_nstates, 1);
+   ck_assert_int_eq( hand->lz4_state_size % 64, 0);
+   ck_assert( hand->lz4_state_size >= (size_t) xrif_lz4_sizeofState(12) );
+   ck_assert_int_eq( hand->lz4_state_memory_usage, 12);
+   
+   //The same state is used for each compression
+   char * state = hand->lz4_state;
+   
+   for(int c = 0; c < 2; ++c)
+   {
+      rv = xrif_encode(hand);
+      ck_assert( rv == XRIF_NOERROR );
+      ck_assert( hand->lz4_state == state );
+   }
+   
+   //A larger table needs a larger state
+   rv = xrif_set_lz4_memory_usage(hand, 20);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_encode(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand->lz4_state_memory_usage, 20);
+   ck_assert( hand->lz4_state_size >= (1 << 20) );
+   
+   //LZ4HC has its own state
+   rv = xrif_set_compress_method(hand, XRIF_COMPRESS_LZ4HC);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_encode(hand);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand->lz4_state_method, XRIF_COMPRESS_LZ4HC);
+   ck_assert( hand->lz4_state_size >= (size_t) LZ4_sizeofStateHC() );
+   
+   rv = xrif_delete(hand);
+   ck_assert( rv == XRIF_NOERROR );
+}
+END_TEST
+
+START_TEST (header_read_zstd)
+{
+   //This test verifies that the zstd level is written to and read from the header, and the zstd settings
+   
+   xrif_handle hand;
+   
+   xrif_error_t rv = xrif_initialize_handle(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(&hand, 120,240,2,1000, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_compress_method(&hand, XRIF_COMPRESS_ZSTD);
+   
+   #ifdef XRIF_USE_ZSTD
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand.compress_method, XRIF_COMPRESS_ZSTD);
+   #else
+   //Without zstd the default is used
+   ck_assert( rv == XRIF_ERROR_NOTIMPL );
+   ck_assert_int_eq( hand.compress_method, XRIF_COMPRESS_DEFAULT);
+   hand.compress_method = XRIF_COMPRESS_ZSTD;
+   #endif
+   
+   rv = xrif_set_zstd_level(&hand, -5);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   char header[XRIF_HEADER_SIZE];
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( *((int16_t *) &header[34]) == XRIF_COMPRESS_ZSTD);
+   ck_assert( *((int16_t *) &header[40]) == -5);
+   
+   xrif_handle hand2;
+   
+   rv = xrif_initialize_handle(&hand2);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   uint32_t header_size;
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( hand2.compress_method, XRIF_COMPRESS_ZSTD);
+   ck_assert_int_eq( hand2.zstd_level, -5);
+   
+   //Out of range settings are clamped
+   rv = xrif_set_zstd_level(&hand, 100);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.zstd_level, XRIF_ZSTD_LEVEL_MAX);
+   
+   rv = xrif_set_zstd_level(&hand, -100000);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.zstd_level, XRIF_ZSTD_LEVEL_MIN);
+   
+   rv = xrif_set_zstd_workers(&hand, 4);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand.zstd_workers, 4);
+   
+   rv = xrif_set_zstd_workers(&hand, -1);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.zstd_workers, 0);
+   
+   #ifndef XRIF_USE_ZSTD
+   //Data compressed with zstd can not be decoded
+   ck_assert( xrif_decompress_zstd(&hand2) == XRIF_ERROR_NOTIMPL );
+   #endif
+}
+END_TEST
+
+START_TEST (header_read_blocks)
+{
+   //This test verifies that the compression block size is written to and read from the header, and that unknown header flags are rejected
+   
+   xrif_handle hand;
+   
+   xrif_error_t rv = xrif_initialize_handle(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(&hand, 120,120,1,1000, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_compress_block_size(&hand, 64*XRIF_COMPRESS_BLOCK_UNIT);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( xrif_compress_nblocks(&hand), (120*120*1000*2 + 64*1024 - 1)/(64*1024));
+   
+   //The compressed buffer must have room for the table and a worst-case slot for each block
+   ck_assert( xrif_min_compressed_size(&hand) >= XRIF_BLOCK_TABLE_SIZE(xrif_compress_nblocks(&hand)) + xrif_min_reordered_size(&hand));
+   
+   char header[XRIF_HEADER_SIZE];
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( *((uint16_t *) &header[42]) == 64);
+   
+   xrif_handle hand2;
+   
+   rv = xrif_initialize_handle(&hand2);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   uint32_t header_size;
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( hand2.compress_block_size, 64*XRIF_COMPRESS_BLOCK_UNIT);
+   
+   //Unknown flags are rejected
+   *((uint16_t *) &header[44]) = 0x8000;
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_ERROR_BADHEADER );
+   
+   //Invalid sizes are rounded up
+   rv = xrif_set_compress_block_size(&hand, 1000);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.compress_block_size, XRIF_COMPRESS_BLOCK_UNIT);
+   
+   rv = xrif_set_compress_block_size(&hand, XRIF_COMPRESS_BLOCK_SIZE_MAX + 1);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.compress_block_size, XRIF_COMPRESS_BLOCK_SIZE_MAX);
+}
+END_TEST
+
+START_TEST (header_read_chained)
+{
+   //This test verifies that the cube chaining flags and index are written to and read from the header
+   
+   xrif_handle hand;
+   
+   xrif_error_t rv = xrif_initialize_handle(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(&hand, 120,120,1,16, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   char header[XRIF_HEADER_SIZE];
+   
+   //A keyframe has no flags
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( *((uint16_t *) &header[44]) == 0);
+   ck_assert( *((uint16_t *) &header[46]) == 0);
+   
+   hand.chained = 1;
+   hand.chain_index = 65535;
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( *((uint16_t *) &header[44]) == XRIF_HEADER_FLAG_CHAINED);
+   ck_assert( *((uint16_t *) &header[46]) == 65535);
+   
+   xrif_handle hand2;
+   
+   rv = xrif_initialize_handle(&hand2);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   uint32_t header_size;
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( hand2.chained, 1);
+   ck_assert_int_eq( hand2.chain_index, 65535);
+   
+   //The reordering includes the first frame of a chained cube
+   ck_assert_int_eq( xrif_reorder_first_frame(&hand2), 1);
+   
+   hand.chained = 0;
+   hand.chain_index = 0;
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( hand2.chained, 0);
+   ck_assert_int_eq( xrif_reorder_first_frame(&hand2), 0);
+   
+   //LZ4 streaming is flagged independently, and does not change the reordering
+   hand.lz4_chained = 1;
+   hand.chain_index = 7;
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( *((uint16_t *) &header[44]) == XRIF_HEADER_FLAG_LZ4_CHAINED);
+   ck_assert( *((uint16_t *) &header[46]) == 7);
+   
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( hand2.chained, 0);
+   ck_assert_int_eq( hand2.lz4_chained, 1);
+   ck_assert_int_eq( hand2.chain_index, 7);
+   ck_assert_int_eq( xrif_reorder_first_frame(&hand2), 0);
+}
+END_TEST
+
+START_TEST (header_read_planes)
+{
+   //This test verifies that per-plane compression is flagged in the header, and sizes the compressed buffer for the plane table
+   
+   xrif_handle hand;
+   
+   xrif_error_t rv = xrif_initialize_handle(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(&hand, 120,120,1,16, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_compress_block_size(&hand, 64*XRIF_COMPRESS_BLOCK_UNIT);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_compress_planes(&hand, 1);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand.compress_planes, 1);
+   ck_assert_int_eq( xrif_compress_by_plane(&hand), 1);
+   
+   //The two byte planes, and the first frame
+   ck_assert_int_eq( xrif_compress_nplanes(&hand), 3);
+   
+   size_t plane_sizes[XRIF_COMPRESS_PLANES_MAX];
+   ck_assert_int_eq( xrif_compress_plane_sizes(&hand, plane_sizes), 3);
+   ck_assert_int_eq( plane_sizes[0], 120*120*2);
+   ck_assert_int_eq( plane_sizes[1], 120*120*15);
+   ck_assert_int_eq( plane_sizes[2], 120*120*15);
+   
+   //A plane never takes more than its own size
+   ck_assert_int_eq( xrif_min_compressed_size(&hand), XRIF_BLOCK_TABLE_SIZE(3*3) + xrif_min_reordered_size(&hand));
+   
+   char header[XRIF_HEADER_SIZE];
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   //Blocks are not used with planes
+   ck_assert( *((uint16_t *) &header[42]) == 0);
+   ck_assert( *((uint16_t *) &header[44]) == XRIF_HEADER_FLAG_PLANES);
+   
+   xrif_handle hand2;
+   
+   rv = xrif_initialize_handle(&hand2);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   uint32_t header_size;
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( hand2.compress_planes, 1);
+   ck_assert_int_eq( hand2.compress_block_size, 0);
+   
+   //Not used with rANS, which always codes planes, or without compression
+   rv = xrif_set_compress_method(&hand, XRIF_COMPRESS_RANS);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( xrif_compress_by_plane(&hand), 0);
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert( *((uint16_t *) &header[44]) == 0);
+   
+   rv = xrif_set_compress_method(&hand, XRIF_COMPRESS_NONE);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( xrif_compress_by_plane(&hand), 0);
+   
+   rv = xrif_set_compress_planes(NULL, 1);
+   ck_assert( rv == XRIF_ERROR_NULLPTR );
+   
+   //The entropy threshold is limited to 0 to 8 bits per byte
+   rv = xrif_set_skip_entropy(&hand, 7.5);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert( hand.skip_entropy == 7.5 );
+   
+   rv = xrif_set_skip_entropy(&hand, -1);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert( hand.skip_entropy == 0 );
+   
+   rv = xrif_set_skip_entropy(&hand, 9);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert( hand.skip_entropy == 8 );
+   
+   rv = xrif_set_skip_entropy(NULL, 1);
+   ck_assert( rv == XRIF_ERROR_NULLPTR );
+}
+END_TEST
+
+START_TEST (header_read_tiles)
+{
+   //This test verifies that tiling is flagged in the header with the tile size in place of the block size, and sizes the buffers for the tile table
+   
+   xrif_handle hand;
+   
+   xrif_error_t rv = xrif_initialize_handle(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_size(&hand, 120,120,1,16, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_compress_block_size(&hand, 64*XRIF_COMPRESS_BLOCK_UNIT);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( xrif_tiled(&hand), 0);
+   ck_assert_int_eq( xrif_ntiles(&hand), 0);
+   
+   rv = xrif_set_tile_size(&hand, 256*XRIF_COMPRESS_BLOCK_UNIT);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand.tile_size, 256*XRIF_COMPRESS_BLOCK_UNIT);
+   ck_assert_int_eq( xrif_tiled(&hand), 1);
+   ck_assert_int_eq( xrif_ntiles(&hand), 2);
+   
+   //Each tile takes at most its own size, and the compressed tiles are staged in the reordered buffer
+   ck_assert_int_eq( xrif_min_compressed_size(&hand), XRIF_BLOCK_TABLE_SIZE(2) + 120*120*16*2 + 1);
+   ck_assert_int_eq( xrif_min_reordered_size(&hand), 2*256*XRIF_COMPRESS_BLOCK_UNIT);
+   
+   char header[XRIF_HEADER_SIZE];
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( *((uint16_t *) &header[42]) == 256);
+   ck_assert( *((uint16_t *) &header[44]) == XRIF_HEADER_FLAG_TILED);
+   
+   xrif_handle hand2;
+   
+   rv = xrif_initialize_handle(&hand2);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   uint32_t header_size;
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( hand2.tile_size, 256*XRIF_COMPRESS_BLOCK_UNIT);
+   ck_assert_int_eq( hand2.compress_block_size, 0);
+   ck_assert_int_eq( xrif_tiled(&hand2), 1);
+   
+   //Tiling needs a fused difference and reorder stage, and LZ4
+   rv = xrif_set_reorder_method(&hand, XRIF_REORDER_BITPACK);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( xrif_tiled(&hand), 0);
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert( *((uint16_t *) &header[42]) == 64);
+   ck_assert( *((uint16_t *) &header[44]) == 0);
+   
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand2.tile_size, 0);
+   ck_assert_int_eq( hand2.compress_block_size, 64*XRIF_COMPRESS_BLOCK_UNIT);
+   
+   rv = xrif_set_reorder_method(&hand, XRIF_REORDER_BYTEPACK);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_compress_method(&hand, XRIF_COMPRESS_RANS);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( xrif_tiled(&hand), 0);
+   
+   rv = xrif_set_tile_size(&hand, 1000);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.tile_size, XRIF_COMPRESS_BLOCK_UNIT);
+   
+   rv = xrif_set_tile_size(&hand, XRIF_COMPRESS_BLOCK_SIZE_MAX + 1);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.tile_size, XRIF_COMPRESS_BLOCK_SIZE_MAX);
+   
+   rv = xrif_set_tile_size(NULL, 0);
+   ck_assert( rv == XRIF_ERROR_NULLPTR );
+}
+END_TEST
+
+/** Verify the key frame interval in the header
+  * Verify that the key frame interval is flagged in the header in place of the chain index for the temporal methods only, that it is 
+  * restored from the header, that it is range checked, and that it can not be combined with chaining or streaming.
+  * \anchor header_read_keyframes
+  */
+START_TEST (header_read_keyframes)
+{
+   xrif_handle hand;
+   
+   xrif_error_t rv = xrif_initialize_handle(&hand);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand.keyframe_interval, 0);
+   
+   rv = xrif_set_size(&hand, 120,120,1,16, XRIF_TYPECODE_INT16);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( xrif_segment_frames(&hand), 16);
+   
+   rv = xrif_set_keyframe_interval(&hand, 5);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand.keyframe_interval, 5);
+   ck_assert_int_eq( xrif_segment_frames(&hand), 5);
+   
+   char header[XRIF_HEADER_SIZE];
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert( *((uint16_t *) &header[44]) & XRIF_HEADER_FLAG_KEYFRAMES);
+   ck_assert( *((uint16_t *) &header[46]) == 5);
+   
+   xrif_handle hand2;
+   
+   rv = xrif_initialize_handle(&hand2);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   uint32_t header_size;
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   
+   ck_assert_int_eq( hand2.keyframe_interval, 5);
+   ck_assert_int_eq( hand2.chain_index, 0);
+   
+   //Without a key frame interval the chain index is written as before
+   rv = xrif_set_keyframe_interval(&hand, 0);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( xrif_segment_frames(&hand), 16);
+   
+   hand.chain_index = 7;
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert( (*((uint16_t *) &header[44]) & XRIF_HEADER_FLAG_KEYFRAMES) == 0);
+   ck_assert( *((uint16_t *) &header[46]) == 7);
+   
+   rv = xrif_read_header( &hand2, &header_size, header );
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( hand2.keyframe_interval, 0);
+   ck_assert_int_eq( hand2.chain_index, 7);
+   
+   //Methods which do not use the key frame interval keep the chain index
+   rv = xrif_set_keyframe_interval(&hand, 5);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   hand.difference_method = XRIF_DIFFERENCE_PIXEL;
+   ck_assert_int_eq( xrif_has_keyframe_interval(&hand), 0);
+   
+   rv = xrif_write_header( header, &hand );
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert( (*((uint16_t *) &header[44]) & XRIF_HEADER_FLAG_KEYFRAMES) == 0);
+   ck_assert( *((uint16_t *) &header[46]) == 7);
+   
+   hand.difference_method = XRIF_DIFFERENCE_LINEAR;
+   ck_assert_int_eq( xrif_has_keyframe_interval(&hand), 1);
+   
+   //A key frame interval can not be combined with chaining or streaming, which need the chain index
+   rv = xrif_set_chain_cubes(&hand, 1);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.chain_cubes, 0);
+   
+   rv = xrif_set_lz4_stream(&hand, 1);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.lz4_stream, 0);
+   
+   rv = xrif_set_keyframe_interval(&hand, 0);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_lz4_stream(&hand, 1);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   rv = xrif_set_keyframe_interval(&hand, 5);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.keyframe_interval, 0);
+   
+   rv = xrif_set_lz4_stream(&hand, 0);
+   ck_assert( rv == XRIF_NOERROR );
+   
+   //An interval longer than the cube is one segment
+   rv = xrif_set_keyframe_interval(&hand, 20);
+   ck_assert( rv == XRIF_NOERROR );
+   ck_assert_int_eq( xrif_segment_frames(&hand), 16);
+   
+   rv = xrif_set_keyframe_interval(&hand, UINT16_MAX + 1);
+   ck_assert( rv == XRIF_ERROR_BADARG );
+   ck_assert_int_eq( hand.keyframe_interval, UINT16_MAX);
+   
+   rv = xrif_set_keyframe_interval(NULL, 0);
+   ck_assert( rv == XRIF_ERROR_NULLPTR );
+}
+END_TEST
+
 Suite * initandalloc_suite(void)
 {
     Suite *s;
@@ -638,6 +1333,14 @@ Suite * headerformat_suite(void)
 
     tcase_add_test(tc_core, header_write );
     tcase_add_test(tc_core, header_read );
+    tcase_add_test(tc_core, header_read_lz4hc );
+    tcase_add_test(tc_core, lz4_state_allocate );
+    tcase_add_test(tc_core, header_read_zstd );
+    tcase_add_test(tc_core, header_read_blocks );
+    tcase_add_test(tc_core, header_read_chained );
+    tcase_add_test(tc_core, header_read_planes );
+    tcase_add_test(tc_core, header_read_tiles );
+    tcase_add_test(tc_core, header_read_keyframes );
     suite_add_tcase(s, tc_core);
 
     return s;
@@ -0,0 +1,690 @@
+/** \file xrif_test_reorder_simd.c
+  * \brief Test the vectorized reordering kernels
+  *
+  * \author Jared R. Males (jaredmales@gmail.com)
+  *
+  * \ingroup xrif_files
+  */
+
+/* This file is part of the xrif library.
+
+Copyright (c) 2021 The Arizona Board of Regents on behalf of The
+University of Arizona
+
+All rights reserved.
+
+Developed by: The Arizona Board of Regents on behalf of the
+University of Arizona.
+
+Redistribution and use for noncommercial purposes in source and
+binary forms, with or without modification, are permitted provided
+that the following conditions are met:
+
+1. The software is used solely for noncommercial purposes.
+
+2. Redistributions of source code must retain the above copyright
+notice, terms and conditions specified herein and the disclaimer
+specified in Section 4 below.
+
+3. Redistributions in binary form must reproduce the above
+copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided
+with the distribution.
+
+4. Neither the name of the Arizona Board of Regents, the University
+of Arizona nor the names of other contributors may be used to
+endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Arizona Required Clauses:
+
+1.1. Arbitration. The parties agree that if a dispute arises
+between them concerning this Agreement, the parties may be required
+to submit the matter to arbitration pursuant to Arizona law.
+
+1.2. Applicable Law and Venue. This Agreement shall be interpreted
+pursuant to the laws of the State of Arizona. Any arbitration or
+litigation between the Parties shall be conducted in Pima County,
+ARIZONA, and LICENSEE hereby submits to venue and jurisdiction in
+Pima County, ARIZONA.
+
+1.3. Non-Discrimination. The Parties agree to be bound by state and
+federal laws and regulations governing equal opportunity and non-
+discrimination and immigration.
+
+1.4. Appropriation of Funds. The Parties recognize that performance
+by ARIZONA may depend upon appropriation of funds by the State
+Legislature of ARIZONA. If the Legislature fails to appropriate the
+necessary funds, or if ARIZONA’S appropriation is reduced during
+the fiscal year, ARIZONA may cancel this Agreement without further
+duty or obligation. ARIZONA will notify LICENSEE as soon as
+reasonably possible after it knows of the loss of funds.
+
+1.5. Conflict of Interest. This Agreement is subject to the
+provisions of A.R.S. 38-511 and other conflict of interest
+regulations. Within three years of the EFFECTIVE DATE, ARIZONA may
+cancel this Agreement if any person significantly involved in
+initiating, negotiating, drafting, securing, or creating this
+Agreement for or on behalf of ARIZONA becomes an employee or
+consultant in any capacity of LICENSEE with respect to the subject
+matter of this Agreement.
+
+*/
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../src/xrif.h"
+
+//Numbers of pixels, chosen to exercise the vector loops and the scalar tails
+size_t npixs[] = {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 1000, XRIF_REORDER_CHUNK+7};
+
+#define NNPIX (sizeof(npixs)/sizeof(npixs[0]))
+
+//Fill 16 bit pixels so that the sign fixup is exercised: high bytes of 0 and -1 with both signs of low byte are common
+void fill_sint16( char * raw,
+                  size_t npix
+                )
+{
+   for(size_t i = 0; i < npix; ++i)
+   {
+      int r = rand();
+      
+      raw[2*i] = r & 0xFF;
+      
+      switch( (r >> 8) % 4)
+      {
+         case 0:
+            raw[2*i+1] = 0;
+            break;
+         case 1:
+            raw[2*i+1] = -1;
+            break;
+         default:
+            raw[2*i+1] = (r >> 16) & 0xFF;
+      }
+   }
+}
+
+/** Verify the vector kernels for 16 bit bytepack match the scalar kernel
+  * For each vector instruction set available, verify that reordering gives the same planes as the scalar kernel, and that unreordering
+  * restores the original pixels.
+  * \anchor reorder_simd_sint16
+  */
+START_TEST (reorder_simd_sint16)
+{
+   int maxsimd = xrif_simd_level();
+   
+   fprintf(stderr, "Testing 16 bit bytepack kernels up to SIMD level %d.\n", maxsimd);
+   
+   for(size_t n = 0; n < NNPIX; ++n)
+   {
+      size_t npix = npixs[n];
+      
+      char * raw = (char *) malloc(2*npix + 1);
+      char * lo0 = (char *) malloc(npix + 1);
+      char * hi0 = (char *) malloc(npix + 1);
+      char * lo = (char *) malloc(npix + 1);
+      char * hi = (char *) malloc(npix + 1);
+      char * raw2 = (char *) malloc(2*npix + 1);
+      
+      ck_assert( raw && lo0 && hi0 && lo && hi && raw2 );
+      
+      fill_sint16(raw, npix);
+      
+      xrif_reorder_bytepack_sint16_kernel(lo0, hi0, raw, npix, XRIF_SIMD_NONE);
+      
+      for(int simd = XRIF_SIMD_NONE; simd <= maxsimd; ++simd)
+      {
+         memset(lo, 0, npix + 1);
+         memset(hi, 0, npix + 1);
+         
+         xrif_reorder_bytepack_sint16_kernel(lo, hi, raw, npix, simd);
+         
+         ck_assert( memcmp(lo, lo0, npix) == 0 );
+         ck_assert( memcmp(hi, hi0, npix) == 0 );
+         
+         //Nothing is written past the end
+         ck_assert( lo[npix] == 0 && hi[npix] == 0 );
+         
+         memset(raw2, 0, 2*npix + 1);
+         
+         xrif_unreorder_bytepack_sint16_kernel(raw2, lo, hi, npix, simd);
+         
+         ck_assert( memcmp(raw2, raw, 2*npix) == 0 );
+         ck_assert( raw2[2*npix] == 0 );
+      }
+      
+      free(raw);
+      free(lo0);
+      free(hi0);
+      free(lo);
+      free(hi);
+      free(raw2);
+   }
+}
+END_TEST;
+
+/** Verify the sign fixup of 16 bit bytepack
+  * Verify that small negative values have a zero high byte after reordering, for each vector instruction set available.
+  * \anchor reorder_simd_sint16_sign
+  */
+START_TEST (reorder_simd_sint16_sign)
+{
+   int maxsimd = xrif_simd_level();
+   
+   int16_t raw[64];
+   char lo[64];
+   char hi[64];
+   
+   for(int i = 0; i < 64; ++i) raw[i] = (i % 2) ? -i : i;
+   
+   for(int simd = XRIF_SIMD_NONE; simd <= maxsimd; ++simd)
+   {
+      xrif_reorder_bytepack_sint16_kernel(lo, hi, (char *) raw, 64, simd);
+      
+      for(int i = 0; i < 64; ++i) ck_assert( hi[i] == 0 );
+   }
+}
+END_TEST;
+
+//Fill wide pixels with a mix of small values of both signs, the extremes, and random bytes
+void fill_wide( char * raw,
+                size_t npix,
+                size_t nbytes
+              )
+{
+   for(size_t i = 0; i < npix; ++i)
+   {
+      int r = rand();
+      
+      int64_t v;
+      switch( r % 5)
+      {
+         case 0:
+            v = (r >> 4) % 200 - 100;
+            break;
+         case 1:
+            v = (nbytes == 4) ? INT32_MIN : INT64_MIN;
+            break;
+         case 2:
+            v = (nbytes == 4) ? INT32_MAX : INT64_MAX;
+            break;
+         default:
+            v = ((int64_t) rand() << 40) ^ ((int64_t) rand() << 20) ^ rand();
+      }
+      
+      if(nbytes == 4) 
+      {
+         int32_t v32 = (int32_t) v;
+         memcpy(raw + 4*i, &v32, 4);
+      }
+      else memcpy(raw + 8*i, &v, 8);
+   }
+}
+
+/** Verify the vector kernels for 32 and 64 bit bytepack match the scalar kernels
+  * For each vector instruction set available, verify that reordering gives the same planes as the scalar kernel, and that unreordering
+  * restores the original pixels.  The planes are written with a stride larger than the number of pixels to check that nothing
+  * is written between them.
+  * \anchor reorder_simd_wide
+  */
+START_TEST (reorder_simd_wide)
+{
+   int maxsimd = xrif_simd_level();
+   
+   for(size_t nbytes = 4; nbytes <= 8; nbytes += 4)
+   {
+      for(size_t n = 0; n < NNPIX; ++n)
+      {
+         size_t npix = npixs[n];
+         size_t stride = npix + 1;
+         
+         char * raw = (char *) malloc(nbytes*npix + 1);
+         char * planes0 = (char *) malloc(nbytes*stride);
+         char * planes = (char *) malloc(nbytes*stride);
+         char * raw2 = (char *) malloc(nbytes*npix + 1);
+         
+         ck_assert( raw && planes0 && planes && raw2 );
+         
+         fill_wide(raw, npix, nbytes);
+         
+         if(nbytes == 4) xrif_reorder_bytepack_sint32_kernel(planes0, stride, raw, npix, XRIF_SIMD_NONE);
+         else xrif_reorder_bytepack_sint64_kernel(planes0, stride, raw, npix, XRIF_SIMD_NONE);
+         
+         for(int simd = XRIF_SIMD_NONE; simd <= maxsimd; ++simd)
+         {
+            memset(planes, 0, nbytes*stride);
+            
+            if(nbytes == 4) xrif_reorder_bytepack_sint32_kernel(planes, stride, raw, npix, simd);
+            else xrif_reorder_bytepack_sint64_kernel(planes, stride, raw, npix, simd);
+            
+            for(size_t b = 0; b < nbytes; ++b)
+            {
+               ck_assert( memcmp(planes + b*stride, planes0 + b*stride, npix) == 0 );
+               ck_assert( planes[b*stride + npix] == 0 );
+            }
+            
+            memset(raw2, 0, nbytes*npix + 1);
+            
+            if(nbytes == 4) xrif_unreorder_bytepack_sint32_kernel(raw2, planes, stride, npix, simd);
+            else xrif_unreorder_bytepack_sint64_kernel(raw2, planes, stride, npix, simd);
+            
+            ck_assert( memcmp(raw2, raw, nbytes*npix) == 0 );
+            ck_assert( raw2[nbytes*npix] == 0 );
+         }
+         
+         free(raw);
+         free(planes0);
+         free(planes);
+         free(raw2);
+      }
+   }
+   
+   //Small negative values have zero high bytes
+   int32_t raw32[64];
+   int64_t raw64[64];
+   char planes[8*64];
+   
+   for(int i = 0; i < 64; ++i) raw32[i] = raw64[i] = (i % 2) ? -i : i;
+   
+   for(int simd = XRIF_SIMD_NONE; simd <= maxsimd; ++simd)
+   {
+      xrif_reorder_bytepack_sint32_kernel(planes, 64, (char *) raw32, 64, simd);
+      for(int i = 64; i < 4*64; ++i) ck_assert( planes[i] == 0 );
+      
+      xrif_reorder_bytepack_sint64_kernel(planes, 64, (char *) raw64, 64, simd);
+      for(int i = 64; i < 8*64; ++i) ck_assert( planes[i] == 0 );
+   }
+}
+END_TEST;
+
+/** Verify the byte shuffle kernels
+  * For 2, 3, 4, and 8 byte pixels, verify that each vector instruction set gives the byte planes, and that unshuffling restores the pixels.
+  * \anchor reorder_simd_shuffle
+  */
+START_TEST (reorder_simd_shuffle)
+{
+   int maxsimd = xrif_simd_level();
+   
+   size_t sizes[] = {2, 3, 4, 8};
+   
+   for(size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+   {
+      size_t nbytes = sizes[s];
+      
+      for(size_t n = 0; n < NNPIX; ++n)
+      {
+         size_t npix = npixs[n];
+         size_t stride = npix + 1;
+         
+         char * raw = (char *) malloc(nbytes*npix + 1);
+         char * planes = (char *) malloc(nbytes*stride);
+         char * raw2 = (char *) malloc(nbytes*npix + 1);
+         
+         ck_assert( raw && planes && raw2 );
+         
+         for(size_t i = 0; i < nbytes*npix; ++i) raw[i] = rand();
+         
+         for(int simd = XRIF_SIMD_NONE; simd <= maxsimd; ++simd)
+         {
+            memset(planes, 0, nbytes*stride);
+            
+            xrif_reorder_byteshuffle_kernel(planes, stride, raw, npix, nbytes, simd);
+            
+            for(size_t b = 0; b < nbytes; ++b)
+            {
+               for(size_t i = 0; i < npix; ++i) ck_assert( planes[b*stride + i] == raw[i*nbytes + b] );
+               ck_assert( planes[b*stride + npix] == 0 );
+            }
+            
+            memset(raw2, 0, nbytes*npix + 1);
+            
+            xrif_unreorder_byteshuffle_kernel(raw2, planes, stride, npix, nbytes, simd);
+            
+            ck_assert( memcmp(raw2, raw, nbytes*npix) == 0 );
+            ck_assert( raw2[nbytes*npix] == 0 );
+         }
+         
+         free(raw);
+         free(planes);
+         free(raw2);
+      }
+   }
+}
+END_TEST;
+
+/** Verify the bitpack kernels
+  * Verify that each vector instruction set puts bit b of each zigzag encoded pixel in plane b, that nothing is written past the end of a
+  * plane, that unreordering restores the pixels, and that small values leave the upper planes zero.
+  * \anchor reorder_simd_bitpack
+  */
+START_TEST (reorder_simd_bitpack)
+{
+   int maxsimd = xrif_simd_level();
+   
+   for(size_t n = 0; n < NNPIX; ++n)
+   {
+      size_t npix = npixs[n];
+      size_t stride = (npix + 7)/8 + 1;
+      
+      char * raw = (char *) malloc(2*npix + 1);
+      char * planes = (char *) malloc(16*stride);
+      char * raw2 = (char *) malloc(2*npix + 1);
+      
+      ck_assert( raw && planes && raw2 );
+      
+      fill_sint16(raw, npix);
+      
+      const int16_t * rb = (const int16_t *) raw;
+      
+      for(int simd = XRIF_SIMD_NONE; simd <= maxsimd; ++simd)
+      {
+         memset(planes, 0, 16*stride);
+         
+         xrif_reorder_bitpack_sint16_kernel(planes, stride, raw, npix, simd);
+         
+         for(size_t i = 0; i < npix; ++i)
+         {
+            uint16_t x = rb[i];
+            uint16_t z = (x << 1) ^ (uint16_t) -(x >> 15);
+            
+            for(int b = 0; b < 16; ++b) ck_assert( ((planes[b*stride + i/8] >> (i % 8)) & 1) == ((z >> b) & 1) );
+         }
+         
+         for(int b = 0; b < 16; ++b) ck_assert( planes[b*stride + stride - 1] == 0 );
+         
+         memset(raw2, 0, 2*npix + 1);
+         
+         xrif_unreorder_bitpack_sint16_kernel(raw2, planes, stride, npix, simd);
+         
+         ck_assert( memcmp(raw2, raw, 2*npix) == 0 );
+         ck_assert( raw2[2*npix] == 0 );
+      }
+      
+      free(raw);
+      free(planes);
+      free(raw2);
+   }
+   
+   int16_t small[64];
+   char planes[16*8];
+   
+   for(int i = 0; i < 64; ++i) small[i] = (i % 2) ? -(i % 8) : (i % 8);
+   
+   for(int simd = XRIF_SIMD_NONE; simd <= maxsimd; ++simd)
+   {
+      xrif_reorder_bitpack_sint16_kernel(planes, 8, (char *) small, 64, simd);
+      
+      //Values up to 7 in magnitude zigzag to at most 14, which is 4 bits
+      for(int i = 4*8; i < 16*8; ++i) ck_assert( planes[i] == 0 );
+   }
+}
+END_TEST;
+
+/** Verify the renibble kernels
+  * Verify that each vector instruction set writes the sign-magnitude folded low byte of each pixel and the nibbles of each pair of
+  * high bytes, including the most negative value, that nothing is written past the end of a plane, and that unreordering restores the pixels.
+  * \anchor reorder_simd_renibble
+  */
+START_TEST (reorder_simd_renibble)
+{
+   int maxsimd = xrif_simd_level();
+   
+   for(size_t n = 0; n < NNPIX; ++n)
+   {
+      size_t npix = npixs[n];
+      size_t half = (npix + 1)/2;
+      
+      char * raw = (char *) malloc(2*npix + 1);
+      unsigned char * planes = (unsigned char *) malloc(npix + 2*half + 3);
+      char * raw2 = (char *) malloc(2*npix + 1);
+      
+      ck_assert( raw && planes && raw2 );
+      
+      fill_sint16(raw, npix);
+      
+      int16_t * rb = (int16_t *) raw;
+      if(npix > 0) rb[0] = -32768;
+      if(npix > 3) rb[3] = 32767;
+      
+      for(int simd = XRIF_SIMD_NONE; simd <= maxsimd; ++simd)
+      {
+         memset(planes, 0, npix + 2*half + 3);
+         
+         unsigned char * nib1 = planes + npix + 1;
+         unsigned char * nib2 = nib1 + half + 1;
+         
+         xrif_reorder_bytepack_renibble_sint16_kernel( (char *) planes, (char *) nib1, (char *) nib2, raw, npix, simd);
+         
+         for(size_t i = 0; i < npix; ++i)
+         {
+            int s = rb[i];
+            uint16_t us = (uint16_t) ( ((s < 0 ? -s : s) << 1) | (s < 0) );
+            unsigned char h = us >> 8;
+            
+            ck_assert( planes[i] == (us & 0xFF) );
+            
+            if(i % 2 == 0)
+            {
+               ck_assert( (nib1[i/2] >> 4) == (h & 15) );
+               ck_assert( (nib2[i/2] & 240) == (h & 240) );
+            }
+            else
+            {
+               ck_assert( (nib1[i/2] & 15) == (h & 15) );
+               ck_assert( (nib2[i/2] & 15) == (h >> 4) );
+            }
+         }
+         
+         //A lone last pixel leaves the other half of its nibble bytes zero
+         if(npix % 2)
+         {
+            ck_assert( (nib1[half-1] & 15) == 0 );
+            ck_assert( (nib2[half-1] & 15) == 0 );
+         }
+         
+         ck_assert( planes[npix] == 0 );
+         ck_assert( nib1[half] == 0 );
+         ck_assert( nib2[half] == 0 );
+         
+         memset(raw2, 0, 2*npix + 1);
+         
+         xrif_unreorder_bytepack_renibble_sint16_kernel(raw2, (char *) planes, (char *) nib1, (char *) nib2, npix, simd);
+         
+         ck_assert( memcmp(raw2, raw, 2*npix) == 0 );
+         ck_assert( raw2[2*npix] == 0 );
+      }
+      
+      free(raw);
+      free(planes);
+      free(raw2);
+   }
+}
+END_TEST;
+
+//Check an undifference kernel against a running sum done with unsigned arithmetic, and that nothing past the run is changed
+#define XRIF_CHECK_UNDIFFERENCE_PIXEL( type, utype, kernel ) \
+   { \
+      type * pix = (type *) malloc((npix+1)*sizeof(type)); \
+      type * diff = (type *) malloc((npix+1)*sizeof(type)); \
+      ck_assert( pix && diff ); \
+      \
+      for(size_t i = 0; i < npix+1; ++i) diff[i] = (utype) rand() * (utype) rand(); \
+      type prev = (utype) rand() * (utype) rand(); \
+      \
+      for(int simd = XRIF_SIMD_NONE; simd <= maxsimd; ++simd) \
+      { \
+         memcpy(pix, diff, (npix+1)*sizeof(type)); \
+         \
+         kernel(pix, npix, prev, simd); \
+         \
+         utype sum = prev; \
+         for(size_t i = 0; i < npix; ++i) \
+         { \
+            sum += (utype) diff[i]; \
+            ck_assert( (utype) pix[i] == sum ); \
+         } \
+         ck_assert( pix[npix] == diff[npix] ); \
+      } \
+      \
+      free(pix); \
+      free(diff); \
+   }
+
+/** Verify the pixel undifferencing kernels
+  * For each vector instruction set available, verify that the kernels for each pixel size give the running sum of the run
+  * starting from the previous pixel, and that nothing past the end of the run is changed.
+  * \anchor undifference_pixel_simd
+  */
+START_TEST (undifference_pixel_simd)
+{
+   int maxsimd = xrif_simd_level();
+   
+   for(size_t n = 0; n < NNPIX; ++n)
+   {
+      size_t npix = npixs[n];
+      
+      XRIF_CHECK_UNDIFFERENCE_PIXEL( int8_t, uint8_t, xrif_undifference_pixel_sint8_kernel );
+      XRIF_CHECK_UNDIFFERENCE_PIXEL( int16_t, uint16_t, xrif_undifference_pixel_sint16_kernel );
+      XRIF_CHECK_UNDIFFERENCE_PIXEL( int32_t, uint32_t, xrif_undifference_pixel_sint32_kernel );
+      XRIF_CHECK_UNDIFFERENCE_PIXEL( int64_t, uint64_t, xrif_undifference_pixel_sint64_kernel );
+   }
+}
+END_TEST;
+
+#undef XRIF_CHECK_UNDIFFERENCE_PIXEL
+
+//Check a linear differencing kernel and its inverse against the prediction taken in 64 bits, with and without the unsigned bias, 
+//and that nothing past the run is changed.  The values are drawn near the ends of the range half the time so the clamp is exercised.
+#define XRIF_CHECK_LINEAR( type, utype, tmin, tmax, dkernel, ukernel ) \
+   { \
+      type * x0 = (type *) malloc((npix+1)*sizeof(type)); \
+      type * x1 = (type *) malloc((npix+1)*sizeof(type)); \
+      type * x2 = (type *) malloc((npix+1)*sizeof(type)); \
+      type * res = (type *) malloc((npix+1)*sizeof(type)); \
+      ck_assert( x0 && x1 && x2 && res ); \
+      \
+      for(size_t i = 0; i < npix+1; ++i) \
+      { \
+         x0[i] = (utype) rand() * (utype) rand(); \
+         x1[i] = (utype) rand() * (utype) rand(); \
+         x2[i] = (utype) rand() * (utype) rand(); \
+         if(i % 4 == 0) x1[i] = (type) ((tmax) - (x1[i] & 0xFF)); \
+         if(i % 4 == 1) x1[i] = (type) ((tmin) + (x1[i] & 0xFF)); \
+      } \
+      \
+      for(int u = 0; u < 2; ++u) \
+      { \
+         type bias = (u) ? (tmin) : 0; \
+         \
+         for(int simd = XRIF_SIMD_NONE; simd <= maxsimd; ++simd) \
+         { \
+            memcpy(res, x2, (npix+1)*sizeof(type)); \
+            \
+            dkernel(res, x1, x0, npix, bias, simd); \
+            \
+            for(size_t i = 0; i < npix; ++i) \
+            { \
+               int64_t a = (type) (x1[i] ^ bias); \
+               int64_t b = (type) (x0[i] ^ bias); \
+               int64_t p = 2*a - b; \
+               if(p > (tmax)) p = (tmax); \
+               if(p < (tmin)) p = (tmin); \
+               type pred = ((type) p) ^ bias; \
+               ck_assert( (utype) res[i] == (utype) ((utype) x2[i] - (utype) pred) ); \
+            } \
+            ck_assert( res[npix] == x2[npix] ); \
+            \
+            ukernel(res, x1, x0, npix, bias, simd); \
+            \
+            ck_assert( memcmp(res, x2, (npix+1)*sizeof(type)) == 0 ); \
+         } \
+      } \
+      \
+      free(x0); \
+      free(x1); \
+      free(x2); \
+      free(res); \
+   }
+
+/** Verify the linear differencing kernels
+  * For each vector instruction set available, verify that the 16 and 32 bit kernels subtract the clamped linear prediction for
+  * signed and unsigned types, that the inverse kernels restore the pixels, and that nothing past the end of the run is changed.
+  * \anchor linear_simd
+  */
+START_TEST (linear_simd)
+{
+   int maxsimd = xrif_simd_level();
+   
+   for(size_t n = 0; n < NNPIX; ++n)
+   {
+      size_t npix = npixs[n];
+      
+      XRIF_CHECK_LINEAR( int16_t, uint16_t, INT16_MIN, INT16_MAX, xrif_difference_linear_sint16_kernel, xrif_undifference_linear_sint16_kernel );
+      XRIF_CHECK_LINEAR( int32_t, uint32_t, INT32_MIN, INT32_MAX, xrif_difference_linear_sint32_kernel, xrif_undifference_linear_sint32_kernel );
+   }
+}
+END_TEST;
+
+#undef XRIF_CHECK_LINEAR
+
+Suite * reorder_simd_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Reordering kernels");
+
+    tc_core = tcase_create("Vector kernels match scalar");
+
+    tcase_set_timeout(tc_core, 1e9);
+    
+    tcase_add_test(tc_core, reorder_simd_sint16);
+    tcase_add_test(tc_core, reorder_simd_sint16_sign);
+    tcase_add_test(tc_core, reorder_simd_wide);
+    tcase_add_test(tc_core, reorder_simd_shuffle);
+    tcase_add_test(tc_core, reorder_simd_bitpack);
+    tcase_add_test(tc_core, reorder_simd_renibble);
+    tcase_add_test(tc_core, undifference_pixel_simd);
+    tcase_add_test(tc_core, linear_simd);
+    
+    suite_add_tcase(s, tc_core);
+    
+    return s;
+}
+
+int main()
+{
+   int number_failed;
+   Suite *s;
+   SRunner *sr;
+
+   srand((unsigned) time(NULL));
+
+   s = reorder_simd_suite();
+   sr = srunner_create(s);
+
+   srunner_run_all(sr, CK_NORMAL);
+   number_failed = srunner_ntests_failed(sr);
+   srunner_free(sr);
+   
+   return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}